@@ -149,6 +149,17 @@ FOREACH(testfile ${INTEGRATION_TESTS})
 ENDFOREACH()
 message("-- Finished building ${INT_TEST_COUNT} integration test file(s)...")
 
+SET(BENCHMARK_COUNT 0)
+GETSOURCEFILES(BENCHMARKS "${TEST_DIR}/benchmarks/")
+FOREACH(testfile ${BENCHMARKS})
+  get_filename_component(testfilename "${testfile}" NAME_WE)
+  add_executable("${testfilename}" "${TEST_DIR}/benchmarks/${testfile}")
+  createTests("${testfilename}")
+  target_link_libraries(${testfilename} ${CATCH_MAIN_LIB})
+  MATH(EXPR BENCHMARK_COUNT "${BENCHMARK_COUNT}+1")
+ENDFOREACH()
+message("-- Finished building ${BENCHMARK_COUNT} benchmark file(s)...")
+
 get_property(extensions GLOBAL PROPERTY EXTENSION-TESTS)
 foreach(EXTENSION ${extensions})
 	add_subdirectory(${EXTENSION})
@@ -133,6 +133,8 @@ void HTTPClient::initialize(const std::string &method, const std::string url, co
   }
   if (isSecure(url_) && ssl_context_service_ != nullptr) {
     configure_secure_connection(http_session_);
+  } else {
+    curl_easy_setopt(http_session_, CURLOPT_SHARE, HTTPClientInitializer::getInstance()->getShare(""));
   }
 }
 
@@ -254,7 +256,7 @@ bool HTTPClient::submit() {
     return false;
   }
 
-  logger_->log_debug("Finished with %s", url_);
+  logger_->log_debug("Finished with %s, %s", url_, getConnectionsOpened() > 0 ? "on a new connection" : "reusing a connection");
   std::string key = "";
   for (auto header_line : header_response_.header_tokens_) {
     unsigned int i = 0;
@@ -292,6 +294,12 @@ CURLcode HTTPClient::getResponseResult() {
   return res;
 }
 
+int64_t HTTPClient::getConnectionsOpened() {
+  long connections = 0;
+  curl_easy_getinfo(http_session_, CURLINFO_NUM_CONNECTS, &connections);
+  return connections;
+}
+
 int64_t &HTTPClient::getResponseCode() {
   return http_code;
 }
@@ -345,6 +353,9 @@ bool HTTPClient::matches(const std::string &value, const std::string &sregex) {
 }
 
 void HTTPClient::configure_secure_connection(CURL *http_session) {
+  // sessions are only shared between clients presenting the same certificate
+  CURLSH *share = HTTPClientInitializer::getInstance()->getShare(ssl_context_service_->getCertificateFile() + ":" + ssl_context_service_->getPrivateKeyFile());
+  curl_easy_setopt(http_session, CURLOPT_SHARE, share);
 #ifdef USE_CURL_NSS
   setVerbose();
   logger_->log_debug("Using NSS and certificate file %s", ssl_context_service_->getCertificateFile());
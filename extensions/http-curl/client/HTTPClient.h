@@ -31,6 +31,9 @@
 #include <regex.h>
 #endif
 #include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include "utils/ByteArrayCallback.h"
 #include "controllers/SSLContextService.h"
@@ -57,13 +60,57 @@ class HTTPClientInitializer {
   void initialize() {
 
   }
+
+  /**
+   * Returns the share handle of the clients presenting the given identity, through which
+   * they resume the TLS sessions negotiated by one another. Clients also keep their
+   * connections open in it once they are done, so that the next request to the same
+   * host reuses one instead of connecting again. Plain HTTP clients use the empty identity.
+   */
+  CURLSH *getShare(const std::string &identity) {
+    std::lock_guard<std::mutex> lock(share_mutex_);
+    std::unique_ptr<Share> &share = shares_[identity];
+    if (share == nullptr) {
+      share = std::unique_ptr<Share>(new Share());
+      share->handle = curl_share_init();
+      curl_share_setopt(share->handle, CURLSHOPT_LOCKFUNC, &lockShare);
+      curl_share_setopt(share->handle, CURLSHOPT_UNLOCKFUNC, &unlockShare);
+      curl_share_setopt(share->handle, CURLSHOPT_USERDATA, share.get());
+      curl_share_setopt(share->handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+      curl_share_setopt(share->handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+#if LIBCURL_VERSION_NUM >= 0x073900
+      // connections can be shared since 7.57.0
+      curl_share_setopt(share->handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+    }
+    return share->handle;
+  }
  private:
+  struct Share {
+    CURLSH *handle;
+    std::mutex locks[CURL_LOCK_DATA_LAST];
+  };
+
+  static void lockShare(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr) {
+    static_cast<Share*>(userptr)->locks[data].lock();
+  }
+
+  static void unlockShare(CURL *handle, curl_lock_data data, void *userptr) {
+    static_cast<Share*>(userptr)->locks[data].unlock();
+  }
+
   ~HTTPClientInitializer() {
+    for (const auto &share : shares_) {
+      curl_share_cleanup(share.second->handle);
+    }
     curl_global_cleanup();
   }
   HTTPClientInitializer() {
     curl_global_init(CURL_GLOBAL_DEFAULT);
   }
+
+  std::mutex share_mutex_;
+  std::map<std::string, std::unique_ptr<Share>> shares_;
 };
 
 /**
@@ -117,6 +164,11 @@ class HTTPClient : public BaseHTTPClient, public core::Connectable {
 
   CURLcode getResponseResult();
 
+  /**
+   * Returns the number of connections the last request opened, 0 if it reused one.
+   */
+  int64_t getConnectionsOpened();
+
   int64_t &getResponseCode() override;
 
   const char *getContentType() override;
@@ -35,9 +35,6 @@ namespace io {
 HttpStream::HttpStream(std::shared_ptr<utils::HTTPClient> client)
     : http_client_(client),
       written(0),
-      // given the nature of the stream we don't want to slow libCURL, we will produce
-      // a warning instead allowing us to adjust it server side or through the local configuration.
-      http_read_callback_(66560, true),
       started_(false),
       logger_(logging::LoggerFactory<HttpStream>::getLogger()) {
   // submit early on
@@ -180,7 +180,8 @@ class HttpStream : public io::BaseStream {
 
   utils::HTTPUploadCallback callback_;
 
-  utils::ByteOutputCallback http_read_callback_;
+  // hands the body curl receives straight to the buffers readData is called with
+  utils::HandoffOutputCallback http_read_callback_;
 
   utils::HTTPReadCallback read_callback_;
 
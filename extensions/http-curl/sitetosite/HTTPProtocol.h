@@ -160,6 +160,10 @@ class HttpSiteToSiteClient : public sitetosite::SiteToSiteClient {
 
   const std::string parseTransactionId(const std::string &uri);
 
+  /**
+   * Creates a client for one request of a transaction. Clients keep their connections open in
+   * the share of their identity, so the requests of a transaction reuse the connection to the peer.
+   */
   std::unique_ptr<utils::HTTPClient> create_http_client(const std::string &uri, const std::string &method = "POST", bool setPropertyHeaders = false) {
     std::unique_ptr<utils::HTTPClient> http_client_ = std::unique_ptr<utils::HTTPClient>(new minifi::utils::HTTPClient(uri, ssl_context_service_));
     http_client_->initialize(method, uri, ssl_context_service_);
@@ -0,0 +1,95 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <memory>
+#include <string>
+#include <vector>
+#include "TestBase.h"
+#include "HTTPClient.h"
+#include "HTTPStream.h"
+#include "CivetServer.h"
+
+class KeepAliveHandler : public CivetHandler {
+ public:
+  bool handleGet(CivetServer *server, struct mg_connection *conn) {
+    mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 2\r\nConnection: keep-alive\r\n\r\nOK");
+    return true;
+  }
+};
+
+class BodyHandler : public CivetHandler {
+ public:
+  explicit BodyHandler(const std::string &body)
+      : body_(body) {
+  }
+  bool handleGet(CivetServer *server, struct mg_connection *conn) {
+    mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %zu\r\n\r\n", body_.size());
+    mg_write(conn, body_.data(), body_.size());
+    return true;
+  }
+
+ private:
+  std::string body_;
+};
+
+TEST_CASE("HTTPClientReusesConnections", "[httpclient]") {
+  std::vector<std::string> options = { "listening_ports", "10502", "enable_keep_alive", "yes" };
+  KeepAliveHandler handler;
+  mg_init_library(0);
+  std::unique_ptr<CivetServer> server(new CivetServer(options));
+  server->addHandler("/keepalive", handler);
+
+  // the clients are destroyed after each request, as those of a site to site transaction are
+  for (int i = 0; i < 3; i++) {
+    utils::HTTPClient client("http://localhost:10502/keepalive");
+    client.initialize("GET");
+    REQUIRE(client.submit());
+    REQUIRE(200 == client.getResponseCode());
+    REQUIRE((i == 0 ? 1 : 0) == client.getConnectionsOpened());
+  }
+
+  server = nullptr;
+  mg_exit_library();
+}
+
+TEST_CASE("HttpStreamReadsBody", "[httpclient]") {
+  std::string body;
+  for (int i = 0; i < 200000; i++) {
+    body += std::to_string(i);
+  }
+  std::vector<std::string> options = { "listening_ports", "10502" };
+  BodyHandler handler(body);
+  mg_init_library(0);
+  std::unique_ptr<CivetServer> server(new CivetServer(options));
+  server->addHandler("/body", handler);
+
+  // the body is handed from curl to the reads, which do not line up with what curl receives
+  auto client = std::make_shared<utils::HTTPClient>("http://localhost:10502/body");
+  client->initialize("GET");
+  minifi::io::HttpStream stream(client);
+  std::string received;
+  std::vector<uint8_t> buffer(10007);
+  int read;
+  while ((read = stream.readData(buffer.data(), buffer.size())) > 0) {
+    received.append(reinterpret_cast<char*>(buffer.data()), read);
+  }
+  REQUIRE(body == received);
+  REQUIRE(200 == stream.getClient()->getResponseCode());
+
+  server = nullptr;
+  mg_exit_library();
+}
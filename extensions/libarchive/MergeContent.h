@@ -68,8 +68,8 @@ public:
   // Nest Callback Class for read stream
   class ReadCallback : public InputStreamCallback {
    public:
-    ReadCallback(uint64_t size, std::shared_ptr<io::BaseStream> stream)
-        : buffer_size_(size), stream_(stream) {
+    ReadCallback(uint64_t size, std::shared_ptr<io::BaseStream> stream, const std::string &prefix)
+        : buffer_size_(size), stream_(stream), prefix_(prefix), prefix_written_(prefix.empty()) {
     }
     ~ReadCallback() {
     }
@@ -81,7 +81,21 @@ public:
       while (read_size < buffer_size_) {
         int readRet = stream->read(buffer, sizeof(buffer));
         if (readRet > 0) {
-          ret += stream_->write(buffer, readRet);
+          if (!prefix_written_) {
+            // the prefix goes out in one write along with the first chunk
+            struct iovec iov[2];
+            iov[0].iov_base = const_cast<char*>(prefix_.data());
+            iov[0].iov_len = prefix_.size();
+            iov[1].iov_base = buffer;
+            iov[1].iov_len = readRet;
+            int len = stream_->writeV(iov, 2);
+            if (len < 0)
+              return len;
+            ret += len - prefix_.size();
+            prefix_written_ = true;
+          } else {
+            ret += stream_->write(buffer, readRet);
+          }
           read_size += readRet;
         } else {
           break;
@@ -89,8 +103,17 @@ public:
       }
       return ret;
     }
+    // writes the prefix if the content was empty
+    int64_t writePrefix() {
+      if (prefix_written_)
+        return 0;
+      prefix_written_ = true;
+      return stream_->write(reinterpret_cast<uint8_t*>(const_cast<char*>(prefix_.data())), prefix_.size());
+    }
     uint64_t buffer_size_;
     std::shared_ptr<io::BaseStream> stream_;
+    std::string prefix_;
+    bool prefix_written_;
   };
   // Nest Callback Class for write stream
   class WriteCallback: public OutputStreamCallback {
@@ -105,25 +128,24 @@ public:
     core::ProcessSession *session_;
     int64_t process(std::shared_ptr<io::BaseStream> stream) {
       int64_t ret = 0;
-      if (!header_.empty()) {
-        int64_t len = stream->write(reinterpret_cast<uint8_t*>(const_cast<char*>(header_.data())), header_.size());
-        if (len < 0)
-          return len;
-        ret += len;
-      }
       bool isFirst = true;
       for (auto flow : flows_) {
-        if (!isFirst && !demarcator_.empty()) {
-          int64_t len = stream->write(reinterpret_cast<uint8_t*>(const_cast<char*>(demarcator_.data())), demarcator_.size());
-          if (len < 0)
-            return len;
-          ret += len;
-        }
-        ReadCallback readCb(flow->getSize(), stream);
+        // the header or demarcator preceding each flow is written with its first chunk
+        const std::string &prefix = isFirst ? header_ : demarcator_;
+        ReadCallback readCb(flow->getSize(), stream, prefix);
         session_->read(flow, &readCb);
-        ret += flow->getSize();
+        int64_t len = readCb.writePrefix();
+        if (len < 0)
+          return len;
+        ret += prefix.size() + flow->getSize();
         isFirst = false;
       }
+      if (flows_.empty() && !header_.empty()) {
+        int64_t len = stream->write(reinterpret_cast<uint8_t*>(const_cast<char*>(header_.data())), header_.size());
+        if (len < 0)
+          return len;
+        ret += len;
+      }
       if (!footer_.empty()) {
         int64_t len = stream->write(reinterpret_cast<uint8_t*>(const_cast<char*>(footer_.data())), footer_.size());
         if (len < 0)
@@ -37,6 +37,8 @@ bool DatabaseContentRepository::initialize(const std::shared_ptr<minifi::Configu
     directory_ = configuration->getHome() + "/dbcontentrepository";
   }
   rocksdb::Options options;
+  rocksdb_resources_ = RocksDbResources::getInstance(configuration);
+  rocksdb_resources_->configure(options);
   options.create_if_missing = true;
   options.use_direct_io_for_flush_and_compaction = true;
   options.use_direct_reads = true;
@@ -24,6 +24,7 @@
 #include "core/Connectable.h"
 #include "core/ContentRepository.h"
 #include "properties/Configure.h"
+#include "RocksDbResources.h"
 #include "core/logging/LoggerConfiguration.h"
 namespace org {
 namespace apache {
@@ -120,6 +121,8 @@ class DatabaseContentRepository : public core::ContentRepository, public core::C
  private:
   bool is_valid_;
   rocksdb::DB* db_;
+  // cache and write buffers shared with the other databases, must outlive db_
+  std::shared_ptr<RocksDbResources> rocksdb_resources_;
   std::shared_ptr<logging::Logger> logger_;
 };
 
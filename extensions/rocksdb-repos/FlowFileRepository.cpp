@@ -17,6 +17,9 @@
  */
 #include "FlowFileRepository.h"
 #include "rocksdb/write_batch.h"
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -32,23 +35,35 @@ namespace repository {
 
 void FlowFileRepository::flush() {
   rocksdb::WriteBatch batch;
-  std::string key;
   std::string value;
   rocksdb::ReadOptions options;
 
-  std::vector<std::shared_ptr<FlowFileRecord>> purgeList;
+  std::vector<std::shared_ptr<minifi::ResourceClaim>> purgeList;
 
   uint64_t decrement_total = 0;
-  while (keys_to_delete.size_approx() > 0) {
-    if (keys_to_delete.try_dequeue(key)) {
-      db_->Get(options, key, &value);
-      decrement_total += value.size();
-      std::shared_ptr<FlowFileRecord> eventRead = std::make_shared<FlowFileRecord>(shared_from_this(), content_repo_);
-      if (eventRead->DeSerialize(reinterpret_cast<const uint8_t *>(value.data()), value.size())) {
-        purgeList.push_back(eventRead);
+  DeletedFlowFile deletions[FLOWFILE_REPOSITORY_DELETE_BATCH];
+  size_t count = 0;
+  while ((count = keys_to_delete.try_dequeue_bulk(deletions, FLOWFILE_REPOSITORY_DELETE_BATCH)) > 0) {
+    for (size_t i = 0; i < count; i++) {
+      DeletedFlowFile &deletion = deletions[i];
+      if (!deletion.resolved) {
+        // only the key was provided, so we must read the value to find its claim
+        value.clear();
+        if (db_->Get(options, deletion.key, &value).ok()) {
+          deletion.size = value.size();
+          std::shared_ptr<FlowFileRecord> eventRead = std::make_shared<FlowFileRecord>(shared_from_this(), content_repo_);
+          if (eventRead->DeSerialize(reinterpret_cast<const uint8_t *>(value.data()), value.size())) {
+            deletion.claim = eventRead->getResourceClaim();
+          }
+        }
       }
-      logger_->log_debug("Issuing batch delete, including %s, Content path %s", eventRead->getUUIDStr(), eventRead->getContentFullPath());
-      batch.Delete(key);
+      decrement_total += deletion.size;
+      if (nullptr != deletion.claim) {
+        purgeList.push_back(deletion.claim);
+      }
+      logger_->log_debug("Issuing batch delete, including %s", deletion.key);
+      batch.Delete(deletion.key);
+      deletion.claim = nullptr;
     }
   }
   if (db_->Write(rocksdb::WriteOptions(), &batch).ok()) {
@@ -60,13 +75,8 @@ void FlowFileRepository::flush() {
     }
   }
 
-  if (nullptr != content_repo_) {
-    for (const auto &ffr : purgeList) {
-      auto claim = ffr->getResourceClaim();
-      if (claim != nullptr) {
-        content_repo_->removeIfOrphaned(claim);
-      }
-    }
+  if (nullptr != content_repo_ && !purgeList.empty()) {
+    content_repo_->removeOrphans(purgeList);
   }
 }
 
@@ -91,35 +101,79 @@ void FlowFileRepository::run() {
 }
 
 void FlowFileRepository::prune_stored_flowfiles() {
-  rocksdb::DB* stored_database_;
-  bool corrupt_checkpoint = false;
-  if (nullptr != checkpoint_) {
-    rocksdb::Options options;
-    options.create_if_missing = true;
-    options.use_direct_io_for_flush_and_compaction = true;
-    options.use_direct_reads = true;
-    rocksdb::Status status = rocksdb::DB::OpenForReadOnly(options, FLOWFILE_CHECKPOINT_DIRECTORY, &stored_database_);
-    if (!status.ok()) {
-      stored_database_ = db_;
-    }
-  } else {
-    logger_->log_trace("Could not open checkpoint as object doesn't exist. Likely not needed or file system error.");
+  if (nullptr == recovery_snapshot_) {
+    logger_->log_trace("No stored flow files to recover");
     return;
   }
+  const rocksdb::Snapshot *snapshot = recovery_snapshot_;
+
+  // keys are flow file uuids, so split the key space on their leading hex digit
+  static const char hex_digits[] = "0123456789abcdef";
+  const unsigned partitions = std::min<unsigned>(recovery_threads_, 16);
+  std::vector<std::string> bounds;
+  bounds.push_back("");
+  for (unsigned i = 1; i < partitions; i++) {
+    bounds.push_back(std::string(1, hex_digits[16 * i / partitions]));
+  }
+  bounds.push_back("");
+
+  const auto start = std::chrono::steady_clock::now();
+  std::atomic<uint64_t> recovered(0);
+  std::vector<std::thread> workers;
+  for (unsigned i = 1; i < partitions; i++) {
+    workers.emplace_back([this, snapshot, &bounds, &recovered, i]() {
+      recovered += recover_range(snapshot, bounds[i], bounds[i + 1]);
+    });
+  }
+  recovered += recover_range(snapshot, bounds[0], bounds[1]);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  logger_->log_info("Recovered %llu flow files in %llu ms using %u threads", recovered.load(), elapsed, partitions);
 
-  rocksdb::Iterator* it = stored_database_->NewIterator(rocksdb::ReadOptions());
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+  release_recovery_snapshot();
+}
+
+uint64_t FlowFileRepository::recover_range(const rocksdb::Snapshot *snapshot, const std::string &lower, const std::string &upper) {
+  rocksdb::ReadOptions options;
+  // flow files written or deleted since startup are not part of the recovery
+  options.snapshot = snapshot;
+  rocksdb::Slice upper_bound(upper);
+  if (!upper.empty()) {
+    options.iterate_upper_bound = &upper_bound;
+  }
+
+  uint64_t recovered = 0;
+  std::map<std::shared_ptr<minifi::Connection>, std::vector<std::shared_ptr<core::FlowFile>>> batches;
+  auto flushBatch = [&recovered](const std::shared_ptr<minifi::Connection> &connection, std::vector<std::shared_ptr<core::FlowFile>> &batch) {
+    recovered += batch.size();
+    connection->multiPut(batch);
+    batch.clear();
+  };
+
+  std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(options));
+  if (lower.empty()) {
+    it->SeekToFirst();
+  } else {
+    it->Seek(lower);
+  }
+  for (; it->Valid(); it->Next()) {
     std::shared_ptr<FlowFileRecord> eventRead = std::make_shared<FlowFileRecord>(shared_from_this(), content_repo_);
     std::string key = it->key().ToString();
     repo_size_ += it->value().size();
+    eventRead->setStoredSize(it->value().size());
     if (eventRead->DeSerialize(reinterpret_cast<const uint8_t *>(it->value().data()), it->value().size())) {
-      logger_->log_debug("Found connection for %s, path %s ", eventRead->getConnectionUuid(), eventRead->getContentFullPath());
       auto search = connectionMap.find(eventRead->getConnectionUuid());
-      if (!corrupt_checkpoint && search != connectionMap.end()) {
-        // we find the connection for the persistent flowfile, create the flowfile and enqueue that
-        std::shared_ptr<core::FlowFile> flow_file_ref = std::static_pointer_cast<core::FlowFile>(eventRead);
+      std::shared_ptr<minifi::Connection> connection = search != connectionMap.end() ? std::dynamic_pointer_cast<minifi::Connection>(search->second) : nullptr;
+      if (nullptr != connection) {
+        // we find the connection for the persistent flowfile, queue it with the rest of the batch for that connection
         eventRead->setStoredToRepository(true);
-        search->second->put(eventRead);
+        auto &batch = batches[connection];
+        batch.push_back(eventRead);
+        if (batch.size() >= FLOWFILE_REPOSITORY_RECOVERY_BATCH) {
+          flushBatch(connection, batch);
+        }
       } else {
         logger_->log_warn("Could not find connection for %s, path %s ", eventRead->getConnectionUuid(), eventRead->getContentFullPath());
         if (eventRead->getContentFullPath().length() > 0) {
@@ -127,45 +181,49 @@ void FlowFileRepository::prune_stored_flowfiles() {
             content_repo_->remove(eventRead->getResourceClaim());
           }
         }
-        keys_to_delete.enqueue(key);
+        // the claim was removed above, so only the key remains to be deleted
+        Delete(key, nullptr, it->value().size());
       }
     } else {
-      keys_to_delete.enqueue(key);
+      Delete(key, nullptr, it->value().size());
     }
   }
 
-  delete it;
-
+  for (auto &batch : batches) {
+    flushBatch(batch.first, batch.second);
+  }
+  return recovered;
 }
 
 /**
  * Returns True if there is data to interrogate.
  * @return true if our db has data stored.
  */
-bool FlowFileRepository::need_checkpoint(){
+bool FlowFileRepository::need_recovery() {
   std::unique_ptr<rocksdb::Iterator> it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(rocksdb::ReadOptions()));
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    return true;
+  it->SeekToFirst();
+  return it->Valid();
+}
+
+void FlowFileRepository::release_recovery_snapshot() {
+  if (nullptr != recovery_snapshot_) {
+    db_->ReleaseSnapshot(recovery_snapshot_);
+    recovery_snapshot_ = nullptr;
   }
-  return false;
 }
+
 void FlowFileRepository::initialize_repository() {
-  // first we need to establish a checkpoint iff it is needed.
-  if (!need_checkpoint()){
-    logger_->log_trace("Do not need checkpoint");
+  // earlier versions copied the database into a checkpoint at startup, reclaim that space
+  utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY);
+  release_recovery_snapshot();
+  if (!need_recovery()) {
+    logger_->log_trace("No stored flow files, recovery is not needed");
     return;
   }
-  rocksdb::Checkpoint *checkpoint;
-  // delete any previous copy
-  if (utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY) >= 0 && rocksdb::Checkpoint::Create(db_, &checkpoint).ok()) {
-    if (checkpoint->CreateCheckpoint(FLOWFILE_CHECKPOINT_DIRECTORY).ok()) {
-      checkpoint_ = std::unique_ptr<rocksdb::Checkpoint>(checkpoint);
-      logger_->log_trace("Created checkpoint directory");
-    } else {
-      logger_->log_trace("Could not create checkpoint. Corrupt?");
-    }
-  } else
-    logger_->log_trace("Could not create checkpoint directory. Not properly deleted?");
+  // the snapshot pins the stored flow files without copying them; the live database is
+  // only modified by deletes of orphaned flow files, so a crash during recovery is harmless
+  recovery_snapshot_ = db_->GetSnapshot();
+  logger_->log_trace("Created recovery snapshot");
 }
 
 void FlowFileRepository::loadComponent(const std::shared_ptr<core::ContentRepository> &content_repo) {
@@ -22,12 +22,14 @@
 #include "rocksdb/db.h"
 #include "rocksdb/options.h"
 #include "rocksdb/slice.h"
-#include "rocksdb/utilities/checkpoint.h"
 #include "core/Repository.h"
+#include "RocksDbResources.h"
 #include "core/Core.h"
 #include "Connection.h"
 #include "core/logging/LoggerConfiguration.h"
 #include "concurrentqueue.h"
+#include <algorithm>
+#include <thread>
 
 namespace org {
 namespace apache {
@@ -46,6 +48,9 @@ namespace repository {
 #define MAX_FLOWFILE_REPOSITORY_STORAGE_SIZE (10*1024*1024) // 10M
 #define MAX_FLOWFILE_REPOSITORY_ENTRY_LIFE_TIME (600000) // 10 minute
 #define FLOWFILE_REPOSITORY_PURGE_PERIOD (2000) // 2000 msec
+#define FLOWFILE_REPOSITORY_DELETE_BATCH (1024)
+#define FLOWFILE_REPOSITORY_RECOVERY_BATCH (1024)
+#define FLOWFILE_REPOSITORY_MAX_RECOVERY_THREADS (16)
 
 /**
  * Flow File repository
@@ -64,13 +69,15 @@ class FlowFileRepository : public core::Repository, public std::enable_shared_fr
       : core::SerializableComponent(repo_name),
         Repository(repo_name.length() > 0 ? repo_name : core::getClassName<FlowFileRepository>(), directory, maxPartitionMillis, maxPartitionBytes, purgePeriod),
         content_repo_(nullptr),
-        checkpoint_(nullptr),
+        recovery_snapshot_(nullptr),
+        recovery_threads_(std::max<unsigned>(1, std::min<unsigned>(std::thread::hardware_concurrency(), FLOWFILE_REPOSITORY_MAX_RECOVERY_THREADS))),
         logger_(logging::LoggerFactory<FlowFileRepository>::getLogger()) {
     db_ = NULL;
   }
 
   // Destructor
   ~FlowFileRepository() {
+    release_recovery_snapshot();
     if (db_)
       delete db_;
   }
@@ -95,7 +102,16 @@ class FlowFileRepository : public core::Repository, public std::enable_shared_fr
       }
     }
     logger_->log_debug("NiFi FlowFile Max Storage Time: [%d] ms", max_partition_millis_);
+    if (configure->get(Configure::nifi_flowfile_repository_recovery_threads, value)) {
+      int64_t recovery_threads = 0;
+      if (Property::StringToInt(value, recovery_threads) && recovery_threads > 0) {
+        recovery_threads_ = std::min<int64_t>(recovery_threads, FLOWFILE_REPOSITORY_MAX_RECOVERY_THREADS);
+      }
+    }
+    logger_->log_debug("NiFi FlowFile Recovery Threads: %u", recovery_threads_);
     rocksdb::Options options;
+    rocksdb_resources_ = RocksDbResources::getInstance(configure);
+    rocksdb_resources_->configure(options);
     options.create_if_missing = true;
     options.use_direct_io_for_flush_and_compaction = true;
     options.use_direct_reads = true;
@@ -128,7 +144,18 @@ class FlowFileRepository : public core::Repository, public std::enable_shared_fr
    * @return status of the delete operation
    */
   virtual bool Delete(std::string key) {
-    keys_to_delete.enqueue(key);
+    DeletedFlowFile deletion = { key, nullptr, 0, false };
+    keys_to_delete.enqueue(deletion);
+    return true;
+  }
+
+  /**
+   * Deletes the key. Since the claim and the size of the value are known, flush
+   * does not need to read the value back.
+   */
+  virtual bool Delete(const std::string &key, const std::shared_ptr<minifi::ResourceClaim> &claim, uint64_t size) {
+    DeletedFlowFile deletion = { key, claim, size, true };
+    keys_to_delete.enqueue(deletion);
     return true;
   }
   /**
@@ -162,26 +189,55 @@ class FlowFileRepository : public core::Repository, public std::enable_shared_fr
 
  private:
 
+  /**
+   * Key queued for deletion, along with what is needed to release it.
+   */
+  struct DeletedFlowFile {
+    std::string key;
+    std::shared_ptr<minifi::ResourceClaim> claim;
+    uint64_t size;
+    // false if only the key is known, in which case flush reads the value back
+    bool resolved;
+  };
+
   /**
    * Initialize the repository
    */
   void initialize_repository();
 
   /**
-   * Returns true if a checkpoint is needed at startup
-   * @return true if a checkpoint is needed.
+   * Returns true if there are stored flow files to recover at startup
+   * @return true if our db has data stored.
+   */
+  bool need_recovery();
+
+  /**
+   * Releases the snapshot taken for recovery, if one is held.
    */
-  bool need_checkpoint();
+  void release_recovery_snapshot();
 
   /**
    * Prunes stored flow files.
    */
   void prune_stored_flowfiles();
 
-  moodycamel::ConcurrentQueue<std::string> keys_to_delete;
+  /**
+   * Recovers the flow files whose keys fall in [lower, upper), enqueueing them into their
+   * connections in batches. An empty bound leaves that end of the range open.
+   * @param snapshot view of the database at startup
+   * @return number of flow files enqueued
+   */
+  uint64_t recover_range(const rocksdb::Snapshot *snapshot, const std::string &lower, const std::string &upper);
+
+  moodycamel::ConcurrentQueue<DeletedFlowFile> keys_to_delete;
   std::shared_ptr<core::ContentRepository> content_repo_;
   rocksdb::DB* db_;
-  std::unique_ptr<rocksdb::Checkpoint> checkpoint_;
+  // cache and write buffers shared with the other databases, must outlive db_
+  std::shared_ptr<RocksDbResources> rocksdb_resources_;
+  // view of the flow files stored at startup, held until they are recovered
+  const rocksdb::Snapshot *recovery_snapshot_;
+  // threads across which the key space is divided at startup
+  unsigned recovery_threads_;
   std::shared_ptr<logging::Logger> logger_;
 };
 
@@ -18,8 +18,13 @@
 
 #include "ProvenanceRepository.h"
 #include "rocksdb/write_batch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <string>
 #include <vector>
+#include "rocksdb/convenience.h"
 #include "rocksdb/options.h"
 #include "provenance/Provenance.h"
 namespace org {
@@ -28,57 +33,488 @@ namespace nifi {
 namespace minifi {
 namespace provenance {
 
+namespace {
+
+const size_t SEQUENCE_KEY_SIZE = 8;
+
+const size_t EVENT_TIME_SIZE = 8;
+
+const char *WATERMARK_KEY = "watermark";
+
+void appendBigEndian(std::string &key, uint64_t value, int bytes) {
+  for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+    key.push_back(static_cast<char>((value >> shift) & 0xFF));
+  }
+}
+
+uint64_t readBigEndian(const char *data, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) {
+    value = (value << 8) | static_cast<uint8_t>(data[i]);
+  }
+  return value;
+}
+
+/**
+ * Events are keyed by their sequence number in big endian, so that keys sort in the order
+ * events were stored. Every index key ends with the sequence key of the event it refers to.
+ */
+std::string sequenceKey(uint64_t sequence) {
+  std::string key;
+  appendBigEndian(key, sequence, SEQUENCE_KEY_SIZE);
+  return key;
+}
+
+// string keys are terminated so that one id is never a prefix of another
+std::string stringIndexPrefix(const std::string &value) {
+  return value + '\0';
+}
+
+std::string typeIndexPrefix(uint32_t type) {
+  std::string key;
+  appendBigEndian(key, type, 4);
+  return key;
+}
+
+std::string timeIndexPrefix(uint64_t time) {
+  std::string key;
+  appendBigEndian(key, time, EVENT_TIME_SIZE);
+  return key;
+}
+
+}  // namespace
+
+bool ProvenanceCompactionFilter::Filter(int level, const rocksdb::Slice &key, const rocksdb::Slice &existing_value, std::string *new_value, bool *value_changed) const {
+  uint64_t sequence = 0;
+  uint64_t event_time = 0;
+  bool timed = false;
+  switch (layout_) {
+    case EVENTS:
+      // events stored by earlier versions under their id are migrated upon opening
+      if (key.size() != SEQUENCE_KEY_SIZE) {
+        return false;
+      }
+      sequence = readBigEndian(key.data(), SEQUENCE_KEY_SIZE);
+      timed = ProvenanceEventRecord::readEventTime(reinterpret_cast<const uint8_t *>(existing_value.data()), existing_value.size(), event_time);
+      break;
+    case EVENT_ID_INDEX:
+      if (existing_value.size() < SEQUENCE_KEY_SIZE) {
+        return false;
+      }
+      sequence = readBigEndian(existing_value.data(), SEQUENCE_KEY_SIZE);
+      // entries written before the event time was indexed hold the sequence key alone
+      timed = existing_value.size() == SEQUENCE_KEY_SIZE + EVENT_TIME_SIZE;
+      if (timed) {
+        event_time = readBigEndian(existing_value.data() + SEQUENCE_KEY_SIZE, EVENT_TIME_SIZE);
+      }
+      break;
+    case INDEX:
+      if (key.size() < SEQUENCE_KEY_SIZE) {
+        return false;
+      }
+      sequence = readBigEndian(key.data() + key.size() - SEQUENCE_KEY_SIZE, SEQUENCE_KEY_SIZE);
+      timed = existing_value.size() == EVENT_TIME_SIZE;
+      if (timed) {
+        event_time = readBigEndian(existing_value.data(), EVENT_TIME_SIZE);
+      }
+      break;
+  }
+  if (sequence < watermark_.load()) {
+    return true;
+  }
+  if (timed && event_time < expiry_.load()) {
+    if (expired_bytes_ != nullptr) {
+      *expired_bytes_ += existing_value.size();
+    }
+    return true;
+  }
+  return false;
+}
+
+bool ProvenanceRepository::openDatabase(const rocksdb::Options &options) {
+  static const char *index_names[] = { "event_id", "flowfile", "component", "event_type", "event_time" };
+  std::vector<rocksdb::ColumnFamilyDescriptor> families;
+  rocksdb::ColumnFamilyOptions event_options(options);
+  event_options.compaction_filter = &event_filter_;
+  rocksdb::ColumnFamilyOptions event_id_options(options);
+  event_id_options.compaction_filter = &event_id_filter_;
+  rocksdb::ColumnFamilyOptions index_options(options);
+  index_options.compaction_filter = &index_filter_;
+  families.push_back(rocksdb::ColumnFamilyDescriptor(rocksdb::kDefaultColumnFamilyName, event_options));
+  for (const char *name : index_names) {
+    // the event id index maps to the sequence key, the others end with it
+    families.push_back(rocksdb::ColumnFamilyDescriptor(name, name == index_names[0] ? event_id_options : index_options));
+  }
+  families.push_back(rocksdb::ColumnFamilyDescriptor("metadata", rocksdb::ColumnFamilyOptions(options)));
+  rocksdb::Status status = rocksdb::DB::Open(rocksdb::DBOptions(options), directory_, families, &column_families_, &db_);
+  if (!status.ok()) {
+    logger_->log_error("NiFi Provenance Repository could not open %s: %s", directory_, status.ToString());
+    return false;
+  }
+  event_id_index_ = column_families_[1];
+  flowfile_index_ = column_families_[2];
+  component_index_ = column_families_[3];
+  event_type_index_ = column_families_[4];
+  event_time_index_ = column_families_[5];
+  metadata_ = column_families_[6];
+
+  std::string watermark;
+  if (db_->Get(rocksdb::ReadOptions(), metadata_, WATERMARK_KEY, &watermark).ok() && watermark.size() == SEQUENCE_KEY_SIZE) {
+    watermark_ = readBigEndian(watermark.data(), SEQUENCE_KEY_SIZE);
+  }
+
+  // sequence keys begin with a zero byte for the foreseeable future, so the last of them
+  // precedes \x01, from where on are the events that earlier versions keyed by their id
+  const rocksdb::Slice legacy_begin("\x01", 1);
+  std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+  it->Seek(legacy_begin);
+  if (it->Valid()) {
+    it->Prev();
+  } else {
+    it->SeekToLast();
+  }
+  if (it->Valid() && it->key().size() == SEQUENCE_KEY_SIZE) {
+    next_sequence_ = readBigEndian(it->key().data(), SEQUENCE_KEY_SIZE) + 1;
+  }
+  // when every event has been dropped, sequence numbers must still not be reused while
+  // index entries referring to them may remain
+  if (next_sequence_ < watermark_) {
+    next_sequence_ = watermark_.load();
+  }
+  if (!migrateLegacyEvents()) {
+    return false;
+  }
+  uint64_t live_size = 0;
+  if (db_->GetIntProperty("rocksdb.estimate-live-data-size", &live_size)) {
+    repo_size_ = live_size;
+  }
+  return true;
+}
+
+bool ProvenanceRepository::migrateLegacyEvents() {
+  static const uint64_t MIGRATION_BATCH_EVENTS = 1000;
+  rocksdb::WriteBatch batch;
+  uint64_t batched = 0;
+  uint64_t migrated = 0;
+  uint64_t discarded = 0;
+  std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+  for (it->Seek(rocksdb::Slice("\x01", 1)); it->Valid(); it->Next()) {
+    // each event moves to a sequence key in the same write that removes its old key
+    if (addEvent(batch, it->key().ToString(), reinterpret_cast<const uint8_t *>(it->value().data()), it->value().size())) {
+      migrated++;
+    } else {
+      discarded++;
+    }
+    batch.Delete(it->key());
+    if (++batched >= MIGRATION_BATCH_EVENTS) {
+      if (!db_->Write(rocksdb::WriteOptions(), &batch).ok()) {
+        logger_->log_error("Could not migrate provenance events stored without an index");
+        return false;
+      }
+      batch.Clear();
+      batched = 0;
+    }
+  }
+  if (batched > 0 && !db_->Write(rocksdb::WriteOptions(), &batch).ok()) {
+    logger_->log_error("Could not migrate provenance events stored without an index");
+    return false;
+  }
+  if (migrated > 0 || discarded > 0) {
+    logger_->log_info("Migrated %llu provenance events stored without an index, discarded %llu that could not be read", migrated, discarded);
+  }
+  return it->status().ok();
+}
+
+bool ProvenanceRepository::addEvent(rocksdb::WriteBatch &batch, const std::string &key, const uint8_t *buf, size_t bufLen) {
+  std::string event_id, component_id, flowfile_uuid;
+  uint32_t event_type = 0;
+  uint64_t event_time = 0;
+  if (!ProvenanceEventRecord::getIndexedFields(buf, bufLen, event_id, event_type, event_time, component_id, flowfile_uuid)) {
+    logger_->log_error("Could not index provenance event %s", key);
+    return false;
+  }
+  const std::string sequence_key = sequenceKey(next_sequence_++);
+  // index entries carry the event time, so that compaction can drop them once the event expires
+  const std::string time = timeIndexPrefix(event_time);
+  batch.Put(sequence_key, rocksdb::Slice(reinterpret_cast<const char *>(buf), bufLen));
+  batch.Put(event_id_index_, key, sequence_key + time);
+  batch.Put(flowfile_index_, stringIndexPrefix(flowfile_uuid) + sequence_key, time);
+  batch.Put(component_index_, stringIndexPrefix(component_id) + sequence_key, time);
+  batch.Put(event_type_index_, typeIndexPrefix(event_type) + sequence_key, time);
+  batch.Put(event_time_index_, time + sequence_key, time);
+  return true;
+}
+
+bool ProvenanceRepository::Put(std::string key, const uint8_t *buf, size_t bufLen) {
+  if (repo_full_) {
+    return false;
+  }
+  // persist the event and its index entries atomically
+  rocksdb::WriteBatch batch;
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  if (!addEvent(batch, key, buf, bufLen) || !db_->Write(rocksdb::WriteOptions(), &batch).ok()) {
+    return false;
+  }
+  repo_size_ += bufLen;
+  return true;
+}
+
+bool ProvenanceRepository::MultiPut(const std::vector<std::pair<std::string, std::unique_ptr<io::DataStream>>> &data) {
+  if (repo_full_) {
+    return false;
+  }
+  rocksdb::WriteBatch batch;
+  uint64_t size = 0;
+  bool indexed = true;
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  for (const auto &item : data) {
+    if (addEvent(batch, item.first, item.second->getBuffer(), item.second->getSize())) {
+      size += item.second->getSize();
+    } else {
+      indexed = false;
+    }
+  }
+  if (batch.Count() > 0 && !db_->Write(rocksdb::WriteOptions(), &batch).ok()) {
+    return false;
+  }
+  repo_size_ += size;
+  return indexed;
+}
+
+bool ProvenanceRepository::DeSerialize(std::vector<std::shared_ptr<core::SerializableComponent>> &records, size_t &max_size,
+                                       std::function<std::shared_ptr<core::SerializableComponent>()> lambda, std::string &cursor) {
+  std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+  if (cursor.empty()) {
+    it->SeekToFirst();
+  } else {
+    // sequence keys only grow and writes become visible in sequence order, so the events
+    // stored since the last read all follow the cursor
+    it->Seek(cursor);
+    if (it->Valid() && it->key() == cursor) {
+      it->Next();
+    }
+  }
+  const size_t requested_batch = max_size;
+  max_size = 0;
+  for (; it->Valid() && max_size < requested_batch; it->Next()) {
+    cursor = it->key().ToString();
+    std::shared_ptr<core::SerializableComponent> eventRead = lambda();
+    if (eventRead->DeSerialize(reinterpret_cast<const uint8_t *>(it->value().data()), it->value().size())) {
+      max_size++;
+      records.push_back(eventRead);
+    }
+  }
+  return max_size > 0;
+}
+
+bool ProvenanceRepository::Get(const std::string &key, std::string &value) {
+  std::string sequence_key;
+  if (!getSequenceKey(key, sequence_key)) {
+    return false;
+  }
+  return db_->Get(rocksdb::ReadOptions(), sequence_key, &value).ok();
+}
+
+bool ProvenanceRepository::getSequenceKey(const std::string &event_id, std::string &sequence_key) {
+  if (!db_->Get(rocksdb::ReadOptions(), event_id_index_, event_id, &sequence_key).ok() || sequence_key.size() < SEQUENCE_KEY_SIZE) {
+    return false;
+  }
+  // the event time follows
+  sequence_key.resize(SEQUENCE_KEY_SIZE);
+  return true;
+}
+
+uint64_t ProvenanceRepository::deleteEvent(rocksdb::WriteBatch &batch, const std::string &sequence_key, const std::string &value) {
+  batch.Delete(sequence_key);
+  std::string event_id, component_id, flowfile_uuid;
+  uint32_t event_type = 0;
+  uint64_t event_time = 0;
+  if (ProvenanceEventRecord::getIndexedFields(reinterpret_cast<const uint8_t *>(value.data()), value.size(), event_id, event_type, event_time, component_id, flowfile_uuid)) {
+    batch.Delete(event_id_index_, event_id);
+    batch.Delete(flowfile_index_, stringIndexPrefix(flowfile_uuid) + sequence_key);
+    batch.Delete(component_index_, stringIndexPrefix(component_id) + sequence_key);
+    batch.Delete(event_type_index_, typeIndexPrefix(event_type) + sequence_key);
+    batch.Delete(event_time_index_, timeIndexPrefix(event_time) + sequence_key);
+  }
+  return value.size();
+}
+
+bool ProvenanceRepository::getEventsInTimeRange(uint64_t begin, uint64_t end, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, size_t max_size, std::string &cursor) {
+  return queryIndex(event_time_index_, timeIndexPrefix(begin), timeIndexPrefix(end), records, max_size, cursor);
+}
+
+bool ProvenanceRepository::getEventsForFlowFile(const std::string &flowFileUuid, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, size_t max_size, std::string &cursor) {
+  return queryIndex(flowfile_index_, stringIndexPrefix(flowFileUuid), flowFileUuid + '\x01', records, max_size, cursor);
+}
+
+bool ProvenanceRepository::getEventsForComponent(const std::string &componentId, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, size_t max_size, std::string &cursor) {
+  return queryIndex(component_index_, stringIndexPrefix(componentId), componentId + '\x01', records, max_size, cursor);
+}
+
+bool ProvenanceRepository::getEventsOfType(ProvenanceEventRecord::ProvenanceEventType type, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, size_t max_size, std::string &cursor) {
+  return queryIndex(event_type_index_, typeIndexPrefix(type), typeIndexPrefix(type + 1), records, max_size, cursor);
+}
+
+bool ProvenanceRepository::queryIndex(rocksdb::ColumnFamilyHandle *index, const std::string &lower, const std::string &upper, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records,
+                                      size_t max_size, std::string &cursor) {
+  rocksdb::ReadOptions options;
+  rocksdb::Slice upper_bound(upper);
+  options.iterate_upper_bound = &upper_bound;
+  std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(options, index));
+  if (cursor > lower) {
+    it->Seek(cursor);
+    // the cursor is the last entry returned by the previous query
+    if (it->Valid() && it->key() == cursor) {
+      it->Next();
+    }
+  } else {
+    it->Seek(lower);
+  }
+
+  std::string value;
+  for (size_t found = 0; found < max_size && it->Valid(); it->Next()) {
+    rocksdb::Slice key = it->key();
+    if (key.size() < SEQUENCE_KEY_SIZE) {
+      continue;
+    }
+    cursor = key.ToString();
+    const rocksdb::Slice sequence_key(key.data() + key.size() - SEQUENCE_KEY_SIZE, SEQUENCE_KEY_SIZE);
+    if (!db_->Get(rocksdb::ReadOptions(), sequence_key, &value).ok()) {
+      continue;
+    }
+    std::shared_ptr<ProvenanceEventRecord> eventRead = std::make_shared<ProvenanceEventRecord>();
+    if (eventRead->DeSerialize(reinterpret_cast<const uint8_t *>(value.data()), value.size())) {
+      records.push_back(eventRead);
+      found++;
+    }
+  }
+  if (!it->Valid()) {
+    cursor.clear();
+  }
+  return it->status().ok();
+}
+
 void ProvenanceRepository::flush() {
   rocksdb::WriteBatch batch;
   std::string key;
+  std::string sequence_key;
   std::string value;
   rocksdb::ReadOptions options;
   uint64_t decrement_total = 0;
   while (keys_to_delete.size_approx() > 0) {
     if (keys_to_delete.try_dequeue(key)) {
-      db_->Get(options, key, &value);
-      decrement_total += value.size();
-      batch.Delete(key);
-      logger_->log_debug("Removing %s", key);
+      if (getSequenceKey(key, sequence_key) && db_->Get(options, sequence_key, &value).ok()) {
+        decrement_total += deleteEvent(batch, sequence_key, value);
+        logger_->log_debug("Removing %s", key);
+      }
     }
   }
   if (db_->Write(rocksdb::WriteOptions(), &batch).ok()) {
-    logger_->log_debug("Decrementing %u from a repo size of %u", decrement_total, repo_size_.load());
-    if (decrement_total > repo_size_.load()) {
-      repo_size_ = 0;
-    } else {
-      repo_size_ -= decrement_total;
+    decrementRepoSize(decrement_total);
+  }
+}
+
+void ProvenanceRepository::decrementRepoSize(uint64_t size) {
+  logger_->log_debug("Decrementing %u from a repo size of %u", size, repo_size_.load());
+  if (size > repo_size_.load()) {
+    repo_size_ = 0;
+  } else {
+    repo_size_ -= size;
+  }
+}
+
+uint64_t ProvenanceRepository::dropEventsBefore(uint64_t sequence) {
+  const uint64_t watermark = watermark_.load();
+  const uint64_t stored = next_sequence_.load() - watermark;
+  if (sequence <= watermark || stored == 0) {
+    return 0;
+  }
+  const std::string begin = sequenceKey(watermark);
+  const std::string end = sequenceKey(sequence);
+  rocksdb::WriteBatch batch;
+  batch.DeleteRange(db_->DefaultColumnFamily(), begin, end);
+  batch.Put(metadata_, WATERMARK_KEY, end);
+  if (!db_->Write(rocksdb::WriteOptions(), &batch).ok()) {
+    return 0;
+  }
+  watermark_ = sequence;
+
+  // files holding only dropped events are removed now instead of at their next compaction
+  const rocksdb::Slice begin_slice(begin), end_slice(end);
+  rocksdb::DeleteFilesInRange(db_, db_->DefaultColumnFamily(), &begin_slice, &end_slice);
+
+  // events are not sized individually here, so assume the dropped ones are of average size
+  const uint64_t dropped = std::min(sequence - watermark, stored);
+  const uint64_t size = repo_size_.load();
+  repo_size_ -= std::min<uint64_t>(size, size * (dropped / static_cast<double>(stored)));
+  logger_->log_debug("Dropped %llu provenance events below sequence %llu", dropped, sequence);
+  return dropped;
+}
+
+void ProvenanceRepository::expireEvents() {
+  const uint64_t now = getTimeMillis();
+  if (max_partition_millis_ <= 0 || now <= (uint64_t) max_partition_millis_) {
+    return;
+  }
+  expiry_ = now - max_partition_millis_;
+  // event times need not follow the order in which events were stored, so the time index tells
+  // which sequence numbers hold expired events. Only the keys of the index are read.
+  const std::string expiry = timeIndexPrefix(expiry_.load());
+  const rocksdb::Slice upper_bound(expiry);
+  rocksdb::ReadOptions options;
+  options.iterate_upper_bound = &upper_bound;
+  std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(options, event_time_index_));
+  uint64_t first = std::numeric_limits<uint64_t>::max();
+  uint64_t last = 0;
+  uint64_t expired = 0;
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    const rocksdb::Slice key = it->key();
+    if (key.size() == EVENT_TIME_SIZE + SEQUENCE_KEY_SIZE) {
+      const uint64_t sequence = readBigEndian(key.data() + EVENT_TIME_SIZE, SEQUENCE_KEY_SIZE);
+      first = std::min(first, sequence);
+      last = std::max(last, sequence);
+      expired++;
     }
   }
+
+  if (it->status().ok() && expired > 0) {
+    const std::string begin = sequenceKey(first);
+    const std::string end = sequenceKey(last + 1);
+    const rocksdb::Slice begin_slice(begin), end_slice(end);
+    rocksdb::CompactRangeOptions compact_options;
+    // compactions of the events being stored carry on meanwhile
+    compact_options.exclusive_manual_compaction = false;
+    // the filter drops the expired events of the range and keeps the others. An event stored
+    // with an expired time after the index was read is left to the compactions that rewrite it.
+    if (db_->CompactRange(compact_options, db_->DefaultColumnFamily(), &begin_slice, &end_slice).ok()
+        && db_->DeleteRange(rocksdb::WriteOptions(), event_time_index_, rocksdb::Slice(), upper_bound).ok()) {
+      logger_->log_debug("Expired %llu provenance events", expired);
+    }
+  }
+  // compaction may also have dropped expired events on its own
+  decrementRepoSize(expired_bytes_.exchange(0));
+}
+
+void ProvenanceRepository::trimEvents() {
+  const uint64_t size = getRepoSize();
+  if (max_partition_bytes_ <= 0 || size <= (uint64_t) max_partition_bytes_) {
+    return;
+  }
+  const uint64_t target = max_partition_bytes_ * 3 / 4;
+  const uint64_t watermark = watermark_.load();
+  const uint64_t stored = next_sequence_.load() - watermark;
+  // drop the oldest events in proportion to the excess
+  const uint64_t excess = std::ceil(stored * ((size - target) / static_cast<double>(size)));
+  dropEventsBefore(watermark + excess);
 }
 
 void ProvenanceRepository::run() {
   while (running_) {
     std::this_thread::sleep_for(std::chrono::milliseconds(purge_period_));
-    uint64_t curTime = getTimeMillis();
-    // threshold for purge
-    uint64_t purgeThreshold = max_partition_bytes_ * 3 / 4;
-
-    uint64_t size = getRepoSize();
-
-    if (size >= purgeThreshold) {
-      rocksdb::Iterator* it = db_->NewIterator(rocksdb::ReadOptions());
-      for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        ProvenanceEventRecord eventRead;
-        std::string key = it->key().ToString();
-        uint64_t eventTime = eventRead.getEventTime(reinterpret_cast<uint8_t*>(const_cast<char*>(it->value().data())), it->value().size());
-        if (eventTime > 0) {
-          if ((curTime - eventTime) > (uint64_t)max_partition_millis_)
-            Delete(key);
-        } else {
-          logger_->log_debug("NiFi Provenance retrieve event %s fail", key);
-          Delete(key);
-        }
-      }
-      delete it;
-    }
     flush();
-    size = getRepoSize();
+    expireEvents();
+    trimEvents();
+    uint64_t size = getRepoSize();
     if (size > (uint64_t)max_partition_bytes_)
       repo_full_ = true;
     else
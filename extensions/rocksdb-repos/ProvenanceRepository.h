@@ -17,10 +17,19 @@
 #ifndef LIBMINIFI_INCLUDE_PROVENANCE_PROVENANCEREPOSITORY_H_
 #define LIBMINIFI_INCLUDE_PROVENANCE_PROVENANCEREPOSITORY_H_
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "rocksdb/compaction_filter.h"
 #include "rocksdb/db.h"
 #include "rocksdb/options.h"
 #include "rocksdb/slice.h"
+#include "rocksdb/write_batch.h"
 #include "core/Repository.h"
+#include "RocksDbResources.h"
 #include "core/Core.h"
 #include "provenance/Provenance.h"
 #include "core/logging/LoggerConfiguration.h"
@@ -36,6 +45,46 @@ namespace provenance {
 #define MAX_PROVENANCE_ENTRY_LIFE_TIME (60000) // 1 minute
 #define PROVENANCE_PURGE_PERIOD (2500) // 2500 msec
 
+/**
+ * Drops stored events, and index entries, whose sequence number is below the watermark of the
+ * repository or whose event time precedes its expiry. Events thus cost little to remove: they
+ * are discarded when compaction next rewrites the files that hold them, rather than deleted one
+ * key at a time.
+ */
+class ProvenanceCompactionFilter : public rocksdb::CompactionFilter {
+ public:
+  enum Layout {
+    // the key is the sequence key and the value the serialized event
+    EVENTS,
+    // the value is the sequence key followed by the event time
+    EVENT_ID_INDEX,
+    // the key ends with the sequence key and the value is the event time
+    INDEX
+  };
+
+  /**
+   * @param expired_bytes if not null, incremented by the size of the values dropped for their event time
+   */
+  ProvenanceCompactionFilter(const std::atomic<uint64_t> &watermark, const std::atomic<uint64_t> &expiry, Layout layout, std::atomic<uint64_t> *expired_bytes = nullptr)
+      : watermark_(watermark),
+        expiry_(expiry),
+        layout_(layout),
+        expired_bytes_(expired_bytes) {
+  }
+
+  virtual bool Filter(int level, const rocksdb::Slice &key, const rocksdb::Slice &existing_value, std::string *new_value, bool *value_changed) const;
+
+  virtual const char *Name() const {
+    return "ProvenanceCompactionFilter";
+  }
+
+ private:
+  const std::atomic<uint64_t> &watermark_;
+  const std::atomic<uint64_t> &expiry_;
+  Layout layout_;
+  std::atomic<uint64_t> *expired_bytes_;
+};
+
 class ProvenanceRepository : public core::Repository, public std::enable_shared_from_this<ProvenanceRepository> {
  public:
 
@@ -52,14 +101,26 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
                        uint64_t purgePeriod = PROVENANCE_PURGE_PERIOD)
       : core::SerializableComponent(repo_name),
         Repository(repo_name.length() > 0 ? repo_name : core::getClassName<ProvenanceRepository>(), directory, maxPartitionMillis, maxPartitionBytes, purgePeriod),
+        next_sequence_(1),
+        watermark_(1),
+        expiry_(0),
+        expired_bytes_(0),
+        event_filter_(watermark_, expiry_, ProvenanceCompactionFilter::EVENTS, &expired_bytes_),
+        event_id_filter_(watermark_, expiry_, ProvenanceCompactionFilter::EVENT_ID_INDEX),
+        index_filter_(watermark_, expiry_, ProvenanceCompactionFilter::INDEX),
+        metadata_(nullptr),
+        event_id_index_(nullptr),
+        flowfile_index_(nullptr),
+        component_index_(nullptr),
+        event_type_index_(nullptr),
+        event_time_index_(nullptr),
         logger_(logging::LoggerFactory<ProvenanceRepository>::getLogger()) {
     db_ = NULL;
   }
 
   // Destructor
   virtual ~ProvenanceRepository() {
-    if (db_)
-      delete db_;
+    destroy();
   }
 
   virtual void flush();
@@ -92,11 +153,13 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
     }
     logger_->log_debug("NiFi Provenance Max Storage Time: [%d] ms", max_partition_millis_);
     rocksdb::Options options;
+    rocksdb_resources_ = core::repository::RocksDbResources::getInstance(config);
+    rocksdb_resources_->configure(options);
     options.create_if_missing = true;
     options.use_direct_io_for_flush_and_compaction = true;
     options.use_direct_reads = true;
-    rocksdb::Status status = rocksdb::DB::Open(options, directory_, &db_);
-    if (status.ok()) {
+    options.create_missing_column_families = true;
+    if (openDatabase(options)) {
       logger_->log_debug("NiFi Provenance Repository database open %s success", directory_);
     } else {
       logger_->log_error("NiFi Provenance Repository database open %s fail", directory_);
@@ -105,35 +168,23 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
 
     return true;
   }
-  // Put
-  virtual bool Put(std::string key, const uint8_t *buf, size_t bufLen) {
-    if (repo_full_) {
-      return false;
-    }
+  /**
+   * Stores the event under the next sequence number, so that events are kept in the order
+   * they were stored, and adds it to the indices.
+   */
+  virtual bool Put(std::string key, const uint8_t *buf, size_t bufLen);
 
-    // persist to the DB
-    rocksdb::Slice value((const char *) buf, bufLen);
-    rocksdb::Status status;
-    status = db_->Put(rocksdb::WriteOptions(), key, value);
-    if (status.ok())
-      return true;
-    else
-      return false;
-  }
+  /**
+   * Stores the events and their index entries in a single write.
+   */
+  virtual bool MultiPut(const std::vector<std::pair<std::string, std::unique_ptr<io::DataStream>>> &data);
   // Delete
   virtual bool Delete(std::string key) {
     keys_to_delete.enqueue(key);
     return true;
   }
-  // Get
-  virtual bool Get(const std::string &key, std::string &value) {
-    rocksdb::Status status;
-    status = db_->Get(rocksdb::ReadOptions(), key, &value);
-    if (status.ok())
-      return true;
-    else
-      return false;
-  }
+  // Get the event with the given event id
+  virtual bool Get(const std::string &key, std::string &value);
 
   // Remove event
   void removeEvent(ProvenanceEventRecord *event) {
@@ -183,6 +234,9 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
       return false;
     }
   }
+  virtual bool DeSerialize(std::vector<std::shared_ptr<core::SerializableComponent>> &records, size_t &max_size, std::function<std::shared_ptr<core::SerializableComponent>()> lambda,
+                           std::string &cursor);
+
   //! get record
   void getProvenanceRecord(std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, int maxSize) {
     rocksdb::Iterator* it = db_->NewIterator(rocksdb::ReadOptions());
@@ -225,8 +279,41 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
     }
     flush();
   }
+  /**
+   * Queries for events whose event time falls in [begin, end), in event time order.
+   * @param begin start of the range in milliseconds since the epoch
+   * @param end end of the range in milliseconds since the epoch
+   * @param records vector to which at most max_size events are appended
+   * @param cursor position at which to resume, empty to start from the beginning. Upon return
+   * it is the position following the events returned, or empty if no events remain.
+   * @return true if the index could be read
+   */
+  bool getEventsInTimeRange(uint64_t begin, uint64_t end, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, size_t max_size, std::string &cursor);
+
+  /**
+   * Queries for the events of a flow file, in the order they were stored.
+   * @see getEventsInTimeRange for the meaning of records, max_size and cursor
+   */
+  bool getEventsForFlowFile(const std::string &flowFileUuid, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, size_t max_size, std::string &cursor);
+
+  /**
+   * Queries for the events reported by a component, in the order they were stored.
+   * @see getEventsInTimeRange for the meaning of records, max_size and cursor
+   */
+  bool getEventsForComponent(const std::string &componentId, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, size_t max_size, std::string &cursor);
+
+  /**
+   * Queries for the events of a given type, in the order they were stored.
+   * @see getEventsInTimeRange for the meaning of records, max_size and cursor
+   */
+  bool getEventsOfType(ProvenanceEventRecord::ProvenanceEventType type, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, size_t max_size, std::string &cursor);
+
   // destroy
   void destroy() {
+    for (auto handle : column_families_) {
+      delete handle;
+    }
+    column_families_.clear();
     if (db_) {
       delete db_;
       db_ = NULL;
@@ -241,8 +328,100 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
   ProvenanceRepository &operator=(const ProvenanceRepository &parent) = delete;
 
  private:
+
+  /**
+   * Opens the database along with the column families of its indices, migrating events
+   * stored by earlier versions under their event ids.
+   */
+  bool openDatabase(const rocksdb::Options &options);
+
+  /**
+   * Stores the events that earlier versions keyed by their event id under sequence keys, adds
+   * them to the indices and removes their old keys. Events that cannot be read are discarded.
+   * @return false if the migrated events could not be written
+   */
+  bool migrateLegacyEvents();
+
+  /**
+   * Drops the events whose sequence number is below sequence with a range deletion and raises
+   * the watermark to it, so that compaction discards their index entries.
+   * @param sequence new watermark, ignored unless above the current one
+   * @return number of events dropped
+   */
+  uint64_t dropEventsBefore(uint64_t sequence);
+
+  /**
+   * Raises the expiry to the maximum storage time ago and compacts the range of sequence numbers
+   * that holds the events the time index lists as expired, so that the compaction filter drops
+   * them. The expired entries of the time index are then removed with a range deletion, while
+   * those of the other indices are left to the compaction filter.
+   */
+  void expireEvents();
+
+  /**
+   * Subtracts the size of deleted events from the repository size, without dropping below zero.
+   */
+  void decrementRepoSize(uint64_t size);
+
+  /**
+   * Drops the oldest events once the repository exceeds its maximum size, until it is
+   * three quarters full.
+   */
+  void trimEvents();
+
+  /**
+   * Reads the sequence key under which the event with the given id is stored.
+   */
+  bool getSequenceKey(const std::string &event_id, std::string &sequence_key);
+
+  /**
+   * Adds the deletion of a stored event and of its index entries to batch.
+   * @return size of the deleted event, or 0 if it could not be read
+   */
+  uint64_t deleteEvent(rocksdb::WriteBatch &batch, const std::string &sequence_key, const std::string &value);
+
+  /**
+   * Adds an event and its index entries to batch under the next sequence number.
+   * @return false if the event could not be indexed
+   */
+  bool addEvent(rocksdb::WriteBatch &batch, const std::string &key, const uint8_t *buf, size_t bufLen);
+
+  /**
+   * Reads up to max_size events referenced by the entries of index in [lower, upper), resuming after cursor.
+   */
+  bool queryIndex(rocksdb::ColumnFamilyHandle *index, const std::string &lower, const std::string &upper, std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, size_t max_size,
+                  std::string &cursor);
+
   moodycamel::ConcurrentQueue<std::string> keys_to_delete;
   rocksdb::DB* db_;
+  // sequence number under which the next event is stored
+  std::atomic<uint64_t> next_sequence_;
+  // held from taking sequence numbers until their write completes, so that events become
+  // visible in sequence order and readers resuming from a cursor never skip one
+  std::mutex write_mutex_;
+  // events below this sequence number have been dropped
+  std::atomic<uint64_t> watermark_;
+  // events whose time precedes this, in milliseconds since the epoch, have expired
+  std::atomic<uint64_t> expiry_;
+  // size of the events that compaction dropped for their time, yet to be subtracted from the repository size
+  std::atomic<uint64_t> expired_bytes_;
+  // compaction filters of the column families, must outlive db_
+  ProvenanceCompactionFilter event_filter_;
+  ProvenanceCompactionFilter event_id_filter_;
+  ProvenanceCompactionFilter index_filter_;
+  // holds the watermark across restarts
+  rocksdb::ColumnFamilyHandle *metadata_;
+  // event id to sequence key and event time
+  rocksdb::ColumnFamilyHandle *event_id_index_;
+  // flow file uuid, component id, event type and event time, each followed by the sequence key,
+  // to the event time
+  rocksdb::ColumnFamilyHandle *flowfile_index_;
+  rocksdb::ColumnFamilyHandle *component_index_;
+  rocksdb::ColumnFamilyHandle *event_type_index_;
+  rocksdb::ColumnFamilyHandle *event_time_index_;
+  std::vector<rocksdb::ColumnFamilyHandle*> column_families_;
+  // cache and write buffers shared with the other databases, must outlive db_
+  std::shared_ptr<core::repository::RocksDbResources> rocksdb_resources_;
   std::shared_ptr<logging::Logger> logger_;
 };
 
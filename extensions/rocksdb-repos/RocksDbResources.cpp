@@ -0,0 +1,102 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "RocksDbResources.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include "rocksdb/env.h"
+#include "rocksdb/table.h"
+#include "core/Property.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+namespace repository {
+
+std::mutex RocksDbResources::instance_mutex_;
+std::weak_ptr<RocksDbResources> RocksDbResources::instance_;
+
+std::shared_ptr<RocksDbResources> RocksDbResources::getInstance(const std::shared_ptr<Configure> &configure) {
+  std::lock_guard<std::mutex> lock(instance_mutex_);
+  std::shared_ptr<RocksDbResources> instance = instance_.lock();
+  if (nullptr == instance) {
+    instance = std::shared_ptr<RocksDbResources>(new RocksDbResources(configure));
+    instance_ = instance;
+  }
+  return instance;
+}
+
+RocksDbResources::RocksDbResources(const std::shared_ptr<Configure> &configure)
+    : block_cache_size_(ROCKSDB_DEFAULT_BLOCK_CACHE_SIZE),
+      write_buffer_limit_(ROCKSDB_DEFAULT_WRITE_BUFFER_LIMIT),
+      compaction_threads_(ROCKSDB_DEFAULT_COMPACTION_THREADS),
+      flush_threads_(ROCKSDB_DEFAULT_FLUSH_THREADS),
+      logger_(logging::LoggerFactory<RocksDbResources>::getLogger()) {
+  std::string value;
+  if (nullptr != configure) {
+    int64_t size = 0;
+    if (configure->get(Configure::nifi_rocksdb_block_cache_size, value)) {
+      if (Property::StringToInt(value, size) && size > 0) {
+        block_cache_size_ = size;
+      } else {
+        logger_->log_warn("Invalid RocksDB block cache size %s, using %llu bytes", value, block_cache_size_);
+      }
+    }
+    uint64_t limit = 0;
+    if (configure->get(Configure::nifi_rocksdb_write_buffer_limit, value) && Property::StringToInt(value, limit) && limit > 0) {
+      write_buffer_limit_ = limit;
+    }
+    int32_t threads = 0;
+    if (configure->get(Configure::nifi_rocksdb_compaction_threads, value) && Property::StringToInt(value, threads) && threads > 0) {
+      compaction_threads_ = threads;
+    }
+    if (configure->get(Configure::nifi_rocksdb_flush_threads, value) && Property::StringToInt(value, threads) && threads > 0) {
+      flush_threads_ = threads;
+    }
+  }
+  block_cache_ = rocksdb::NewLRUCache(block_cache_size_);
+  write_buffer_manager_ = std::make_shared<rocksdb::WriteBufferManager>(write_buffer_limit_);
+  // the default Env is process wide, so its pools are shared by every database using it
+  rocksdb::Env::Default()->SetBackgroundThreads(compaction_threads_, rocksdb::Env::LOW);
+  rocksdb::Env::Default()->SetBackgroundThreads(flush_threads_, rocksdb::Env::HIGH);
+  logger_->log_debug("RocksDB block cache %llu bytes, write buffer limit %llu bytes, %d compaction and %d flush threads", block_cache_size_, write_buffer_limit_, compaction_threads_,
+                     flush_threads_);
+}
+
+void RocksDbResources::configure(rocksdb::Options &options) const {
+  options.env = rocksdb::Env::Default();
+  options.max_background_jobs = compaction_threads_ + flush_threads_;
+  options.write_buffer_manager = write_buffer_manager_;
+  // keep a single memtable from claiming the whole budget before the manager forces a flush
+  options.write_buffer_size = std::max<size_t>(ROCKSDB_MIN_WRITE_BUFFER_SIZE, write_buffer_limit_ / 4);
+
+  rocksdb::BlockBasedTableOptions table_options;
+  table_options.block_cache = block_cache_;
+  // index and filter blocks would otherwise be held outside of the cache for every open table
+  table_options.cache_index_and_filter_blocks = true;
+  options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+}
+
+} /* namespace repository */
+} /* namespace core */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
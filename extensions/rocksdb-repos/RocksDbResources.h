@@ -0,0 +1,105 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EXTENSIONS_ROCKSDB_REPOS_ROCKSDBRESOURCES_H_
+#define EXTENSIONS_ROCKSDB_REPOS_ROCKSDBRESOURCES_H_
+
+#include <memory>
+#include <mutex>
+#include "rocksdb/cache.h"
+#include "rocksdb/options.h"
+#include "rocksdb/write_buffer_manager.h"
+#include "properties/Configure.h"
+#include "core/logging/LoggerConfiguration.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+namespace repository {
+
+#define ROCKSDB_DEFAULT_BLOCK_CACHE_SIZE (8*1024*1024) // 8M
+#define ROCKSDB_DEFAULT_WRITE_BUFFER_LIMIT (16*1024*1024) // 16M
+#define ROCKSDB_MIN_WRITE_BUFFER_SIZE (1024*1024) // 1M
+#define ROCKSDB_DEFAULT_COMPACTION_THREADS (1)
+#define ROCKSDB_DEFAULT_FLUSH_THREADS (1)
+
+/**
+ * Purpose: Memory and threads shared by every RocksDB database the agent opens.
+ *
+ * Design: The first repository to open a database creates the instance from its configuration,
+ * and the rest share it until the last of them releases it. All databases use the default Env,
+ * whose background thread pools are sized here, one LRU block cache that also holds index and
+ * filter blocks, and one WriteBufferManager that flushes memtables once together they reach the
+ * write buffer limit. Neither is a hard cap: the cache may exceed its capacity while its blocks are
+ * pinned, and memtables keep growing while a flush is pending.
+ */
+class RocksDbResources {
+ public:
+
+  /**
+   * Returns the shared resources, creating them from configure if no database holds them.
+   * @param configure agent configuration, may be null to use the defaults.
+   */
+  static std::shared_ptr<RocksDbResources> getInstance(const std::shared_ptr<Configure> &configure);
+
+  /**
+   * Points options at the shared environment, block cache and write buffer manager.
+   */
+  void configure(rocksdb::Options &options) const;
+
+  std::shared_ptr<rocksdb::Cache> getBlockCache() const {
+    return block_cache_;
+  }
+
+  std::shared_ptr<rocksdb::WriteBufferManager> getWriteBufferManager() const {
+    return write_buffer_manager_;
+  }
+
+  uint64_t getBlockCacheSize() const {
+    return block_cache_size_;
+  }
+
+  uint64_t getWriteBufferLimit() const {
+    return write_buffer_limit_;
+  }
+
+ private:
+
+  explicit RocksDbResources(const std::shared_ptr<Configure> &configure);
+
+  uint64_t block_cache_size_;
+  uint64_t write_buffer_limit_;
+  int compaction_threads_;
+  int flush_threads_;
+  std::shared_ptr<rocksdb::Cache> block_cache_;
+  std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager_;
+  std::shared_ptr<logging::Logger> logger_;
+
+  static std::mutex instance_mutex_;
+  static std::weak_ptr<RocksDbResources> instance_;
+};
+
+} /* namespace repository */
+} /* namespace core */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+
+#endif /* EXTENSIONS_ROCKSDB_REPOS_ROCKSDBRESOURCES_H_ */
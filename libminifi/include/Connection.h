@@ -143,6 +143,12 @@ class Connection : public core::Connectable, public std::enable_shared_from_this
   }
   // Put the flow file into queue
   void put(std::shared_ptr<core::FlowFile> flow);
+  /**
+   * Puts a batch of flow files into the queue, acquiring the queue lock and notifying
+   * the destination once for the entire batch.
+   * @param flows flow files to enqueue
+   */
+  void multiPut(std::vector<std::shared_ptr<core::FlowFile>> &flows);
   // Poll the flow file from queue, the expired flow file record also being returned
   std::shared_ptr<core::FlowFile> poll(std::set<std::shared_ptr<core::FlowFile>> &expiredFlowRecords);
   // Drain the flow records
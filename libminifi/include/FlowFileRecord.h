@@ -46,6 +46,13 @@ namespace minifi {
 
 #define DEFAULT_FLOWFILE_PATH "."
 
+/**
+ * Serialized records that begin with this byte use the compact format. Records in the
+ * original format begin with a big endian millisecond timestamp, whose first byte is zero.
+ */
+#define FLOWFILE_RECORD_COMPACT_MARKER 0xF1
+#define FLOWFILE_RECORD_COMPACT_VERSION 1
+
 // FlowFile Attribute
 enum FlowAttribute {
   // The flowfile's path indicates the relative directory to which a FlowFile belongs and does not contain the filename
@@ -69,7 +76,8 @@ enum FlowAttribute {
   MAX_FLOW_ATTRIBUTES
 };
 
-// FlowFile Attribute Key
+// FlowFile Attribute Key. The compact record format refers to these keys by index, so
+// new keys may only be appended.
 static const char *FlowAttributeKeyArray[MAX_FLOW_ATTRIBUTES] = { "path", "absolute.path", "filename", "uuid", "priority", "mime.type", "discard.reason", "alternate.identifier", "flow.id" };
 
 // FlowFile Attribute Enum to Key
@@ -134,6 +142,12 @@ class FlowFileRecord : public core::FlowFile, public io::Serializable {
 
   //! Serialize and Persistent to the repository
   bool Serialize();
+  /**
+   * Serializes this record in the compact format, without persisting it.
+   * @param outStream stream to which the record is written
+   * @return true if the record was written.
+   */
+  bool Serialize(io::DataStream &outStream);
   //! DeSerialize
   bool DeSerialize(const uint8_t *buffer, const int bufferSize);
   //! DeSerialize
@@ -177,6 +191,38 @@ class FlowFileRecord : public core::FlowFile, public io::Serializable {
 
  protected:
 
+  // flags of the compact format, describing how the fields that follow are encoded
+  enum CompactFlags {
+    // the flow file uuid is written as 16 bytes
+    BINARY_UUID = 1,
+    // the connection uuid is written as 16 bytes
+    BINARY_CONNECTION_UUID = 2,
+    // the content path is relative to the storage path of the content repository
+    RELATIVE_CONTENT_PATH = 4
+  };
+
+  /**
+   * Writes uuid as 16 bytes if it survives a round trip through its binary form.
+   * @return true if it was written in binary form.
+   */
+  bool writeBinaryUuid(const std::string &uuid, io::DataStream &outStream);
+
+  /**
+   * Reads a uuid written as 16 bytes into uuid.
+   */
+  bool readBinaryUuid(std::string &uuid, io::DataStream &inStream);
+
+  /**
+   * Deserializes a record written in the compact format.
+   */
+  bool DeSerializeCompact(io::DataStream &inStream);
+
+  /**
+   * Deserializes a record written in the original format, which used fixed width
+   * timestamps and UTF strings throughout.
+   */
+  bool DeSerializeLegacy(io::DataStream &inStream);
+
   // connection uuid
   std::string uuid_connection_;
   // Full path to the content
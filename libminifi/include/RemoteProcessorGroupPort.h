@@ -20,6 +20,7 @@
 #ifndef __REMOTE_PROCESSOR_GROUP_PORT_H__
 #define __REMOTE_PROCESSOR_GROUP_PORT_H__
 
+#include <atomic>
 #include <mutex>
 #include <memory>
 #include <stack>
@@ -29,6 +30,7 @@
 #include "core/Processor.h"
 #include "core/ProcessSession.h"
 #include "sitetosite/SiteToSiteClient.h"
+#include "sitetosite/PeerSelector.h"
 #include "io/StreamFactory.h"
 #include "controllers/SSLContextService.h"
 #include "core/logging/LoggerConfiguration.h"
@@ -38,6 +40,9 @@ namespace apache {
 namespace nifi {
 namespace minifi {
 
+// time a peer is skipped after a transfer to it failed, as in NiFi
+#define PEER_PENALIZATION_PERIOD (30000)
+
 /**
  * Count down latch implementation that's used across
  * all threads of the RPG. This is okay since the latch increments
@@ -86,13 +91,17 @@ class RemoteProcessorGroupPort : public core::Processor {
         timeout_(0),
         http_enabled_(false),
         bypass_rest_api_(false),
+        use_compression_(false),
+        max_in_flight_transactions_(1),
+        peer_count_(0),
+        last_peer_refresh_ms_(0),
+        peer_refresh_period_ms_(60000),
         ssl_service(nullptr),
         logger_(logging::LoggerFactory<RemoteProcessorGroupPort>::getLogger()) {
     client_type_ = sitetosite::CLIENT_TYPE::RAW;
     stream_factory_ = stream_factory;
     protocol_uuid_ = uuid;
     site2site_secure_ = false;
-    peer_index_ = -1;
     // REST API port and host
     setURL(url);
   }
@@ -108,6 +117,9 @@ class RemoteProcessorGroupPort : public core::Processor {
   static core::Property SSLContext;
   static core::Property port;
   static core::Property portUUID;
+  static core::Property useCompression;
+  static core::Property maxInFlightTransactions;
+  static core::Property peerRefreshPeriod;
   // Supported Relationships
   static core::Relationship relation;
  public:
@@ -169,8 +181,8 @@ class RemoteProcessorGroupPort : public core::Processor {
   // refresh remoteSite2SiteInfo via nifi rest api
   std::pair<std::string, int> refreshRemoteSite2SiteInfo();
 
-  // refresh site2site peer list
-  void refreshPeerList();
+  // refresh site2site peer list, returns true if the peers were replaced
+  bool refreshPeerList();
 
   virtual void notifyStop();
 
@@ -197,6 +209,29 @@ class RemoteProcessorGroupPort : public core::Processor {
   std::unique_ptr<sitetosite::SiteToSiteClient> getNextProtocol(bool create);
   void returnProtocol(std::unique_ptr<sitetosite::SiteToSiteClient> protocol);
 
+  /**
+   * Sends flow files in up to max_in_flight_transactions_ transactions at once: while the oldest
+   * transaction awaits its confirmation, the next ones send their data over other connections.
+   * Each transaction has its own session, which is committed once the transaction completes
+   * and rolled back if it fails.
+   */
+  void transferPipelined(const std::shared_ptr<core::ProcessContext> &context);
+
+  /**
+   * Penalizes the peer of a protocol whose transfer failed, so that new protocols are
+   * created to the other peers until the penalization period has passed.
+   */
+  void penalize(const std::unique_ptr<sitetosite::SiteToSiteClient> &protocol);
+
+  // most protocols kept for reuse
+  size_t getMaxProtocols() const;
+
+  /**
+   * Closes the pooled protocols whose peer is no longer among peers_, keeping the others for
+   * reuse. Must be called while holding peer_mutex_.
+   */
+  void retainListedProtocols();
+
   moodycamel::ConcurrentQueue<std::unique_ptr<sitetosite::SiteToSiteClient>> available_protocols_;
 
   std::shared_ptr<Configure> configure_;
@@ -220,12 +255,23 @@ class RemoteProcessorGroupPort : public core::Processor {
 
   bool bypass_rest_api_;
 
+  // whether data packets sent over raw site to site are compressed
+  bool use_compression_;
+
+  // send transactions kept in flight at once, each on its own connection
+  uint32_t max_in_flight_transactions_;
+
   sitetosite::CLIENT_TYPE client_type_;
 
   // Remote Site2Site Info
   bool site2site_secure_;
   std::vector<sitetosite::PeerStatus> peers_;
-  std::atomic<int> peer_index_;
+  // size of peers_, read without holding peer_mutex_
+  std::atomic<size_t> peer_count_;
+  // selects the peers of new protocols by the flow files queued on them
+  sitetosite::PeerSelector peer_selector_;
+  std::atomic<uint64_t> last_peer_refresh_ms_;
+  uint64_t peer_refresh_period_ms_;
   std::mutex peer_mutex_;
   std::string rest_user_name_;
   std::string rest_password_;
@@ -0,0 +1,92 @@
+/**
+ * @file RootGroupPort.h
+ * RootGroupPort class declaration
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_ROOTGROUPPORT_H_
+#define LIBMINIFI_INCLUDE_ROOTGROUPPORT_H_
+
+#include <memory>
+#include <string>
+#include "core/Processor.h"
+#include "core/ProcessSession.h"
+#include "core/logging/LoggerConfiguration.h"
+#include "properties/Configure.h"
+#include "sitetosite/SiteToSiteServer.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+
+/**
+ * Input or output port of the root process group, which other instances send flow files to or
+ * receive them from over site to site. The transfers are served by the site to site server of
+ * the agent, into and out of the connections of the port.
+ */
+class RootGroupPort : public core::Processor {
+ public:
+  RootGroupPort(std::string name, const std::shared_ptr<Configure> &configure, utils::Identifier uuid = utils::Identifier())
+      : core::Processor(name, uuid),
+        configure_(configure),
+        direction_(sitetosite::SEND),
+        logger_(logging::LoggerFactory<RootGroupPort>::getLogger()) {
+  }
+  virtual ~RootGroupPort() {
+    notifyStop();
+  }
+
+  // Processor Name
+  static const char *ProcessorName;
+  // Supported Relationships
+  static core::Relationship relation;
+
+  virtual void initialize(void);
+
+  virtual void onSchedule(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory);
+
+  virtual void onTrigger(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session);
+
+  /**
+   * Sets the direction of the transfers: SEND for input ports, which instances send to,
+   * RECEIVE for output ports.
+   */
+  void setDirection(sitetosite::TransferDirection direction) {
+    direction_ = direction;
+  }
+
+  sitetosite::TransferDirection getDirection() const {
+    return direction_;
+  }
+
+ protected:
+  virtual void notifyStop();
+
+ private:
+  std::shared_ptr<Configure> configure_;
+  sitetosite::TransferDirection direction_;
+  std::mutex mutex_;
+  std::shared_ptr<sitetosite::SiteToSiteServer> server_;
+  std::shared_ptr<logging::Logger> logger_;
+};
+
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+
+#endif /* LIBMINIFI_INCLUDE_ROOTGROUPPORT_H_ */
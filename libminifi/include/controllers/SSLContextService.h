@@ -24,8 +24,12 @@
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 #endif
+#include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 #include "core/Resource.h"
 #include "utils/StringUtils.h"
 #include "io/validation.h"
@@ -57,12 +61,59 @@ class SSLContext {
     }
 #endif
   }
+#ifdef OPENSSL_SUPPORT
+  SSL_CTX *getContext() const {
+    return context_;
+  }
+#endif
  protected:
 #ifdef OPENSSL_SUPPORT
   SSL_CTX *context_;
 #endif
 };
 
+#ifdef OPENSSL_SUPPORT
+/**
+ * Keeps the last session negotiated with each peer, so that the next connection
+ * to it can resume the session instead of performing a full handshake.
+ */
+class SSLSessionCache {
+ public:
+  SSLSessionCache() = default;
+
+  ~SSLSessionCache();
+
+  /**
+   * Configures the client context so that its sessions may be cached and resumed.
+   */
+  static void enableResumption(SSL_CTX *ctx);
+
+  /**
+   * Offers the session last negotiated with the peer, if any, on a connection
+   * that is yet to perform its handshake.
+   */
+  void resume(SSL *ssl, const std::string &host, uint16_t port);
+
+  /**
+   * Keeps the session of a connection whose handshake has completed.
+   */
+  void save(SSL *ssl, const std::string &host, uint16_t port);
+
+  void remove(const std::string &host, uint16_t port);
+
+  void clear();
+
+  size_t size();
+
+  SSLSessionCache(const SSLSessionCache &other) = delete;
+  SSLSessionCache &operator=(const SSLSessionCache &other) = delete;
+
+ private:
+  std::mutex mutex_;
+  std::map<std::string, SSL_SESSION*> sessions_;
+};
+#endif
+
 /**
  * SSLContextService provides a configurable controller service from
  * which we can provide an SSL Context or component parts that go
@@ -122,6 +173,22 @@ class SSLContextService : public core::controller::ControllerService {
 
   std::unique_ptr<SSLContext> createSSLContext();
 
+#ifdef OPENSSL_SUPPORT
+  /**
+   * Returns the client context shared by the connections made through this service, creating
+   * it on first use. Sharing it avoids loading the certificates for every connection.
+   * @param create configures a new client context, returning nullptr if it failed to
+   * @return shared context or nullptr if it could not be created, in which case the next call
+   * attempts to create it again
+   */
+  std::shared_ptr<SSLContext> getSharedContext(const std::function<SSL_CTX*()> &create);
+
+  /**
+   * Returns the sessions negotiated by connections made through this service.
+   */
+  std::shared_ptr<SSLSessionCache> getSessionCache();
+#endif
+
   const std::string &getCertificateFile();
 
   const std::string &getPassphrase();
@@ -210,6 +277,12 @@ class SSLContextService : public core::controller::ControllerService {
   std::string passphrase_file_;
   std::string ca_certificate_;
 
+#ifdef OPENSSL_SUPPORT
+  std::mutex context_mutex_;
+  std::shared_ptr<SSLContext> shared_context_;
+  std::shared_ptr<SSLSessionCache> session_cache_;
+#endif
+
  private:
   std::shared_ptr<logging::Logger> logger_;
 };
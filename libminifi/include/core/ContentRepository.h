@@ -76,6 +76,24 @@ class ContentRepository : public StreamManager<minifi::ResourceClaim> {
     }
   }
 
+  /**
+   * Removes each of the claims that are orphaned, acquiring the count lock once for the
+   * entire batch rather than once per claim. As in removeIfOrphaned, the claims are removed
+   * under the lock so that no stream can claim them between the check and the removal.
+   */
+  virtual void removeOrphans(const std::vector<std::shared_ptr<minifi::ResourceClaim>> &claims) {
+    std::lock_guard<std::mutex> lock(count_map_mutex_);
+    for (const auto &claim : claims) {
+      auto count = count_map_.find(claim->getContentFullPath());
+      if (count == count_map_.end()) {
+        remove(claim);
+      } else if (count->second == 0) {
+        remove(claim);
+        count_map_.erase(count);
+      }
+    }
+  }
+
   virtual uint32_t getStreamCount(const std::shared_ptr<minifi::ResourceClaim> &streamId) {
     std::lock_guard<std::mutex> lock(count_map_mutex_);
     auto cnt = count_map_.find(streamId->getContentFullPath());
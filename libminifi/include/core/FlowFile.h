@@ -281,8 +281,21 @@ class FlowFile : public core::Connectable {
     return stored;
   }
 
+  /**
+   * Sets the size of the value last persisted for this flow file.
+   */
+  void setStoredSize(uint64_t stored_size) {
+    stored_size_ = stored_size;
+  }
+
+  uint64_t getStoredSize() {
+    return stored_size_;
+  }
+
  protected:
   bool stored;
+  // size of the value last persisted to the flow file repository
+  uint64_t stored_size_;
   // Mark for deletion
   bool marked_delete_;
   // Date at which the flow file entered the flow
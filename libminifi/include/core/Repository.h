@@ -24,11 +24,14 @@
 #include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 #include "core/ContentRepository.h"
 #include "core/SerializableComponent.h"
@@ -48,6 +51,9 @@ namespace org {
 namespace apache {
 namespace nifi {
 namespace minifi {
+namespace provenance {
+class ProvenancePolicy;
+} /* namespace provenance */
 namespace core {
 
 #define REPOSITORY_DIRECTORY "./repo"
@@ -90,19 +96,55 @@ class Repository : public virtual core::SerializableComponent, public core::Trac
   virtual bool Put(std::string key, const uint8_t *buf, size_t bufLen) {
     return true;
   }
+  /**
+   * Stores several values at once. Repositories that can persist them in a single write
+   * should override this; the base implementation puts each in turn.
+   * @param data pairs of keys and the streams holding their values
+   * @return true if every value was stored
+   */
+  virtual bool MultiPut(const std::vector<std::pair<std::string, std::unique_ptr<io::DataStream>>> &data) {
+    bool stored = true;
+    for (const auto &item : data) {
+      stored &= Put(item.first, item.second->getBuffer(), item.second->getSize());
+    }
+    return stored;
+  }
   // Delete
   virtual bool Delete(std::string key) {
     return true;
   }
 
+  /**
+   * Deletes the key, providing the resource claim referenced by its value and the size
+   * of its value so that repositories need not read the value back to release them.
+   * @param key key to delete
+   * @param claim resource claim referenced by the stored value, may be null
+   * @param size size of the stored value, zero if it was never stored
+   */
+  virtual bool Delete(const std::string &key, const std::shared_ptr<minifi::ResourceClaim> &claim, uint64_t size) {
+    return Delete(key);
+  }
+
   virtual bool Delete(std::vector<std::shared_ptr<core::SerializableComponent>> &storedValues) {
     bool found = true;
     for (auto storedValue : storedValues) {
-      found &= Delete(storedValue->getName());
+      found &= Delete(storedValue->getUUIDStr());
     }
     return found;
   }
 
+  /**
+   * Sets the policy that decides which provenance events are recorded in this repository.
+   * @param policy null to record every event
+   */
+  void setProvenancePolicy(const std::shared_ptr<provenance::ProvenancePolicy> &policy) {
+    provenance_policy_ = policy;
+  }
+
+  std::shared_ptr<provenance::ProvenancePolicy> getProvenancePolicy() const {
+    return provenance_policy_;
+  }
+
   void setConnectionMap(std::map<std::string, std::shared_ptr<core::Connectable>> &connectionMap) {
     this->connectionMap = connectionMap;
   }
@@ -178,6 +220,19 @@ class Repository : public virtual core::SerializableComponent, public core::Trac
     return true;
   }
 
+  /**
+   * Deserializes up to max_size stored objects that follow cursor, in the order they were stored,
+   * so that readers may resume where they left off instead of scanning from the start.
+   * @param cursor key of the last object returned by the previous call, empty to start from the
+   * first. Upon return it is the key of the last object returned.
+   *
+   * Base implementation ignores the cursor and reads from the start.
+   */
+  virtual bool DeSerialize(std::vector<std::shared_ptr<core::SerializableComponent>> &store, size_t &max_size, std::function<std::shared_ptr<core::SerializableComponent>()> lambdaConstructor,
+                           std::string &cursor) {
+    return DeSerialize(store, max_size, lambdaConstructor);
+  }
+
   /**
    * Base implementation returns true;
    */
@@ -246,6 +301,8 @@ class Repository : public virtual core::SerializableComponent, public core::Trac
   }
 
  private:
+  // decides which provenance events are recorded, null to record every event
+  std::shared_ptr<provenance::ProvenancePolicy> provenance_policy_;
   std::shared_ptr<logging::Logger> logger_;
 };
 
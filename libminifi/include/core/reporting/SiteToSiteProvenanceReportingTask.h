@@ -23,6 +23,8 @@
 #include <mutex>
 #include <memory>
 #include <stack>
+#include <string>
+#include <vector>
 #include "FlowFileRecord.h"
 #include "core/Processor.h"
 #include "core/ProcessSession.h"
@@ -37,6 +39,8 @@ namespace minifi {
 namespace core {
 namespace reporting {
 
+#define DEFAULT_MAX_REPORT_SIZE (1024 * 1024) // 1M
+
 //! SiteToSiteProvenanceReportingTask Class
 class SiteToSiteProvenanceReportingTask : public minifi::RemoteProcessorGroupPort {
  public:
@@ -49,6 +53,7 @@ class SiteToSiteProvenanceReportingTask : public minifi::RemoteProcessorGroupPor
         logger_(logging::LoggerFactory<SiteToSiteProvenanceReportingTask>::getLogger()) {
     this->setTriggerWhenEmpty(true);
     batch_size_ = 100;
+    max_report_size_ = DEFAULT_MAX_REPORT_SIZE;
   }
   //! Destructor
   ~SiteToSiteProvenanceReportingTask() {
@@ -58,6 +63,13 @@ class SiteToSiteProvenanceReportingTask : public minifi::RemoteProcessorGroupPor
   static const char *ProvenanceAppStr;
 
  public:
+  /**
+   * Writes records, starting at begin, as a compact json array into report. Records are added
+   * until the report reaches the maximum report size.
+   * @return index of the first record not written
+   */
+  size_t writeJsonReport(const std::vector<std::shared_ptr<core::SerializableComponent>> &records, size_t begin, std::string &report);
+
   //! Get provenance json report
   void getJsonReport(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, std::vector<std::shared_ptr<core::SerializableComponent>> &records, std::string &report);
 
@@ -81,6 +93,14 @@ class SiteToSiteProvenanceReportingTask : public minifi::RemoteProcessorGroupPor
   int getBatchSize(void) {
     return (batch_size_);
   }
+  //! Set the size at which reports are split across data packets
+  void setMaxReportSize(uint64_t size) {
+    max_report_size_ = size;
+  }
+  //! Get Max Report Size
+  uint64_t getMaxReportSize() {
+    return max_report_size_;
+  }
   //! Get Port UUID
   void getPortUUID(utils::Identifier & port_uuid) {
     port_uuid = protocol_uuid_;
@@ -90,6 +110,9 @@ class SiteToSiteProvenanceReportingTask : public minifi::RemoteProcessorGroupPor
 
  private:
   int batch_size_;
+  uint64_t max_report_size_;
+  // key of the last event reported
+  std::string cursor_;
 
   std::shared_ptr<logging::Logger> logger_;
 };
@@ -0,0 +1,203 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_CORE_REPOSITORY_TieredContentRepository_H_
+#define LIBMINIFI_INCLUDE_CORE_REPOSITORY_TieredContentRepository_H_
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <memory>
+#include <condition_variable>
+#include "core/Core.h"
+#include "../ContentRepository.h"
+#include "core/repository/VolatileContentRepository.h"
+#include "core/repository/FileSystemRepository.h"
+#include "properties/Configure.h"
+#include "core/logging/LoggerConfiguration.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+namespace repository {
+
+#define TIERED_CONTENT_SPILL_AGE (5000) // 5 seconds
+#define TIERED_CONTENT_SPILL_THRESHOLD (75) // percent of the memory tier
+
+/**
+ * Purpose: Content repository that stages new claims in a bounded memory tier (VolatileContentRepository)
+ * and migrates them to a disk tier (FileSystemRepository) once they outlive the spill age, or when the
+ * memory tier passes its spill threshold. Writes that no longer fit into memory are spilled to disk
+ * mid-stream rather than rolling back the session.
+ */
+class TieredContentRepository : public core::ContentRepository, public core::CoreComponent, public std::enable_shared_from_this<TieredContentRepository> {
+ public:
+
+  explicit TieredContentRepository(std::string name = getClassName<TieredContentRepository>())
+      : core::CoreComponent(name),
+        spill_age_(TIERED_CONTENT_SPILL_AGE),
+        spill_threshold_(TIERED_CONTENT_SPILL_THRESHOLD),
+        running_(false),
+        logger_(logging::LoggerFactory<TieredContentRepository>::getLogger()) {
+  }
+
+  virtual ~TieredContentRepository() {
+    stop();
+  }
+
+  /**
+   * Initializes both tiers and starts the migration thread.
+   * @param configure configuration
+   */
+  virtual bool initialize(const std::shared_ptr<Configure> &configure);
+
+  /**
+   * Stops the migration thread and the memory tier.
+   */
+  virtual void stop();
+
+  virtual std::shared_ptr<io::BaseStream> write(const std::shared_ptr<minifi::ResourceClaim> &claim);
+
+  virtual std::shared_ptr<io::BaseStream> read(const std::shared_ptr<minifi::ResourceClaim> &claim);
+
+  virtual bool exists(const std::shared_ptr<minifi::ResourceClaim> &streamId);
+
+  virtual bool close(const std::shared_ptr<minifi::ResourceClaim> &claim) {
+    return remove(claim);
+  }
+
+  virtual bool remove(const std::shared_ptr<minifi::ResourceClaim> &claim);
+
+  /**
+   * Returns true if the claim is currently held by the memory tier.
+   */
+  bool isInMemory(const std::shared_ptr<minifi::ResourceClaim> &claim);
+
+  /**
+   * Returns the number of bytes held by the memory tier.
+   */
+  uint64_t getMemoryTierSize() {
+    return memory_tier_->getRepoSize();
+  }
+
+ protected:
+
+  /**
+   * Stream returned for claims that live in the memory tier. Spills the claim to the
+   * disk tier when the memory tier refuses a write and releases the claim on destruction
+   * so that the migration thread may move it.
+   */
+  class TieredStream : public io::BaseStream {
+   public:
+    TieredStream(const std::shared_ptr<TieredContentRepository> &repository, const std::shared_ptr<minifi::ResourceClaim> &claim, const std::shared_ptr<io::BaseStream> &stream);
+
+    virtual ~TieredStream();
+
+    virtual void closeStream() {
+      stream_->closeStream();
+    }
+
+    virtual void seek(uint64_t offset) {
+      stream_->seek(offset);
+    }
+
+    virtual const uint64_t getSize() const {
+      return stream_->getSize();
+    }
+
+    virtual int readData(std::vector<uint8_t> &buf, int buflen);
+
+    virtual int readData(uint8_t *buf, int buflen);
+
+    virtual int writeData(std::vector<uint8_t> &buf, int buflen);
+
+    virtual int writeData(uint8_t *value, int size);
+
+   private:
+    std::shared_ptr<TieredContentRepository> repository_;
+    std::shared_ptr<minifi::ResourceClaim> claim_;
+    std::shared_ptr<io::BaseStream> stream_;
+    bool spilled_;
+  };
+
+  enum Tier {
+    MEMORY,
+    DISK
+  };
+
+  struct ClaimLocation {
+    Tier tier;
+    // time the claim entered the memory tier
+    uint64_t created;
+    // streams currently open against the memory tier
+    uint32_t open_streams;
+    bool migrating;
+  };
+
+  /**
+   * Moves the content written so far through stream to the disk tier.
+   * @param claim claim being written
+   * @param stream memory tier stream, replaced by a disk tier stream positioned at the end of the content on success.
+   * @return true if the claim now lives on disk.
+   */
+  bool spill(const std::shared_ptr<minifi::ResourceClaim> &claim, std::shared_ptr<io::BaseStream> &stream);
+
+  /**
+   * Migrates a memory tier claim to disk unless it is in use.
+   * @return true if the claim was moved.
+   */
+  bool migrate(const std::string &path);
+
+  void releaseStream(const std::string &path);
+
+  void run();
+
+  bool copy(const std::shared_ptr<io::BaseStream> &from, const std::shared_ptr<io::BaseStream> &to);
+
+ private:
+
+  std::shared_ptr<VolatileContentRepository> memory_tier_;
+  std::shared_ptr<FileSystemRepository> disk_tier_;
+
+  // claims older than this are migrated to disk
+  uint64_t spill_age_;
+  // percentage of the memory tier above which the oldest claims are migrated
+  uint64_t spill_threshold_;
+
+  std::mutex location_mutex_;
+  std::map<std::string, ClaimLocation> locations_;
+
+  std::atomic<bool> running_;
+  std::mutex run_mutex_;
+  std::condition_variable run_condition_;
+  std::thread thread_;
+
+  std::shared_ptr<logging::Logger> logger_;
+};
+
+} /* namespace repository */
+} /* namespace core */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+
+#endif /* LIBMINIFI_INCLUDE_CORE_REPOSITORY_TieredContentRepository_H_ */
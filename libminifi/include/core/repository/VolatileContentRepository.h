@@ -26,6 +26,8 @@
 #include "properties/Configure.h"
 #include "core/Connectable.h"
 #include "core/logging/LoggerConfiguration.h"
+#include "utils/StripedHashMap.h"
+#include "concurrentqueue.h"
 namespace org {
 namespace apache {
 namespace nifi {
@@ -52,10 +54,9 @@ class VolatileContentRepository : public core::ContentRepository, public virtual
   virtual ~VolatileContentRepository() {
     logger_->log_debug("Clearing repository");
     if (!minimize_locking_) {
-      std::lock_guard<std::mutex> lock(map_mutex_);
-      for (const auto &item : master_list_) {
-        delete item.second;
-      }
+      master_list_.forEach([](const std::string &key, AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>* &entry) {
+        delete entry;
+      });
       master_list_.clear();
     }
 
@@ -108,6 +109,12 @@ class VolatileContentRepository : public core::ContentRepository, public virtual
 
   virtual void run();
 
+  /**
+   * Returns a function that takes ownership of the entry it is applied to, storing
+   * the result of AtomicEntry::takeOwnership in owned.
+   */
+  std::function<void(AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>*&)> takeOwnership(AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>* &owned);
+
   template<typename T2>
   std::shared_ptr<T2> shared_from_parent() {
     return std::dynamic_pointer_cast<T2>(shared_from_this());
@@ -122,11 +129,12 @@ class VolatileContentRepository : public core::ContentRepository, public virtual
   std::function<bool(std::shared_ptr<minifi::ResourceClaim>)> resource_claim_check_;
   std::function<void(std::shared_ptr<minifi::ResourceClaim>)> claim_reclaimer_;
 
-  // mutex and master list that represent a cache of Atomic entries. this exists so that we don't have to walk the atomic entry list.
-  // The idea is to reduce the computational complexity while keeping access as maximally lock free as we can.
-  std::mutex map_mutex_;
+  // master list that represents a cache of Atomic entries. this exists so that we don't have to walk the atomic entry list.
+  // The list is striped by claim so that writers of different claims do not contend for the same lock.
+  utils::StripedHashMap<std::string, AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>*> master_list_;
 
-  std::map<std::string, AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>*> master_list_;
+  // entries of value_vector_ that are not associated with a claim, so that minimal locking writes don't scan for a free slot.
+  moodycamel::ConcurrentQueue<AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>*> free_entries_;
 
   // logger
   std::shared_ptr<logging::Logger> logger_;
@@ -26,6 +26,7 @@
 #include "core/Core.h"
 #include "Connection.h"
 #include "utils/StringUtils.h"
+#include "utils/StripedHashMap.h"
 #include "AtomicRepoEntries.h"
 
 namespace org {
@@ -130,6 +131,13 @@ class VolatileRepository : public core::Repository, public std::enable_shared_fr
     return current_size_;
   }
 
+  /**
+   * Returns the maximum number of bytes this repository may hold.
+   */
+  virtual uint64_t getMaxRepoSize() {
+    return max_size_;
+  }
+
  protected:
 
   virtual void emplace(RepoValue<T> &old_value) {
@@ -153,10 +161,13 @@ class VolatileRepository : public core::Repository, public std::enable_shared_fr
   // current size of the volatile repo.
   std::atomic<size_t> current_size_;
   // current index.
-  std::atomic<uint16_t> current_index_;
+  std::atomic<uint64_t> current_index_;
   // value vector that exists for non blocking iteration over
   // objects that store data for this repo instance.
   std::vector<AtomicEntry<T>*> value_vector_;
+  // index of the slot in value_vector_ that was last given each key, so that Get
+  // and Delete don't scan value_vector_. The slot is still verified against the key.
+  utils::StripedHashMap<T, size_t> key_index_;
 
   // max count we are allowed to store.
   uint32_t max_count_;
@@ -203,7 +214,7 @@ bool VolatileRepository<T>::initialize(const std::shared_ptr<Configure> &configu
     std::stringstream strstream;
     strstream << Configure::nifi_volatile_repository_options << getName() << "." << volatile_repo_max_count;
     if (configure->get(strstream.str(), value)) {
-      if (core::Property::StringToInt(value, max_cnt)) {
+      if (core::Property::StringToInt(value, max_cnt) && max_cnt > 0 && max_cnt <= std::numeric_limits<uint32_t>::max()) {
         max_count_ = max_cnt;
       }
     }
@@ -246,22 +257,25 @@ bool VolatileRepository<T>::Put(T key, const uint8_t *buf, size_t bufLen) {
   size_t reclaimed_size = 0;
   RepoValue<T> old_value;
   do {
-    uint16_t private_index = current_index_.fetch_add(1);
     // round robin through the beginning
-    if (private_index >= max_count_) {
-      uint16_t new_index = 0;
-      if (current_index_.compare_exchange_weak(new_index, 0)) {
-        private_index = 0;
-      } else {
-        continue;
-      }
-    }
+    const size_t private_index = current_index_.fetch_add(1) % max_count_;
 
     updated = value_vector_.at(private_index)->setRepoValue(new_value, old_value, reclaimed_size);
     logger_->log_debug("Set repo value at %u out of %u updated %u current_size %u, adding %u to  %u", private_index, max_count_, updated == true, reclaimed_size, size, current_size_.load());
-    if (updated && reclaimed_size > 0) {
-      std::lock_guard<std::mutex> lock(mutex_);
-      emplace(old_value);
+    if (updated) {
+      if (reclaimed_size > 0) {
+        key_index_.eraseIfEqual(old_value.getKey(), private_index);
+        std::lock_guard<std::mutex> lock(mutex_);
+        emplace(old_value);
+      }
+      size_t previous_index = 0;
+      if (key_index_.exchange(key, private_index, previous_index) && previous_index != private_index) {
+        // free the slot of the value this one replaces, which the key no longer leads to
+        RepoValue<T> previous_value;
+        if (value_vector_.at(previous_index)->getValue(key, previous_value)) {
+          reclaimed_size += previous_value.size();
+        }
+      }
     }
     if (reclaimed_size > 0) {
       /**
@@ -287,15 +301,17 @@ bool VolatileRepository<T>::Put(T key, const uint8_t *buf, size_t bufLen) {
 template<typename T>
 bool VolatileRepository<T>::Delete(T key) {
   logger_->log_debug("Delete from volatile");
-  for (auto ent : value_vector_) {
-    // let the destructor do the cleanup
-    RepoValue<T> value;
-    if (ent->getValue(key, value)) {
-      current_size_ -= value.size();
-      logger_->log_debug("Delete and pushed into purge_list from volatile");
-      emplace(value);
-      return true;
-    }
+  size_t index = 0;
+  if (!key_index_.erase(key, index)) {
+    return false;
+  }
+  // let the destructor do the cleanup
+  RepoValue<T> value;
+  if (value_vector_.at(index)->getValue(key, value)) {
+    current_size_ -= value.size();
+    logger_->log_debug("Delete and pushed into purge_list from volatile");
+    emplace(value);
+    return true;
   }
   return false;
 }
@@ -306,15 +322,16 @@ bool VolatileRepository<T>::Delete(T key) {
  */
 template<typename T>
 bool VolatileRepository<T>::Get(const T &key, std::string &value) {
-
-  for (auto ent : value_vector_) {
-    // let the destructor do the cleanup
-    RepoValue<T> repo_value;
-    if (ent->getValue(key, repo_value)) {
-      current_size_ -= value.size();
-      repo_value.emplace(value);
-      return true;
-    }
+  size_t index = 0;
+  if (!key_index_.erase(key, index)) {
+    return false;
+  }
+  // let the destructor do the cleanup
+  RepoValue<T> repo_value;
+  if (value_vector_.at(index)->getValue(key, repo_value)) {
+    current_size_ -= repo_value.size();
+    repo_value.emplace(value);
+    return true;
   }
   return false;
 }
@@ -323,11 +340,12 @@ template<typename T>
 bool VolatileRepository<T>::DeSerialize(std::vector<std::shared_ptr<core::SerializableComponent>> &store, size_t &max_size, std::function<std::shared_ptr<core::SerializableComponent>()> lambda) {
   size_t requested_batch = max_size;
   max_size = 0;
-  for (auto ent : value_vector_) {
+  for (size_t index = 0; index < value_vector_.size(); index++) {
     // let the destructor do the cleanup
     RepoValue<T> repo_value;
 
-    if (ent->getValue(repo_value)) {
+    if (value_vector_[index]->getValue(repo_value)) {
+      key_index_.eraseIfEqual(repo_value.getKey(), index);
       std::shared_ptr<core::SerializableComponent> newComponent = lambda();
       // we've taken ownership of this repo value
       newComponent->DeSerialize(repo_value.getBuffer(), repo_value.getBufferSize());
@@ -352,11 +370,12 @@ template<typename T>
 bool VolatileRepository<T>::DeSerialize(std::vector<std::shared_ptr<core::SerializableComponent>> &store, size_t &max_size) {
   logger_->log_debug("VolatileRepository -- DeSerialize %u", current_size_.load());
   max_size = 0;
-  for (auto ent : value_vector_) {
+  for (size_t index = 0; index < value_vector_.size(); index++) {
     // let the destructor do the cleanup
     RepoValue<T> repo_value;
 
-    if (ent->getValue(repo_value)) {
+    if (value_vector_[index]->getValue(repo_value)) {
+      key_index_.eraseIfEqual(repo_value.getKey(), index);
       // we've taken ownership of this repo value
       store.at(max_size)->DeSerialize(repo_value.getBuffer(), repo_value.getBufferSize());
       current_size_ -= repo_value.getBufferSize();
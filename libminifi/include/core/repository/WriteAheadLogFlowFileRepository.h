@@ -0,0 +1,239 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_CORE_REPOSITORY_WRITEAHEADLOGFLOWFILEREPOSITORY_H_
+#define LIBMINIFI_INCLUDE_CORE_REPOSITORY_WRITEAHEADLOGFLOWFILEREPOSITORY_H_
+
+#include <chrono>
+#include <cstdio>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "concurrentqueue.h"
+#include "core/Core.h"
+#include "core/Repository.h"
+#include "properties/Configure.h"
+#include "core/logging/LoggerConfiguration.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+namespace repository {
+
+#ifdef WIN32
+#define WAL_FLOWFILE_REPOSITORY_DIRECTORY ".\\flowfile_wal"
+#else
+#define WAL_FLOWFILE_REPOSITORY_DIRECTORY "./flowfile_wal"
+#endif
+#define WAL_FLOWFILE_REPOSITORY_SEGMENT_SIZE (4*1024*1024) // 4M
+#define WAL_FLOWFILE_REPOSITORY_SNAPSHOT_INTERVAL (60000) // 1 minute
+#define WAL_FLOWFILE_REPOSITORY_PURGE_PERIOD (1000) // 1000 msec
+#define WAL_FLOWFILE_REPOSITORY_RECOVERY_BATCH (1024)
+
+/**
+ * Purpose: Flow file repository that persists queue state without RocksDB, modeled on NiFi's
+ * MinimalLockingWriteAheadLog.
+ *
+ * Design: Every Put appends a checksummed record to the current log segment, and the map of the
+ * stored flow files is updated once the record is written. Concurrent callers are group committed:
+ * the first to arrive writes and syncs everything appended so far while the others wait on it.
+ * Deletes are queued, so that dequeuing flow files does not wait on the disk, and are written in
+ * one batch by the background thread, which then removes the content claims they orphan.
+ * Periodically, or once the current segment outgrows its limit, the map is written to a snapshot,
+ * a new segment is started and the segments the snapshot covers are deleted. Recovery loads
+ * the snapshot and replays the segments that follow it, ignoring a torn record at the end of a
+ * segment.
+ */
+class WriteAheadLogFlowFileRepository : public core::Repository, public std::enable_shared_from_this<WriteAheadLogFlowFileRepository> {
+ public:
+
+  WriteAheadLogFlowFileRepository(std::string name, utils::Identifier uuid)
+      : WriteAheadLogFlowFileRepository(name) {
+  }
+
+  explicit WriteAheadLogFlowFileRepository(const std::string repo_name = "", std::string directory = WAL_FLOWFILE_REPOSITORY_DIRECTORY, int64_t maxPartitionMillis = MAX_REPOSITORY_ENTRY_LIFE_TIME,
+                                           int64_t maxPartitionBytes = MAX_REPOSITORY_STORAGE_SIZE, uint64_t purgePeriod = WAL_FLOWFILE_REPOSITORY_PURGE_PERIOD)
+      : core::SerializableComponent(repo_name),
+        Repository(repo_name.length() > 0 ? repo_name : core::getClassName<WriteAheadLogFlowFileRepository>(), directory, maxPartitionMillis, maxPartitionBytes, purgePeriod),
+        appended_(0),
+        synced_(0),
+        syncing_(false),
+        log_failed_(false),
+        segment_(nullptr),
+        segment_id_(0),
+        segment_bytes_(0),
+        first_segment_id_(0),
+        max_segment_bytes_(WAL_FLOWFILE_REPOSITORY_SEGMENT_SIZE),
+        snapshot_interval_(WAL_FLOWFILE_REPOSITORY_SNAPSHOT_INTERVAL),
+        sync_(true),
+        content_repo_(nullptr),
+        logger_(logging::LoggerFactory<WriteAheadLogFlowFileRepository>::getLogger()) {
+  }
+
+  virtual ~WriteAheadLogFlowFileRepository();
+
+  /**
+   * Recovers the stored flow files from the log and opens a new segment for appends.
+   */
+  virtual bool initialize(const std::shared_ptr<Configure> &configure);
+
+  virtual bool Put(std::string key, const uint8_t *buf, size_t bufLen);
+
+  virtual bool Delete(std::string key);
+
+  virtual bool Delete(const std::string &key, const std::shared_ptr<minifi::ResourceClaim> &claim, uint64_t size);
+
+  virtual bool Get(const std::string &key, std::string &value);
+
+  virtual void loadComponent(const std::shared_ptr<core::ContentRepository> &content_repo);
+
+  virtual void run();
+
+  /**
+   * Writes the queued deletes to the log and removes the content claims they orphan.
+   */
+  virtual void flush();
+
+  /**
+   * Writes the stored flow files to a snapshot, starts a new segment and deletes the segments
+   * the snapshot covers.
+   * @return true if the snapshot was written
+   */
+  bool snapshot();
+
+  /**
+   * Returns the path of the log segment with the given id.
+   */
+  std::string getSegmentPath(uint64_t id) const;
+
+  /**
+   * Returns the path of the snapshot.
+   */
+  std::string getSnapshotPath() const;
+
+ private:
+
+  enum RecordType {
+    RECORD_PUT = 1,
+    RECORD_DELETE = 2
+  };
+
+  struct DeletedFlowFile {
+    std::string key;
+    std::shared_ptr<minifi::ResourceClaim> claim;
+    // false if only the key is known, in which case flush reads the claim from the stored value
+    bool resolved;
+  };
+
+  // a record appended to the log, applied to records_ once it is written
+  struct PendingRecord {
+    RecordType type;
+    std::string key;
+    std::string value;
+  };
+
+  /**
+   * Appends a record, returning once it is written and applied to records_.
+   */
+  bool append(RecordType type, const std::string &key, const uint8_t *buf, size_t len);
+
+  /**
+   * Writes the records appended up to sequence, unless another caller already did.
+   * @param lock holds log_mutex_, released while writing
+   */
+  bool commit(std::unique_lock<std::mutex> &lock, uint64_t sequence);
+
+  /**
+   * Applies records that have been written to records_.
+   */
+  void applyRecords(const std::vector<PendingRecord> &records);
+
+  /**
+   * Writes buffer to the current segment, syncing it if configured to.
+   */
+  bool writeSegment(const std::string &buffer);
+
+  bool openSegment(uint64_t id);
+
+  /**
+   * Loads the snapshot, if any, into records_.
+   * @param next_segment set to the first segment that follows the snapshot
+   */
+  bool readSnapshot(uint64_t &next_segment);
+
+  /**
+   * Applies the records of a segment to records_, stopping at the first that is incomplete or corrupt.
+   * @return number of records applied
+   */
+  uint64_t replaySegment(uint64_t id);
+
+  /**
+   * Queues the flow files loaded at startup into their connections.
+   */
+  void recoverFlowFiles();
+
+  // guards everything below that is touched by appends
+  std::mutex log_mutex_;
+  std::condition_variable sync_cv_;
+  // stored flow files, by key
+  std::unordered_map<std::string, std::string> records_;
+  // records appended but not yet written, serialized and as they apply to records_
+  std::string pending_;
+  std::vector<PendingRecord> pending_records_;
+  // sequence of the last record appended and of the last one written
+  uint64_t appended_;
+  uint64_t synced_;
+  // whether a caller is writing pending records on behalf of the others
+  bool syncing_;
+  // a failed write leaves the log in an unknown state, so later appends are refused
+  bool log_failed_;
+  FILE *segment_;
+  uint64_t segment_id_;
+  uint64_t segment_bytes_;
+
+  // serializes snapshots
+  std::mutex snapshot_mutex_;
+  // oldest segment not yet covered by a snapshot
+  uint64_t first_segment_id_;
+  std::chrono::steady_clock::time_point last_snapshot_;
+
+  uint64_t max_segment_bytes_;
+  int64_t snapshot_interval_;
+  // whether each group commit is synced to disk
+  bool sync_;
+  // deletes waiting for the next flush
+  moodycamel::ConcurrentQueue<DeletedFlowFile> keys_to_delete_;
+  // flow files loaded at startup, queued into their connections once the repository starts
+  std::vector<std::pair<std::string, std::string>> recovered_records_;
+  std::shared_ptr<core::ContentRepository> content_repo_;
+  std::shared_ptr<logging::Logger> logger_;
+};
+
+} /* namespace repository */
+} /* namespace core */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+
+#endif /* LIBMINIFI_INCLUDE_CORE_REPOSITORY_WRITEAHEADLOGFLOWFILEREPOSITORY_H_ */
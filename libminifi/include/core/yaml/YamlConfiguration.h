@@ -44,6 +44,8 @@ namespace core {
 #define CONFIG_YAML_REMOTE_PROCESS_GROUP_KEY "Remote Processing Groups"
 #define CONFIG_YAML_REMOTE_PROCESS_GROUP_KEY_V3 "Remote Process Groups"
 #define CONFIG_YAML_PROVENANCE_REPORT_KEY "Provenance Reporting"
+#define CONFIG_YAML_INPUT_PORTS_KEY "Input Ports"
+#define CONFIG_YAML_OUTPUT_PORTS_KEY "Output Ports"
 
 #define YAML_CONFIGURATION_USE_REGEX
 
@@ -158,12 +160,16 @@ class YamlConfiguration : public FlowConfiguration {
     }
 
     YAML::Node provenanceReportNode = rootYaml[CONFIG_YAML_PROVENANCE_REPORT_KEY];
+    YAML::Node inputPortsNode = rootYaml[CONFIG_YAML_INPUT_PORTS_KEY];
+    YAML::Node outputPortsNode = rootYaml[CONFIG_YAML_OUTPUT_PORTS_KEY];
 
     parseControllerServices(&controllerServiceNode);
     // Create the root process group
     core::ProcessGroup *root = parseRootProcessGroupYaml(flowControllerNode);
     parseProcessorNodeYaml(processorsNode, root);
     parseRemoteProcessGroupYaml(&remoteProcessingGroupsNode, root);
+    parseRootGroupPortsYaml(&inputPortsNode, root, sitetosite::SEND);
+    parseRootGroupPortsYaml(&outputPortsNode, root, sitetosite::RECEIVE);
     parseConnectionYaml(&connectionsNode, root);
     parseProvenanceReportingYaml(&provenanceReportNode, root);
 
@@ -202,6 +208,17 @@ class YamlConfiguration : public FlowConfiguration {
    */
   void parsePortYaml(YAML::Node *portNode, core::ProcessGroup *parent, sitetosite::TransferDirection direction);
 
+  /**
+   * Parses the input or output ports of the root process group, which other
+   * instances transfer flow files to or from over site to site. A RootGroupPort
+   * is created for each port and added to the parent ProcessGroup.
+   *
+   * @param portsNode the YAML::Node containing the sequence of ports
+   * @param parent    the root ProcessGroup
+   * @param direction SEND for input ports, RECEIVE for output ports
+   */
+  void parseRootGroupPortsYaml(YAML::Node *portsNode, core::ProcessGroup *parent, sitetosite::TransferDirection direction);
+
   /**
    * Parses the root level YAML node for the flow configuration and
    * returns a ProcessGroup containing the tree of flow configuration
@@ -64,6 +64,10 @@ class BaseStream : public DataStream, public Serializable {
 
   virtual int writeData(uint8_t *value, int size);
 
+  virtual int writeV(const struct iovec *iov, int iovcnt);
+
+  virtual int readV(const struct iovec *iov, int iovcnt);
+
   virtual void seek(uint64_t offset) {
     if (LIKELY(composable_stream_ != this)) {
       composable_stream_->seek(offset);
@@ -0,0 +1,110 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_IO_BUFFEREDSTREAM_H_
+#define LIBMINIFI_INCLUDE_IO_BUFFEREDSTREAM_H_
+
+#include <cstdint>
+#include <vector>
+#include "DataStream.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace io {
+
+// size of the write buffer, which is also the largest TLS record
+#define BUFFERED_STREAM_SIZE (16 * 1024)
+
+/**
+ * Purpose: Coalesces small writes to a stream, such as the length fields and strings of
+ * site to site framing, so that they reach a socket in one send and, over TLS, in one record.
+ *
+ * Design: Writes are buffered until the buffer is full or flush is called. Writes larger than
+ * the buffer go to the stream directly, after the buffered data. Every read flushes first,
+ * since a peer only responds once it has received the whole request. The underlying stream
+ * is not owned.
+ */
+class BufferedStream : public DataStream {
+ public:
+  explicit BufferedStream(DataStream *stream, size_t buffer_size = BUFFERED_STREAM_SIZE);
+
+  virtual ~BufferedStream() {
+  }
+
+  /**
+   * Writes the buffered data to the underlying stream.
+   * @return number of bytes written, or -1 if the data could not be written
+   */
+  int flush();
+
+  virtual short initialize();
+
+  virtual void seek(uint64_t offset);
+
+  /**
+   * Flushes the buffered data before closing the underlying stream.
+   */
+  virtual void closeStream();
+
+  virtual int readData(std::vector<uint8_t> &buf, int buflen);
+
+  virtual int readData(uint8_t *buf, int buflen);
+
+  /**
+   * Buffers the data.
+   * @return size, or -1 if the buffer could not be flushed
+   */
+  virtual int writeData(uint8_t *value, int size);
+
+  /**
+   * Buffers the data if it fits, and otherwise writes it to the stream after the buffered data.
+   */
+  virtual int writeV(const struct iovec *iov, int iovcnt);
+
+  virtual int readV(const struct iovec *iov, int iovcnt);
+
+  virtual int read(uint64_t &value, bool is_little_endian = EndiannessCheck::IS_LITTLE);
+
+  virtual int read(uint32_t &value, bool is_little_endian = EndiannessCheck::IS_LITTLE);
+
+  virtual int read(uint16_t &value, bool is_little_endian = EndiannessCheck::IS_LITTLE);
+
+  virtual const uint64_t getSize() const {
+    return stream_->getSize();
+  }
+
+  /**
+   * Returns the number of bytes awaiting a flush.
+   */
+  size_t getBufferedSize() const {
+    return output_buffer_.size();
+  }
+
+ private:
+  DataStream *stream_;
+  size_t buffer_size_;
+  std::vector<uint8_t> output_buffer_;
+};
+
+} /* namespace io */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+#endif /* LIBMINIFI_INCLUDE_IO_BUFFEREDSTREAM_H_ */
@@ -18,7 +18,6 @@
 #ifndef LIBMINIFI_INCLUDE_IO_CRCSTREAM_H_
 #define LIBMINIFI_INCLUDE_IO_CRCSTREAM_H_
 
-#include <zlib.h>
 #include <memory>
 #ifdef WIN32
 #include <winsock2.h>
@@ -27,6 +26,7 @@
 #endif
 #include "BaseStream.h"
 #include "Serializable.h"
+#include "utils/CRC32.h"
 
 namespace org {
 namespace apache {
@@ -168,7 +168,7 @@ template<typename T>
 CRCStream<T>::CRCStream(T *other)
     : child_stream_(other),
       disable_encoding_(false) {
-  crc_ = crc32(0L, Z_NULL, 0);
+  crc_ = 0;
 }
 
 template<typename T>
@@ -189,7 +189,7 @@ int CRCStream<T>::readData(std::vector<uint8_t> &buf, int buflen) {
 template<typename T>
 int CRCStream<T>::readData(uint8_t *buf, int buflen) {
   int ret = child_stream_->read(buf, buflen);
-  crc_ = crc32(crc_, buf, ret);
+  crc_ = utils::CRC32::update(crc_, buf, ret > 0 ? ret : 0);
   return ret;
 }
 
@@ -205,17 +205,17 @@ template<typename T>
 int CRCStream<T>::writeData(uint8_t *value, int size) {
 
   int ret = child_stream_->write(value, size);
-  crc_ = crc32(crc_, value, size);
+  crc_ = utils::CRC32::update(crc_, value, size);
   return ret;
 
 }
 template<typename T>
 void CRCStream<T>::reset() {
-  crc_ = crc32(0L, Z_NULL, 0);
+  crc_ = 0;
 }
 template<typename T>
 void CRCStream<T>::updateCRC(uint8_t *buffer, uint32_t length) {
-  crc_ = crc32(crc_, buffer, length);
+  crc_ = utils::CRC32::update(crc_, buffer, length);
 }
 
 template<typename T>
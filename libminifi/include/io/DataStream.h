@@ -22,7 +22,21 @@
 #include <iostream>
 #include <cstdint>
 #include <vector>
+#ifdef WIN32
+#include <cstddef>
+#else
+#include <sys/uio.h>
+#endif
 #include "EndianCheck.h"
+
+#ifdef WIN32
+// scatter/gather buffer, as declared by sys/uio.h
+struct iovec {
+  void *iov_base;
+  size_t iov_len;
+};
+#endif
+
 namespace org {
 namespace apache {
 namespace nifi {
@@ -89,6 +103,23 @@ class DataStream {
    */
   virtual int writeData(uint8_t *value, int size);
 
+  /**
+   * Writes the buffers in order. Streams backed by a descriptor override this to
+   * write them at once; by default each is written with writeData.
+   * @param iov buffers to write
+   * @param iovcnt number of buffers
+   * @return number of bytes written, or -1 if a buffer could not be written
+   */
+  virtual int writeV(const struct iovec *iov, int iovcnt);
+
+  /**
+   * Fills the buffers in order, stopping at the first one that is not filled completely.
+   * @param iov buffers to read into
+   * @param iovcnt number of buffers
+   * @return number of bytes read, or -1 if nothing could be read
+   */
+  virtual int readV(const struct iovec *iov, int iovcnt);
+
   /**
    * Reads a system word
    * @param value value to write
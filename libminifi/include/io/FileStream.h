@@ -97,6 +97,13 @@ class FileStream : public io::BaseStream {
    */
   virtual int writeData(uint8_t *value, int size);
 
+  /**
+   * Writes the buffers under one lock, flushing the file once.
+   * @param iov buffers to write
+   * @param iovcnt number of buffers
+   */
+  virtual int writeV(const struct iovec *iov, int iovcnt);
+
   /**
    * Returns the underlying buffer
    * @return vector's array
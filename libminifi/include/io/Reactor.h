@@ -0,0 +1,178 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_IO_REACTOR_H_
+#define LIBMINIFI_INCLUDE_IO_REACTOR_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "core/logging/LoggerConfiguration.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace io {
+
+// readiness a descriptor is registered for and its callback is given
+#define REACTOR_READABLE (1)
+#define REACTOR_WRITABLE (2)
+#define REACTOR_CLOSED (4)
+// threads of the shared reactor
+#define REACTOR_THREADS (2)
+// events handled per wait
+#define REACTOR_MAX_EVENTS (64)
+
+/**
+ * Purpose: Serves many descriptors from a few threads, in place of a select loop per socket.
+ *
+ * Design: Descriptors are registered with a callback that is run whenever they become ready.
+ * On Linux readiness is taken from epoll, elsewhere from poll. A descriptor is handled by one
+ * thread at a time, and is armed again once its callback returns. Timers run their task on
+ * the reactor threads once their delay has passed. Descriptors are expected to be non-blocking,
+ * and callbacks to return once they would block.
+ */
+class Reactor {
+ public:
+  typedef std::function<void(int fd, uint32_t events)> Callback;
+
+  explicit Reactor(uint16_t threads = 1);
+
+  ~Reactor();
+
+  /**
+   * Returns the reactor shared across the agent, which is started on first use.
+   */
+  static std::shared_ptr<Reactor> getReactor();
+
+  /**
+   * Starts the threads of the reactor.
+   * @return false if readiness cannot be waited for
+   */
+  bool start();
+
+  /**
+   * Stops the threads of the reactor. Registered descriptors are kept.
+   */
+  void stop();
+
+  bool isRunning() const {
+    return running_;
+  }
+
+  /**
+   * Registers the descriptor, replacing a previous registration.
+   * @param fd descriptor to watch
+   * @param events REACTOR_READABLE and/or REACTOR_WRITABLE
+   * @param callback run with the descriptor and its readiness
+   * @return false if the descriptor could not be watched
+   */
+  bool add(int fd, uint32_t events, const Callback &callback);
+
+  /**
+   * Removes the descriptor, waiting for its callback to return unless called from it.
+   * The callback is not run again afterwards, so the descriptor may be closed.
+   */
+  void remove(int fd);
+
+  /**
+   * Runs the task once the delay has passed.
+   * @return identifier of the timer
+   */
+  uint64_t schedule(uint64_t delay_ms, const std::function<void()> &task);
+
+  /**
+   * Cancels a timer that has not run yet.
+   */
+  void cancel(uint64_t timer_id);
+
+  /**
+   * Returns the number of registered descriptors.
+   */
+  size_t size();
+
+  /**
+   * Makes the descriptor non-blocking.
+   */
+  static bool setNonBlocking(int fd);
+
+  Reactor(const Reactor &other) = delete;
+  Reactor &operator=(const Reactor &other) = delete;
+
+ private:
+  struct Registration {
+    int fd;
+    uint32_t events;
+    Callback callback;
+    bool removed;
+    // set while the callback runs
+    bool running;
+    std::thread::id thread;
+  };
+
+  struct Timer {
+    uint64_t id;
+    std::function<void()> task;
+  };
+
+  void run();
+
+  // waits for ready descriptors, for at most timeout_ms
+  void poll(int timeout_ms);
+
+  void dispatch(const std::shared_ptr<Registration> &registration, uint32_t events);
+
+  bool arm(const std::shared_ptr<Registration> &registration, bool added);
+
+  // runs the due timers, returning the time until the next one
+  int runTimers();
+
+  void wake();
+
+  uint16_t thread_count_;
+  std::atomic<bool> running_;
+  std::vector<std::thread> threads_;
+  // epoll descriptor on Linux
+  int poll_fd_;
+  // pipe that interrupts the wait
+  int wake_fds_[2];
+
+  std::mutex mutex_;
+  std::condition_variable callback_finished_;
+  std::map<int, std::shared_ptr<Registration>> registrations_;
+
+  std::mutex timer_mutex_;
+  uint64_t next_timer_id_;
+  // timers by their deadline
+  std::multimap<uint64_t, Timer> timers_;
+
+  std::shared_ptr<logging::Logger> logger_;
+};
+
+} /* namespace io */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+#endif /* LIBMINIFI_INCLUDE_IO_REACTOR_H_ */
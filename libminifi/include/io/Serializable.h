@@ -116,6 +116,23 @@ class Serializable {
    **/
   int writeUTF(std::string str, DataStream *stream, bool widen = false);
 
+  /**
+   * write an unsigned integer to the stream as a variable length quantity,
+   * seven bits per byte with the high bit set on all but the last byte.
+   * @param value value to write
+   * @param stream output stream
+   * @return resulting write size
+   **/
+  int writeVarInt(uint64_t value, DataStream *stream);
+
+  /**
+   * write a string to the stream, prefixed by its length as a variable length quantity
+   * @param str string to write
+   * @param stream output stream
+   * @return resulting write size
+   **/
+  int writeVarString(const std::string &str, DataStream *stream);
+
   /**
    * reads a byte from the stream
    * @param value reference in which will set the result
@@ -173,6 +190,22 @@ class Serializable {
    **/
   int readUTF(std::string &str, DataStream *stream, bool widen = false);
 
+  /**
+   * reads a variable length quantity written by writeVarInt
+   * @param value reference in which will set the result
+   * @param stream stream from which we will read
+   * @return resulting read size, or -1 if the stream ended or the value overflows 64 bits
+   **/
+  int readVarInt(uint64_t &value, DataStream *stream);
+
+  /**
+   * reads a string written by writeVarString
+   * @param str reference string
+   * @param stream stream from which we will read
+   * @return resulting read size, or -1 on failure
+   **/
+  int readVarString(std::string &str, DataStream *stream);
+
  protected:
 
 };
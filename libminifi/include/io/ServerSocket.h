@@ -18,7 +18,11 @@
 #ifndef LIBMINIFI_INCLUDE_IO_SERVERSOCKET_H_
 #define LIBMINIFI_INCLUDE_IO_SERVERSOCKET_H_
 
+#include <memory>
 #include "io/ClientSocket.h"
+#ifndef WIN32
+#include "io/Reactor.h"
+#endif
 
 namespace org {
 namespace apache {
@@ -26,6 +30,10 @@ namespace nifi {
 namespace minifi {
 namespace io {
 
+// threads that run the handlers of accepted connections
+#define SERVER_SOCKET_HANDLER_THREADS (4)
+// seconds that a handler waits on a stalled connection
+#define SERVER_SOCKET_IO_TIMEOUT (30)
 
 class BaseServerSocket  {
 
@@ -60,10 +68,23 @@ class ServerSocket : public BaseServerSocket, public Socket {
   }
 
   /**
-   * Registers a call back and starts the read for the server socket.
+   * Registers a call back and starts the read for the server socket. Connections are
+   * accepted on the threads of the shared reactor, and wait there for their request
+   * without holding a thread. The handler reads and writes in blocking fashion, so each
+   * request is then handled on one of the SERVER_SOCKET_HANDLER_THREADS threads of the
+   * server socket: at most that many requests are served at once, and a stalled client
+   * holds its thread until its reads and writes time out after SERVER_SOCKET_IO_TIMEOUT seconds.
    */
   virtual void registerCallback(std::function<bool()> accept_function, std::function<void(io::BaseStream *)> handler);
 
+#ifndef WIN32
+  /**
+   * Registers a call back that takes over each accepted connection, for protocols whose
+   * connections carry several requests. The handler owns the descriptor it is given.
+   */
+  virtual void registerConnectionCallback(std::function<bool()> accept_function, std::function<void(int)> handler);
+#endif
+
  private:
 
   void close_fd(int fd );
@@ -72,6 +93,18 @@ class ServerSocket : public BaseServerSocket, public Socket {
 
   std::thread server_read_thread_;
 
+#ifndef WIN32
+  // accepts the pending connections, passing those that are accepted to the handler
+  void acceptConnections(const std::function<bool()> &accept_function, const std::function<void(int)> &handler);
+
+  std::shared_ptr<Reactor> reactor_;
+
+  // accepted connections and the threads that handle them, shared with the reactor callbacks
+  // so that a callback still running as the server socket is destroyed does not outlive them
+  struct ConnectionHandlers;
+  std::shared_ptr<ConnectionHandlers> handlers_;
+#endif
+
   std::shared_ptr<logging::Logger> logger_;
 };
 
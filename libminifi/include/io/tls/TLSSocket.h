@@ -72,7 +72,8 @@ class TLSContext : public SocketContext {
   TLSContext(const std::shared_ptr<Configure> &configure, const std::shared_ptr<minifi::controllers::SSLContextService> &ssl_service = nullptr);
 
   virtual ~TLSContext() {
-    if (0 != ctx)
+    // a context shared through the SSL context service is freed by the service
+    if (0 != ctx && nullptr == shared_context_)
       SSL_CTX_free(ctx);
   }
 
@@ -86,8 +87,27 @@ class TLSContext : public SocketContext {
 
   int16_t initialize(bool server_method = false);
 
+  /**
+   * Offers the session last negotiated with the peer on a client connection.
+   */
+  void resumeSession(SSL *ssl, const std::string &host, uint16_t port);
+
+  /**
+   * Keeps the session of a client connection once its handshake has completed.
+   */
+  void saveSession(SSL *ssl, const std::string &host, uint16_t port);
+
+  void removeSession(const std::string &host, uint16_t port);
+
  private:
 
+  /**
+   * Creates a context and loads the certificates it needs.
+   * @param error set to the TLS_ERROR_* code of a failure
+   * @return new context, or NULL if it could not be created or configured
+   */
+  SSL_CTX *createContext(bool server_method, bool needClientCert, int16_t &error);
+
   static int pemPassWordCb(char *buf, int size, int rwflag, void *userdata) {
 
     std::string *pass = (std::string*) userdata;
@@ -104,6 +124,10 @@ class TLSContext : public SocketContext {
   std::shared_ptr<logging::Logger> logger_;
   std::shared_ptr<Configure> configure_;
   std::shared_ptr<minifi::controllers::SSLContextService> ssl_service_;
+  // set when ctx belongs to the SSL context service
+  std::shared_ptr<minifi::controllers::SSLContext> shared_context_;
+  // sessions of client connections
+  std::shared_ptr<minifi::controllers::SSLSessionCache> session_cache_;
   SSL_CTX *ctx;
 
   int16_t error_value;
@@ -183,6 +207,14 @@ class TLSSocket : public Socket {
    */
   int writeData(uint8_t *value, int size);
 
+  /**
+   * Coalesces the buffers into records, so that small buffers are not each sent
+   * in a record of their own.
+   * @param iov buffers to write
+   * @param iovcnt number of buffers
+   */
+  int writeV(const struct iovec *iov, int iovcnt);
+
  protected:
 
   int writeData(uint8_t *value, int size, int fd);
@@ -30,6 +30,9 @@
 #include "utils/ThreadPool.h"
 #include "core/logging/LoggerConfiguration.h"
 #include "controllers/SSLContextService.h"
+#ifndef WIN32
+#include "io/Reactor.h"
+#endif
 
 namespace org {
 namespace apache {
@@ -193,6 +196,7 @@ class GetTCP : public core::Processor, public state::response::MetricsNodeSource
   }
 // Destructor
   virtual ~GetTCP() {
+    notifyStop();
   }
 // Processor Name
   static constexpr char const* ProcessorName = "GetTCP";
@@ -245,6 +249,35 @@ class GetTCP : public core::Processor, public state::response::MetricsNodeSource
 
  private:
 
+  // creates a socket connected to the endpoint, or returns nullptr if it cannot be connected
+  std::unique_ptr<io::Socket> createSocket(const std::string &endpoint);
+
+  // splits the bytes read from the source at the end of message byte and hands them to the handler
+  void handleMessages(const std::string &source, std::vector<uint8_t> &buffer, int size_read);
+
+#ifndef WIN32
+  /**
+   * Watches the connection to the endpoint on the shared reactor, which hands it to a
+   * handler thread once data arrives, so that idle connections do not hold a thread.
+   * @return false if the connection could not be watched
+   */
+  bool watch(const std::string &endpoint, const std::shared_ptr<io::Socket> &socket);
+
+  // reads the connection until no data is left, then watches it again unless it was closed
+  void readConnection(const std::string &endpoint, const std::shared_ptr<io::Socket> &socket);
+
+  std::shared_ptr<io::Reactor> reactor_;
+
+  // open connections by their endpoint, guarded by mutex_
+  std::map<std::string, std::shared_ptr<io::Socket>> connections_;
+
+  // times before which endpoints whose connection closed are not connected to again, guarded by mutex_
+  std::map<std::string, uint64_t> reconnect_times_;
+
+  // receive buffers, reused across the reads of the handler threads
+  moodycamel::ConcurrentQueue<std::vector<uint8_t>> read_buffers_;
+#endif
+
   std::function<int()> f_ex;
 
   std::atomic<bool> running_;
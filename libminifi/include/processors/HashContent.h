@@ -38,6 +38,7 @@
 #include "core/ProcessSession.h"
 #include "core/Resource.h"
 #include "io/BaseStream.h"
+#include "utils/CRC32.h"
 
 using HashReturnType = std::pair<std::string, int64_t>;
 
@@ -124,6 +125,28 @@ namespace {
     }
     return ret_val;
   }
+
+  HashReturnType CRC32Hash(const std::shared_ptr<org::apache::nifi::minifi::io::BaseStream>& stream) {
+    HashReturnType ret_val;
+    ret_val.second = 0;
+    uint8_t buffer[HASH_BUFFER_SIZE];
+    uint32_t crc = 0;
+
+    int ret;
+    do {
+      ret = stream->readData(buffer, HASH_BUFFER_SIZE);
+      if(ret > 0) {
+        crc = org::apache::nifi::minifi::utils::CRC32::update(crc, buffer, ret);
+        ret_val.second += ret;
+      }
+    } while(ret > 0);
+
+    if (ret_val.second > 0) {
+      unsigned char digest[4] = { static_cast<unsigned char>(crc >> 24), static_cast<unsigned char>(crc >> 16), static_cast<unsigned char>(crc >> 8), static_cast<unsigned char>(crc) };
+      ret_val.first = digestToString(digest, sizeof(digest));
+    }
+    return ret_val;
+  }
 }
 
 
@@ -134,7 +157,7 @@ namespace minifi {
 namespace processors {
 
 static const std::map<std::string, const std::function<HashReturnType(const std::shared_ptr<io::BaseStream>&)>> HashAlgos =
-  { {"MD5",  MD5Hash}, {"SHA1", SHA1Hash}, {"SHA256", SHA256Hash} };
+  { {"MD5",  MD5Hash}, {"SHA1", SHA1Hash}, {"SHA256", SHA256Hash}, {"CRC32", CRC32Hash} };
 
 //! HashContent Class
 class HashContent : public core::Processor {
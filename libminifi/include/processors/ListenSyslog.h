@@ -34,6 +34,9 @@
 #include <errno.h>
 #include <sys/types.h>
 #include <chrono>
+#include <map>
+#include <memory>
+#include <string>
 #include <thread>
 #include "FlowFileRecord.h"
 #include "core/Processor.h"
@@ -41,6 +44,9 @@
 #include "core/Core.h"
 #include "core/Resource.h"
 #include "core/logging/LoggerConfiguration.h"
+#ifndef WIN32
+#include "io/Reactor.h"
+#endif
 
 #ifndef WIN32
 
@@ -77,30 +83,10 @@ class ListenSyslog : public core::Processor {
     _protocol = "UDP";
     _port = 514;
     _parseMessages = false;
-    _serverSocket = 0;
-    _maxFds = 0;
-    FD_ZERO(&_readfds);
-    _thread = NULL;
-    _resetServerSocket = false;
-    _serverTheadRunning = false;
   }
   // Destructor
   virtual ~ListenSyslog() {
-    _serverTheadRunning = false;
-    if (this->_thread)
-      delete this->_thread;
-    // need to reset the socket
-    std::vector<int>::iterator it;
-    for (it = _clientSockets.begin(); it != _clientSockets.end(); ++it) {
-      int clientSocket = *it;
-      close(clientSocket);
-    }
-    _clientSockets.clear();
-    if (_serverSocket > 0) {
-      logger_->log_debug("ListenSysLog Server socket %d close", _serverSocket);
-      close(_serverSocket);
-      _serverSocket = 0;
-    }
+    stopServerSocket();
   }
   // Processor Name
   static constexpr char const *ProcessorName = "ListenSyslog";
@@ -144,10 +130,6 @@ class ListenSyslog : public core::Processor {
  private:
   // Logger
   std::shared_ptr<logging::Logger> logger_;
-  // Run function for the thread
-  static void run(ListenSyslog *process);
-  // Run Thread
-  void runThread();
   // Queue for store syslog event
   std::queue<SysLogEvent> _eventQueue;
   // Size of Event queue in bytes
@@ -176,10 +158,18 @@ class ListenSyslog : public core::Processor {
     _eventQueue.push(event);
     _eventQueueByteSize += len;
   }
-  // Read \n terminated line from TCP socket
-  int readline(int fd, char *bufptr, size_t len);
-  // start server socket and handling client socket
-  void startSocketThread();
+  // Open the server socket and register it with the reactor
+  void startServerSocket();
+  // Close the server socket and the client sockets
+  void stopServerSocket();
+  // Accept the pending TCP connections
+  void acceptClients(int fd);
+  // Read the \n terminated lines a TCP client has sent
+  void readClient(int fd);
+  // Read the pending UDP datagrams
+  void readDatagrams(int fd);
+  // Put a copy of the message into the event queue, unless the queue is full
+  void putMessage(const char *message, size_t len);
   // Poll event
   void pollEvent(std::queue<SysLogEvent> &list, int maxSize) {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -202,15 +192,12 @@ class ListenSyslog : public core::Processor {
   std::string _protocol;
   int64_t _port;bool _parseMessages;
   int _serverSocket;
-  std::vector<int> _clientSockets;
-  int _maxFds;
-  fd_set _readfds;
-  // thread
-  std::thread *_thread;
-  // whether to reset the server socket
-  bool _resetServerSocket;bool _serverTheadRunning;
-  // buffer for read socket
-  char _buffer[2048];
+  // Mutex for protection of the sockets
+  std::mutex socket_mutex_;
+  // client sockets with the part of a line received from them
+  std::map<int, std::string> _clientSockets;
+  // reactor the sockets are registered with
+  std::shared_ptr<io::Reactor> reactor_;
 };
 
 REGISTER_RESOURCE(ListenSyslog,"Listens for Syslog messages being sent to a given port over TCP or UDP. Incoming messages are checked against regular expressions for RFC5424 and RFC3164 formatted messages. "
@@ -54,6 +54,8 @@ class Configure : public Properties {
   static const char *nifi_flow_repository_class_name;
   static const char *nifi_content_repository_class_name;
   static const char *nifi_volatile_repository_options;
+  static const char *nifi_tiered_content_repository_spill_age;
+  static const char *nifi_tiered_content_repository_spill_threshold;
   static const char *nifi_provenance_repository_class_name;
   static const char *nifi_server_port;
   static const char *nifi_server_report_interval;
@@ -61,13 +63,28 @@ class Configure : public Properties {
   static const char *nifi_provenance_repository_max_storage_size;
   static const char *nifi_provenance_repository_directory_default;
   static const char *nifi_provenance_repository_enable;
+  static const char *nifi_provenance_policy_excluded_event_types;
+  static const char *nifi_provenance_policy_excluded_components;
+  static const char *nifi_provenance_policy_sample_rate;
+  static const char *nifi_provenance_policy_max_events_per_second;
+  static const char *nifi_provenance_policy_summary_interval;
   static const char *nifi_flowfile_repository_max_storage_time;
   static const char *nifi_dbcontent_repository_directory_default;
   static const char *nifi_flowfile_repository_max_storage_size;
   static const char *nifi_flowfile_repository_directory_default;
   static const char *nifi_flowfile_repository_enable;
+  static const char *nifi_flowfile_repository_recovery_threads;
+  static const char *nifi_flowfile_repository_wal_segment_size;
+  static const char *nifi_flowfile_repository_wal_snapshot_interval;
+  static const char *nifi_flowfile_repository_wal_sync;
+  static const char *nifi_rocksdb_block_cache_size;
+  static const char *nifi_rocksdb_write_buffer_limit;
+  static const char *nifi_rocksdb_compaction_threads;
+  static const char *nifi_rocksdb_flush_threads;
   static const char *nifi_remote_input_secure;
   static const char *nifi_remote_input_http;
+  static const char *nifi_remote_input_host;
+  static const char *nifi_remote_input_socket_port;
   static const char *nifi_security_need_ClientAuth;
   // site2site security config
   static const char *nifi_security_client_certificate;
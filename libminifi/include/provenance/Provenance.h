@@ -350,6 +350,8 @@ class ProvenanceEventRecord : public core::SerializableComponent {
   }
   // Serialize and Persistent to the repository
   bool Serialize(const std::shared_ptr<core::SerializableComponent> &repo);
+  // Serialize into the stream, leaving it to the caller to persist
+  bool Serialize(org::apache::nifi::minifi::io::DataStream &outStream);
   // DeSerialize
   bool DeSerialize(const uint8_t *buffer, const size_t bufferSize);
   // DeSerialize
@@ -387,6 +389,47 @@ class ProvenanceEventRecord : public core::SerializableComponent {
     return event_time;
   }
 
+  /**
+   * Reads the event time from a serialized event, without deserializing the rest of it.
+   * @return true if the event time could be read
+   */
+  static bool readEventTime(const uint8_t *buffer, const size_t bufferSize, uint64_t &eventTime) {
+    // the stream copies its buffer, so only take the prefix that holds the event id, as getEventTime does
+    org::apache::nifi::minifi::io::Serializable reader;
+    org::apache::nifi::minifi::io::DataStream outStream(buffer, bufferSize > 72 ? 72 : bufferSize);
+
+    std::string eventId;
+    uint32_t eventType;
+    return reader.readUTF(eventId, &outStream) > 0 && reader.read(eventType, &outStream) == 4 && reader.read(eventTime, &outStream) == 8;
+  }
+
+  /**
+   * Reads the fields by which events are indexed from a serialized event, without
+   * deserializing the rest of it.
+   * @return true if the fields could be read
+   */
+  static bool getIndexedFields(const uint8_t *buffer, const size_t bufferSize, std::string &eventId, uint32_t &eventType, uint64_t &eventTime, std::string &componentId,
+                               std::string &flowFileUuid) {
+    org::apache::nifi::minifi::io::Serializable reader;
+    org::apache::nifi::minifi::io::DataStream outStream(buffer, bufferSize);
+
+    if (reader.readUTF(eventId, &outStream) <= 0) {
+      return false;
+    }
+    if (reader.read(eventType, &outStream) != 4 || reader.read(eventTime, &outStream) != 8) {
+      return false;
+    }
+    // entry date, duration and lineage start date precede the component
+    uint64_t skipped;
+    for (int i = 0; i < 3; i++) {
+      if (reader.read(skipped, &outStream) != 8) {
+        return false;
+      }
+    }
+    std::string componentType;
+    return reader.readUTF(componentId, &outStream) > 0 && reader.readUTF(componentType, &outStream) > 0 && reader.readUTF(flowFileUuid, &outStream) > 0;
+  }
+
  protected:
 
   // Event type
@@ -441,6 +484,8 @@ class ProvenanceEventRecord : public core::SerializableComponent {
   static std::shared_ptr<utils::IdGenerator> id_generator_;
 };
 
+class ComponentProvenancePolicy;
+
 // Provenance Reporter
 class ProvenanceReporter {
  public:
@@ -448,12 +493,7 @@ class ProvenanceReporter {
   /*!
    * Create a new provenance reporter associated with the process session
    */
-  ProvenanceReporter(std::shared_ptr<core::Repository> repo, std::string componentId, std::string componentType)
-      : logger_(logging::LoggerFactory<ProvenanceReporter>::getLogger()) {
-    _componentId = componentId;
-    _componentType = componentType;
-    repo_ = repo;
-  }
+  ProvenanceReporter(std::shared_ptr<core::Repository> repo, std::string componentId, std::string componentType);
 
   // Destructor
   virtual ~ProvenanceReporter() {
@@ -510,14 +550,10 @@ class ProvenanceReporter {
 
  protected:
 
-  // allocate
-  ProvenanceEventRecord *allocate(ProvenanceEventRecord::ProvenanceEventType eventType, std::shared_ptr<core::FlowFile> flow) {
-    ProvenanceEventRecord *event = new ProvenanceEventRecord(eventType, _componentId, _componentType);
-    if (event)
-      event->fromFlowFile(flow);
-
-    return event;
-  }
+  /**
+   * Creates an event of the given type, or returns null if the provenance policy drops it.
+   */
+  ProvenanceEventRecord *allocate(ProvenanceEventRecord::ProvenanceEventType eventType, std::shared_ptr<core::FlowFile> flow);
 
   // Component ID
   std::string _componentId;
@@ -531,6 +567,8 @@ class ProvenanceReporter {
   std::set<ProvenanceEventRecord *> _events;
   // provenance repository.
   std::shared_ptr<core::Repository> repo_;
+  // policy of the component, null if every event is recorded
+  std::shared_ptr<ComponentProvenancePolicy> policy_;
 
   // Prevent default copy constructor and assignment operation
   // Only support pass by reference or pointer
@@ -0,0 +1,119 @@
+/**
+ * @file ProvenancePolicy.h
+ * ProvenancePolicy class declaration
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_PROVENANCE_PROVENANCEPOLICY_H_
+#define LIBMINIFI_INCLUDE_PROVENANCE_PROVENANCEPOLICY_H_
+
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "provenance/Provenance.h"
+#include "properties/Configure.h"
+#include "core/logging/Logger.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace provenance {
+
+#define PROVENANCE_EVENT_TYPES (ProvenanceEventRecord::REPLAY + 1)
+
+/**
+ * Decides which provenance events of a single component are recorded. Events may be excluded
+ * by type; the rest may be sampled one in N per type and limited to a number per second.
+ * Events dropped by sampling or by the rate limit are counted and reported in summary events.
+ */
+class ComponentProvenancePolicy {
+ public:
+  ComponentProvenancePolicy(const std::bitset<PROVENANCE_EVENT_TYPES> &excluded_types, uint64_t sample_rate, uint64_t max_events_per_second, uint64_t summary_interval_ms);
+
+  /**
+   * Returns true if an event of the given type is to be recorded. This is consulted before
+   * the event is created, so that dropped events are never built or serialized.
+   */
+  bool accept(ProvenanceEventRecord::ProvenanceEventType type);
+
+  /**
+   * Creates one summary event per type for the events dropped since the last summary, once
+   * the summary interval has elapsed. The caller takes ownership of the events.
+   */
+  std::vector<ProvenanceEventRecord*> takeSummaries(const std::string &componentId, const std::string &componentType);
+
+ private:
+  std::mutex mutex_;
+  std::bitset<PROVENANCE_EVENT_TYPES> excluded_types_;
+  // one in sample_rate_ events of each type is recorded
+  uint64_t sample_rate_;
+  // zero if the number of events is not limited
+  uint64_t max_events_per_second_;
+  // zero if dropped events are not summarized
+  uint64_t summary_interval_ms_;
+  uint64_t offered_[PROVENANCE_EVENT_TYPES];
+  uint64_t dropped_[PROVENANCE_EVENT_TYPES];
+  uint64_t window_start_ms_;
+  uint64_t window_events_;
+  uint64_t last_summary_ms_;
+};
+
+/**
+ * Provenance policy of the agent, configured in minifi.properties. It is attached to the
+ * provenance repository, and each ProvenanceReporter looks up the policy of its component.
+ */
+class ProvenancePolicy {
+ public:
+  ProvenancePolicy(const std::set<std::string> &excluded_components, const std::bitset<PROVENANCE_EVENT_TYPES> &excluded_types, uint64_t sample_rate, uint64_t max_events_per_second,
+                   uint64_t summary_interval_ms);
+
+  /**
+   * Creates the configured policy.
+   * @return null if every event is to be recorded
+   */
+  static std::shared_ptr<ProvenancePolicy> create(const std::shared_ptr<Configure> &configure);
+
+  /**
+   * Returns the policy of the component, which is shared by all of its sessions so that rate
+   * limits span them.
+   * @return null if every event of the component is to be recorded
+   */
+  std::shared_ptr<ComponentProvenancePolicy> getComponentPolicy(const std::string &componentId);
+
+ private:
+  std::mutex mutex_;
+  std::set<std::string> excluded_components_;
+  std::bitset<PROVENANCE_EVENT_TYPES> excluded_types_;
+  uint64_t sample_rate_;
+  uint64_t max_events_per_second_;
+  uint64_t summary_interval_ms_;
+  std::map<std::string, std::shared_ptr<ComponentProvenancePolicy>> components_;
+  static std::shared_ptr<logging::Logger> logger_;
+};
+
+} /* namespace provenance */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+
+#endif /* LIBMINIFI_INCLUDE_PROVENANCE_PROVENANCEPOLICY_H_ */
@@ -0,0 +1,110 @@
+/**
+ * @file CompressionStream.h
+ * CompressionOutputStream and CompressionInputStream class declarations
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_SITETOSITE_COMPRESSIONSTREAM_H_
+#define LIBMINIFI_INCLUDE_SITETOSITE_COMPRESSIONSTREAM_H_
+
+#include <cstdint>
+#include <vector>
+#include "io/DataStream.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace sitetosite {
+
+// size of the uncompressed chunks, as used by NiFi
+#define COMPRESSION_CHUNK_SIZE (64 * 1024)
+// largest uncompressed chunk accepted from a peer
+#define MAX_COMPRESSION_CHUNK_SIZE (16 * 1024 * 1024)
+
+/**
+ * Compresses the data of a site to site data packet in the framing of NiFi's
+ * CompressionOutputStream: data is deflated in chunks, each written as "SYNC", the
+ * uncompressed and the compressed length as big endian 32 bit integers and the compressed
+ * bytes. Chunks after the first are preceded by a 1, and the packet is terminated by a 0.
+ * The underlying stream is not owned.
+ */
+class CompressionOutputStream {
+ public:
+  explicit CompressionOutputStream(io::DataStream *stream);
+
+  /**
+   * Buffers the data, writing every chunk that fills up.
+   * @return len, or -1 if a chunk could not be written
+   */
+  int write(const uint8_t *value, int len);
+
+  /**
+   * Writes the buffered data and the end of the packet.
+   * @return 1, or -1 if the data could not be written
+   */
+  int close();
+
+ private:
+  int writeChunk();
+
+  io::DataStream *stream_;
+  std::vector<uint8_t> buffer_;
+  std::vector<uint8_t> compressed_;
+  bool data_written_;
+};
+
+/**
+ * Reads data written by a CompressionOutputStream. The end of the packet is consumed along
+ * with its last chunk, so that the stream is finished once all of the data has been read.
+ * The underlying stream is not owned.
+ */
+class CompressionInputStream {
+ public:
+  explicit CompressionInputStream(io::DataStream *stream);
+
+  /**
+   * Reads up to len bytes, fewer only if the packet ends.
+   * @return number of bytes read, or -1 if a chunk is malformed or could not be read
+   */
+  int read(uint8_t *value, int len);
+
+  /**
+   * Returns true once all of the data of the packet has been read.
+   */
+  bool finished() const {
+    return all_data_read_ && index_ == buffer_.size();
+  }
+
+ private:
+  bool readChunk();
+
+  bool readFully(uint8_t *value, int len);
+
+  io::DataStream *stream_;
+  std::vector<uint8_t> buffer_;
+  std::vector<uint8_t> compressed_;
+  size_t index_;
+  bool all_data_read_;
+};
+
+} /* namespace sitetosite */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+
+#endif /* LIBMINIFI_INCLUDE_SITETOSITE_COMPRESSIONSTREAM_H_ */
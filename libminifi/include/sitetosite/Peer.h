@@ -36,6 +36,8 @@
 #include "io/DataStream.h"
 #include "utils/TimeUtil.h"
 #include "utils/HTTPClient.h"
+#include "sitetosite/CompressionStream.h"
+#include "io/BufferedStream.h"
 
 namespace org {
 namespace apache {
@@ -118,7 +120,7 @@ class PeerStatus {
     return peer_;
   }
 
-  uint32_t getFlowFileCount() {
+  uint32_t getFlowFileCount() const {
     return flow_file_count_;
   }
 
@@ -167,6 +169,7 @@ class SiteToSitePeer : public org::apache::nifi::minifi::io::BaseStream {
 
   explicit SiteToSitePeer(SiteToSitePeer &&ss)
       : stream_(ss.stream_.release()),
+        buffered_stream_(std::move(ss.buffered_stream_)),
         host_(std::move(ss.host_)),
         port_(std::move(ss.port_)),
         local_network_interface_(std::move(ss.local_network_interface_)),
@@ -283,61 +286,103 @@ class SiteToSitePeer : public org::apache::nifi::minifi::io::BaseStream {
   }
 
   void setStream(std::unique_ptr<org::apache::nifi::minifi::io::DataStream> stream) {
+    buffered_stream_ = nullptr;
     stream_ = nullptr;
     if (stream)
       stream_ = std::move(stream);
   }
 
+  /**
+   * Buffers the protocol written to the stream, so that small writes such as length fields
+   * are sent together. Buffered data is sent by flush, before every read, and once the
+   * buffer fills up.
+   */
+  void setBufferedWrites(bool buffered);
+
+  /**
+   * Sends the buffered data. Must be called when the protocol awaits no response after
+   * its last write.
+   * @return number of bytes sent, or -1 if the data could not be sent
+   */
+  int flush();
+
   org::apache::nifi::minifi::io::DataStream *getStream() {
     return stream_.get();
   }
 
   int write(uint8_t value, bool is_little_endian = minifi::io::EndiannessCheck::IS_LITTLE) {
-    return Serializable::write(value, stream_.get());
+    return Serializable::write(value, getProtocolStream());
   }
   int write(char value, bool is_little_endian = minifi::io::EndiannessCheck::IS_LITTLE) {
-    return Serializable::write(value, stream_.get());
+    return Serializable::write(value, getProtocolStream());
   }
   int write(uint32_t value, bool is_little_endian = minifi::io::EndiannessCheck::IS_LITTLE) {
-    return Serializable::write(value, stream_.get());
+    return Serializable::write(value, getProtocolStream());
   }
   int write(uint16_t value, bool is_little_endian = minifi::io::EndiannessCheck::IS_LITTLE) {
-    return Serializable::write(value, stream_.get());
+    return Serializable::write(value, getProtocolStream());
   }
   int write(uint8_t *value, int len) {
-    return Serializable::write(value, len, stream_.get());
+    if (compression_output_ != nullptr)
+      return compression_output_->write(value, len);
+    return Serializable::write(value, len, getProtocolStream());
   }
   int write(uint64_t value, bool is_little_endian = minifi::io::EndiannessCheck::IS_LITTLE) {
-    return Serializable::write(value, stream_.get());
+    return Serializable::write(value, getProtocolStream());
   }
   int write(bool value) {
     uint8_t temp = value;
-    return Serializable::write(temp, stream_.get());
+    return Serializable::write(temp, getProtocolStream());
   }
   int writeUTF(std::string str, bool widen = false) {
-    return Serializable::writeUTF(str, stream_.get(), widen);
+    return Serializable::writeUTF(str, getProtocolStream(), widen);
   }
   int read(uint8_t &value) {
-    return Serializable::read(value, stream_.get());
+    return Serializable::read(value, getProtocolStream());
   }
   int read(uint16_t &value, bool is_little_endian = minifi::io::EndiannessCheck::IS_LITTLE) {
-    return Serializable::read(value, stream_.get());
+    return Serializable::read(value, getProtocolStream());
   }
   int read(char &value) {
-    return Serializable::read(value, stream_.get());
+    return Serializable::read(value, getProtocolStream());
   }
   int read(uint8_t *value, int len) {
-    return Serializable::read(value, len, stream_.get());
+    if (compression_input_ != nullptr) {
+      int ret = compression_input_->read(value, len);
+      if (compression_input_->finished())
+        compression_input_ = nullptr;
+      return ret;
+    }
+    return Serializable::read(value, len, getProtocolStream());
   }
   int read(uint32_t &value, bool is_little_endian = minifi::io::EndiannessCheck::IS_LITTLE) {
-    return Serializable::read(value, stream_.get());
+    return Serializable::read(value, getProtocolStream());
   }
   int read(uint64_t &value, bool is_little_endian = minifi::io::EndiannessCheck::IS_LITTLE) {
-    return Serializable::read(value, stream_.get());
+    return Serializable::read(value, getProtocolStream());
   }
   int readUTF(std::string &str, bool widen = false) {
-    return org::apache::nifi::minifi::io::Serializable::readUTF(str, stream_.get(), widen);
+    return org::apache::nifi::minifi::io::Serializable::readUTF(str, getProtocolStream(), widen);
   }
+  /**
+   * Compresses the data written with write(uint8_t *, int), through which transactions
+   * write their data packets, until finishCompressedWrite is called.
+   */
+  void startCompressedWrite();
+  /**
+   * Writes the remaining compressed data and the end of the packet.
+   * @return 1, or -1 if the data could not be written
+   */
+  int finishCompressedWrite();
+  /**
+   * Decompresses the data read with read(uint8_t *, int) until the end of the packet
+   * has been read.
+   */
+  void startCompressedRead();
+  /**
+   * Stops decompressing reads, discarding whatever remains of the packet being read.
+   */
+  void finishCompressedRead();
   // open connection to the peer
   bool Open();
   // close connection to the peer
@@ -348,6 +393,7 @@ class SiteToSitePeer : public org::apache::nifi::minifi::io::BaseStream {
    */
   SiteToSitePeer& operator=(SiteToSitePeer&& other) {
     stream_ = std::unique_ptr<org::apache::nifi::minifi::io::DataStream>(other.stream_.release());
+    buffered_stream_ = std::move(other.buffered_stream_);
     host_ = std::move(other.host_);
     port_ = std::move(other.port_);
     local_network_interface_ = std::move(other.local_network_interface_);
@@ -364,9 +410,22 @@ class SiteToSitePeer : public org::apache::nifi::minifi::io::BaseStream {
  protected:
 
  private:
+  // stream through which the protocol is written and read
+  io::DataStream *getProtocolStream() {
+    if (buffered_stream_ != nullptr)
+      return buffered_stream_.get();
+    return stream_.get();
+  }
 
   std::unique_ptr<org::apache::nifi::minifi::io::DataStream> stream_;
 
+  // buffers the writes to stream_ when buffered writes are enabled
+  std::unique_ptr<io::BufferedStream> buffered_stream_;
+
+  // set while a compressed data packet is written or read
+  std::unique_ptr<CompressionOutputStream> compression_output_;
+  std::unique_ptr<CompressionInputStream> compression_input_;
+
   std::string host_;
 
   uint16_t port_;
@@ -391,6 +450,28 @@ class SiteToSitePeer : public org::apache::nifi::minifi::io::BaseStream {
   std::shared_ptr<logging::Logger> logger_;
 };
 
+/**
+ * Ends the compressed read of a peer, if any, when it goes out of scope, so that a packet that
+ * could not be read to its end does not leave the peer decompressing the data that follows.
+ */
+class CompressedReadGuard {
+ public:
+  explicit CompressedReadGuard(SiteToSitePeer *peer)
+      : peer_(peer) {
+  }
+
+  ~CompressedReadGuard() {
+    if (peer_ != nullptr)
+      peer_->finishCompressedRead();
+  }
+
+  CompressedReadGuard(const CompressedReadGuard &parent) = delete;
+  CompressedReadGuard &operator=(const CompressedReadGuard &parent) = delete;
+
+ private:
+  SiteToSitePeer *peer_;
+};
+
 } /* namespace sitetosite */
 } /* namespace minifi */
 } /* namespace nifi */
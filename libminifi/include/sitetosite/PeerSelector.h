@@ -0,0 +1,90 @@
+/**
+ * @file PeerSelector.h
+ * PeerSelector class declaration
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_SITETOSITE_PEERSELECTOR_H_
+#define LIBMINIFI_INCLUDE_SITETOSITE_PEERSELECTOR_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include "sitetosite/Peer.h"
+#include "sitetosite/SiteToSite.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace sitetosite {
+
+// entries in the list of destinations, as in NiFi
+#define PEER_SELECTOR_DESTINATIONS (128)
+// no peer gets more than this share of the flow files queued in the cluster counted against it
+#define PEER_SELECTOR_MAX_SHARE (0.8)
+
+/**
+ * Selects the peer of each new site to site client, as NiFi's PeerSelector does. Each peer
+ * appears in a shuffled list of destinations in proportion to its weight: peers with fewer
+ * queued flow files are weighted higher when sending, and peers with more when receiving.
+ * Penalized peers are skipped until their penalty expires.
+ */
+class PeerSelector {
+ public:
+  PeerSelector();
+
+  /**
+   * Replaces the peers and re-weights them by the flow file counts they reported.
+   */
+  void setPeers(const std::vector<PeerStatus> &peers, TransferDirection direction);
+
+  /**
+   * Returns the next destination that is not penalized.
+   * @return null if there are no peers or all of them are penalized
+   */
+  std::shared_ptr<Peer> getNextPeer();
+
+  /**
+   * Skips the peer until the penalization period has passed.
+   */
+  void penalize(const std::string &host, uint16_t port, uint64_t penalization_ms);
+
+  /**
+   * Returns the number of entries of the peer in the list of destinations.
+   */
+  size_t getEntries(const std::string &host, uint16_t port);
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<Peer>> destinations_;
+  size_t index_;
+  // time until which peers, keyed by host:port, are skipped
+  std::map<std::string, uint64_t> penalized_until_;
+  std::mt19937 random_;
+};
+
+} /* namespace sitetosite */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+
+#endif /* LIBMINIFI_INCLUDE_SITETOSITE_PEERSELECTOR_H_ */
@@ -161,7 +161,12 @@ typedef enum {
   /**
    * * The Transaction ended in an error.
    * */
-  TRANSACTION_ERROR
+  TRANSACTION_ERROR,
+  /**
+   * * All data has been sent and the peer has been told that the transaction is finished.
+   * * Transaction awaits the peer's confirmation of the CRC.
+   * */
+  DATA_SENT
 } TransactionState;
 
 // Request Type
@@ -335,7 +340,8 @@ class SiteToSiteClientConfiguration {
       : stream_factory_(stream_factory),
         peer_(peer),
         local_network_interface_(ifc),
-        ssl_service_(nullptr) {
+        ssl_service_(nullptr),
+        use_compression_(false) {
     client_type_ = type;
   }
 
@@ -375,6 +381,14 @@ class SiteToSiteClientConfiguration {
     return this->proxy_;
   }
 
+  void setUseCompression(bool use_compression) {
+    use_compression_ = use_compression;
+  }
+
+  bool getUseCompression() const {
+    return use_compression_;
+  }
+
  protected:
 
   std::shared_ptr<io::StreamFactory> stream_factory_;
@@ -390,6 +404,9 @@ class SiteToSiteClientConfiguration {
   std::shared_ptr<controllers::SSLContextService> ssl_service_;
 
   utils::HTTPProxy proxy_;
+
+  // whether raw socket clients compress data packets
+  bool use_compression_;
 };
 #if defined(__GNUC__) || defined(__GNUG__)
 #pragma GCC diagnostic pop
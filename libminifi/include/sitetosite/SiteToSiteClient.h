@@ -19,6 +19,9 @@
 #ifndef LIBMINIFI_INCLUDE_CORE_SITETOSITE_SITETOSITECLIENT_H_
 #define LIBMINIFI_INCLUDE_CORE_SITETOSITE_SITETOSITECLIENT_H_
 
+#include <algorithm>
+#include <functional>
+#include <vector>
 #include "Peer.h"
 #include "SiteToSite.h"
 #include "core/ProcessSession.h"
@@ -31,6 +34,9 @@ namespace nifi {
 namespace minifi {
 namespace sitetosite {
 
+// largest read of received content, as every write to the content repository is flushed
+#define SITE2SITE_RECEIVE_BUFFER_SIZE (256 * 1024)
+
 /**
  * Represents a piece of data that is to be sent to or that was received from a
  * NiFi instance.
@@ -59,6 +65,7 @@ class SiteToSiteClient : public core::Connectable {
       : core::Connectable("SitetoSiteClient"),
         peer_state_(IDLE),
         _batchSendNanos(5000000000),
+        use_compression_(false),
         ssl_context_service_(nullptr),
         logger_(logging::LoggerFactory<SiteToSiteClient>::getLogger()) {
     _supportedVersion[0] = 5;
@@ -81,6 +88,25 @@ class SiteToSiteClient : public core::Connectable {
     ssl_context_service_ = context_service;
   }
 
+  /**
+   * Requests that data packets are compressed, which takes effect with the next handshake.
+   * Only the raw socket protocol supports compression.
+   */
+  void setUseCompression(bool use_compression) {
+    use_compression_ = use_compression;
+  }
+
+  bool getUseCompression() const {
+    return use_compression_;
+  }
+
+  /**
+   * Returns the peer this client communicates with.
+   */
+  const std::unique_ptr<SiteToSitePeer> &getPeer() const {
+    return peer_;
+  }
+
   /**
    * Creates a transaction using the transaction ID and the direction
    * @param transactionID transaction identifier
@@ -120,6 +146,26 @@ class SiteToSiteClient : public core::Connectable {
    */
   virtual bool transferFlowFiles(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session);
 
+  /**
+   * Starts a transaction that transfers a batch of flow files to server, and tells the server
+   * that the transaction is finished without waiting for its confirmation, so that other
+   * transactions can send their data in the meantime.
+   * @param context process context
+   * @param session process session
+   * @param transactionID set to the identifier of the transaction
+   * @returns true if a transaction was started, false if there was nothing to send, exception thrown on failure
+   */
+  virtual bool startTransferFlowFiles(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, std::string &transactionID);
+
+  /**
+   * Waits for the server to confirm a transaction started by startTransferFlowFiles, and
+   * completes it. The session may be committed once this returns.
+   * @param context process context
+   * @param transactionID transaction identifier
+   * @returns true if the transaction was completed, exception thrown otherwise
+   */
+  virtual bool finishTransferFlowFiles(const std::shared_ptr<core::ProcessContext> &context, const std::string &transactionID);
+
   /**
    * Receive flow files from server
    * @param context process context
@@ -145,6 +191,28 @@ class SiteToSiteClient : public core::Connectable {
   virtual bool transmitPayload(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, const std::string &payload,
                                std::map<std::string, std::string> attributes) = 0;
 
+  /**
+   * Transfers several payloads, each as its own data packet. Payloads are produced on demand so
+   * that only one is held in memory at a time.
+   * @param context process context
+   * @param session process session
+   * @param next fills its argument with the next payload, returning false once none remain
+   * @param attributes attributes of every data packet
+   * @returns true if the process succeeded, failure OR exception thrown otherwise
+   *
+   * Base implementation transfers each payload in its own transaction.
+   */
+  virtual bool transmitPayloads(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, const std::function<bool(std::string&)> &next,
+                                std::map<std::string, std::string> attributes) {
+    std::string payload;
+    while (next(payload)) {
+      if (!transmitPayload(context, session, payload, attributes)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   void setPortId(utils::Identifier &id) {
     port_id_ = id;
     port_id_str_ = port_id_.to_string();
@@ -218,6 +286,8 @@ class SiteToSiteClient : public core::Connectable {
   virtual void error(std::string transactionID);
 
   virtual bool confirm(std::string transactionID);
+  // Tell the peer that all data of a send transaction has been sent, without waiting for its confirmation
+  virtual bool finishSending(std::string transactionID);
   // deleteTransaction
   virtual void deleteTransaction(std::string transactionID);
 
@@ -231,6 +301,10 @@ class SiteToSiteClient : public core::Connectable {
   virtual int readResponse(const std::shared_ptr<Transaction> &transaction, RespondCode &code, std::string &message);
   // write respond
   virtual int writeResponse(const std::shared_ptr<Transaction> &transaction, RespondCode code, std::string message);
+  // Write the attributes and the content of a data packet to the transaction stream
+  // Return -1 when any error occurs, -2 when the flow file content could not be read
+  int16_t writePacket(const std::shared_ptr<Transaction> &transaction, DataPacket *packet, const std::shared_ptr<FlowFileRecord> &flowFile,
+                      const std::shared_ptr<core::ProcessSession> &session, uint64_t &len);
   // getRespondCodeContext
   virtual RespondCodeContext *getRespondCodeContext(RespondCode code) {
     for (unsigned int i = 0; i < sizeof(SiteToSiteRequest::respondCodeContext) / sizeof(RespondCodeContext); i++) {
@@ -261,6 +335,9 @@ class SiteToSiteClient : public core::Connectable {
   // BATCH_SEND_NANOS
   uint64_t _batchSendNanos;
 
+  // whether data packets are compressed
+  bool use_compression_;
+
   /***
    * versioning
    */
@@ -286,24 +363,27 @@ class WriteCallback : public OutputStreamCallback {
       : _packet(packet) {
   }
   DataPacket *_packet;
-  //void process(std::ofstream *stream) {
+  // reads the content from the transaction, which computes its CRC, straight into the content stream
   int64_t process(std::shared_ptr<io::BaseStream> stream) {
-    uint8_t buffer[16384];
-    int len = _packet->_size;
-    int total = 0;
+    std::vector<uint8_t> buffer(static_cast<size_t>(std::min<uint64_t>(_packet->_size, SITE2SITE_RECEIVE_BUFFER_SIZE)));
+    uint64_t len = _packet->_size;
+    uint64_t total = 0;
     while (len > 0) {
-	  int size = len < 16384 ? len : 16384; 
-      int ret = _packet->transaction_->getStream().readData(buffer, size);
+      int size = static_cast<int>(std::min<uint64_t>(len, buffer.size()));
+      int ret = _packet->transaction_->getStream().readData(buffer.data(), size);
       if (ret != size) {
         logging::LOG_ERROR(_packet->logger_reference_) << "Site2Site Receive Flow Size " << size << " Failed " << ret << ", should have received " << len;
         return -1;
       }
-      stream->write(buffer, size);
+      if (stream->writeData(buffer.data(), size) != size) {
+        logging::LOG_ERROR(_packet->logger_reference_) << "Site2Site Receive Flow could not write " << size << " bytes to the content repository";
+        return -1;
+      }
       len -= size;
       total += size;
     }
-    logging::LOG_INFO(_packet->logger_reference_) << "Received " << len << " from stream";
-    return len;
+    logging::LOG_INFO(_packet->logger_reference_) << "Received " << total << " from stream";
+    return total;
   }
 };
 // Nest Callback Class for read stream
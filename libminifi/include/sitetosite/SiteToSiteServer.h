@@ -0,0 +1,195 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_SITETOSITE_SITETOSITESERVER_H_
+#define LIBMINIFI_INCLUDE_SITETOSITE_SITETOSITESERVER_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "core/ProcessSession.h"
+#include "core/ProcessSessionFactory.h"
+#include "core/logging/LoggerConfiguration.h"
+#include "io/Reactor.h"
+#include "io/ServerSocket.h"
+#include "properties/Configure.h"
+#include "sitetosite/Peer.h"
+#include "sitetosite/SiteToSite.h"
+#include "utils/ThreadPool.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace sitetosite {
+
+// threads serving the requests of the connected instances
+#define SITE2SITE_SERVER_THREADS (4)
+// time the server waits for the data of a request
+#define SITE2SITE_SERVER_TIMEOUT_MS (30000)
+// time a transaction sends flow files for unless the client asks for another
+#define SITE2SITE_SERVER_BATCH_DURATION_MS (5000)
+// newest protocol and codec versions the server speaks
+#define SITE2SITE_SERVER_VERSION (5)
+#define SITE2SITE_SERVER_CODEC_VERSION (1)
+
+/**
+ * Purpose: Accepts site to site connections over the raw socket protocol, so that other
+ * instances can send flow files to the input ports of this agent and receive them from its
+ * output ports.
+ *
+ * Design: The listening socket accepts on the shared reactor, which also watches the connections
+ * while they are idle. Once a request arrives, the connection is handed to a thread of the
+ * server, which serves the whole transaction with blocking reads and writes before the
+ * connection is watched again, so the reactor threads never wait on a slow instance. At most
+ * as many transactions as the server has threads are served at once. Received flow files are
+ * written to the content repository as they are read, and sessions are committed once the
+ * client has confirmed the CRC of the transaction.
+ */
+class SiteToSiteServer {
+ public:
+  SiteToSiteServer(const std::string &host, uint16_t port, uint16_t threads = SITE2SITE_SERVER_THREADS);
+
+  ~SiteToSiteServer();
+
+  /**
+   * Returns the server listening on the configured site to site port, starting it if it is
+   * not running. The server stops once no port holds it. Ports configured with port 0 share a
+   * server listening on a port chosen by the system.
+   * @return server, or nullptr if no port is configured or it cannot be listened on
+   */
+  static std::shared_ptr<SiteToSiteServer> getServer(const std::shared_ptr<Configure> &configure);
+
+  /**
+   * Starts listening. A server created for port 0 listens on a port chosen by the system,
+   * which getPort returns once started.
+   * @return false if the port cannot be listened on
+   */
+  bool start();
+
+  /**
+   * Stops listening and closes the connections, waiting for the requests being served.
+   */
+  void stop();
+
+  /**
+   * Makes a port available to the connected instances.
+   * @param id identifier the instances know the port by
+   * @param name name of the port
+   * @param direction SEND for input ports, which instances send to, RECEIVE for output ports
+   * @param session_factory creates the sessions flow files are received into or sent from
+   */
+  void registerPort(const std::string &id, const std::string &name, TransferDirection direction, const std::shared_ptr<core::ProcessSessionFactory> &session_factory);
+
+  /**
+   * Removes a port. Transactions already started on it are completed.
+   */
+  void unregisterPort(const std::string &id);
+
+  uint16_t getPort() const {
+    return port_;
+  }
+
+  /**
+   * Returns the number of connected instances.
+   */
+  size_t getConnectionCount();
+
+  SiteToSiteServer(const SiteToSiteServer &other) = delete;
+  SiteToSiteServer &operator=(const SiteToSiteServer &other) = delete;
+
+ private:
+  struct Port {
+    std::string name;
+    TransferDirection direction;
+    std::shared_ptr<core::ProcessSessionFactory> session_factory;
+  };
+
+  struct Connection {
+    int fd;
+    std::unique_ptr<SiteToSitePeer> peer;
+    PeerState state;
+    uint32_t version;
+    std::string port_id;
+    bool use_compression;
+    uint64_t batch_count;
+    uint64_t batch_size;
+    uint64_t batch_duration;
+  };
+
+  // takes over an accepted connection
+  void addConnection(int fd);
+
+  // watches the idle connection for its next request. Must be called while holding mutex_
+  bool watch(int fd);
+
+  // serves the request that has arrived on the connection on a thread of the server
+  void dispatch(int fd);
+
+  void closeConnection(int fd);
+
+  // serves the request that has arrived on the connection, returning false once it is to be closed
+  bool serve(Connection &connection);
+
+  // reads the magic bytes, negotiates the protocol version and handshakes
+  bool establish(Connection &connection);
+
+  bool handShake(Connection &connection);
+
+  bool negotiateCodec(Connection &connection);
+
+  bool sendPeerList(Connection &connection);
+
+  // receives the flow files an instance sends to an input port
+  bool receiveFlowFiles(Connection &connection, const std::shared_ptr<Port> &port);
+
+  // sends the flow files queued at an output port to an instance
+  bool sendFlowFiles(Connection &connection, const std::shared_ptr<Port> &port);
+
+  std::shared_ptr<Port> getPort(const std::string &id);
+
+  int readResponse(Connection &connection, RespondCode &code, std::string &message);
+
+  int writeResponse(Connection &connection, RespondCode code, const std::string &message);
+
+  std::string host_;
+  uint16_t port_;
+
+  std::unique_ptr<io::ServerSocket> server_socket_;
+
+  // watches the idle connections
+  std::shared_ptr<io::Reactor> reactor_;
+
+  // serves the requests of the connections
+  utils::ThreadPool<bool> pool_;
+
+  std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<Port>> ports_;
+  std::map<int, std::shared_ptr<Connection>> connections_;
+
+  std::shared_ptr<logging::Logger> logger_;
+};
+
+} /* namespace sitetosite */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+
+#endif /* LIBMINIFI_INCLUDE_SITETOSITE_SITETOSITESERVER_H_ */
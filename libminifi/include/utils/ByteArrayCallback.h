@@ -119,7 +119,7 @@ class ByteOutputCallback : public OutputStreamCallback {
 
   virtual void write(char *data, size_t size);
 
-  size_t readFully(char *buffer, size_t size);
+  virtual size_t readFully(char *buffer, size_t size);
 
  protected:
 
@@ -161,6 +161,27 @@ class StreamOutputCallback : public ByteOutputCallback {
   virtual int64_t process(std::shared_ptr<io::BaseStream> stream);
 };
 
+/**
+ * Hands the data of the writer directly to the buffer of the reader, rather than queueing
+ * copies of it. A write blocks until the reader has consumed all of its data or the callback
+ * is closed, so that the writer is paced by the reader.
+ */
+class HandoffOutputCallback : public ByteOutputCallback {
+ public:
+  HandoffOutputCallback()
+      : ByteOutputCallback(0),
+        pending_(nullptr) {
+  }
+
+  virtual void write(char *data, size_t size);
+
+  virtual size_t readFully(char *buffer, size_t size);
+
+ private:
+  // data of the blocked write, which the reader has yet to consume
+  char *pending_;
+};
+
 } /* namespace utils */
 } /* namespace minifi */
 } /* namespace nifi */
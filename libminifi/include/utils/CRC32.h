@@ -0,0 +1,60 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_UTILS_CRC32_H_
+#define LIBMINIFI_INCLUDE_UTILS_CRC32_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace utils {
+
+/**
+ * Purpose: Computes the CRC-32 used by zlib, and by NiFi to confirm site to site transactions.
+ *
+ * Design: The implementation is chosen once at runtime. On x86 processors supporting PCLMULQDQ
+ * the buffer is folded with carry-less multiplications, and on ARMv8 processors supporting the
+ * CRC32 instructions these are used. Otherwise zlib's crc32() is called. All of them give the
+ * same result as zlib.
+ */
+class CRC32 {
+ public:
+  /**
+   * Updates the checksum with the given bytes, as zlib's crc32() does.
+   * @param crc checksum of the preceding bytes, 0 if there are none
+   * @param data bytes to add
+   * @param length number of bytes
+   * @return checksum including the bytes
+   */
+  static uint32_t update(uint32_t crc, const uint8_t *data, size_t length);
+
+  /**
+   * Returns the name of the implementation in use.
+   */
+  static const char *getImplementation();
+};
+
+} /* namespace utils */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+#endif /* LIBMINIFI_INCLUDE_UTILS_CRC32_H_ */
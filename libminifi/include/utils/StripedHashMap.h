@@ -0,0 +1,213 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_UTILS_STRIPEDHASHMAP_H_
+#define LIBMINIFI_INCLUDE_UTILS_STRIPEDHASHMAP_H_
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace utils {
+
+#define DEFAULT_HASH_MAP_STRIPES 32
+
+/**
+ * Purpose: Hash map that splits its keys across a fixed number of independently locked
+ * stripes, so that threads operating on different keys rarely contend for the same mutex.
+ *
+ * Design: Each stripe is an unordered_map guarded by its own mutex. Operations touch exactly
+ * one stripe, selected by the hash of the key. Iteration locks one stripe at a time, so it
+ * does not represent a point in time snapshot of the whole map.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>>
+class StripedHashMap {
+ public:
+
+  explicit StripedHashMap(size_t stripes = DEFAULT_HASH_MAP_STRIPES)
+      : stripes_(stripes > 0 ? stripes : 1) {
+  }
+
+  StripedHashMap(const StripedHashMap &other) = delete;
+  StripedHashMap &operator=(const StripedHashMap &other) = delete;
+
+  /**
+   * Finds key, copying its value into value.
+   * @return true if the key exists.
+   */
+  bool find(const K &key, V &value) {
+    Stripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex_);
+    auto it = stripe.map_.find(key);
+    if (it == stripe.map_.end()) {
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+
+  /**
+   * Runs function against the value of key while holding the lock of its stripe.
+   * @return true if the key exists.
+   */
+  bool applyIfPresent(const K &key, const std::function<void(V&)> &function) {
+    Stripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex_);
+    auto it = stripe.map_.find(key);
+    if (it == stripe.map_.end()) {
+      return false;
+    }
+    function(it->second);
+    return true;
+  }
+
+  bool contains(const K &key) {
+    Stripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex_);
+    return stripe.map_.find(key) != stripe.map_.end();
+  }
+
+  /**
+   * Inserts or replaces the value associated with key.
+   */
+  void put(const K &key, const V &value) {
+    Stripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex_);
+    stripe.map_[key] = value;
+  }
+
+  /**
+   * Inserts or replaces the value associated with key.
+   * @return true if the key existed, with the value it replaced in previous.
+   */
+  bool exchange(const K &key, const V &value, V &previous) {
+    Stripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex_);
+    auto it = stripe.map_.find(key);
+    if (it == stripe.map_.end()) {
+      stripe.map_.insert(std::make_pair(key, value));
+      return false;
+    }
+    previous = std::move(it->second);
+    it->second = value;
+    return true;
+  }
+
+  /**
+   * Inserts value if key is not present.
+   * @return true if the value was inserted.
+   */
+  bool putIfAbsent(const K &key, const V &value) {
+    Stripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex_);
+    return stripe.map_.insert(std::make_pair(key, value)).second;
+  }
+
+  /**
+   * Removes key, moving its value into value.
+   * @return true if the key existed.
+   */
+  bool erase(const K &key, V &value) {
+    Stripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex_);
+    auto it = stripe.map_.find(key);
+    if (it == stripe.map_.end()) {
+      return false;
+    }
+    value = std::move(it->second);
+    stripe.map_.erase(it);
+    return true;
+  }
+
+  bool erase(const K &key) {
+    Stripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex_);
+    return stripe.map_.erase(key) > 0;
+  }
+
+  /**
+   * Removes key only if it is still mapped to value.
+   * @return true if the entry was removed.
+   */
+  bool eraseIfEqual(const K &key, const V &value) {
+    Stripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex_);
+    auto it = stripe.map_.find(key);
+    if (it == stripe.map_.end() || !(it->second == value)) {
+      return false;
+    }
+    stripe.map_.erase(it);
+    return true;
+  }
+
+  /**
+   * Runs function against every entry, holding the lock of one stripe at a time.
+   */
+  void forEach(const std::function<void(const K&, V&)> &function) {
+    for (auto &stripe : stripes_) {
+      std::lock_guard<std::mutex> lock(stripe.mutex_);
+      for (auto &entry : stripe.map_) {
+        function(entry.first, entry.second);
+      }
+    }
+  }
+
+  void clear() {
+    for (auto &stripe : stripes_) {
+      std::lock_guard<std::mutex> lock(stripe.mutex_);
+      stripe.map_.clear();
+    }
+  }
+
+  size_t size() {
+    size_t size = 0;
+    for (auto &stripe : stripes_) {
+      std::lock_guard<std::mutex> lock(stripe.mutex_);
+      size += stripe.map_.size();
+    }
+    return size;
+  }
+
+ private:
+
+  struct Stripe {
+    std::mutex mutex_;
+    std::unordered_map<K, V, Hash> map_;
+  };
+
+  inline Stripe &getStripe(const K &key) {
+    return stripes_[hash_(key) % stripes_.size()];
+  }
+
+  Hash hash_;
+  std::vector<Stripe> stripes_;
+};
+
+} /* namespace utils */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
+
+#endif /* LIBMINIFI_INCLUDE_UTILS_STRIPEDHASHMAP_H_ */
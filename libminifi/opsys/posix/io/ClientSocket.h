@@ -26,6 +26,7 @@
 #include <unistd.h>
 #include <mutex>
 #include <atomic>
+#include <vector>
 #include "io/BaseStream.h"
 #include "core/Core.h"
 #include "core/logging/Logger.h"
@@ -110,6 +111,13 @@ class Socket : public BaseStream {
    */
   uint16_t getPort();
 
+  /**
+   * Returns the file descriptor of the socket, or -1 if it is not connected.
+   */
+  int getDescriptor() const {
+    return socket_file_descriptor_;
+  }
+
   // data stream extensions
   /**
    * Reads data and places it into buf
@@ -160,6 +168,13 @@ class Socket : public BaseStream {
    */
   virtual int writeData(uint8_t *value, int size);
 
+  /**
+   * Writes the buffers with writev, in as few system calls as the kernel allows.
+   * @param iov buffers to write
+   * @param iovcnt number of buffers
+   */
+  virtual int writeV(const struct iovec *iov, int iovcnt);
+
   /**
    * Writes a system word
    * @param value value to write
@@ -253,6 +268,24 @@ class Socket : public BaseStream {
    */
   virtual int16_t select_descriptor(const uint16_t msec);
 
+  /**
+   * Adds a descriptor to those waited on by select_descriptor.
+   */
+  void add_descriptor(int fd);
+
+  /**
+   * Removes a descriptor from those waited on by select_descriptor.
+   */
+  void remove_descriptor(int fd);
+
+  /**
+   * Waits for one of the descriptors to become readable. Unlike select, poll is not
+   * bounded by FD_SETSIZE, so descriptors of any value may be waited on.
+   * @param msec timeout interval to wait, or 0 to wait indefinitely
+   * @returns readable descriptor, or -1 if none became readable
+   */
+  int poll_descriptors(const uint16_t msec);
+
   addrinfo *addr_info_;
 
   std::recursive_mutex selection_mutex_;
@@ -267,9 +300,8 @@ class Socket : public BaseStream {
   // connection information
   int32_t socket_file_descriptor_;
 
-  fd_set total_list_;
-  fd_set read_fds_;
-  std::atomic<uint16_t> socket_max_;
+  // descriptors waited on by select_descriptor, guarded by selection_mutex_
+  std::vector<int> descriptors_;
   std::atomic<uint64_t> total_written_;
   std::atomic<uint64_t> total_read_;
   uint16_t listeners_;
@@ -277,6 +277,23 @@ protected:
 	 */
 	virtual int16_t select_descriptor(const uint16_t msec);
 
+	/**
+	 * Adds a descriptor to those waited on by select_descriptor.
+	 */
+	void add_descriptor(int fd);
+
+	/**
+	 * Removes a descriptor from those waited on by select_descriptor.
+	 */
+	void remove_descriptor(int fd);
+
+	/**
+	 * Waits for one of the descriptors to become readable. A Windows fd_set holds up to
+	 * FD_SETSIZE sockets of any value, so select is kept here.
+	 * @param msec timeout interval to wait, or 0 to wait indefinitely
+	 * @returns readable descriptor, or -1 if none became readable
+	 */
+	int poll_descriptors(const uint16_t msec);
 
 	addrinfo *addr_info_;
 
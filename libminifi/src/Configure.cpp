@@ -37,18 +37,35 @@ const char *Configure::nifi_configuration_class_name = "nifi.flow.configuration.
 const char *Configure::nifi_flow_repository_class_name = "nifi.flowfile.repository.class.name";
 const char *Configure::nifi_content_repository_class_name = "nifi.content.repository.class.name";
 const char *Configure::nifi_volatile_repository_options = "nifi.volatile.repository.options.";
+const char *Configure::nifi_tiered_content_repository_spill_age = "nifi.tiered.content.repository.spill.age";
+const char *Configure::nifi_tiered_content_repository_spill_threshold = "nifi.tiered.content.repository.spill.threshold";
 const char *Configure::nifi_provenance_repository_class_name = "nifi.provenance.repository.class.name";
 const char *Configure::nifi_server_port = "nifi.server.port";
 const char *Configure::nifi_server_report_interval = "nifi.server.report.interval";
 const char *Configure::nifi_provenance_repository_max_storage_size = "nifi.provenance.repository.max.storage.size";
 const char *Configure::nifi_provenance_repository_max_storage_time = "nifi.provenance.repository.max.storage.time";
 const char *Configure::nifi_provenance_repository_directory_default = "nifi.provenance.repository.directory.default";
+const char *Configure::nifi_provenance_policy_excluded_event_types = "nifi.provenance.policy.excluded.event.types";
+const char *Configure::nifi_provenance_policy_excluded_components = "nifi.provenance.policy.excluded.components";
+const char *Configure::nifi_provenance_policy_sample_rate = "nifi.provenance.policy.sample.rate";
+const char *Configure::nifi_provenance_policy_max_events_per_second = "nifi.provenance.policy.max.events.per.second";
+const char *Configure::nifi_provenance_policy_summary_interval = "nifi.provenance.policy.summary.interval";
 const char *Configure::nifi_flowfile_repository_max_storage_size = "nifi.flowfile.repository.max.storage.size";
 const char *Configure::nifi_flowfile_repository_max_storage_time = "nifi.flowfile.repository.max.storage.time";
 const char *Configure::nifi_flowfile_repository_directory_default = "nifi.flowfile.repository.directory.default";
+const char *Configure::nifi_flowfile_repository_recovery_threads = "nifi.flowfile.repository.recovery.threads";
+const char *Configure::nifi_flowfile_repository_wal_segment_size = "nifi.flowfile.repository.wal.segment.size";
+const char *Configure::nifi_flowfile_repository_wal_snapshot_interval = "nifi.flowfile.repository.wal.snapshot.interval";
+const char *Configure::nifi_flowfile_repository_wal_sync = "nifi.flowfile.repository.wal.sync";
+const char *Configure::nifi_rocksdb_block_cache_size = "nifi.rocksdb.block.cache.size";
+const char *Configure::nifi_rocksdb_write_buffer_limit = "nifi.rocksdb.write.buffer.limit";
+const char *Configure::nifi_rocksdb_compaction_threads = "nifi.rocksdb.compaction.threads";
+const char *Configure::nifi_rocksdb_flush_threads = "nifi.rocksdb.flush.threads";
 const char *Configure::nifi_dbcontent_repository_directory_default = "nifi.database.content.repository.directory.default";
 const char *Configure::nifi_remote_input_secure = "nifi.remote.input.secure";
 const char *Configure::nifi_remote_input_http = "nifi.remote.input.http.enabled";
+const char *Configure::nifi_remote_input_host = "nifi.remote.input.host";
+const char *Configure::nifi_remote_input_socket_port = "nifi.remote.input.socket.port";
 const char *Configure::nifi_security_need_ClientAuth = "nifi.security.need.ClientAuth";
 const char *Configure::nifi_security_client_certificate = "nifi.security.client.certificate";
 const char *Configure::nifi_security_client_private_key = "nifi.security.client.private.key";
@@ -145,6 +145,7 @@ void Connection::put(std::shared_ptr<core::FlowFile> flow) {
     FlowFileRecord event(flow_repository_, content_repo_, flow, this->uuidStr_);
     if (event.Serialize()) {
       flow->setStoredToRepository(true);
+      flow->setStoredSize(event.getStoredSize());
     }
   }
 
@@ -155,6 +156,40 @@ void Connection::put(std::shared_ptr<core::FlowFile> flow) {
   }
 }
 
+void Connection::multiPut(std::vector<std::shared_ptr<core::FlowFile>> &flows) {
+  if (flows.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto &flow : flows) {
+      queue_.push(flow);
+      queued_data_size_ += flow->getSize();
+    }
+
+    logger_->log_debug("Enqueue %u flow files to connection %s", flows.size(), name_);
+  }
+
+  for (const auto &flow : flows) {
+    if (!flow->isStored()) {
+      // Save to the flowfile repo
+      std::shared_ptr<core::FlowFile> ff = flow;
+      FlowFileRecord event(flow_repository_, content_repo_, ff, this->uuidStr_);
+      if (event.Serialize()) {
+        flow->setStoredToRepository(true);
+        flow->setStoredSize(event.getStoredSize());
+      }
+    }
+  }
+
+  // Notify receiving processor that work may be available
+  if (dest_connectable_) {
+    logger_->log_debug("Notifying %s that %u flow files were inserted", dest_connectable_->getName(), flows.size());
+    dest_connectable_->notifyWork();
+  }
+}
+
 std::shared_ptr<core::FlowFile> Connection::poll(std::set<std::shared_ptr<core::FlowFile>> &expiredFlowRecords) {
   std::lock_guard<std::mutex> lock(mutex_);
 
@@ -169,7 +204,7 @@ std::shared_ptr<core::FlowFile> Connection::poll(std::set<std::shared_ptr<core::
         // Flow record expired
         expiredFlowRecords.insert(item);
         logger_->log_debug("Delete flow file UUID %s from connection %s, because it expired", item->getUUIDStr(), name_);
-        if (flow_repository_->Delete(item->getUUIDStr())) {
+        if (flow_repository_->Delete(item->getUUIDStr(), item->getResourceClaim(), item->getStoredSize())) {
           item->setStoredToRepository(false);
         }
       } else {
@@ -210,7 +245,7 @@ void Connection::drain() {
     std::shared_ptr<core::FlowFile> item = queue_.front();
     queue_.pop();
     logger_->log_debug("Delete flow file UUID %s from connection %s, because it expired", item->getUUIDStr(), name_);
-    if (flow_repository_->Delete(item->getUUIDStr())) {
+    if (flow_repository_->Delete(item->getUUIDStr(), item->getResourceClaim(), item->getStoredSize())) {
       item->setStoredToRepository(false);
     }
   }
@@ -54,6 +54,7 @@
 #include "core/Connectable.h"
 #include "utils/HTTPClient.h"
 #include "io/NetworkPrioritizer.h"
+#include "provenance/ProvenancePolicy.h"
 
 #ifdef _MSC_VER
 #ifndef PATH_MAX
@@ -114,6 +115,7 @@ FlowController::FlowController(std::shared_ptr<core::Repository> provenance_repo
   root_ = nullptr;
 
   protocol_ = new FlowControlProtocol(this, configure);
+  provenance_repo_->setProvenancePolicy(provenance::ProvenancePolicy::create(configure));
 
   if (!headless_mode) {
     std::string rawConfigFileString;
@@ -218,80 +218,291 @@ bool FlowFileRecord::DeSerialize(std::string key) {
 bool FlowFileRecord::Serialize() {
   io::DataStream outStream;
 
+  if (!Serialize(outStream)) {
+    return false;
+  }
+
+  if (flow_repository_->Put(uuidStr_, const_cast<uint8_t*>(outStream.getBuffer()), outStream.getSize())) {
+    logger_->log_debug("NiFi FlowFile Store event %s size %llu success", uuidStr_, outStream.getSize());
+    stored_size_ = outStream.getSize();
+    return true;
+  } else {
+    logger_->log_error("NiFi FlowFile Store event %s size %llu fail", uuidStr_, outStream.getSize());
+    return false;
+  }
+
+  return true;
+}
+
+bool FlowFileRecord::writeBinaryUuid(const std::string &uuid, io::DataStream &outStream) {
+  uuid_t binary;
+  char unparsed[37];
+  if (uuid.length() != 36 || uuid_parse(uuid.c_str(), binary) != 0) {
+    return false;
+  }
+  uuid_unparse_lower(binary, unparsed);
+  if (uuid != unparsed) {
+    return false;
+  }
+  return write(binary, sizeof(uuid_t), &outStream) == sizeof(uuid_t);
+}
+
+bool FlowFileRecord::readBinaryUuid(std::string &uuid, io::DataStream &inStream) {
+  uuid_t binary;
+  char unparsed[37];
+  if (read(binary, sizeof(uuid_t), &inStream) != sizeof(uuid_t)) {
+    return false;
+  }
+  uuid_unparse_lower(binary, unparsed);
+  uuid = unparsed;
+  return true;
+}
+
+bool FlowFileRecord::Serialize(io::DataStream &outStream) {
   int ret;
 
-  ret = write(this->event_time_, &outStream);
-  if (ret != 8) {
+  ret = write(static_cast<uint8_t>(FLOWFILE_RECORD_COMPACT_MARKER), &outStream);
+  if (ret != 1) {
     return false;
   }
 
-  ret = write(this->entry_date_, &outStream);
-  if (ret != 8) {
+  ret = writeVarInt(FLOWFILE_RECORD_COMPACT_VERSION, &outStream);
+  if (ret <= 0) {
     return false;
   }
 
-  ret = write(this->lineage_start_date_, &outStream);
-  if (ret != 8) {
+  std::string content_path = content_full_fath_;
+  uint64_t flags = 0;
+  if (nullptr != content_repo_) {
+    const std::string storage_path = content_repo_->getStoragePath();
+    if (!storage_path.empty() && content_path.length() > storage_path.length() + 1 && content_path.compare(0, storage_path.length(), storage_path) == 0
+        && content_path[storage_path.length()] == '/') {
+      // only the claim id is written; the storage path is restored from the content repository
+      content_path = content_path.substr(storage_path.length() + 1);
+      flags |= RELATIVE_CONTENT_PATH;
+    }
+  }
+
+  // the uuids are written after the flags, so encode them to a scratch stream first
+  io::DataStream uuidStream;
+  if (writeBinaryUuid(uuidStr_, uuidStream)) {
+    flags |= BINARY_UUID;
+  } else if (writeVarString(uuidStr_, &uuidStream) <= 0) {
+    return false;
+  }
+  if (writeBinaryUuid(uuid_connection_, uuidStream)) {
+    flags |= BINARY_CONNECTION_UUID;
+  } else if (writeVarString(uuid_connection_, &uuidStream) <= 0) {
     return false;
   }
 
-  ret = writeUTF(this->uuidStr_, &outStream);
+  ret = writeVarInt(flags, &outStream);
   if (ret <= 0) {
     return false;
   }
 
-  ret = writeUTF(this->uuid_connection_, &outStream);
+  // the entry and lineage dates are close to the event time, so they are written as offsets from it
+  ret = writeVarInt(event_time_, &outStream);
+  if (ret <= 0) {
+    return false;
+  }
+  ret = writeVarInt(event_time_ - entry_date_, &outStream);
+  if (ret <= 0) {
+    return false;
+  }
+  ret = writeVarInt(event_time_ - lineage_start_date_, &outStream);
   if (ret <= 0) {
     return false;
   }
+
+  ret = outStream.writeData(const_cast<uint8_t*>(uuidStream.getBuffer()), uuidStream.getSize());
+  if (ret != static_cast<int>(uuidStream.getSize())) {
+    return false;
+  }
+
   // write flow attributes
-  uint32_t numAttributes = this->attributes_.size();
-  ret = write(numAttributes, &outStream);
-  if (ret != 4) {
+  ret = writeVarInt(attributes_.size(), &outStream);
+  if (ret <= 0) {
     return false;
   }
 
-  for (auto itAttribute : attributes_) {
-    ret = writeUTF(itAttribute.first, &outStream, true);
+  for (const auto &itAttribute : attributes_) {
+    // well known keys are written as their index plus one, zero is followed by the key itself
+    uint64_t key_index = 0;
+    for (int i = 0; i < MAX_FLOW_ATTRIBUTES; i++) {
+      if (itAttribute.first == FlowAttributeKeyArray[i]) {
+        key_index = i + 1;
+        break;
+      }
+    }
+    ret = writeVarInt(key_index, &outStream);
     if (ret <= 0) {
       return false;
     }
-    ret = writeUTF(itAttribute.second, &outStream, true);
+    if (key_index == 0) {
+      ret = writeVarString(itAttribute.first, &outStream);
+      if (ret <= 0) {
+        return false;
+      }
+    }
+    ret = writeVarString(itAttribute.second, &outStream);
     if (ret <= 0) {
       return false;
     }
   }
 
-  ret = writeUTF(this->content_full_fath_, &outStream);
+  ret = writeVarString(content_path, &outStream);
   if (ret <= 0) {
     return false;
   }
 
-  ret = write(this->size_, &outStream);
-  if (ret != 8) {
+  ret = writeVarInt(size_, &outStream);
+  if (ret <= 0) {
     return false;
   }
 
-  ret = write(this->offset_, &outStream);
-  if (ret != 8) {
+  ret = writeVarInt(offset_, &outStream);
+  if (ret <= 0) {
     return false;
   }
 
-  if (flow_repository_->Put(uuidStr_, const_cast<uint8_t*>(outStream.getBuffer()), outStream.getSize())) {
-    logger_->log_debug("NiFi FlowFile Store event %s size %llu success", uuidStr_, outStream.getSize());
-    return true;
+  return true;
+}
+
+bool FlowFileRecord::DeSerialize(const uint8_t *buffer, const int bufferSize) {
+  if (bufferSize <= 0) {
+    return false;
+  }
+
+  io::DataStream inStream(buffer, bufferSize);
+
+  bool ret;
+  if (buffer[0] == FLOWFILE_RECORD_COMPACT_MARKER) {
+    ret = DeSerializeCompact(inStream);
   } else {
-    logger_->log_error("NiFi FlowFile Store event %s size %llu fail", uuidStr_, outStream.getSize());
+    ret = DeSerializeLegacy(inStream);
+  }
+  if (!ret) {
     return false;
   }
 
+  if (nullptr == claim_) {
+    claim_ = std::make_shared<ResourceClaim>(content_full_fath_, content_repo_, true);
+  }
   return true;
 }
 
-bool FlowFileRecord::DeSerialize(const uint8_t *buffer, const int bufferSize) {
+bool FlowFileRecord::DeSerializeCompact(io::DataStream &inStream) {
   int ret;
 
-  io::DataStream outStream(buffer, bufferSize);
+  uint8_t marker = 0;
+  ret = read(marker, &inStream);
+  if (ret != 1 || marker != FLOWFILE_RECORD_COMPACT_MARKER) {
+    return false;
+  }
+
+  uint64_t version = 0;
+  ret = readVarInt(version, &inStream);
+  if (ret <= 0 || version > FLOWFILE_RECORD_COMPACT_VERSION) {
+    logger_->log_error("Unsupported flow file record version %llu", version);
+    return false;
+  }
+
+  uint64_t flags = 0;
+  ret = readVarInt(flags, &inStream);
+  if (ret <= 0) {
+    return false;
+  }
+
+  uint64_t offset = 0;
+  ret = readVarInt(event_time_, &inStream);
+  if (ret <= 0) {
+    return false;
+  }
+  ret = readVarInt(offset, &inStream);
+  if (ret <= 0) {
+    return false;
+  }
+  entry_date_ = event_time_ - offset;
+  ret = readVarInt(offset, &inStream);
+  if (ret <= 0) {
+    return false;
+  }
+  lineage_start_date_ = event_time_ - offset;
+
+  if (flags & BINARY_UUID) {
+    if (!readBinaryUuid(uuidStr_, inStream)) {
+      return false;
+    }
+  } else if (readVarString(uuidStr_, &inStream) <= 0) {
+    return false;
+  }
+
+  if (flags & BINARY_CONNECTION_UUID) {
+    if (!readBinaryUuid(uuid_connection_, inStream)) {
+      return false;
+    }
+  } else if (readVarString(uuid_connection_, &inStream) <= 0) {
+    return false;
+  }
+
+  // read flow attributes
+  uint64_t numAttributes = 0;
+  ret = readVarInt(numAttributes, &inStream);
+  if (ret <= 0) {
+    return false;
+  }
+
+  for (uint64_t i = 0; i < numAttributes; i++) {
+    uint64_t key_index = 0;
+    ret = readVarInt(key_index, &inStream);
+    if (ret <= 0 || key_index > MAX_FLOW_ATTRIBUTES) {
+      return false;
+    }
+    std::string key;
+    if (key_index == 0) {
+      ret = readVarString(key, &inStream);
+      if (ret <= 0) {
+        return false;
+      }
+    } else {
+      key = FlowAttributeKeyArray[key_index - 1];
+    }
+    std::string value;
+    ret = readVarString(value, &inStream);
+    if (ret <= 0) {
+      return false;
+    }
+    this->attributes_[key] = value;
+  }
+
+  ret = readVarString(content_full_fath_, &inStream);
+  if (ret <= 0) {
+    return false;
+  }
+  if (flags & RELATIVE_CONTENT_PATH) {
+    if (nullptr == content_repo_) {
+      logger_->log_error("Cannot resolve content claim %s without a content repository", content_full_fath_);
+      return false;
+    }
+    content_full_fath_ = content_repo_->getStoragePath() + "/" + content_full_fath_;
+  }
+
+  ret = readVarInt(size_, &inStream);
+  if (ret <= 0) {
+    return false;
+  }
+
+  ret = readVarInt(offset_, &inStream);
+  if (ret <= 0) {
+    return false;
+  }
+
+  return true;
+}
+
+bool FlowFileRecord::DeSerializeLegacy(io::DataStream &outStream) {
+  int ret;
 
   ret = read(this->event_time_, &outStream);
   if (ret != 8) {
@@ -354,9 +565,6 @@ bool FlowFileRecord::DeSerialize(const uint8_t *buffer, const int bufferSize) {
     return false;
   }
 
-  if (nullptr == claim_) {
-    claim_ = std::make_shared<ResourceClaim>(content_full_fath_, content_repo_, true);
-  }
   return true;
 }
 
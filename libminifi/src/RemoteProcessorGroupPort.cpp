@@ -42,9 +42,11 @@
 #include "core/logging/Logger.h"
 #include "core/ProcessContext.h"
 #include "core/ProcessorNode.h"
+#include "core/ProcessSession.h"
 #include "core/Property.h"
 #include "core/Relationship.h"
 #include "utils/HTTPClient.h"
+#include "utils/TimeUtil.h"
 
 namespace org {
 namespace apache {
@@ -58,31 +60,40 @@ core::Property RemoteProcessorGroupPort::hostName("Host Name", "Remote Host Name
 core::Property RemoteProcessorGroupPort::SSLContext("SSL Context Service", "The SSL Context Service used to provide client certificate information for TLS/SSL (https) connections.", "");
 core::Property RemoteProcessorGroupPort::port("Port", "Remote Port", "");
 core::Property RemoteProcessorGroupPort::portUUID("Port UUID", "Specifies remote NiFi Port UUID.", "");
+core::Property RemoteProcessorGroupPort::useCompression("Use Compression", "Whether data sent or received over the raw socket protocol is compressed.", "false");
+core::Property RemoteProcessorGroupPort::peerRefreshPeriod("Peer Refresh Period", "How often the list of peers and the number of flow files queued on each is refreshed.",
+                                                          "1 min");
+core::Property RemoteProcessorGroupPort::maxInFlightTransactions(
+    "Max In Flight Transactions", "Number of send transactions kept in flight at once, each on its own connection. The next transactions send their data while "
+    "earlier ones await their confirmation.", "1");
 core::Relationship RemoteProcessorGroupPort::relation;
 
 std::unique_ptr<sitetosite::SiteToSiteClient> RemoteProcessorGroupPort::getNextProtocol(bool create = true) {
   std::unique_ptr<sitetosite::SiteToSiteClient> nextProtocol = nullptr;
   if (!available_protocols_.try_dequeue(nextProtocol)) {
     if (create) {
-      // create
+      // the peers may be replaced by a refresh meanwhile
+      std::lock_guard<std::mutex> lock(peer_mutex_);
       if (bypass_rest_api_) {
         if (nifi_instances_.size() > 0) {
           auto rpg = nifi_instances_.front();
           sitetosite::SiteToSiteClientConfiguration config(stream_factory_, std::make_shared<sitetosite::Peer>(protocol_uuid_, rpg.host_, rpg.port_, ssl_service != nullptr), this->getInterface(),
                                                            client_type_);
           config.setHTTPProxy(this->proxy_);
+          config.setUseCompression(use_compression_);
           nextProtocol = sitetosite::createClient(config);
         }
-      } else if (peer_index_ >= 0) {
-        std::lock_guard<std::mutex> lock(peer_mutex_);
-        logger_->log_debug("Creating client from peer %ll", peer_index_.load());
-        sitetosite::SiteToSiteClientConfiguration config(stream_factory_, peers_[this->peer_index_].getPeer(), local_network_interface_, client_type_);
-        config.setSecurityContext(ssl_service);
-        peer_index_++;
-        if (peer_index_ >= static_cast<int>(peers_.size())) {
-          peer_index_ = 0;
+      } else if (!peers_.empty()) {
+        auto peer = peer_selector_.getNextPeer();
+        if (peer == nullptr) {
+          logger_->log_debug("All peers are penalized");
+          return nullptr;
         }
+        logger_->log_debug("Creating client from peer %s:%d", peer->getHost(), peer->getPort());
+        sitetosite::SiteToSiteClientConfiguration config(stream_factory_, peer, local_network_interface_, client_type_);
+        config.setSecurityContext(ssl_service);
         config.setHTTPProxy(this->proxy_);
+        config.setUseCompression(use_compression_);
         nextProtocol = sitetosite::createClient(config);
       } else {
         logger_->log_debug("Refreshing the peer list since there are none configured.");
@@ -94,10 +105,32 @@ std::unique_ptr<sitetosite::SiteToSiteClient> RemoteProcessorGroupPort::getNextP
   return nextProtocol;
 }
 
+size_t RemoteProcessorGroupPort::getMaxProtocols() const {
+  return std::max<size_t>(peer_count_.load(), max_concurrent_tasks_ * max_in_flight_transactions_);
+}
+
+void RemoteProcessorGroupPort::retainListedProtocols() {
+  std::vector<std::unique_ptr<sitetosite::SiteToSiteClient>> retained;
+  std::unique_ptr<sitetosite::SiteToSiteClient> pooled = nullptr;
+  while (available_protocols_.try_dequeue(pooled)) {
+    const auto &peer = pooled->getPeer();
+    bool listed = peer != nullptr && std::any_of(peers_.begin(), peers_.end(), [&peer](const sitetosite::PeerStatus &status) {
+      return status.getPeer()->getHost() == peer->getHostName() && status.getPeer()->getPort() == peer->getPort();
+    });
+    if (listed) {
+      retained.push_back(std::move(pooled));
+    } else {
+      // the protocol closes its connection as it is destroyed
+      logger_->log_debug("Closing a protocol to a peer that was removed from %s", getUUIDStr());
+    }
+  }
+  for (auto &protocol : retained) {
+    available_protocols_.enqueue(std::move(protocol));
+  }
+}
+
 void RemoteProcessorGroupPort::returnProtocol(std::unique_ptr<sitetosite::SiteToSiteClient> return_protocol) {
-  auto count = peers_.size();
-  if (max_concurrent_tasks_ > count)
-    count = max_concurrent_tasks_;
+  auto count = getMaxProtocols();
   if (available_protocols_.size_approx() >= count) {
     logger_->log_debug("not enqueueing protocol %s", getUUIDStr());
     // let the memory be freed
@@ -114,6 +147,9 @@ void RemoteProcessorGroupPort::initialize() {
   properties.insert(port);
   properties.insert(SSLContext);
   properties.insert(portUUID);
+  properties.insert(useCompression);
+  properties.insert(maxInFlightTransactions);
+  properties.insert(peerRefreshPeriod);
   setSupportedProperties(properties);
 // Set the supported relationships
   std::set<core::Relationship> relationships;
@@ -128,6 +164,13 @@ void RemoteProcessorGroupPort::onSchedule(const std::shared_ptr<core::ProcessCon
   if (context->getProperty(portUUID.getName(), value) && !value.empty()) {
     protocol_uuid_ = value;
   }
+  if (context->getProperty(useCompression.getName(), value)) {
+    utils::StringUtils::StringToBool(value, use_compression_);
+  }
+  int64_t max_in_flight_transactions;
+  if (context->getProperty(maxInFlightTransactions.getName(), value) && core::Property::StringToInt(value, max_in_flight_transactions) && max_in_flight_transactions > 0) {
+    max_in_flight_transactions_ = max_in_flight_transactions;
+  }
 
   std::string http_enabled_str;
   if (configure_->get(Configure::nifi_remote_input_http, http_enabled_str)) {
@@ -154,11 +197,16 @@ void RemoteProcessorGroupPort::onSchedule(const std::shared_ptr<core::ProcessCon
     }
   }
 
+  int64_t peer_refresh_period;
+  core::TimeUnit unit;
+  if (context->getProperty(peerRefreshPeriod.getName(), value) && core::Property::StringToTime(value, peer_refresh_period, unit)
+      && core::Property::ConvertTimeUnitToMS(peer_refresh_period, unit, peer_refresh_period) && peer_refresh_period >= 0) {
+    peer_refresh_period_ms_ = peer_refresh_period;
+  }
+
   std::lock_guard<std::mutex> lock(peer_mutex_);
   if (!nifi_instances_.empty()) {
     refreshPeerList();
-    if (peers_.size() > 0)
-      peer_index_ = 0;
   }
   /**
    * If at this point we have no peers and HTTP support is disabled this means
@@ -181,19 +229,20 @@ void RemoteProcessorGroupPort::onSchedule(const std::shared_ptr<core::ProcessCon
   }
   // populate the site2site protocol for load balancing between them
   if (peers_.size() > 0) {
-    auto count = peers_.size();
-    if (max_concurrent_tasks_ > count)
-      count = max_concurrent_tasks_;
+    auto count = getMaxProtocols();
     for (uint32_t i = 0; i < count; i++) {
+      auto peer = peer_selector_.getNextPeer();
+      if (peer == nullptr) {
+        // protocols are created on demand once a peer is no longer penalized
+        logger_->log_debug("All peers are penalized, pooling no further protocols");
+        break;
+      }
       std::unique_ptr<sitetosite::SiteToSiteClient> nextProtocol = nullptr;
-      sitetosite::SiteToSiteClientConfiguration config(stream_factory_, peers_[this->peer_index_].getPeer(), this->getInterface(), client_type_);
+      sitetosite::SiteToSiteClientConfiguration config(stream_factory_, peer, this->getInterface(), client_type_);
       config.setSecurityContext(ssl_service);
-      peer_index_++;
-      if (peer_index_ >= static_cast<int>(peers_.size())) {
-        peer_index_ = 0;
-      }
       logger_->log_trace("Creating client");
       config.setHTTPProxy(this->proxy_);
+      config.setUseCompression(use_compression_);
       nextProtocol = sitetosite::createClient(config);
       logger_->log_trace("Created client, moving into available protocols");
       returnProtocol(std::move(nextProtocol));
@@ -228,6 +277,23 @@ void RemoteProcessorGroupPort::onTrigger(const std::shared_ptr<core::ProcessCont
 
   logger_->log_trace("On trigger %s", getUUIDStr());
 
+  if (!bypass_rest_api_ && peer_refresh_period_ms_ > 0 && getTimeMillis() - last_peer_refresh_ms_ >= peer_refresh_period_ms_) {
+    std::lock_guard<std::mutex> lock(peer_mutex_);
+    if (getTimeMillis() - last_peer_refresh_ms_ >= peer_refresh_period_ms_) {
+      logger_->log_debug("Refreshing the peer list of %s", getUUIDStr());
+      // pooled protocols to peers that remain are reused, and all of them are kept while
+      // the peers could not be obtained
+      if (refreshPeerList()) {
+        retainListedProtocols();
+      }
+    }
+  }
+
+  if (direction_ == sitetosite::SEND && max_in_flight_transactions_ > 1) {
+    transferPipelined(context);
+    return;
+  }
+
   std::unique_ptr<sitetosite::SiteToSiteClient> protocol_ = nullptr;
   try {
     logger_->log_trace("get protocol in on trigger");
@@ -247,14 +313,100 @@ void RemoteProcessorGroupPort::onTrigger(const std::shared_ptr<core::ProcessCont
     returnProtocol(std::move(protocol_));
     return;
   } catch (const minifi::Exception &ex2) {
+    penalize(protocol_);
     context->yield();
     session->rollback();
   } catch (...) {
+    penalize(protocol_);
     context->yield();
     session->rollback();
   }
 }
 
+void RemoteProcessorGroupPort::penalize(const std::unique_ptr<sitetosite::SiteToSiteClient> &protocol) {
+  if (protocol == nullptr || protocol->getPeer() == nullptr) {
+    return;
+  }
+  logger_->log_debug("Penalizing peer %s:%d", protocol->getPeer()->getHostName(), protocol->getPeer()->getPort());
+  peer_selector_.penalize(protocol->getPeer()->getHostName(), protocol->getPeer()->getPort(), PEER_PENALIZATION_PERIOD);
+}
+
+namespace {
+
+/**
+ * Transaction whose data has been sent, awaiting its confirmation.
+ */
+struct PendingTransaction {
+  std::unique_ptr<sitetosite::SiteToSiteClient> protocol;
+  std::shared_ptr<core::ProcessSession> session;
+  std::string transaction_id;
+};
+
+}  // namespace
+
+void RemoteProcessorGroupPort::transferPipelined(const std::shared_ptr<core::ProcessContext> &context) {
+  std::deque<PendingTransaction> pending;
+  bool more = true;
+  while (more || !pending.empty()) {
+    // fill the window with transactions whose data is sent right away
+    while (more && pending.size() < max_in_flight_transactions_) {
+      std::unique_ptr<sitetosite::SiteToSiteClient> protocol = getNextProtocol();
+      if (!protocol) {
+        if (pending.empty()) {
+          logger_->log_info("no protocol, yielding");
+          context->yield();
+        }
+        more = false;
+        break;
+      }
+      auto session = std::make_shared<core::ProcessSession>(context);
+      std::string transaction_id;
+      try {
+        if (!protocol->startTransferFlowFiles(context, session, transaction_id)) {
+          session->rollback();
+          returnProtocol(std::move(protocol));
+          more = false;
+          break;
+        }
+      } catch (const std::exception &exception) {
+        logger_->log_warn("Site2Site transaction could not be started: %s", exception.what());
+        penalize(protocol);
+        session->rollback();
+        more = false;
+        break;
+      } catch (...) {
+        penalize(protocol);
+        session->rollback();
+        more = false;
+        break;
+      }
+      pending.push_back(PendingTransaction { std::move(protocol), session, transaction_id });
+    }
+    if (pending.empty()) {
+      break;
+    }
+
+    // wait for the oldest transaction while the others are in flight
+    PendingTransaction oldest = std::move(pending.front());
+    pending.pop_front();
+    try {
+      oldest.protocol->finishTransferFlowFiles(context, oldest.transaction_id);
+      oldest.session->commit();
+      returnProtocol(std::move(oldest.protocol));
+    } catch (const std::exception &exception) {
+      logger_->log_warn("Site2Site transaction %s failed, rolling back its flow files: %s", oldest.transaction_id, exception.what());
+      penalize(oldest.protocol);
+      oldest.session->rollback();
+      more = false;
+    } catch (...) {
+      logger_->log_warn("Site2Site transaction %s failed, rolling back its flow files", oldest.transaction_id);
+      penalize(oldest.protocol);
+      oldest.session->rollback();
+      more = false;
+    }
+  }
+}
+
 std::pair<std::string, int> RemoteProcessorGroupPort::refreshRemoteSite2SiteInfo() {
   if (nifi_instances_.empty())
     return std::make_pair("", -1);
@@ -359,15 +511,16 @@ std::pair<std::string, int> RemoteProcessorGroupPort::refreshRemoteSite2SiteInfo
   return std::make_pair("", -1);
 }
 
-void RemoteProcessorGroupPort::refreshPeerList() {
+bool RemoteProcessorGroupPort::refreshPeerList() {
+  // a failed refresh is retried after the refresh period as well
+  last_peer_refresh_ms_ = getTimeMillis();
   auto connection = refreshRemoteSite2SiteInfo();
   if (connection.second == -1) {
     logger_->log_debug("No port configured");
-    return;
+    return false;
   }
 
-  this->peers_.clear();
-
+  std::vector<sitetosite::PeerStatus> peers;
   std::unique_ptr<sitetosite::SiteToSiteClient> protocol;
   sitetosite::SiteToSiteClientConfiguration config(stream_factory_, std::make_shared<sitetosite::Peer>(protocol_uuid_, connection.first, connection.second, ssl_service != nullptr),
                                                    this->getInterface(), client_type_);
@@ -376,12 +529,18 @@ void RemoteProcessorGroupPort::refreshPeerList() {
   protocol = sitetosite::createClient(config);
 
   if (protocol)
-    protocol->getPeerList(peers_);
+    protocol->getPeerList(peers);
 
-  logging::LOG_INFO(logger_) << "Have " << peers_.size() << " peers";
+  logging::LOG_INFO(logger_) << "Have " << peers.size() << " peers";
 
-  if (peers_.size() > 0)
-    peer_index_ = 0;
+  if (peers.empty() && !peers_.empty()) {
+    logger_->log_debug("Keeping the previous peers since none were obtained");
+    return false;
+  }
+  peer_selector_.setPeers(peers, direction_);
+  peers_.swap(peers);
+  peer_count_ = peers_.size();
+  return !peers_.empty();
 }
 
 } /* namespace minifi */
@@ -0,0 +1,68 @@
+/**
+ * @file RootGroupPort.cpp
+ * RootGroupPort class implementation
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "RootGroupPort.h"
+#include <memory>
+#include <set>
+#include <string>
+#include "Exception.h"
+#include "core/ProcessContext.h"
+#include "core/ProcessSessionFactory.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+
+const char *RootGroupPort::ProcessorName("RootGroupPort");
+core::Relationship RootGroupPort::relation;
+
+void RootGroupPort::initialize() {
+  std::set<core::Relationship> relationships;
+  relationships.insert(relation);
+  setSupportedRelationships(relationships);
+}
+
+void RootGroupPort::onSchedule(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  server_ = sitetosite::SiteToSiteServer::getServer(configure_);
+  if (server_ == nullptr) {
+    logger_->log_error("Port %s cannot be served, set %s to the port other instances connect to", getName(), Configure::nifi_remote_input_socket_port);
+    throw Exception(SITE2SITE_EXCEPTION, "No site to site server for port " + getName());
+  }
+  server_->registerPort(getUUIDStr(), getName(), direction_, sessionFactory);
+}
+
+void RootGroupPort::onTrigger(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session) {
+  // flow files are transferred when the instances ask for them
+  context->yield();
+}
+
+void RootGroupPort::notifyStop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (server_ != nullptr) {
+    server_->unregisterPort(getUUIDStr());
+    server_ = nullptr;
+  }
+}
+
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
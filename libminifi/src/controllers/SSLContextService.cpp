@@ -34,6 +34,61 @@ namespace nifi {
 namespace minifi {
 namespace controllers {
 
+#ifdef OPENSSL_SUPPORT
+SSLSessionCache::~SSLSessionCache() {
+  clear();
+}
+
+void SSLSessionCache::enableResumption(SSL_CTX *ctx) {
+  // clients look sessions up in this cache rather than in the store of the context
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+}
+
+void SSLSessionCache::resume(SSL *ssl, const std::string &host, uint16_t port) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto session = sessions_.find(host + ":" + std::to_string(port));
+  if (session != sessions_.end()) {
+    SSL_set_session(ssl, session->second);
+  }
+}
+
+void SSLSessionCache::save(SSL *ssl, const std::string &host, uint16_t port) {
+  SSL_SESSION *session = SSL_get1_session(ssl);
+  if (session == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  SSL_SESSION *&entry = sessions_[host + ":" + std::to_string(port)];
+  if (entry != nullptr) {
+    SSL_SESSION_free(entry);
+  }
+  entry = session;
+}
+
+void SSLSessionCache::remove(const std::string &host, uint16_t port) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto session = sessions_.find(host + ":" + std::to_string(port));
+  if (session != sessions_.end()) {
+    SSL_SESSION_free(session->second);
+    sessions_.erase(session);
+  }
+}
+
+void SSLSessionCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &session : sessions_) {
+    SSL_SESSION_free(session.second);
+  }
+  sessions_.clear();
+}
+
+size_t SSLSessionCache::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sessions_.size();
+}
+#endif
+
 void SSLContextService::initialize() {
   if (initialized_)
     return;
@@ -96,6 +151,29 @@ std::unique_ptr<SSLContext> SSLContextService::createSSLContext() {
 #endif
 }
 
+#ifdef OPENSSL_SUPPORT
+std::shared_ptr<SSLContext> SSLContextService::getSharedContext(const std::function<SSL_CTX*()> &create) {
+  std::lock_guard<std::mutex> lock(context_mutex_);
+  if (shared_context_ == nullptr) {
+    SSL_CTX *context = create();
+    if (context == nullptr) {
+      return nullptr;
+    }
+    SSLSessionCache::enableResumption(context);
+    shared_context_ = std::make_shared<SSLContext>(context);
+  }
+  return shared_context_;
+}
+
+std::shared_ptr<SSLSessionCache> SSLContextService::getSessionCache() {
+  std::lock_guard<std::mutex> lock(context_mutex_);
+  if (session_cache_ == nullptr) {
+    session_cache_ = std::make_shared<SSLSessionCache>();
+  }
+  return session_cache_;
+}
+#endif
+
 const std::string &SSLContextService::getCertificateFile() {
   std::lock_guard<std::mutex> lock(initialization_mutex_);
   return certificate;
@@ -123,6 +201,16 @@ const std::string &SSLContextService::getCACertificate() {
 
 void SSLContextService::onEnable() {
   valid_ = true;
+#ifdef OPENSSL_SUPPORT
+  {
+    // the certificates may have changed, so contexts and sessions are created anew
+    std::lock_guard<std::mutex> lock(context_mutex_);
+    shared_context_ = nullptr;
+    if (session_cache_ != nullptr) {
+      session_cache_->clear();
+    }
+  }
+#endif
   core::Property property("Client Certificate", "Client Certificate");
   core::Property privKey("Private Key", "Private Key file");
   core::Property passphrase_prop("Passphrase", "Client passphrase. Either a file or unencrypted text");
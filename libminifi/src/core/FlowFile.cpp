@@ -37,6 +37,7 @@ FlowFile::FlowFile()
       size_(0),
       id_(0),
       stored(false),
+      stored_size_(0),
       offset_(0),
       last_queue_date_(0),
       penaltyExpiration_ms_(0),
@@ -56,6 +57,7 @@ FlowFile::~FlowFile() {
 FlowFile& FlowFile::operator=(const FlowFile& other) {
   uuid_ = other.uuid_;
   stored = other.stored;
+  stored_size_ = other.stored_size_;
   marked_delete_ = other.marked_delete_;
   entry_date_ = other.entry_date_;
   lineage_start_date_ = other.lineage_start_date_;
@@ -24,8 +24,10 @@
 #include "core/Repository.h"
 #include "core/ClassLoader.h"
 #include "core/repository/FileSystemRepository.h"
+#include "core/repository/TieredContentRepository.h"
 #include "core/repository/VolatileFlowFileRepository.h"
 #include "core/repository/VolatileProvenanceRepository.h"
+#include "core/repository/WriteAheadLogFlowFileRepository.h"
 
 namespace org {
 namespace apache {
@@ -53,6 +55,8 @@ std::shared_ptr<core::Repository> createRepository(const std::string configurati
       return_obj = instantiate<repository::VolatileFlowFileRepository>(repo_name);
     } else if (class_name_lc == "provenancerepository" || class_name_lc == "volatileprovenancefilerepository") {
       return_obj = instantiate<repository::VolatileProvenanceRepository>(repo_name);
+    } else if (class_name_lc == "writeaheadlogflowfilerepository") {
+      return_obj = instantiate<repository::WriteAheadLogFlowFileRepository>(repo_name);
     } else if (class_name_lc == "nooprepository") {
       return_obj = instantiate<core::Repository>(repo_name);
     }
@@ -91,6 +95,8 @@ std::shared_ptr<core::ContentRepository> createContentRepository(const std::stri
       return std::make_shared<core::repository::VolatileContentRepository>(repo_name);
     } else if (class_name_lc == "filesystemrepository") {
       return std::make_shared<core::repository::FileSystemRepository>(repo_name);
+    } else if (class_name_lc == "tieredcontentrepository") {
+      return std::make_shared<core::repository::TieredContentRepository>(repo_name);
     }
     if (fail_safe) {
       return std::make_shared<core::repository::VolatileContentRepository>("fail_safe");
@@ -39,8 +39,6 @@
 
 #include "rapidjson/document.h"
 #include "rapidjson/writer.h"
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/prettywriter.h"
 
 
 namespace org {
@@ -56,92 +54,121 @@ void SiteToSiteProvenanceReportingTask::initialize() {
   RemoteProcessorGroupPort::initialize();
 }
 
-void setJsonStr(const std::string& key, const std::string& value, rapidjson::Value& parent, rapidjson::Document::AllocatorType& alloc) { // NOLINT
-  rapidjson::Value keyVal;
-  rapidjson::Value valueVal;
-  const char* c_key = key.c_str();
-  const char* c_val = value.c_str();
+namespace {
 
-  keyVal.SetString(c_key, key.length(), alloc);
-  valueVal.SetString(c_val, value.length(), alloc);
+/**
+ * Output stream for rapidjson writers that appends to a string, so that reports are written
+ * in place rather than copied out of a buffer.
+ */
+class StringOutputStream {
+ public:
+  typedef char Ch;
+
+  explicit StringOutputStream(std::string &str)
+      : str_(str) {
+  }
+
+  void Put(Ch c) {
+    str_.push_back(c);
+  }
+
+  void Flush() {
+  }
+
+ private:
+  std::string &str_;
+};
 
-  parent.AddMember(keyVal, valueVal, alloc);
+typedef rapidjson::Writer<StringOutputStream> ReportWriter;
+
+void writeString(ReportWriter &writer, const char *key, const std::string &value) {
+  writer.Key(key);
+  writer.String(value.c_str(), value.length());
 }
 
-rapidjson::Value getStringValue(const std::string& value, rapidjson::Document::AllocatorType& alloc) { // NOLINT
-  rapidjson::Value Val;
-  Val.SetString(value.c_str(), value.length(), alloc);
-  return Val;
+void writeRecord(ReportWriter &writer, const std::shared_ptr<provenance::ProvenanceEventRecord> &record) {
+  writer.StartObject();
+  writer.Key("timestampMillis");
+  writer.Uint64(record->getEventTime());
+  writer.Key("durationMillis");
+  writer.Uint64(record->getEventDuration());
+  writer.Key("lineageStart");
+  writer.Uint64(record->getlineageStartDate());
+  writer.Key("entitySize");
+  writer.Uint64(record->getFileSize());
+  writer.Key("entityOffset");
+  writer.Uint64(record->getFileOffset());
+
+  writeString(writer, "entityType", "org.apache.nifi.flowfile.FlowFile");
+  writeString(writer, "eventId", record->getEventId());
+  writeString(writer, "eventType", provenance::ProvenanceEventRecord::ProvenanceEventTypeStr[record->getEventType()]);
+  writeString(writer, "details", record->getDetails());
+  writeString(writer, "componentId", record->getComponentId());
+  writeString(writer, "componentType", record->getComponentType());
+  writeString(writer, "entityId", record->getFlowFileUuid());
+  writeString(writer, "transitUri", record->getTransitUri());
+  writeString(writer, "remoteIdentifier", record->getSourceSystemFlowFileIdentifier());
+  writeString(writer, "alternateIdentifier", record->getAlternateIdentifierUri());
+
+  writer.Key("updatedAttributes");
+  writer.StartObject();
+  for (const auto &attr : record->getAttributes()) {
+    writeString(writer, attr.first.c_str(), attr.second);
+  }
+  writer.EndObject();
+
+  writer.Key("parentIds");
+  writer.StartArray();
+  for (const auto &parentUUID : record->getParentUuids()) {
+    writer.String(parentUUID.c_str(), parentUUID.length());
+  }
+  writer.EndArray();
+
+  writer.Key("childIds");
+  writer.StartArray();
+  for (const auto &childUUID : record->getChildrenUuids()) {
+    writer.String(childUUID.c_str(), childUUID.length());
+  }
+  writer.EndArray();
+
+  writer.Key("application");
+  writer.String(SiteToSiteProvenanceReportingTask::ProvenanceAppStr);
+  writer.EndObject();
 }
 
-void appendJsonStr(const std::string& value, rapidjson::Value& parent, rapidjson::Document::AllocatorType& alloc) { // NOLINT
-  rapidjson::Value valueVal;
-  const char* c_val = value.c_str();
-  valueVal.SetString(c_val, value.length(), alloc);
-  parent.PushBack(valueVal, alloc);
+}  // namespace
+
+size_t SiteToSiteProvenanceReportingTask::writeJsonReport(const std::vector<std::shared_ptr<core::SerializableComponent>> &records, size_t begin, std::string &report) {
+  report.clear();
+  StringOutputStream stream(report);
+  ReportWriter writer(stream);
+  writer.StartArray();
+  size_t next = begin;
+  // every report holds at least one record, however large
+  for (; next < records.size() && (next == begin || report.size() < max_report_size_); next++) {
+    std::shared_ptr<provenance::ProvenanceEventRecord> record = std::dynamic_pointer_cast<provenance::ProvenanceEventRecord>(records[next]);
+    if (nullptr != record) {
+      writeRecord(writer, record);
+    }
+  }
+  writer.EndArray();
+  return next;
 }
 
 void SiteToSiteProvenanceReportingTask::getJsonReport(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session,
                                                       std::vector<std::shared_ptr<core::SerializableComponent>> &records, std::string &report) {
-  rapidjson::Document array(rapidjson::kArrayType);
-  rapidjson::Document::AllocatorType &alloc = array.GetAllocator();
-
+  report.clear();
+  StringOutputStream stream(report);
+  ReportWriter writer(stream);
+  writer.StartArray();
   for (auto sercomp : records) {
     std::shared_ptr<provenance::ProvenanceEventRecord> record = std::dynamic_pointer_cast<provenance::ProvenanceEventRecord>(sercomp);
     if (nullptr == record) {
       break;
     }
-
-    rapidjson::Value recordJson(rapidjson::kObjectType);
-    rapidjson::Value updatedAttributesJson(rapidjson::kObjectType);
-    rapidjson::Value parentUuidJson(rapidjson::kArrayType);
-    rapidjson::Value childUuidJson(rapidjson::kArrayType);
-
-    recordJson.AddMember("timestampMillis", record->getEventTime(), alloc);
-    recordJson.AddMember("durationMillis", record->getEventDuration(), alloc);
-    recordJson.AddMember("lineageStart", record->getlineageStartDate(), alloc);
-    recordJson.AddMember("entitySize", record->getFileSize(), alloc);
-    recordJson.AddMember("entityOffset", record->getFileOffset(), alloc);
-
-    recordJson.AddMember("entityType", "org.apache.nifi.flowfile.FlowFile", alloc);
-
-    recordJson.AddMember("eventId", getStringValue(record->getEventId(), alloc), alloc);
-    recordJson.AddMember("eventType", getStringValue(provenance::ProvenanceEventRecord::ProvenanceEventTypeStr[record->getEventType()], alloc), alloc);
-    recordJson.AddMember("details", getStringValue(record->getDetails(), alloc), alloc);
-    recordJson.AddMember("componentId", getStringValue(record->getComponentId(), alloc), alloc);
-    recordJson.AddMember("componentType", getStringValue(record->getComponentType(), alloc), alloc);
-    recordJson.AddMember("entityId", getStringValue(record->getFlowFileUuid(), alloc), alloc);
-    recordJson.AddMember("transitUri", getStringValue(record->getTransitUri(), alloc), alloc);
-    recordJson.AddMember("remoteIdentifier", getStringValue(record->getSourceSystemFlowFileIdentifier(), alloc), alloc);
-    recordJson.AddMember("alternateIdentifier", getStringValue(record->getAlternateIdentifierUri(), alloc), alloc);
-
-    for (auto attr : record->getAttributes()) {
-      setJsonStr(attr.first, attr.second, updatedAttributesJson, alloc);
-    }
-    recordJson.AddMember("updatedAttributes", updatedAttributesJson, alloc);
-
-    for (auto parentUUID : record->getParentUuids()) {
-      appendJsonStr(parentUUID, parentUuidJson, alloc);
-    }
-    recordJson.AddMember("parentIds", parentUuidJson, alloc);
-
-    for (auto childUUID : record->getChildrenUuids()) {
-      appendJsonStr(childUUID, childUuidJson, alloc);
-    }
-    recordJson.AddMember("childIds", childUuidJson, alloc);
-
-    rapidjson::Value applicationVal;
-    applicationVal.SetString(ProvenanceAppStr, std::strlen(ProvenanceAppStr));
-    recordJson.AddMember("application", applicationVal, alloc);
-
-    array.PushBack(recordJson, alloc);
+    writeRecord(writer, record);
   }
-
-  rapidjson::StringBuffer buffer;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-  array.Accept(writer);
-
-  report = buffer.GetString();
+  writer.EndArray();
 }
 
 void SiteToSiteProvenanceReportingTask::onSchedule(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory) {
@@ -154,15 +181,12 @@ void SiteToSiteProvenanceReportingTask::onTrigger(const std::shared_ptr<core::Pr
   size_t deserialized = batch_size_;
   std::shared_ptr<core::Repository> repo = context->getProvenanceRepository();
   std::function<std::shared_ptr<core::SerializableComponent>()> constructor = []() {return std::make_shared<provenance::ProvenanceEventRecord>();};
-  if (!repo->DeSerialize(records, deserialized, constructor) && deserialized == 0) {
+  // resume after the last event reported rather than scanning from the first stored event
+  std::string cursor = cursor_;
+  if (!repo->DeSerialize(records, deserialized, constructor, cursor) && deserialized == 0) {
     return;
   }
   logging::LOG_DEBUG(logger_) << "Captured " << deserialized << " records";
-  std::string jsonStr;
-  this->getJsonReport(context, session, records, jsonStr);
-  if (jsonStr.length() <= 0) {
-    return;
-  }
 
   auto protocol_ = getNextProtocol(true);
 
@@ -171,10 +195,23 @@ void SiteToSiteProvenanceReportingTask::onTrigger(const std::shared_ptr<core::Pr
     return;
   }
 
+  // reports are written one at a time as the transaction asks for them, each split off once
+  // it reaches the maximum report size
+  size_t next = 0;
+  std::function<bool(std::string&)> nextReport = [this, &records, &next](std::string &report) {
+    if (next >= records.size()) {
+      return false;
+    }
+    next = writeJsonReport(records, next, report);
+    return true;
+  };
+
   try {
     std::map<std::string, std::string> attributes;
-    if (!protocol_->transmitPayload(context, session, jsonStr, attributes)) {
+    if (!protocol_->transmitPayloads(context, session, nextReport, attributes)) {
       context->yield();
+      returnProtocol(std::move(protocol_));
+      return;
     }
   } catch (...) {
     // if transfer bytes failed, return instead of purge the provenance records
@@ -182,6 +219,7 @@ void SiteToSiteProvenanceReportingTask::onTrigger(const std::shared_ptr<core::Pr
   }
 
   // we transfer the record, purge the record from DB
+  cursor_ = cursor;
   repo->Delete(records);
   returnProtocol(std::move(protocol_));
 }
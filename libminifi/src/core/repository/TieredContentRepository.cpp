@@ -0,0 +1,363 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core/repository/TieredContentRepository.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "core/Property.h"
+#include "utils/TimeUtil.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+namespace repository {
+
+TieredContentRepository::TieredStream::TieredStream(const std::shared_ptr<TieredContentRepository> &repository, const std::shared_ptr<minifi::ResourceClaim> &claim,
+                                                    const std::shared_ptr<io::BaseStream> &stream)
+    : repository_(repository),
+      claim_(claim),
+      stream_(stream),
+      spilled_(false) {
+}
+
+TieredContentRepository::TieredStream::~TieredStream() {
+  // release the underlying entry before the claim becomes eligible for migration
+  stream_ = nullptr;
+  repository_->releaseStream(claim_->getContentFullPath());
+}
+
+int TieredContentRepository::TieredStream::readData(std::vector<uint8_t> &buf, int buflen) {
+  return stream_->readData(buf, buflen);
+}
+
+int TieredContentRepository::TieredStream::readData(uint8_t *buf, int buflen) {
+  return stream_->readData(buf, buflen);
+}
+
+int TieredContentRepository::TieredStream::writeData(std::vector<uint8_t> &buf, int buflen) {
+  if (static_cast<int>(buf.capacity()) < buflen)
+    return -1;
+  return writeData(reinterpret_cast<uint8_t *>(&buf[0]), buflen);
+}
+
+int TieredContentRepository::TieredStream::writeData(uint8_t *value, int size) {
+  int ret = stream_->writeData(value, size);
+  if (ret < 0 && !spilled_ && nullptr != value) {
+    // the memory tier is full; continue this claim on disk instead of failing the session
+    if (!repository_->spill(claim_, stream_)) {
+      return -1;
+    }
+    spilled_ = true;
+    ret = stream_->writeData(value, size);
+  }
+  return ret;
+}
+
+bool TieredContentRepository::initialize(const std::shared_ptr<Configure> &configure) {
+  memory_tier_ = std::make_shared<VolatileContentRepository>(getName());
+  disk_tier_ = std::make_shared<FileSystemRepository>(getName());
+  if (!memory_tier_->initialize(configure) || !disk_tier_->initialize(configure)) {
+    logger_->log_error("Could not initialize the tiers of %s", getName());
+    return false;
+  }
+  directory_ = disk_tier_->getStoragePath();
+
+  std::string value;
+  if (configure->get(Configure::nifi_tiered_content_repository_spill_age, value)) {
+    int64_t spill_age = 0;
+    TimeUnit unit;
+    if (core::Property::StringToTime(value, spill_age, unit) && core::Property::ConvertTimeUnitToMS(spill_age, unit, spill_age) && spill_age >= 0) {
+      spill_age_ = spill_age;
+    }
+  }
+  if (configure->get(Configure::nifi_tiered_content_repository_spill_threshold, value)) {
+    int64_t spill_threshold = 0;
+    if (core::Property::StringToInt(value, spill_threshold) && spill_threshold > 0 && spill_threshold <= 100) {
+      spill_threshold_ = spill_threshold;
+    }
+  }
+  logger_->log_info("%s spills claims to %s after %llu ms or above %llu%% of %llu bytes", getName(), directory_, spill_age_, spill_threshold_, memory_tier_->getMaxRepoSize());
+
+  if (!running_) {
+    running_ = true;
+    thread_ = std::thread(&TieredContentRepository::run, this);
+  }
+  return true;
+}
+
+void TieredContentRepository::stop() {
+  {
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    running_ = false;
+  }
+  run_condition_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (memory_tier_ != nullptr) {
+    memory_tier_->stop();
+  }
+}
+
+std::shared_ptr<io::BaseStream> TieredContentRepository::write(const std::shared_ptr<minifi::ResourceClaim> &claim) {
+  const std::string path = claim->getContentFullPath();
+  bool created = false;
+  bool on_disk = false;
+  {
+    std::lock_guard<std::mutex> lock(location_mutex_);
+    auto location = locations_.find(path);
+    if (location == locations_.end()) {
+      ClaimLocation new_location = { MEMORY, getTimeMillis(), 1, false };
+      locations_[path] = new_location;
+      created = true;
+    } else if (location->second.tier == DISK) {
+      on_disk = true;
+    } else {
+      location->second.open_streams++;
+    }
+  }
+  if (on_disk) {
+    return disk_tier_->write(claim);
+  }
+
+  auto stream = memory_tier_->write(claim);
+  if (stream != nullptr) {
+    return std::make_shared<TieredStream>(shared_from_this(), claim, stream);
+  }
+
+  if (!created) {
+    releaseStream(path);
+    return nullptr;
+  }
+
+  // the memory tier has no free entries, so the claim goes straight to disk
+  {
+    std::lock_guard<std::mutex> lock(location_mutex_);
+    auto location = locations_.find(path);
+    if (location != locations_.end()) {
+      location->second.tier = DISK;
+      location->second.open_streams = 0;
+    }
+  }
+  logger_->log_debug("Memory tier is full, writing %s to disk", path);
+  return disk_tier_->write(claim);
+}
+
+std::shared_ptr<io::BaseStream> TieredContentRepository::read(const std::shared_ptr<minifi::ResourceClaim> &claim) {
+  const std::string path = claim->getContentFullPath();
+  bool on_disk = false;
+  {
+    std::lock_guard<std::mutex> lock(location_mutex_);
+    auto location = locations_.find(path);
+    // claims we do not know of may have been persisted by a previous run
+    if (location == locations_.end() || location->second.tier == DISK) {
+      on_disk = true;
+    } else {
+      location->second.open_streams++;
+    }
+  }
+  if (on_disk) {
+    return disk_tier_->read(claim);
+  }
+
+  auto stream = memory_tier_->read(claim);
+  if (stream == nullptr) {
+    releaseStream(path);
+    return nullptr;
+  }
+  return std::make_shared<TieredStream>(shared_from_this(), claim, stream);
+}
+
+bool TieredContentRepository::exists(const std::shared_ptr<minifi::ResourceClaim> &streamId) {
+  if (isInMemory(streamId)) {
+    return memory_tier_->exists(streamId);
+  }
+  return disk_tier_->exists(streamId);
+}
+
+bool TieredContentRepository::remove(const std::shared_ptr<minifi::ResourceClaim> &claim) {
+  Tier tier = DISK;
+  {
+    std::lock_guard<std::mutex> lock(location_mutex_);
+    auto location = locations_.find(claim->getContentFullPath());
+    if (location != locations_.end()) {
+      tier = location->second.tier;
+      locations_.erase(location);
+    }
+  }
+  if (tier == MEMORY) {
+    return memory_tier_->remove(claim);
+  }
+  return disk_tier_->remove(claim);
+}
+
+bool TieredContentRepository::isInMemory(const std::shared_ptr<minifi::ResourceClaim> &claim) {
+  std::lock_guard<std::mutex> lock(location_mutex_);
+  auto location = locations_.find(claim->getContentFullPath());
+  return location != locations_.end() && location->second.tier == MEMORY;
+}
+
+void TieredContentRepository::releaseStream(const std::string &path) {
+  std::lock_guard<std::mutex> lock(location_mutex_);
+  auto location = locations_.find(path);
+  if (location != locations_.end() && location->second.open_streams > 0) {
+    location->second.open_streams--;
+  }
+}
+
+bool TieredContentRepository::copy(const std::shared_ptr<io::BaseStream> &from, const std::shared_ptr<io::BaseStream> &to) {
+  if (from == nullptr || to == nullptr) {
+    return false;
+  }
+  uint8_t buffer[4096];
+  int read = 0;
+  while ((read = from->readData(buffer, sizeof(buffer))) > 0) {
+    if (to->writeData(buffer, read) != read) {
+      return false;
+    }
+  }
+  return read == 0;
+}
+
+bool TieredContentRepository::spill(const std::shared_ptr<minifi::ResourceClaim> &claim, std::shared_ptr<io::BaseStream> &stream) {
+  const std::string path = claim->getContentFullPath();
+  {
+    std::lock_guard<std::mutex> lock(location_mutex_);
+    auto location = locations_.find(path);
+    // another stream is using the memory entry, so we cannot move it from underneath
+    if (location == locations_.end() || location->second.tier != MEMORY || location->second.open_streams > 1 || location->second.migrating) {
+      return false;
+    }
+    location->second.migrating = true;
+  }
+
+  std::shared_ptr<io::BaseStream> disk_stream = disk_tier_->write(claim);
+  bool copied = copy(memory_tier_->read(claim), disk_stream);
+
+  {
+    std::lock_guard<std::mutex> lock(location_mutex_);
+    auto location = locations_.find(path);
+    if (location != locations_.end()) {
+      location->second.migrating = false;
+      if (copied) {
+        location->second.tier = DISK;
+      }
+    }
+  }
+  if (!copied) {
+    disk_stream = nullptr;
+    disk_tier_->remove(claim);
+    return false;
+  }
+  // drop our ownership of the memory entry so that it is freed
+  stream = nullptr;
+  memory_tier_->remove(claim);
+  stream = disk_stream;
+  logger_->log_debug("Spilled %s to disk", path);
+  return true;
+}
+
+bool TieredContentRepository::migrate(const std::string &path) {
+  {
+    std::lock_guard<std::mutex> lock(location_mutex_);
+    auto location = locations_.find(path);
+    if (location == locations_.end() || location->second.tier != MEMORY || location->second.open_streams > 0 || location->second.migrating) {
+      return false;
+    }
+    location->second.migrating = true;
+  }
+
+  auto claim = std::make_shared<minifi::ResourceClaim>(path, memory_tier_);
+  bool moved = copy(memory_tier_->read(claim), disk_tier_->write(claim));
+
+  bool removed = false;
+  {
+    std::lock_guard<std::mutex> lock(location_mutex_);
+    auto location = locations_.find(path);
+    if (location == locations_.end()) {
+      removed = true;
+    } else {
+      location->second.migrating = false;
+      // a stream was opened while we were copying; try again on a later pass
+      if (moved && location->second.open_streams == 0) {
+        location->second.tier = DISK;
+      } else {
+        moved = false;
+      }
+    }
+  }
+  if (removed || !moved) {
+    disk_tier_->remove(claim);
+    return false;
+  }
+  memory_tier_->remove(claim);
+  return true;
+}
+
+void TieredContentRepository::run() {
+  const uint64_t period = std::min<uint64_t>(std::max<uint64_t>(spill_age_ / 2, 10), 1000);
+  while (running_) {
+    {
+      std::unique_lock<std::mutex> lock(run_mutex_);
+      run_condition_.wait_for(lock, std::chrono::milliseconds(period), [this] {return !running_;});
+    }
+    if (!running_) {
+      break;
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> candidates;
+    {
+      std::lock_guard<std::mutex> lock(location_mutex_);
+      for (const auto &location : locations_) {
+        if (location.second.tier == MEMORY && location.second.open_streams == 0 && !location.second.migrating) {
+          candidates.emplace_back(location.second.created, location.first);
+        }
+      }
+    }
+    // oldest first, so that memory pressure evicts the claims least likely to be consumed soon
+    std::sort(candidates.begin(), candidates.end());
+
+    const uint64_t now = getTimeMillis();
+    const uint64_t threshold = memory_tier_->getMaxRepoSize() / 100 * spill_threshold_;
+    for (const auto &candidate : candidates) {
+      if (!running_) {
+        break;
+      }
+      bool expired = now >= candidate.first + spill_age_;
+      if (!expired && memory_tier_->getRepoSize() <= threshold) {
+        break;
+      }
+      if (migrate(candidate.second)) {
+        logger_->log_debug("Migrated %s to disk", candidate.second);
+      }
+    }
+  }
+}
+
+} /* namespace repository */
+} /* namespace core */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
@@ -63,6 +63,10 @@ bool VolatileContentRepository::initialize(const std::shared_ptr<Configure> &con
       delete ent;
     }
     value_vector_.clear();
+  } else {
+    for (auto ent : value_vector_) {
+      free_entries_.enqueue(ent);
+    }
   }
   start();
 
@@ -87,57 +91,66 @@ void VolatileContentRepository::start() {
   logger_->log_info("%s Repository Monitor Thread Start", getName());
 }
 
+std::function<void(AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>*&)> VolatileContentRepository::takeOwnership(AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>* &owned) {
+  // ownership is taken under the lock of the claim's stripe so that a concurrent remove cannot recycle the entry in between
+  return [&owned](AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>* &entry) {
+    owned = entry->takeOwnership();
+  };
+}
+
 std::shared_ptr<io::BaseStream> VolatileContentRepository::write(const std::shared_ptr<minifi::ResourceClaim> &claim) {
   logger_->log_info("enter write for %s", claim->getContentFullPath());
-  {
-    std::lock_guard<std::mutex> lock(map_mutex_);
-    auto claim_check = master_list_.find(claim->getContentFullPath());
-    if (claim_check != master_list_.end()) {
-      logger_->log_info("Creating copy of atomic entry");
-      auto ent = claim_check->second->takeOwnership();
-      if (ent == nullptr) {
-        return nullptr;
-      }
-      return std::make_shared<io::AtomicEntryStream<std::shared_ptr<minifi::ResourceClaim>>>(claim, ent);
+  AtomicEntry<std::shared_ptr<minifi::ResourceClaim>> *ent = nullptr;
+  if (master_list_.applyIfPresent(claim->getContentFullPath(), takeOwnership(ent))) {
+    logger_->log_info("Creating copy of atomic entry");
+    if (ent == nullptr) {
+      return nullptr;
     }
+    return std::make_shared<io::AtomicEntryStream<std::shared_ptr<minifi::ResourceClaim>>>(claim, ent);
   }
 
-  int size = 0;
+  size_t size = 0;
   if (LIKELY(minimize_locking_ == true)) {
-    for (auto ent : value_vector_) {
+    // entries that are still referenced by a stream are put back, so bound the attempts by the queue size
+    size_t attempts = free_entries_.size_approx();
+    while (attempts-- > 0 && free_entries_.try_dequeue(ent)) {
       if (ent->testAndSetKey(claim, nullptr, nullptr, resource_claim_comparator_)) {
-        std::lock_guard<std::mutex> lock(map_mutex_);
-        master_list_[claim->getContentFullPath()] = ent;
-        logger_->log_info("Minimize locking, return stream for %s", claim->getContentFullPath());
-        return std::make_shared<io::AtomicEntryStream<std::shared_ptr<minifi::ResourceClaim>>>(claim, ent);
+        if (master_list_.putIfAbsent(claim->getContentFullPath(), ent)) {
+          logger_->log_info("Minimize locking, return stream for %s", claim->getContentFullPath());
+          return std::make_shared<io::AtomicEntryStream<std::shared_ptr<minifi::ResourceClaim>>>(claim, ent);
+        }
+        // another writer registered the claim first, so return our entry and share theirs
+        ent->decrementOwnership();
+        ent->freeValue(claim);
+        free_entries_.enqueue(ent);
+        ent = nullptr;
+        if (master_list_.applyIfPresent(claim->getContentFullPath(), takeOwnership(ent)) && ent != nullptr) {
+          return std::make_shared<io::AtomicEntryStream<std::shared_ptr<minifi::ResourceClaim>>>(claim, ent);
+        }
+        break;
       }
+      free_entries_.enqueue(ent);
       size++;
     }
   } else {
-    std::lock_guard<std::mutex> lock(map_mutex_);
-    auto claim_check = master_list_.find(claim->getContentFullPath());
-    if (claim_check != master_list_.end()) {
-      return std::make_shared<io::AtomicEntryStream<std::shared_ptr<minifi::ResourceClaim>>>(claim, claim_check->second);
-    } else {
-      AtomicEntry<std::shared_ptr<minifi::ResourceClaim>> *ent = new AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>(&current_size_, &max_size_);
-      if (ent->testAndSetKey(claim, nullptr, nullptr, resource_claim_comparator_)) {
-        master_list_[claim->getContentFullPath()] = ent;
-        return std::make_shared<io::AtomicEntryStream<std::shared_ptr<minifi::ResourceClaim>>>(claim, ent);
-      }
+    ent = new AtomicEntry<std::shared_ptr<minifi::ResourceClaim>>(&current_size_, &max_size_);
+    if (ent->testAndSetKey(claim, nullptr, nullptr, resource_claim_comparator_) && master_list_.putIfAbsent(claim->getContentFullPath(), ent)) {
+      return std::make_shared<io::AtomicEntryStream<std::shared_ptr<minifi::ResourceClaim>>>(claim, ent);
     }
+    delete ent;
   }
   logger_->log_info("Cannot write %s %d, returning nullptr to roll back session. Repo is either full or locked", claim->getContentFullPath(), size);
   return nullptr;
 }
 
 bool VolatileContentRepository::exists(const std::shared_ptr<minifi::ResourceClaim> &claim) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  auto claim_check = master_list_.find(claim->getContentFullPath());
-  if (claim_check != master_list_.end()) {
-    auto ent = claim_check->second->takeOwnership();
+  AtomicEntry<std::shared_ptr<minifi::ResourceClaim>> *ent = nullptr;
+  if (master_list_.applyIfPresent(claim->getContentFullPath(), takeOwnership(ent))) {
     if (ent == nullptr) {
       return false;
     }
+    // the check must not keep the entry alive once the claim is removed
+    ent->decrementOwnership();
     return true;
   }
 
@@ -145,10 +158,8 @@ bool VolatileContentRepository::exists(const std::shared_ptr<minifi::ResourceCla
 }
 
 std::shared_ptr<io::BaseStream> VolatileContentRepository::read(const std::shared_ptr<minifi::ResourceClaim> &claim) {
-  std::lock_guard<std::mutex> lock(map_mutex_);
-  auto claim_check = master_list_.find(claim->getContentFullPath());
-  if (claim_check != master_list_.end()) {
-    auto ent = claim_check->second->takeOwnership();
+  AtomicEntry<std::shared_ptr<minifi::ResourceClaim>> *ent = nullptr;
+  if (master_list_.applyIfPresent(claim->getContentFullPath(), takeOwnership(ent))) {
     if (ent == nullptr) {
       return nullptr;
     }
@@ -159,17 +170,16 @@ std::shared_ptr<io::BaseStream> VolatileContentRepository::read(const std::share
 }
 
 bool VolatileContentRepository::remove(const std::shared_ptr<minifi::ResourceClaim> &claim) {
+  AtomicEntry<std::shared_ptr<minifi::ResourceClaim>> *ent = nullptr;
   if (LIKELY(minimize_locking_ == true)) {
-    std::lock_guard<std::mutex> lock(map_mutex_);
-    auto ent = master_list_.find(claim->getContentFullPath());
-    if (ent != master_list_.end()) {
-      auto ptr = ent->second;
+    if (master_list_.erase(claim->getContentFullPath(), ent)) {
       // if we cannot remove the entry we will let the owner's destructor
       // decrement the reference count and free it
-      master_list_.erase(claim->getContentFullPath());
       // because of the test and set we need to decrement ownership
-      ptr->decrementOwnership();
-      if (ptr->freeValue(claim)) {
+      ent->decrementOwnership();
+      if (ent->freeValue(claim)) {
+        // the entry is reclaimed by testAndSetKey once its last reader lets go
+        free_entries_.enqueue(ent);
         logger_->log_info("Removed %s", claim->getContentFullPath());
         return true;
       } else {
@@ -179,12 +189,9 @@ bool VolatileContentRepository::remove(const std::shared_ptr<minifi::ResourceCla
       logger_->log_info("Could not remove %s", claim->getContentFullPath());
     }
   } else {
-    std::lock_guard<std::mutex> lock(map_mutex_);
-    auto claim_item = master_list_.find(claim->getContentFullPath());
-    if (claim_item != master_list_.end()) {
-      auto size = claim_item->second->getLength();
-      delete claim_item->second;
-      master_list_.erase(claim->getContentFullPath());
+    if (master_list_.erase(claim->getContentFullPath(), ent)) {
+      auto size = ent->getLength();
+      delete ent;
       current_size_ -= size;
     }
     return true;
@@ -0,0 +1,563 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "core/repository/WriteAheadLogFlowFileRepository.h"
+#include <sys/stat.h>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Connection.h"
+#include "FlowFileRecord.h"
+#include "utils/CRC32.h"
+#include "utils/StringUtils.h"
+#include "utils/file/FileUtils.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+namespace repository {
+
+namespace {
+
+const uint32_t SNAPSHOT_MAGIC = 0x57414C53;  // WALS
+const uint32_t SNAPSHOT_VERSION = 1;
+// length and checksum that precede every record
+const size_t RECORD_HEADER_SIZE = 8;
+
+void appendUint32(std::string &buffer, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    buffer.push_back(static_cast<char>((value >> shift) & 0xFF));
+  }
+}
+
+void appendUint64(std::string &buffer, uint64_t value) {
+  appendUint32(buffer, static_cast<uint32_t>(value >> 32));
+  appendUint32(buffer, static_cast<uint32_t>(value));
+}
+
+uint32_t readUint32(const std::string &buffer, size_t offset) {
+  const uint8_t *data = reinterpret_cast<const uint8_t*>(buffer.data()) + offset;
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+uint64_t readUint64(const std::string &buffer, size_t offset) {
+  return (static_cast<uint64_t>(readUint32(buffer, offset)) << 32) | readUint32(buffer, offset + 4);
+}
+
+/**
+ * Appends a record as its payload length and CRC32, followed by the payload: the record
+ * type, the length of the key, the key and the value.
+ */
+void appendRecord(std::string &buffer, uint8_t type, const std::string &key, const uint8_t *value, size_t value_len) {
+  const size_t start = buffer.size();
+  const uint32_t payload_len = static_cast<uint32_t>(1 + 4 + key.size() + value_len);
+  appendUint32(buffer, payload_len);
+  appendUint32(buffer, 0);
+  buffer.push_back(static_cast<char>(type));
+  appendUint32(buffer, static_cast<uint32_t>(key.size()));
+  buffer.append(key);
+  if (value_len > 0) {
+    buffer.append(reinterpret_cast<const char*>(value), value_len);
+  }
+  const uint32_t crc = utils::CRC32::update(0, reinterpret_cast<const uint8_t*>(buffer.data() + start + RECORD_HEADER_SIZE), payload_len);
+  std::string crc_bytes;
+  appendUint32(crc_bytes, crc);
+  buffer.replace(start + 4, 4, crc_bytes);
+}
+
+/**
+ * Reads the record at offset, advancing offset past it.
+ * @return false if the record is incomplete or fails its checksum
+ */
+bool readRecord(const std::string &buffer, size_t &offset, uint8_t &type, std::string &key, std::string &value) {
+  if (buffer.size() - offset < RECORD_HEADER_SIZE) {
+    return false;
+  }
+  const uint32_t payload_len = readUint32(buffer, offset);
+  const uint32_t crc = readUint32(buffer, offset + 4);
+  if (payload_len < 5 || buffer.size() - offset - RECORD_HEADER_SIZE < payload_len) {
+    return false;
+  }
+  const size_t payload = offset + RECORD_HEADER_SIZE;
+  if (crc != utils::CRC32::update(0, reinterpret_cast<const uint8_t*>(buffer.data() + payload), payload_len)) {
+    return false;
+  }
+  type = static_cast<uint8_t>(buffer[payload]);
+  const uint32_t key_len = readUint32(buffer, payload + 1);
+  if (key_len > payload_len - 5) {
+    return false;
+  }
+  key.assign(buffer, payload + 5, key_len);
+  value.assign(buffer, payload + 5 + key_len, payload_len - 5 - key_len);
+  offset = payload + payload_len;
+  return true;
+}
+
+bool readFile(const std::string &path, std::string &contents) {
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  contents = buffer.str();
+  return true;
+}
+
+bool fileExists(const std::string &path) {
+  struct stat file_stat;
+  return stat(path.c_str(), &file_stat) == 0;
+}
+
+bool syncFile(FILE *file) {
+  if (fflush(file) != 0) {
+    return false;
+  }
+#ifdef WIN32
+  return _commit(_fileno(file)) == 0;
+#else
+  return fsync(fileno(file)) == 0;
+#endif
+}
+
+}  // namespace
+
+WriteAheadLogFlowFileRepository::~WriteAheadLogFlowFileRepository() {
+  stop();
+  flush();
+  if (nullptr != segment_) {
+    fclose(segment_);
+  }
+}
+
+bool WriteAheadLogFlowFileRepository::initialize(const std::shared_ptr<Configure> &configure) {
+  std::string value;
+  if (configure->get(Configure::nifi_flowfile_repository_directory_default, value)) {
+    directory_ = value;
+  }
+  logger_->log_debug("NiFi FlowFile Repository Directory %s", directory_);
+  if (configure->get(Configure::nifi_flowfile_repository_max_storage_size, value)) {
+    Property::StringToInt(value, max_partition_bytes_);
+  }
+  if (configure->get(Configure::nifi_flowfile_repository_wal_segment_size, value)) {
+    uint64_t segment_size = 0;
+    if (Property::StringToInt(value, segment_size) && segment_size > 0) {
+      max_segment_bytes_ = segment_size;
+    }
+  }
+  if (configure->get(Configure::nifi_flowfile_repository_wal_snapshot_interval, value)) {
+    TimeUnit unit;
+    int64_t interval = 0;
+    if (Property::StringToTime(value, interval, unit) && Property::ConvertTimeUnitToMS(interval, unit, interval) && interval > 0) {
+      snapshot_interval_ = interval;
+    }
+  }
+  if (configure->get(Configure::nifi_flowfile_repository_wal_sync, value)) {
+    utils::StringUtils::StringToBool(value, sync_);
+  }
+  logger_->log_debug("NiFi FlowFile WAL segment size %llu, snapshot interval %lld ms, sync %s", max_segment_bytes_, snapshot_interval_, sync_ ? "true" : "false");
+
+  utils::file::FileUtils::create_dir(directory_);
+
+  std::lock_guard<std::mutex> lock(log_mutex_);
+  records_.clear();
+  uint64_t next_segment = 1;
+  if (!readSnapshot(next_segment)) {
+    return false;
+  }
+  // segments a snapshot covers may outlive it if we stopped before deleting them
+  for (uint64_t id = next_segment - 1; id > 0 && fileExists(getSegmentPath(id)); id--) {
+    std::remove(getSegmentPath(id).c_str());
+  }
+  uint64_t id = next_segment;
+  uint64_t replayed = 0;
+  for (; fileExists(getSegmentPath(id)); id++) {
+    replayed += replaySegment(id);
+  }
+  repo_size_ = 0;
+  for (const auto &record : records_) {
+    repo_size_ += record.second.size();
+  }
+  logger_->log_info("Loaded %llu flow files from %s, replaying %llu log records", records_.size(), directory_, replayed);
+
+  first_segment_id_ = next_segment;
+  last_snapshot_ = std::chrono::steady_clock::now();
+  // a torn record may end the last segment, so appends always start a new one
+  return openSegment(id);
+}
+
+bool WriteAheadLogFlowFileRepository::Put(std::string key, const uint8_t *buf, size_t bufLen) {
+  return append(RECORD_PUT, key, buf, bufLen);
+}
+
+bool WriteAheadLogFlowFileRepository::Delete(std::string key) {
+  DeletedFlowFile deletion = { key, nullptr, false };
+  keys_to_delete_.enqueue(deletion);
+  return true;
+}
+
+bool WriteAheadLogFlowFileRepository::Delete(const std::string &key, const std::shared_ptr<minifi::ResourceClaim> &claim, uint64_t size) {
+  DeletedFlowFile deletion = { key, claim, true };
+  keys_to_delete_.enqueue(deletion);
+  return true;
+}
+
+void WriteAheadLogFlowFileRepository::flush() {
+  std::vector<DeletedFlowFile> deletions;
+  DeletedFlowFile deletion;
+  while (keys_to_delete_.try_dequeue(deletion)) {
+    deletions.push_back(deletion);
+  }
+  if (deletions.empty()) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<minifi::ResourceClaim>> claims;
+  {
+    std::unique_lock<std::mutex> lock(log_mutex_);
+    if (log_failed_ || nullptr == segment_) {
+      return;
+    }
+    for (auto &deleted : deletions) {
+      auto record = records_.find(deleted.key);
+      if (record == records_.end()) {
+        // nothing was stored, so there is nothing to log
+        continue;
+      }
+      if (!deleted.resolved && nullptr != content_repo_) {
+        // the record is only read for its claim; flush also runs from the destructor, where shared_from_this() is unavailable
+        std::shared_ptr<FlowFileRecord> eventRead = std::make_shared<FlowFileRecord>(nullptr, content_repo_);
+        if (eventRead->DeSerialize(reinterpret_cast<const uint8_t *>(record->second.data()), record->second.size())) {
+          deleted.claim = eventRead->getResourceClaim();
+        }
+      }
+      appendRecord(pending_, static_cast<uint8_t>(RECORD_DELETE), deleted.key, nullptr, 0);
+      PendingRecord pending = { RECORD_DELETE, deleted.key, "" };
+      pending_records_.push_back(std::move(pending));
+      ++appended_;
+      if (nullptr != deleted.claim) {
+        claims.push_back(deleted.claim);
+      }
+    }
+    if (!commit(lock, appended_)) {
+      return;
+    }
+  }
+  // claims are only removed once the deletes that orphan them are durable
+  if (nullptr != content_repo_ && !claims.empty()) {
+    content_repo_->removeOrphans(claims);
+  }
+}
+
+bool WriteAheadLogFlowFileRepository::Get(const std::string &key, std::string &value) {
+  std::lock_guard<std::mutex> lock(log_mutex_);
+  auto record = records_.find(key);
+  if (record == records_.end()) {
+    return false;
+  }
+  value = record->second;
+  return true;
+}
+
+bool WriteAheadLogFlowFileRepository::append(RecordType type, const std::string &key, const uint8_t *buf, size_t len) {
+  std::unique_lock<std::mutex> lock(log_mutex_);
+  if (log_failed_ || nullptr == segment_) {
+    return false;
+  }
+  appendRecord(pending_, static_cast<uint8_t>(type), key, buf, len);
+  PendingRecord pending = { type, key, nullptr != buf ? std::string(reinterpret_cast<const char*>(buf), len) : "" };
+  pending_records_.push_back(std::move(pending));
+  return commit(lock, ++appended_);
+}
+
+bool WriteAheadLogFlowFileRepository::commit(std::unique_lock<std::mutex> &lock, uint64_t sequence) {
+  // group commit: whoever finds no write in progress writes everything pending on behalf of the rest
+  while (synced_ < sequence && !log_failed_) {
+    if (syncing_) {
+      sync_cv_.wait(lock);
+      continue;
+    }
+    syncing_ = true;
+    std::string batch;
+    batch.swap(pending_);
+    std::vector<PendingRecord> records;
+    records.swap(pending_records_);
+    const uint64_t last = appended_;
+    lock.unlock();
+    const bool written = writeSegment(batch);
+    lock.lock();
+    syncing_ = false;
+    if (written) {
+      synced_ = last;
+      segment_bytes_ += batch.size();
+      applyRecords(records);
+    } else {
+      logger_->log_error("Could not write to FlowFile log segment %llu, refusing further updates", segment_id_);
+      log_failed_ = true;
+    }
+    sync_cv_.notify_all();
+  }
+  return !log_failed_;
+}
+
+void WriteAheadLogFlowFileRepository::applyRecords(const std::vector<PendingRecord> &records) {
+  for (const auto &pending : records) {
+    auto record = records_.find(pending.key);
+    if (record != records_.end()) {
+      repo_size_ -= std::min<uint64_t>(repo_size_, record->second.size());
+    }
+    if (pending.type == RECORD_PUT) {
+      records_[pending.key] = pending.value;
+      repo_size_ += pending.value.size();
+    } else if (record != records_.end()) {
+      records_.erase(record);
+    }
+  }
+}
+
+bool WriteAheadLogFlowFileRepository::writeSegment(const std::string &buffer) {
+  if (buffer.empty()) {
+    return true;
+  }
+  if (fwrite(buffer.data(), 1, buffer.size(), segment_) != buffer.size()) {
+    return false;
+  }
+  return sync_ ? syncFile(segment_) : fflush(segment_) == 0;
+}
+
+bool WriteAheadLogFlowFileRepository::openSegment(uint64_t id) {
+  segment_ = fopen(getSegmentPath(id).c_str(), "ab");
+  if (nullptr == segment_) {
+    logger_->log_error("Could not open FlowFile log segment %s", getSegmentPath(id));
+    return false;
+  }
+  segment_id_ = id;
+  segment_bytes_ = 0;
+  return true;
+}
+
+bool WriteAheadLogFlowFileRepository::snapshot() {
+  std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex_);
+  std::unordered_map<std::string, std::string> records;
+  uint64_t next_segment = 0;
+  {
+    std::unique_lock<std::mutex> lock(log_mutex_);
+    sync_cv_.wait(lock, [this]() {return !syncing_;});
+    if (log_failed_ || nullptr == segment_) {
+      return false;
+    }
+    // with everything appended so far in the current segment, the snapshot covers it exactly
+    if (!writeSegment(pending_)) {
+      log_failed_ = true;
+      sync_cv_.notify_all();
+      return false;
+    }
+    segment_bytes_ += pending_.size();
+    pending_.clear();
+    applyRecords(pending_records_);
+    pending_records_.clear();
+    synced_ = appended_;
+    sync_cv_.notify_all();
+    records = records_;
+    fclose(segment_);
+    segment_ = nullptr;
+    if (!openSegment(segment_id_ + 1)) {
+      log_failed_ = true;
+      return false;
+    }
+    next_segment = segment_id_;
+  }
+
+  std::string buffer;
+  appendUint32(buffer, SNAPSHOT_MAGIC);
+  appendUint32(buffer, SNAPSHOT_VERSION);
+  appendUint64(buffer, next_segment);
+  appendUint64(buffer, records.size());
+  for (const auto &record : records) {
+    appendRecord(buffer, RECORD_PUT, record.first, reinterpret_cast<const uint8_t*>(record.second.data()), record.second.size());
+  }
+  const std::string partial_path = getSnapshotPath() + ".partial";
+  FILE *file = fopen(partial_path.c_str(), "wb");
+  if (nullptr == file) {
+    logger_->log_error("Could not create FlowFile snapshot %s", partial_path);
+    return false;
+  }
+  const bool written = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && syncFile(file);
+  fclose(file);
+  // the rename is what makes the snapshot visible, so a crash leaves either the old or the new one
+  if (!written || std::rename(partial_path.c_str(), getSnapshotPath().c_str()) != 0) {
+    logger_->log_error("Could not write FlowFile snapshot %s", getSnapshotPath());
+    std::remove(partial_path.c_str());
+    return false;
+  }
+
+  for (uint64_t id = first_segment_id_; id < next_segment; id++) {
+    std::remove(getSegmentPath(id).c_str());
+  }
+  first_segment_id_ = next_segment;
+  last_snapshot_ = std::chrono::steady_clock::now();
+  logger_->log_debug("Wrote snapshot of %llu flow files, log continues with segment %llu", records.size(), next_segment);
+  return true;
+}
+
+bool WriteAheadLogFlowFileRepository::readSnapshot(uint64_t &next_segment) {
+  std::string buffer;
+  if (!readFile(getSnapshotPath(), buffer)) {
+    next_segment = 1;
+    return true;
+  }
+  if (buffer.size() < 24 || readUint32(buffer, 0) != SNAPSHOT_MAGIC || readUint32(buffer, 4) != SNAPSHOT_VERSION) {
+    logger_->log_error("FlowFile snapshot %s is not recognized", getSnapshotPath());
+    return false;
+  }
+  next_segment = readUint64(buffer, 8);
+  const uint64_t count = readUint64(buffer, 16);
+  size_t offset = 24;
+  uint8_t type;
+  std::string key, value;
+  for (uint64_t i = 0; i < count; i++) {
+    if (!readRecord(buffer, offset, type, key, value)) {
+      // snapshots are renamed into place once complete, so this is not a torn write
+      logger_->log_error("FlowFile snapshot %s is corrupt", getSnapshotPath());
+      return false;
+    }
+    records_[key] = value;
+  }
+  return true;
+}
+
+uint64_t WriteAheadLogFlowFileRepository::replaySegment(uint64_t id) {
+  std::string buffer;
+  if (!readFile(getSegmentPath(id), buffer)) {
+    return 0;
+  }
+  uint64_t replayed = 0;
+  size_t offset = 0;
+  uint8_t type;
+  std::string key, value;
+  while (offset < buffer.size()) {
+    if (!readRecord(buffer, offset, type, key, value)) {
+      // records past this point were never acknowledged as written
+      logger_->log_warn("Discarding %llu bytes at the end of FlowFile log segment %llu", buffer.size() - offset, id);
+      break;
+    }
+    if (type == RECORD_PUT) {
+      records_[key] = value;
+    } else {
+      records_.erase(key);
+    }
+    replayed++;
+  }
+  return replayed;
+}
+
+void WriteAheadLogFlowFileRepository::loadComponent(const std::shared_ptr<core::ContentRepository> &content_repo) {
+  content_repo_ = content_repo;
+  std::lock_guard<std::mutex> lock(log_mutex_);
+  recovered_records_.assign(records_.begin(), records_.end());
+}
+
+void WriteAheadLogFlowFileRepository::recoverFlowFiles() {
+  std::map<std::shared_ptr<minifi::Connection>, std::vector<std::shared_ptr<core::FlowFile>>> batches;
+  uint64_t recovered = 0;
+  for (const auto &record : recovered_records_) {
+    std::shared_ptr<FlowFileRecord> eventRead = std::make_shared<FlowFileRecord>(shared_from_this(), content_repo_);
+    eventRead->setStoredSize(record.second.size());
+    if (eventRead->DeSerialize(reinterpret_cast<const uint8_t *>(record.second.data()), record.second.size())) {
+      auto search = connectionMap.find(eventRead->getConnectionUuid());
+      std::shared_ptr<minifi::Connection> connection = search != connectionMap.end() ? std::dynamic_pointer_cast<minifi::Connection>(search->second) : nullptr;
+      if (nullptr != connection) {
+        eventRead->setStoredToRepository(true);
+        auto &batch = batches[connection];
+        batch.push_back(eventRead);
+        if (batch.size() >= WAL_FLOWFILE_REPOSITORY_RECOVERY_BATCH) {
+          recovered += batch.size();
+          connection->multiPut(batch);
+          batch.clear();
+        }
+        continue;
+      }
+      logger_->log_warn("Could not find connection for %s, path %s ", eventRead->getConnectionUuid(), eventRead->getContentFullPath());
+      if (nullptr != content_repo_ && nullptr != eventRead->getResourceClaim()) {
+        content_repo_->remove(eventRead->getResourceClaim());
+      }
+    }
+    Delete(record.first, nullptr, record.second.size());
+  }
+  for (auto &batch : batches) {
+    recovered += batch.second.size();
+    batch.first->multiPut(batch.second);
+  }
+  logger_->log_info("Recovered %llu flow files", recovered);
+  recovered_records_.clear();
+}
+
+void WriteAheadLogFlowFileRepository::run() {
+  if (running_) {
+    recoverFlowFiles();
+  }
+  while (running_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(purge_period_));
+    flush();
+    uint64_t segment_bytes = 0;
+    {
+      std::lock_guard<std::mutex> lock(log_mutex_);
+      segment_bytes = segment_bytes_;
+    }
+    int64_t since_snapshot = 0;
+    {
+      std::lock_guard<std::mutex> lock(snapshot_mutex_);
+      since_snapshot = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - last_snapshot_).count();
+    }
+    if (segment_bytes >= max_segment_bytes_ || (segment_bytes > 0 && since_snapshot >= snapshot_interval_)) {
+      snapshot();
+    }
+    repo_full_ = getRepoSize() > (uint64_t) max_partition_bytes_;
+  }
+  flush();
+}
+
+std::string WriteAheadLogFlowFileRepository::getSegmentPath(uint64_t id) const {
+  std::stringstream path;
+  path << directory_ << "/journal." << id;
+  return path.str();
+}
+
+std::string WriteAheadLogFlowFileRepository::getSnapshotPath() const {
+  return directory_ + "/snapshot";
+}
+
+} /* namespace repository */
+} /* namespace core */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
@@ -22,6 +22,7 @@
 
 #include "core/yaml/YamlConfiguration.h"
 #include "core/state/Value.h"
+#include "RootGroupPort.h"
 #ifdef YAML_CONFIGURATION_USE_REGEX
 #include <regex>
 #endif  // YAML_CONFIGURATION_USE_REGEX
@@ -435,6 +436,14 @@ void YamlConfiguration::parseProvenanceReportingYaml(YAML::Node *reportNode, cor
     reportTask->setBatchSize(lvalue);
   }
 
+  if (node["max report size"]) {
+    auto maxReportSizeStr = node["max report size"].as<std::string>();
+    if (core::Property::StringToInt(maxReportSizeStr, lvalue) && lvalue > 0) {
+      logger_->log_debug("ProvenanceReportingTask max report size %lld", lvalue);
+      reportTask->setMaxReportSize(lvalue);
+    }
+  }
+
   reportTask->initialize();
 
   // add processor to parent
@@ -718,6 +727,38 @@ void YamlConfiguration::parsePortYaml(YAML::Node *portNode, core::ProcessGroup *
   }
 }
 
+void YamlConfiguration::parseRootGroupPortsYaml(YAML::Node *portsNode, core::ProcessGroup *parent, sitetosite::TransferDirection direction) {
+  if (!parent) {
+    logger_->log_error("parseRootGroupPorts: no parent group existed");
+    return;
+  }
+  if (!portsNode || !portsNode->IsSequence()) {
+    return;
+  }
+  const char *section = direction == sitetosite::SEND ? CONFIG_YAML_INPUT_PORTS_KEY : CONFIG_YAML_OUTPUT_PORTS_KEY;
+  for (YAML::const_iterator portIter = portsNode->begin(); portIter != portsNode->end(); ++portIter) {
+    YAML::Node portNode = portIter->as<YAML::Node>();
+
+    checkRequiredField(&portNode, "name", section);
+    auto nameStr = portNode["name"].as<std::string>();
+    checkRequiredField(&portNode, "id", section,
+                       "The field 'id' is required for "
+                           "the port named '" + nameStr + "' in the YAML Config. Remote Process Groups of other "
+                           "instances send to or receive from the port by this id.");
+    utils::Identifier uuid;
+    uuid = portNode["id"].as<std::string>();
+    logger_->log_debug("parseRootGroupPorts: name => [%s] id => [%s]", nameStr, uuid.to_string());
+
+    auto port = std::make_shared<minifi::RootGroupPort>(nameStr, configuration_, uuid);
+    port->setDirection(direction);
+    port->setYieldPeriodMsec(parent->getYieldPeriodMsec());
+    port->initialize();
+
+    parent->addProcessor(port);
+    port->setScheduledState(core::RUNNING);
+  }
+}
+
 void YamlConfiguration::parsePropertiesNodeYaml(YAML::Node *propertiesNode, std::shared_ptr<core::ConfigurableComponent> processor, const std::string &component_name,
                                                 const std::string &yaml_section) {
   // Treat generically as a YAML node so we can perform inspection on entries to ensure they are populated
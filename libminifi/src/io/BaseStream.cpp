@@ -45,6 +45,22 @@ int BaseStream::writeData(uint8_t *value, int size) {
   }
 }
 
+int BaseStream::writeV(const struct iovec *iov, int iovcnt) {
+  if (LIKELY(composable_stream_ == this)) {
+    return DataStream::writeV(iov, iovcnt);
+  } else {
+    return composable_stream_->writeV(iov, iovcnt);
+  }
+}
+
+int BaseStream::readV(const struct iovec *iov, int iovcnt) {
+  if (LIKELY(composable_stream_ == this)) {
+    return DataStream::readV(iov, iovcnt);
+  } else {
+    return composable_stream_->readV(iov, iovcnt);
+  }
+}
+
 /**
  * write 2 bytes to stream
  * @param base_value non encoded value
@@ -147,6 +163,8 @@ int BaseStream::read(uint8_t *value, int len) {
  * @param buflen
  */
 int BaseStream::readData(std::vector<uint8_t> &buf, int buflen) {
+  if (static_cast<int>(buf.size()) < buflen)
+    buf.resize(buflen);
   return Serializable::read(&buf[0], buflen, composable_stream_);
 }
 /**
@@ -0,0 +1,151 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "io/BufferedStream.h"
+#include <vector>
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace io {
+
+BufferedStream::BufferedStream(DataStream *stream, size_t buffer_size)
+    : stream_(stream),
+      buffer_size_(buffer_size) {
+  output_buffer_.reserve(buffer_size_);
+}
+
+int BufferedStream::flush() {
+  if (output_buffer_.empty()) {
+    return 0;
+  }
+  int size = output_buffer_.size();
+  int ret = stream_->writeData(output_buffer_.data(), size);
+  output_buffer_.clear();
+  return ret == size ? size : -1;
+}
+
+short BufferedStream::initialize() {
+  output_buffer_.clear();
+  return stream_->initialize();
+}
+
+void BufferedStream::seek(uint64_t offset) {
+  flush();
+  stream_->seek(offset);
+}
+
+void BufferedStream::closeStream() {
+  flush();
+  stream_->closeStream();
+}
+
+int BufferedStream::readData(std::vector<uint8_t> &buf, int buflen) {
+  if (flush() < 0) {
+    return -1;
+  }
+  return stream_->readData(buf, buflen);
+}
+
+int BufferedStream::readData(uint8_t *buf, int buflen) {
+  if (flush() < 0) {
+    return -1;
+  }
+  return stream_->readData(buf, buflen);
+}
+
+int BufferedStream::writeData(uint8_t *value, int size) {
+  if (size < 0) {
+    return -1;
+  }
+  if (static_cast<size_t>(size) >= buffer_size_) {
+    // sent along with the buffered data
+    struct iovec iov;
+    iov.iov_base = value;
+    iov.iov_len = size;
+    return writeV(&iov, 1);
+  }
+  if (output_buffer_.size() + size > buffer_size_ && flush() < 0) {
+    return -1;
+  }
+  output_buffer_.insert(output_buffer_.end(), value, value + size);
+  return size;
+}
+
+int BufferedStream::writeV(const struct iovec *iov, int iovcnt) {
+  size_t size = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    size += iov[i].iov_len;
+  }
+  if (output_buffer_.size() + size <= buffer_size_) {
+    for (int i = 0; i < iovcnt; i++) {
+      uint8_t *value = reinterpret_cast<uint8_t*>(iov[i].iov_base);
+      output_buffer_.insert(output_buffer_.end(), value, value + iov[i].iov_len);
+    }
+    return size;
+  }
+  if (output_buffer_.empty()) {
+    return stream_->writeV(iov, iovcnt);
+  }
+  // the buffered data goes out along with the buffers
+  std::vector<struct iovec> buffers;
+  buffers.reserve(iovcnt + 1);
+  struct iovec buffered;
+  buffered.iov_base = output_buffer_.data();
+  buffered.iov_len = output_buffer_.size();
+  buffers.push_back(buffered);
+  buffers.insert(buffers.end(), iov, iov + iovcnt);
+  int expected = output_buffer_.size() + size;
+  int ret = stream_->writeV(buffers.data(), buffers.size());
+  output_buffer_.clear();
+  return ret == expected ? size : -1;
+}
+
+int BufferedStream::readV(const struct iovec *iov, int iovcnt) {
+  if (flush() < 0) {
+    return -1;
+  }
+  return stream_->readV(iov, iovcnt);
+}
+
+int BufferedStream::read(uint64_t &value, bool is_little_endian) {
+  if (flush() < 0) {
+    return -1;
+  }
+  return stream_->read(value, is_little_endian);
+}
+
+int BufferedStream::read(uint32_t &value, bool is_little_endian) {
+  if (flush() < 0) {
+    return -1;
+  }
+  return stream_->read(value, is_little_endian);
+}
+
+int BufferedStream::read(uint16_t &value, bool is_little_endian) {
+  if (flush() < 0) {
+    return -1;
+  }
+  return stream_->read(value, is_little_endian);
+}
+
+} /* namespace io */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
@@ -38,6 +38,35 @@ int DataStream::writeData(uint8_t *value, int size) {
   return size;
 }
 
+int DataStream::writeV(const struct iovec *iov, int iovcnt) {
+  int total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    int size = static_cast<int>(iov[i].iov_len);
+    if (size == 0)
+      continue;
+    if (writeData(reinterpret_cast<uint8_t*>(iov[i].iov_base), size) != size)
+      return -1;
+    total += size;
+  }
+  return total;
+}
+
+int DataStream::readV(const struct iovec *iov, int iovcnt) {
+  int total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    int size = static_cast<int>(iov[i].iov_len);
+    if (size == 0)
+      continue;
+    int ret = readData(reinterpret_cast<uint8_t*>(iov[i].iov_base), size);
+    if (ret <= 0)
+      return total > 0 ? total : -1;
+    total += ret;
+    if (ret < size)
+      break;
+  }
+  return total;
+}
+
 int DataStream::read(uint64_t &value, bool is_little_endian) {
   if ((8 + readBuffer) > buffer.size()) {
     // if read exceed
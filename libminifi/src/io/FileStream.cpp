@@ -110,6 +110,26 @@ int FileStream::writeData(uint8_t *value, int size) {
   }
 }
 
+int FileStream::writeV(const struct iovec *iov, int iovcnt) {
+  std::lock_guard<std::recursive_mutex> lock(file_lock_);
+  int total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    if (iov[i].iov_len == 0)
+      continue;
+    if (!file_stream_->write(reinterpret_cast<const char*>(iov[i].iov_base), iov[i].iov_len)) {
+      return -1;
+    }
+    total += iov[i].iov_len;
+  }
+  offset_ += total;
+  if (offset_ > length_) {
+    length_ = offset_;
+  }
+  file_stream_->seekg(offset_);
+  file_stream_->flush();
+  return total;
+}
+
 template<typename T>
 inline std::vector<uint8_t> FileStream::readBuffer(const T& t) {
   std::vector<uint8_t> buf;
@@ -147,6 +147,8 @@ int Serializable::readUTF(std::string &str, DataStream *stream, bool widen) {
 
   std::vector<uint8_t> buf;
   ret = stream->readData(buf, utflen);
+  if (ret < 0)
+    return -1;
 
   // The number of chars produced may be less than utflen
   str = std::string((const char*) &buf[0], utflen);
@@ -195,6 +197,66 @@ int Serializable::writeUTF(std::string str, DataStream *stream, bool widen) {
   return ret;
 }
 
+int Serializable::writeVarInt(uint64_t value, DataStream *stream) {
+  uint8_t bytes[10];
+  int len = 0;
+  while (value >= 0x80) {
+    bytes[len++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  bytes[len++] = static_cast<uint8_t>(value);
+  return stream->writeData(bytes, len);
+}
+
+int Serializable::readVarInt(uint64_t &value, DataStream *stream) {
+  value = 0;
+  for (int i = 0; i < 10; i++) {
+    uint8_t byte = 0;
+    if (stream->readData(&byte, 1) != 1) {
+      return -1;
+    }
+    if (i == 9 && byte > 1) {
+      return -1;
+    }
+    value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      return i + 1;
+    }
+  }
+  return -1;
+}
+
+int Serializable::writeVarString(const std::string &str, DataStream *stream) {
+  int ret = writeVarInt(str.length(), stream);
+  if (ret <= 0 || str.empty()) {
+    return ret;
+  }
+  int written = stream->writeData(reinterpret_cast<uint8_t*>(const_cast<char*>(str.data())), str.length());
+  if (written != static_cast<int>(str.length())) {
+    return -1;
+  }
+  return ret + written;
+}
+
+int Serializable::readVarString(std::string &str, DataStream *stream) {
+  uint64_t len = 0;
+  int ret = readVarInt(len, stream);
+  if (ret <= 0) {
+    return -1;
+  }
+  if (len > static_cast<uint64_t>(stream->getSize())) {
+    return -1;
+  }
+  str.resize(len);
+  if (len == 0) {
+    return ret;
+  }
+  if (stream->readData(reinterpret_cast<uint8_t*>(&str[0]), len) != static_cast<int>(len)) {
+    return -1;
+  }
+  return ret + static_cast<int>(len);
+}
+
 } /* namespace io */
 } /* namespace minifi */
 } /* namespace nifi */
@@ -23,6 +23,7 @@
 #include <netinet/tcp.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -34,7 +35,11 @@
 #include <cerrno>
 #include <iostream>
 #include <string>
+#include <set>
+#include <mutex>
+#include <future>
 #include "io/validation.h"
+#include "utils/ThreadPool.h"
 #include "core/logging/LoggerConfiguration.h"
 
 namespace org {
@@ -49,12 +54,135 @@ ServerSocket::ServerSocket(const std::shared_ptr<SocketContext> &context, const
       logger_(logging::LoggerFactory<ServerSocket>::getLogger()) {
 }
 
+#ifndef WIN32
+struct ServerSocket::ConnectionHandlers {
+  explicit ConnectionHandlers(int threads)
+      : closed(false),
+        pool(threads, false, nullptr, "ServerSocketHandlers") {
+    pool.start();
+  }
+
+  /**
+   * Takes over an accepted connection from the server socket.
+   * @return false if the server socket closed the connection meanwhile
+   */
+  bool claim(int fd) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return connections.erase(fd) > 0;
+  }
+
+  std::mutex mutex;
+  // accepted connections that no handler has claimed yet
+  std::set<int> connections;
+  // set once the server socket closes
+  bool closed;
+  utils::ThreadPool<bool> pool;
+};
+
+namespace {
+
+// bounds the time a handler spends on a connection that stopped sending or receiving
+void setTimeouts(int fd) {
+  struct timeval timeout;
+  timeout.tv_sec = SERVER_SOCKET_IO_TIMEOUT;
+  timeout.tv_usec = 0;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char*>(&timeout), sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<char*>(&timeout), sizeof(timeout));
+}
+
+}  // namespace
+#endif
+
 ServerSocket::~ServerSocket() {
   running_ = false;
   if (server_read_thread_.joinable())
     server_read_thread_.join();
+#ifndef WIN32
+  if (reactor_ != nullptr) {
+    // the accepting callback uses this server socket, so it is unregistered first
+    reactor_->remove(socket_file_descriptor_);
+  }
+  if (handlers_ != nullptr) {
+    std::set<int> connections;
+    {
+      std::lock_guard<std::mutex> lock(handlers_->mutex);
+      handlers_->closed = true;
+      connections.swap(handlers_->connections);
+    }
+    for (int fd : connections) {
+      reactor_->remove(fd);
+      close(fd);
+    }
+    // waits for the running handlers, which may refer to the owner of this server socket
+    handlers_->pool.shutdown();
+  }
+#endif
 }
 
+#ifndef WIN32
+/**
+ * Registers the server socket with the reactor
+ */
+void ServerSocket::registerCallback(std::function<bool()> accept_function, std::function<void(io::BaseStream *)> handler) {
+  handlers_ = std::make_shared<ConnectionHandlers>(SERVER_SOCKET_HANDLER_THREADS);
+  std::shared_ptr<ConnectionHandlers> handlers = handlers_;
+  // the shared reactor lives as long as the agent
+  Reactor *reactor = Reactor::getReactor().get();
+  registerConnectionCallback(accept_function, [handlers, handler, reactor](int newfd) {
+    setTimeouts(newfd);
+    std::lock_guard<std::mutex> lock(handlers->mutex);
+    if (handlers->closed) {
+      close(newfd);
+      return;
+    }
+    handlers->connections.insert(newfd);
+    // the handler reads the request, so it is dispatched once the request arrives
+    reactor->add(newfd, REACTOR_READABLE, [handlers, handler, reactor](int fd, uint32_t events) {
+      reactor->remove(fd);
+      std::function<bool()> task = [handlers, handler, fd]() {
+        if (!handlers->claim(fd)) {
+          return false;
+        }
+        io::DescriptorStream stream(fd);
+        handler(&stream);
+        close(fd);
+        return true;
+      };
+      std::lock_guard<std::mutex> lock(handlers->mutex);
+      // a closed server socket closes the connections it still holds
+      if (!handlers->closed) {
+        utils::Worker<bool> worker(task, "ServerSocketHandler");
+        std::future<bool> future;
+        handlers->pool.execute(std::move(worker), future);
+      }
+    });
+  });
+}
+
+void ServerSocket::registerConnectionCallback(std::function<bool()> accept_function, std::function<void(int)> handler) {
+  reactor_ = Reactor::getReactor();
+  Reactor::setNonBlocking(socket_file_descriptor_);
+  reactor_->add(socket_file_descriptor_, REACTOR_READABLE, [this, accept_function, handler](int fd, uint32_t events) {
+    acceptConnections(accept_function, handler);
+  });
+}
+
+void ServerSocket::acceptConnections(const std::function<bool()> &accept_function, const std::function<void(int)> &handler) {
+  while (running_) {
+    struct sockaddr_storage remoteaddr;
+    socklen_t addrlen = sizeof remoteaddr;
+    int newfd = accept(socket_file_descriptor_, (struct sockaddr *) &remoteaddr, &addrlen);
+    if (newfd < 0) {
+      return;
+    }
+    if (!accept_function()) {
+      close(newfd);
+      continue;
+    }
+    handler(newfd);
+  }
+}
+#else
 /**
  * Initializes the socket
  * @return result of the creation operation.
@@ -72,11 +200,12 @@ void ServerSocket::registerCallback(std::function<bool()> accept_function, std::
   };
   server_read_thread_ = std::thread(fx, accept_function, handler);
 }
+#endif
 
 void ServerSocket::close_fd(int fd) {
   std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
+  remove_descriptor(fd);
   close(fd);
-  FD_CLR(fd, &total_list_);
 }
 
 } /* namespace io */
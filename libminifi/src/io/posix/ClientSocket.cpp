@@ -23,10 +23,14 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <climits>
 #include <net/if.h>
 #include <ifaddrs.h>
 #include <unistd.h>
 #include <cstdio>
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -47,7 +51,6 @@ Socket::Socket(const std::shared_ptr<SocketContext> &context, const std::string
       port_(port),
       addr_info_(0),
       socket_file_descriptor_(-1),
-      socket_max_(0),
       total_written_(0),
       total_read_(0),
       is_loopback_only_(false),
@@ -55,8 +58,6 @@ Socket::Socket(const std::shared_ptr<SocketContext> &context, const std::string
       canonical_hostname_(""),
       nonBlocking_(false),
       logger_(logging::LoggerFactory<Socket>::getLogger()) {
-  FD_ZERO(&total_list_);
-  FD_ZERO(&read_fds_);
 }
 
 Socket::Socket(const std::shared_ptr<SocketContext> &context, const std::string &hostname, const uint16_t port)
@@ -69,10 +70,8 @@ Socket::Socket(const Socket &&other)
       is_loopback_only_(false),
       addr_info_(std::move(other.addr_info_)),
       socket_file_descriptor_(other.socket_file_descriptor_),
-      socket_max_(other.socket_max_.load()),
       listeners_(other.listeners_),
-      total_list_(other.total_list_),
-      read_fds_(other.read_fds_),
+      descriptors_(other.descriptors_),
       canonical_hostname_(std::move(other.canonical_hostname_)),
       nonBlocking_(false),
       logger_(std::move(other.logger_)) {
@@ -91,6 +90,7 @@ void Socket::closeStream() {
   }
   if (socket_file_descriptor_ >= 0) {
     logging::LOG_DEBUG(logger_) << "Closing " << socket_file_descriptor_;
+    remove_descriptor(socket_file_descriptor_);
     close(socket_file_descriptor_);
     socket_file_descriptor_ = -1;
   }
@@ -192,10 +192,17 @@ int8_t Socket::createConnection(const addrinfo *p, in_addr_t &addr) {
     } else {
       logger_->log_debug("Created connection with %d listeners", listeners_);
     }
+    if (port_ == 0) {
+      // the port chosen by the system is kept, so that it can be handed to clients
+      struct sockaddr_in bound;
+      socklen_t length = sizeof(bound);
+      if (getsockname(socket_file_descriptor_, reinterpret_cast<struct sockaddr*>(&bound), &length) == 0) {
+        port_ = ntohs(bound.sin_port);
+      }
+    }
   }
   // add the listener to the total set
-  FD_SET(socket_file_descriptor_, &total_list_);
-  socket_max_ = socket_file_descriptor_;
+  add_descriptor(socket_file_descriptor_);
   logger_->log_debug("Created connection with file descriptor %d", socket_file_descriptor_);
   return 0;
 }
@@ -244,7 +251,8 @@ int16_t Socket::initialize() {
         canonical_hostname_ = p->ai_canonname;
     }
     // we've successfully connected
-    if (port_ > 0 && createConnection(p, addr) >= 0) {
+    // servers may listen on port 0, which has the system choose a free port
+    if ((port_ > 0 || listeners_ > 0) && createConnection(p, addr) >= 0) {
       // Put the socket in non-blocking mode:
       if (nonBlocking_) {
         if (fcntl(socket_file_descriptor_, F_SETFL, O_NONBLOCK) < 0) {
@@ -269,46 +277,59 @@ int16_t Socket::select_descriptor(const uint16_t msec) {
     return socket_file_descriptor_;
   }
 
-  struct timeval tv;
+  std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
+
+  int fd = poll_descriptors(msec);
+  if (fd == socket_file_descriptor_) {
+    // we have a new connection
+    struct sockaddr_storage remoteaddr;  // client address
+    socklen_t addrlen = sizeof remoteaddr;
+    int newfd = accept(socket_file_descriptor_, (struct sockaddr *) &remoteaddr, &addrlen);
+    if (newfd < 0) {
+      logger_->log_debug("Could not accept a connection, error: %s", strerror(errno));
+      return -1;
+    }
+    add_descriptor(newfd);
+    return newfd;
+  } else if (fd >= 0) {
+    // data to be received on fd
+    return fd;
+  }
 
-  read_fds_ = total_list_;
+  logger_->log_debug("Could not find a suitable file descriptor or select timed out");
 
-  tv.tv_sec = msec / 1000;
-  tv.tv_usec = (msec % 1000) * 1000;
+  return -1;
+}
 
+void Socket::add_descriptor(int fd) {
   std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
+  descriptors_.push_back(fd);
+}
 
-  if (msec > 0)
-    select(socket_max_ + 1, &read_fds_, NULL, NULL, &tv);
-  else
-    select(socket_max_ + 1, &read_fds_, NULL, NULL, NULL);
-
-  for (int i = 0; i <= socket_max_; i++) {
-    if (FD_ISSET(i, &read_fds_)) {
-      if (i == socket_file_descriptor_) {
-        if (listeners_ > 0) {
-          struct sockaddr_storage remoteaddr;  // client address
-          socklen_t addrlen = sizeof remoteaddr;
-          int newfd = accept(socket_file_descriptor_, (struct sockaddr *) &remoteaddr, &addrlen);
-          FD_SET(newfd, &total_list_);  // add to master set
-          if (newfd > socket_max_) {    // keep track of the max
-            socket_max_ = newfd;
-          }
-          return newfd;
+void Socket::remove_descriptor(int fd) {
+  std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
+  descriptors_.erase(std::remove(descriptors_.begin(), descriptors_.end(), fd), descriptors_.end());
+}
 
-        } else {
-          return socket_file_descriptor_;
-        }
-        // we have a new connection
-      } else {
-        // data to be received on i
-        return i;
-      }
-    }
+int Socket::poll_descriptors(const uint16_t msec) {
+  std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
+  std::vector<struct pollfd> fds(descriptors_.size());
+  for (size_t i = 0; i < descriptors_.size(); i++) {
+    fds[i].fd = descriptors_[i];
+    fds[i].events = POLLIN;
+    fds[i].revents = 0;
   }
 
-  logger_->log_debug("Could not find a suitable file descriptor or select timed out");
+  if (poll(fds.data(), fds.size(), msec > 0 ? msec : -1) <= 0) {
+    return -1;
+  }
 
+  for (const auto &fd : fds) {
+    // a hung up descriptor is returned as well, so that its reader sees the end of the stream
+    if (fd.revents & (POLLIN | POLLHUP | POLLERR)) {
+      return fd.fd;
+    }
+  }
   return -1;
 }
 
@@ -350,6 +371,10 @@ std::string Socket::getHostname() const {
   return canonical_hostname_;
 }
 
+uint16_t Socket::getPort() {
+  return port_;
+}
+
 int Socket::writeData(std::vector<uint8_t> &buf, int buflen) {
   if (static_cast<int>(buf.capacity()) < buflen)
     return -1;
@@ -366,8 +391,14 @@ int Socket::writeData(uint8_t *value, int size) {
     ret = send(fd, value + bytes, size - bytes, 0);
     // check for errors
     if (ret <= 0) {
-      close(fd);
       logger_->log_error("Could not send to %d, error: %s", fd, strerror(errno));
+      // the descriptor of a connected socket is released by closeStream, so that it is not closed twice
+      if (fd == socket_file_descriptor_) {
+        closeStream();
+      } else {
+        remove_descriptor(fd);
+        close(fd);
+      }
       return ret;
     }
     bytes += ret;
@@ -379,6 +410,44 @@ int Socket::writeData(uint8_t *value, int size) {
   return bytes;
 }
 
+int Socket::writeV(const struct iovec *iov, int iovcnt) {
+  // copied, since buffers that are written partially are advanced
+  std::vector<struct iovec> pending(iov, iov + iovcnt);
+  size_t index = 0;
+  int bytes = 0;
+
+  int fd = select_descriptor(1000);
+  while (index < pending.size()) {
+    int count = static_cast<int>(std::min<size_t>(pending.size() - index, IOV_MAX));
+    ssize_t ret = writev(fd, &pending[index], count);
+    // check for errors
+    if (ret <= 0) {
+      logger_->log_error("Could not send to %d, error: %s", fd, strerror(errno));
+      // the descriptor of a connected socket is released by closeStream, so that it is not closed twice
+      if (fd == socket_file_descriptor_) {
+        closeStream();
+      } else {
+        remove_descriptor(fd);
+        close(fd);
+      }
+      return ret;
+    }
+    bytes += ret;
+    while (index < pending.size() && static_cast<size_t>(ret) >= pending[index].iov_len) {
+      ret -= pending[index].iov_len;
+      index++;
+    }
+    if (ret > 0) {
+      pending[index].iov_base = reinterpret_cast<uint8_t*>(pending[index].iov_base) + ret;
+      pending[index].iov_len -= ret;
+    }
+  }
+
+  logger_->log_trace("Send data size %d in %d buffers over socket %d", bytes, iovcnt, fd);
+  total_written_ += bytes;
+  return bytes;
+}
+
 template<typename T>
 inline std::vector<uint8_t> Socket::readBuffer(const T& t) {
   std::vector<uint8_t> buf;
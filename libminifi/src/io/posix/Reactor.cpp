@@ -0,0 +1,390 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "io/Reactor.h"
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "utils/TimeUtil.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace io {
+
+namespace {
+
+// longest wait, after which the threads check whether they are to stop
+const int MAX_WAIT_MS = 1000;
+
+}  // namespace
+
+Reactor::Reactor(uint16_t threads)
+    : thread_count_(std::max<uint16_t>(1, threads)),
+      running_(false),
+      poll_fd_(-1),
+      next_timer_id_(1),
+      logger_(logging::LoggerFactory<Reactor>::getLogger()) {
+  wake_fds_[0] = wake_fds_[1] = -1;
+  if (pipe(wake_fds_) < 0) {
+    logger_->log_error("Could not create the wake pipe of the reactor: %s", strerror(errno));
+    wake_fds_[0] = wake_fds_[1] = -1;
+  } else {
+    setNonBlocking(wake_fds_[0]);
+    setNonBlocking(wake_fds_[1]);
+  }
+#ifdef __linux__
+  poll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (poll_fd_ < 0) {
+    logger_->log_error("Could not create the epoll descriptor of the reactor: %s", strerror(errno));
+  } else if (wake_fds_[0] >= 0) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = wake_fds_[0];
+    epoll_ctl(poll_fd_, EPOLL_CTL_ADD, wake_fds_[0], &event);
+  }
+#else
+  // poll reports a descriptor to every thread waiting on it
+  thread_count_ = 1;
+#endif
+}
+
+Reactor::~Reactor() {
+  stop();
+  if (poll_fd_ >= 0)
+    close(poll_fd_);
+  if (wake_fds_[0] >= 0)
+    close(wake_fds_[0]);
+  if (wake_fds_[1] >= 0)
+    close(wake_fds_[1]);
+}
+
+std::shared_ptr<Reactor> Reactor::getReactor() {
+  static std::shared_ptr<Reactor> reactor = [] {
+    auto shared = std::make_shared<Reactor>(REACTOR_THREADS);
+    shared->start();
+    return shared;
+  }();
+  return reactor;
+}
+
+bool Reactor::start() {
+#ifdef __linux__
+  if (poll_fd_ < 0)
+    return false;
+#endif
+  if (wake_fds_[0] < 0)
+    return false;
+  bool expected = false;
+  if (!running_.compare_exchange_strong(expected, true))
+    return true;
+  for (uint16_t i = 0; i < thread_count_; i++) {
+    threads_.emplace_back(&Reactor::run, this);
+  }
+  logger_->log_debug("Started reactor with %d threads", thread_count_);
+  return true;
+}
+
+void Reactor::stop() {
+  running_ = false;
+  wake();
+  for (auto &thread : threads_) {
+    if (thread.get_id() == std::this_thread::get_id())
+      thread.detach();
+    else if (thread.joinable())
+      thread.join();
+  }
+  threads_.clear();
+}
+
+bool Reactor::add(int fd, uint32_t events, const Callback &callback) {
+  auto registration = std::make_shared<Registration>();
+  registration->fd = fd;
+  registration->events = events;
+  registration->callback = callback;
+  registration->removed = false;
+  registration->running = false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto previous = registrations_.find(fd);
+  if (previous != registrations_.end()) {
+    previous->second->removed = true;
+  }
+  registrations_[fd] = registration;
+  if (!arm(registration, true)) {
+    registrations_.erase(fd);
+    return false;
+  }
+  wake();
+  return true;
+}
+
+void Reactor::remove(int fd) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = registrations_.find(fd);
+  if (it == registrations_.end())
+    return;
+  std::shared_ptr<Registration> registration = it->second;
+  registration->removed = true;
+  registrations_.erase(it);
+#ifdef __linux__
+  epoll_ctl(poll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+  if (registration->thread != std::this_thread::get_id()) {
+    callback_finished_.wait(lock, [&registration] {return !registration->running;});
+  }
+}
+
+uint64_t Reactor::schedule(uint64_t delay_ms, const std::function<void()> &task) {
+  uint64_t id;
+  {
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    id = next_timer_id_++;
+    Timer timer;
+    timer.id = id;
+    timer.task = task;
+    timers_.insert(std::make_pair(getTimeMillis() + delay_ms, std::move(timer)));
+  }
+  // the waiting threads take the new deadline into account
+  wake();
+  return id;
+}
+
+void Reactor::cancel(uint64_t timer_id) {
+  std::lock_guard<std::mutex> lock(timer_mutex_);
+  for (auto it = timers_.begin(); it != timers_.end(); ++it) {
+    if (it->second.id == timer_id) {
+      timers_.erase(it);
+      return;
+    }
+  }
+}
+
+size_t Reactor::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return registrations_.size();
+}
+
+bool Reactor::setNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags < 0)
+    return false;
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void Reactor::run() {
+  while (running_) {
+    int timeout = runTimers();
+    if (!running_)
+      break;
+    poll(timeout);
+  }
+}
+
+#ifdef __linux__
+
+bool Reactor::arm(const std::shared_ptr<Registration> &registration, bool added) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  // one thread at a time handles a descriptor, which is armed again after its callback
+  event.events = EPOLLONESHOT;
+  if (registration->events & REACTOR_READABLE)
+    event.events |= EPOLLIN | EPOLLRDHUP;
+  if (registration->events & REACTOR_WRITABLE)
+    event.events |= EPOLLOUT;
+  event.data.fd = registration->fd;
+  if (added) {
+    if (epoll_ctl(poll_fd_, EPOLL_CTL_ADD, registration->fd, &event) == 0)
+      return true;
+    // still watched for a registration being replaced
+    if (errno != EEXIST)
+      return false;
+  }
+  return epoll_ctl(poll_fd_, EPOLL_CTL_MOD, registration->fd, &event) == 0;
+}
+
+void Reactor::poll(int timeout_ms) {
+  struct epoll_event events[REACTOR_MAX_EVENTS];
+  int count = epoll_wait(poll_fd_, events, REACTOR_MAX_EVENTS, timeout_ms);
+  if (count < 0) {
+    if (errno != EINTR)
+      logger_->log_error("Waiting for ready descriptors failed: %s", strerror(errno));
+    return;
+  }
+  for (int i = 0; i < count; i++) {
+    int fd = events[i].data.fd;
+    if (fd == wake_fds_[0]) {
+      if (running_) {
+        char buffer[64];
+        while (read(wake_fds_[0], buffer, sizeof(buffer)) > 0) {
+        }
+      }
+      continue;
+    }
+    std::shared_ptr<Registration> registration;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = registrations_.find(fd);
+      if (it == registrations_.end())
+        continue;
+      registration = it->second;
+    }
+    uint32_t ready = 0;
+    if (events[i].events & EPOLLIN)
+      ready |= REACTOR_READABLE;
+    if (events[i].events & EPOLLOUT)
+      ready |= REACTOR_WRITABLE;
+    if (events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP))
+      ready |= REACTOR_CLOSED | REACTOR_READABLE;
+    dispatch(registration, ready);
+  }
+}
+
+#else
+
+bool Reactor::arm(const std::shared_ptr<Registration> &registration, bool added) {
+  // the descriptors are collected for each call to poll
+  return true;
+}
+
+void Reactor::poll(int timeout_ms) {
+  std::vector<struct pollfd> fds;
+  std::vector<std::shared_ptr<Registration>> watched;
+  struct pollfd wake_fd;
+  wake_fd.fd = wake_fds_[0];
+  wake_fd.events = POLLIN;
+  wake_fd.revents = 0;
+  fds.push_back(wake_fd);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &entry : registrations_) {
+      struct pollfd fd;
+      fd.fd = entry.first;
+      fd.events = 0;
+      if (entry.second->events & REACTOR_READABLE)
+        fd.events |= POLLIN;
+      if (entry.second->events & REACTOR_WRITABLE)
+        fd.events |= POLLOUT;
+      fd.revents = 0;
+      fds.push_back(fd);
+      watched.push_back(entry.second);
+    }
+  }
+  int count = ::poll(fds.data(), fds.size(), timeout_ms);
+  if (count < 0) {
+    if (errno != EINTR)
+      logger_->log_error("Waiting for ready descriptors failed: %s", strerror(errno));
+    return;
+  }
+  if (fds[0].revents & POLLIN) {
+    char buffer[64];
+    while (read(wake_fds_[0], buffer, sizeof(buffer)) > 0) {
+    }
+  }
+  for (size_t i = 1; i < fds.size(); i++) {
+    if (fds[i].revents == 0)
+      continue;
+    uint32_t ready = 0;
+    if (fds[i].revents & POLLIN)
+      ready |= REACTOR_READABLE;
+    if (fds[i].revents & POLLOUT)
+      ready |= REACTOR_WRITABLE;
+    if (fds[i].revents & (POLLHUP | POLLERR | POLLNVAL))
+      ready |= REACTOR_CLOSED | REACTOR_READABLE;
+    dispatch(watched[i - 1], ready);
+  }
+}
+
+#endif
+
+void Reactor::dispatch(const std::shared_ptr<Registration> &registration, uint32_t events) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (registration->removed || registration->running)
+      return;
+    registration->running = true;
+    registration->thread = std::this_thread::get_id();
+  }
+  try {
+    registration->callback(registration->fd, events);
+  } catch (const std::exception &exception) {
+    logger_->log_error("Callback for descriptor %d failed: %s", registration->fd, exception.what());
+  } catch (...) {
+    logger_->log_error("Callback for descriptor %d failed", registration->fd);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  registration->running = false;
+  registration->thread = std::thread::id();
+  if (!registration->removed) {
+    arm(registration, false);
+  }
+  callback_finished_.notify_all();
+}
+
+int Reactor::runTimers() {
+  std::vector<std::function<void()>> due;
+  int timeout = MAX_WAIT_MS;
+  {
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    uint64_t now = getTimeMillis();
+    auto it = timers_.begin();
+    while (it != timers_.end() && it->first <= now) {
+      due.push_back(std::move(it->second.task));
+      it = timers_.erase(it);
+    }
+    if (it != timers_.end()) {
+      timeout = static_cast<int>(std::min<uint64_t>(it->first - now, MAX_WAIT_MS));
+    }
+  }
+  for (auto &task : due) {
+    try {
+      task();
+    } catch (const std::exception &exception) {
+      logger_->log_error("Timer task failed: %s", exception.what());
+    } catch (...) {
+      logger_->log_error("Timer task failed");
+    }
+  }
+  return due.empty() ? timeout : 0;
+}
+
+void Reactor::wake() {
+  if (wake_fds_[1] < 0)
+    return;
+  char byte = 0;
+  if (write(wake_fds_[1], &byte, 1) < 0 && errno != EAGAIN) {
+    logger_->log_debug("Could not wake the reactor: %s", strerror(errno));
+  }
+}
+
+} /* namespace io */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
@@ -90,12 +90,11 @@ void TLSServerSocket::registerCallback(std::function<bool()> accept_function, st
     while (accept_function()) {
       int fd = select_descriptor(3000);
       if (fd > 0) {
-        int fd_remove = 0;
         std::vector<uint8_t> data;
         if ( handler(&data, &size) > 0 ) {
           ret = writeData(data.data(), size, fd);
           if (ret < 0) {
-            close_ssl(fd_remove);
+            close_ssl(fd);
           } else {
             fds.push_back(fd);
           }
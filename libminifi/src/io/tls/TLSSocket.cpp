@@ -61,16 +61,44 @@ int16_t TLSContext::initialize(bool server_method) {
 
   std::string clientAuthStr;
   bool needClientCert = true;
-  if (!(configure_->get(Configure::nifi_security_need_ClientAuth, clientAuthStr) && org::apache::nifi::minifi::utils::StringUtils::StringToBool(clientAuthStr, needClientCert))) {
-    needClientCert = true;
+  // StringToBool returns the parsed value, so a configured false must not be taken for a failure
+  if (configure_->get(Configure::nifi_security_need_ClientAuth, clientAuthStr)) {
+    org::apache::nifi::minifi::utils::StringUtils::StringToBool(clientAuthStr, needClientCert);
   }
+  if (ssl_service_ != nullptr && !server_method) {
+    // clients of the same service share its context, and resume the sessions negotiated by one another
+    int16_t error = 0;
+    shared_context_ = ssl_service_->getSharedContext([this, needClientCert, &error]() {
+      return createContext(false, needClientCert, error);
+    });
+    if (shared_context_ == nullptr) {
+      logger_->log_error("Could not create SSL context from %s", ssl_service_->getName());
+      error_value = error != 0 ? error : TLS_ERROR_CONTEXT;
+      return error_value;
+    }
+    session_cache_ = ssl_service_->getSessionCache();
+    ctx = shared_context_->getContext();
+    return 0;
+  }
+  ctx = createContext(server_method, needClientCert, error_value);
+  if (ctx == NULL) {
+    return error_value;
+  }
+  if (!server_method) {
+    controllers::SSLSessionCache::enableResumption(ctx);
+    session_cache_ = std::make_shared<controllers::SSLSessionCache>();
+  }
+  return 0;
+}
+
+SSL_CTX *TLSContext::createContext(bool server_method, bool needClientCert, int16_t &error) {
   const SSL_METHOD *method;
   method = server_method ? TLSv1_2_server_method() : TLSv1_2_client_method();
-  ctx = SSL_CTX_new(method);
-  if (ctx == NULL) {
+  SSL_CTX *context = SSL_CTX_new(method);
+  if (context == NULL) {
     logger_->log_error("Could not create SSL context, error: %s.", std::strerror(errno));
-    error_value = TLS_ERROR_CONTEXT;
-    return error_value;
+    error = TLS_ERROR_CONTEXT;
+    return NULL;
   }
   if (needClientCert) {
     std::string certificate;
@@ -86,65 +114,97 @@ int16_t TLSContext::initialize(bool server_method) {
     } else {
       if (!(configure_->get(Configure::nifi_security_client_certificate, certificate) && configure_->get(Configure::nifi_security_client_private_key, privatekey))) {
         logger_->log_error("Certificate and Private Key PEM file not configured, error: %s.", std::strerror(errno));
-        error_value = TLS_ERROR_PEM_MISSING;
-        return error_value;
+        error = TLS_ERROR_PEM_MISSING;
+        SSL_CTX_free(context);
+        return NULL;
       }
     }
     // load certificates and private key in PEM format
-    if (SSL_CTX_use_certificate_file(ctx, certificate.c_str(), SSL_FILETYPE_PEM) <= 0) {
-      logger_->log_error("Could not load certificate %s, for %X and %X error : %s", certificate, this, ctx, std::strerror(errno));
-      error_value = TLS_ERROR_CERT_MISSING;
-      return error_value;
+    if (SSL_CTX_use_certificate_file(context, certificate.c_str(), SSL_FILETYPE_PEM) <= 0) {
+      logger_->log_error("Could not load certificate %s, for %X and %X error : %s", certificate, this, context, std::strerror(errno));
+      error = TLS_ERROR_CERT_MISSING;
+      SSL_CTX_free(context);
+      return NULL;
     }
     if (ssl_service_ != nullptr) {
       // if the private key has passphase
-      SSL_CTX_set_default_passwd_cb(ctx, pemPassWordCb);
-      SSL_CTX_set_default_passwd_cb_userdata(ctx, static_cast<void*>(const_cast<char*>(passphrase.c_str())));
+      SSL_CTX_set_default_passwd_cb(context, pemPassWordCb);
+      SSL_CTX_set_default_passwd_cb_userdata(context, static_cast<void*>(const_cast<char*>(passphrase.c_str())));
     } else {
       if (configure_->get(Configure::nifi_security_client_pass_phrase, passphrase)) {
         std::ifstream file(passphrase.c_str(), std::ifstream::in);
         if (!file.good()) {
-          return error_value;
+          logger_->log_error("Could not read the passphrase file %s", passphrase);
+          error = TLS_ERROR_KEY_ERROR;
+          SSL_CTX_free(context);
+          return NULL;
         }
 
         std::string password;
         password.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
         file.close();
         passphrase = password;
-        SSL_CTX_set_default_passwd_cb(ctx, pemPassWordCb);
-        SSL_CTX_set_default_passwd_cb_userdata(ctx, static_cast<void*>(const_cast<char*>(passphrase.c_str())));
+        SSL_CTX_set_default_passwd_cb(context, pemPassWordCb);
+        SSL_CTX_set_default_passwd_cb_userdata(context, static_cast<void*>(const_cast<char*>(passphrase.c_str())));
       }
     }
 
-    int retp = SSL_CTX_use_PrivateKey_file(ctx, privatekey.c_str(), SSL_FILETYPE_PEM);
+    int retp = SSL_CTX_use_PrivateKey_file(context, privatekey.c_str(), SSL_FILETYPE_PEM);
+    // the passphrase does not outlive this call
+    SSL_CTX_set_default_passwd_cb_userdata(context, NULL);
     if (retp != 1) {
       logger_->log_error("Could not create load private key,%i on %s error : %s", retp, privatekey, std::strerror(errno));
-      error_value = TLS_ERROR_KEY_ERROR;
-      return error_value;
+      error = TLS_ERROR_KEY_ERROR;
+      SSL_CTX_free(context);
+      return NULL;
     }
     // verify private key
-    if (!SSL_CTX_check_private_key(ctx)) {
+    if (!SSL_CTX_check_private_key(context)) {
       logger_->log_error("Private key does not match the public certificate, error : %s", std::strerror(errno));
-      error_value = TLS_ERROR_KEY_ERROR;
-      return error_value;
+      error = TLS_ERROR_KEY_ERROR;
+      SSL_CTX_free(context);
+      return NULL;
     }
     // load CA certificates
     if (ssl_service_ != nullptr || configure_->get(Configure::nifi_security_client_ca_certificate, caCertificate)) {
-      retp = SSL_CTX_load_verify_locations(ctx, caCertificate.c_str(), 0);
+      retp = SSL_CTX_load_verify_locations(context, caCertificate.c_str(), 0);
       if (retp == 0) {
         logger_->log_error("Can not load CA certificate, Exiting, error : %s", std::strerror(errno));
-        error_value = TLS_ERROR_CERT_ERROR;
-        return error_value;
+        error = TLS_ERROR_CERT_ERROR;
+        SSL_CTX_free(context);
+        return NULL;
       }
     }
 
-    logger_->log_debug("Load/Verify Client Certificate OK. for %X and %X", this, ctx);
+    logger_->log_debug("Load/Verify Client Certificate OK. for %X and %X", this, context);
+  }
+  return context;
+}
+
+void TLSContext::resumeSession(SSL *ssl, const std::string &host, uint16_t port) {
+  if (session_cache_ != nullptr) {
+    session_cache_->resume(ssl, host, port);
+  }
+}
+
+void TLSContext::saveSession(SSL *ssl, const std::string &host, uint16_t port) {
+  if (session_cache_ != nullptr) {
+    session_cache_->save(ssl, host, port);
+  }
+}
+
+void TLSContext::removeSession(const std::string &host, uint16_t port) {
+  if (session_cache_ != nullptr) {
+    session_cache_->remove(host, port);
   }
-  return 0;
 }
 
 TLSSocket::~TLSSocket() {
   if (ssl_ != 0) {
+    if (connected_) {
+      // a session is only kept resumable once the connection has been shut down
+      SSL_shutdown(ssl_);
+    }
     SSL_free(ssl_);
     ssl_ = nullptr;
   }
@@ -193,6 +253,7 @@ int16_t TLSSocket::initialize(bool blocking) {
     // we have s2s secure config
     ssl_ = SSL_new(context_->getContext());
     SSL_set_fd(ssl_, socket_file_descriptor_);
+    context_->resumeSession(ssl_, requested_hostname_, port_);
     connected_ = false;
     int rez = SSL_connect(ssl_);
     if (rez < 0) {
@@ -205,6 +266,7 @@ int16_t TLSSocket::initialize(bool blocking) {
         logger_->log_trace("want read");
         return 0;
       } else {
+        context_->removeSession(requested_hostname_, port_);
         return -1;
       }
       logger_->log_error("SSL socket connect failed to %s %d", requested_hostname_, port_);
@@ -214,7 +276,8 @@ int16_t TLSSocket::initialize(bool blocking) {
       return -1;
     } else {
       connected_ = true;
-      logger_->log_debug("SSL socket connect success to %s %d, on fd %d", requested_hostname_, port_, socket_file_descriptor_);
+      context_->saveSession(ssl_, requested_hostname_, port_);
+      logger_->log_debug("SSL socket connect success to %s %d, on fd %d, session %s", requested_hostname_, port_, socket_file_descriptor_, SSL_session_reused(ssl_) ? "resumed" : "negotiated");
       return 0;
     }
   }
@@ -223,7 +286,7 @@ int16_t TLSSocket::initialize(bool blocking) {
 }
 
 void TLSSocket::close_ssl(int fd) {
-  FD_CLR(fd, &total_list_);  // add to master set
+  remove_descriptor(fd);
   if (UNLIKELY(listeners_ > 0)) {
     std::lock_guard<std::mutex> lock(ssl_mutex_);
     auto fd_ssl = ssl_map_[fd];
@@ -240,79 +303,61 @@ int16_t TLSSocket::select_descriptor(const uint16_t msec) {
     return socket_file_descriptor_;
   }
 
-  struct timeval tv;
-
-  read_fds_ = total_list_;
-
-  tv.tv_sec = msec / 1000;
-  tv.tv_usec = (msec % 1000) * 1000;
-
   std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
 
-  if (msec > 0)
-    select(socket_max_ + 1, &read_fds_, NULL, NULL, &tv);
-  else
-    select(socket_max_ + 1, &read_fds_, NULL, NULL, NULL);
-
-  for (int i = 0; i <= socket_max_; i++) {
-    if (FD_ISSET(i, &read_fds_)) {
-      if (i == socket_file_descriptor_) {
-        if (listeners_ > 0) {
-          struct sockaddr_in remoteaddr;  // client address
-          socklen_t addrlen = sizeof remoteaddr;
-          int newfd = accept(socket_file_descriptor_, (struct sockaddr *) &remoteaddr, &addrlen);
-          FD_SET(newfd, &total_list_);  // add to master set
-          if (newfd > socket_max_) {    // keep track of the max
-            socket_max_ = newfd;
-          }
-          auto ssl = SSL_new(context_->getContext());
-          SSL_set_fd(ssl, newfd);
-          auto accept_value = SSL_accept(ssl);
-          if (accept_value != -1) {
-            logger_->log_trace("Accepted on %d", newfd);
-            ssl_map_[newfd] = ssl;
-            return newfd;
-          } else {
-            int ssl_err = SSL_get_error(ssl, accept_value);
-            logger_->log_error("Could not accept %d, error code %d", newfd, ssl_err);
-            close_ssl(newfd);
-            return -1;
-          }
+  int fd = poll_descriptors(msec);
+  if (fd == socket_file_descriptor_) {
+    if (listeners_ > 0) {
+      // we have a new connection
+      struct sockaddr_in remoteaddr;  // client address
+      socklen_t addrlen = sizeof remoteaddr;
+      int newfd = accept(socket_file_descriptor_, (struct sockaddr *) &remoteaddr, &addrlen);
+      if (newfd < 0) {
+        logger_->log_debug("Could not accept a connection, error: %s", strerror(errno));
+        return -1;
+      }
+      add_descriptor(newfd);
+      auto ssl = SSL_new(context_->getContext());
+      SSL_set_fd(ssl, newfd);
+      auto accept_value = SSL_accept(ssl);
+      if (accept_value != -1) {
+        logger_->log_trace("Accepted on %d", newfd);
+        ssl_map_[newfd] = ssl;
+        return newfd;
+      } else {
+        int ssl_err = SSL_get_error(ssl, accept_value);
+        logger_->log_error("Could not accept %d, error code %d", newfd, ssl_err);
+        SSL_free(ssl);
+        remove_descriptor(newfd);
+        close(newfd);
+        return -1;
+      }
+    } else if (!connected_) {
+      int rez = SSL_connect(ssl_);
+
+      if (rez < 0) {
+        ERR_print_errors_fp(stderr);
+        int ssl_error = SSL_get_error(ssl_, rez);
+        if (ssl_error == SSL_ERROR_WANT_WRITE) {
+          logger_->log_trace("want write");
+          return socket_file_descriptor_;
+        } else if (ssl_error == SSL_ERROR_WANT_READ) {
+          logger_->log_trace("want read");
+          return socket_file_descriptor_;
         } else {
-          if (!connected_) {
-            int rez = SSL_connect(ssl_);
-
-            if (rez < 0) {
-              ERR_print_errors_fp(stderr);
-              int ssl_error = SSL_get_error(ssl_, rez);
-              if (ssl_error == SSL_ERROR_WANT_WRITE) {
-                logger_->log_trace("want write");
-                return socket_file_descriptor_;
-              } else if (ssl_error == SSL_ERROR_WANT_READ) {
-                logger_->log_trace("want read");
-                return socket_file_descriptor_;
-              } else {
-                return -1;
-              }
-              logger_->log_error("SSL socket connect failed to %s %d", requested_hostname_, port_);
-              SSL_free(ssl_);
-              ssl_ = NULL;
-              close(socket_file_descriptor_);
-              return -1;
-            } else {
-              connected_ = true;
-              logger_->log_debug("SSL socket connect success to %s %d, on fd %d", requested_hostname_, port_, socket_file_descriptor_);
-              return socket_file_descriptor_;
-            }
-          }
+          context_->removeSession(requested_hostname_, port_);
+          return -1;
         }
-        return socket_file_descriptor_;
-        // we have a new connection
       } else {
-        // data to be received on i
-        return i;
+        connected_ = true;
+        context_->saveSession(ssl_, requested_hostname_, port_);
+        logger_->log_debug("SSL socket connect success to %s %d, on fd %d, session %s", requested_hostname_, port_, socket_file_descriptor_, SSL_session_reused(ssl_) ? "resumed" : "negotiated");
       }
     }
+    return socket_file_descriptor_;
+  } else if (fd >= 0) {
+    // data to be received on fd
+    return fd;
   }
 
   bool is_server = listeners_ > 0;
@@ -340,26 +385,29 @@ int TLSSocket::readData(std::vector<uint8_t> &buf, int buflen, bool retrieve_all
 
 int TLSSocket::readData(uint8_t *buf, int buflen, bool retrieve_all_bytes) {
   int total_read = 0;
-  int status = 0;
-  int loc = 0;
   int16_t fd = select_descriptor(1000);
+  if (fd < 0) {
+    return -1;
+  }
   auto fd_ssl = get_ssl(fd);
-  if (!SSL_pending(fd_ssl)) {
-    return 0;
+  if (IsNullOrEmpty(fd_ssl)) {
+    return -1;
   }
   while (buflen) {
-    if (fd <= 0) {
-      return -1;
+    int status = SSL_read(fd_ssl, buf + total_read, buflen);
+    if (status <= 0) {
+      int ssl_error = SSL_get_error(fd_ssl, status);
+      // as with Socket, -2 tells a non blocking reader that no more data is available yet
+      if (ssl_error == SSL_ERROR_WANT_READ || ssl_error == SSL_ERROR_WANT_WRITE) {
+        return total_read > 0 ? total_read : -2;
+      }
+      return total_read > 0 ? total_read : -1;
     }
-    int sslStatus;
-    do {
-      status = SSL_read(fd_ssl, buf + loc, buflen);
-      sslStatus = SSL_get_error(fd_ssl, status);
-    } while (status < 0 && sslStatus == SSL_ERROR_WANT_READ && SSL_pending(fd_ssl));
-
     buflen -= status;
-    loc += status;
     total_read += status;
+    if (!retrieve_all_bytes) {
+      break;
+    }
   }
 
   return total_read;
@@ -437,6 +485,30 @@ int TLSSocket::writeData(uint8_t *value, int size) {
   return size;
 }
 
+int TLSSocket::writeV(const struct iovec *iov, int iovcnt) {
+  std::vector<uint8_t> record;
+  int total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    uint8_t *value = reinterpret_cast<uint8_t*>(iov[i].iov_base);
+    int size = static_cast<int>(iov[i].iov_len);
+    if (!record.empty() && record.size() + size > SSL3_RT_MAX_PLAIN_LENGTH) {
+      if (writeData(record.data(), record.size()) != static_cast<int>(record.size()))
+        return -1;
+      record.clear();
+    }
+    if (size >= SSL3_RT_MAX_PLAIN_LENGTH) {
+      if (writeData(value, size) != size)
+        return -1;
+    } else {
+      record.insert(record.end(), value, value + size);
+    }
+    total += size;
+  }
+  if (!record.empty() && writeData(record.data(), record.size()) != static_cast<int>(record.size()))
+    return -1;
+  return total;
+}
+
 int TLSSocket::readData(uint8_t *buf, int buflen) {
   int total_read = 0;
   int status = 0;
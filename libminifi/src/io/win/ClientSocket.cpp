@@ -96,6 +96,7 @@ void Socket::closeStream() {
   }
   if (socket_file_descriptor_ >= 0 && socket_file_descriptor_ != INVALID_SOCKET) {
     logging::LOG_DEBUG(logger_) << "Closing " << socket_file_descriptor_;
+    remove_descriptor(socket_file_descriptor_);
 #ifdef WIN32
     closesocket(socket_file_descriptor_);
 #else
@@ -225,8 +226,7 @@ int8_t Socket::createConnection(const addrinfo *p, in_addr_t &addr) {
     }
   }
   // add the listener to the total set
-  FD_SET(socket_file_descriptor_, &total_list_);
-  socket_max_ = socket_file_descriptor_;
+  add_descriptor(socket_file_descriptor_);
   logger_->log_debug("Created connection with file descriptor %d", socket_file_descriptor_);
   return 0;
 }
@@ -311,15 +311,53 @@ int16_t Socket::select_descriptor(const uint16_t msec) {
     return socket_file_descriptor_;
   }
 
+  std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
+
+  int fd = poll_descriptors(msec);
+  if (fd == socket_file_descriptor_) {
+    // we have a new connection
+    struct sockaddr_storage remoteaddr;  // client address
+    socklen_t addrlen = sizeof remoteaddr;
+    int newfd = accept(socket_file_descriptor_, (struct sockaddr *) &remoteaddr, &addrlen);
+    if (newfd < 0) {
+      logger_->log_debug("Could not accept a connection");
+      return -1;
+    }
+    add_descriptor(newfd);
+    return newfd;
+  } else if (fd >= 0) {
+    // data to be received on fd
+    return fd;
+  }
+
+  logger_->log_debug("Could not find a suitable file descriptor or select timed out");
+
+  return -1;
+}
+
+void Socket::add_descriptor(int fd) {
+  std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
+  FD_SET(fd, &total_list_);  // add to master set
+  if (fd > socket_max_) {    // keep track of the max
+    socket_max_ = fd;
+  }
+}
+
+void Socket::remove_descriptor(int fd) {
+  std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
+  FD_CLR(fd, &total_list_);
+}
+
+int Socket::poll_descriptors(const uint16_t msec) {
   struct timeval tv;
 
+  std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
+
   read_fds_ = total_list_;
 
   tv.tv_sec = msec / 1000;
   tv.tv_usec = (msec % 1000) * 1000;
 
-  std::lock_guard<std::recursive_mutex> guard(selection_mutex_);
-
   if (msec > 0)
     select(socket_max_ + 1, &read_fds_, NULL, NULL, &tv);
   else
@@ -327,30 +365,9 @@ int16_t Socket::select_descriptor(const uint16_t msec) {
 
   for (int i = 0; i <= socket_max_; i++) {
     if (FD_ISSET(i, &read_fds_)) {
-      if (i == socket_file_descriptor_) {
-        if (listeners_ > 0) {
-          struct sockaddr_storage remoteaddr;  // client address
-          socklen_t addrlen = sizeof remoteaddr;
-          int newfd = accept(socket_file_descriptor_, (struct sockaddr *) &remoteaddr, &addrlen);
-          FD_SET(newfd, &total_list_);  // add to master set
-          if (newfd > socket_max_) {    // keep track of the max
-            socket_max_ = newfd;
-          }
-          return newfd;
-
-        } else {
-          return socket_file_descriptor_;
-        }
-        // we have a new connection
-      } else {
-        // data to be received on i
-        return i;
-      }
+      return i;
     }
   }
-
-  logger_->log_debug("Could not find a suitable file descriptor or select timed out");
-
   return -1;
 }
 
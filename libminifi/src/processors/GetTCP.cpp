@@ -157,6 +157,7 @@ void GetTCP::onSchedule(const std::shared_ptr<core::ProcessContext> &context, co
 
   handler_ = std::unique_ptr<DataHandler>(new DataHandler(sessionFactory));
 
+#ifdef WIN32
   f_ex = [&] {
     std::unique_ptr<io::Socket> socket_ptr;
     // reuse the byte buffer.
@@ -167,27 +168,7 @@ void GetTCP::onSchedule(const std::shared_ptr<core::ProcessContext> &context, co
           int size_read = socket_ptr->readData(buffer, receive_buffer_size_, false);
           if (size_read >= 0) {
             if (size_read > 0) {
-              // determine cut location
-              int startLoc = 0, i = 0;
-              for (; i < size_read; i++) {
-                if (buffer.at(i) == endOfMessageByte && i > 0) {
-                  if (i-startLoc > 0) {
-                    handler_->handle(socket_ptr->getHostname(), buffer.data()+startLoc, (i-startLoc), true);
-                  }
-                  startLoc = i;
-                }
-              }
-              if (startLoc > 0) {
-                logger_->log_trace("Starting at %i, ending at %i", startLoc, size_read);
-                if (size_read-startLoc > 0) {
-                  handler_->handle(socket_ptr->getHostname(), buffer.data()+startLoc, (size_read-startLoc), true);
-                }
-              } else {
-                logger_->log_trace("Handling at %i, ending at %i", startLoc, size_read);
-                if (size_read > 0) {
-                  handler_->handle(socket_ptr->getHostname(), buffer.data(), size_read, false);
-                }
-              }
+              handleMessages(socket_ptr->getHostname(), buffer, size_read);
               reconnects = 0;
             }
             socket_ring_buffer_.enqueue(std::move(socket_ptr));
@@ -215,6 +196,9 @@ void GetTCP::onSchedule(const std::shared_ptr<core::ProcessContext> &context, co
       logger_->log_debug("Ending private thread");
       return 0;
     };
+#else
+  reactor_ = io::Reactor::getReactor();
+#endif
 
   if (context->getProperty(SSLContextService.getName(), value)) {
     std::shared_ptr<core::controller::ControllerService> service = context->getControllerService(value);
@@ -231,7 +215,20 @@ void GetTCP::onSchedule(const std::shared_ptr<core::ProcessContext> &context, co
 }
 
 void GetTCP::notifyStop() {
+#ifndef WIN32
+  std::map<std::string, std::shared_ptr<io::Socket>> connections;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    connections.swap(connections_);
+  }
+  // once removed, the connections are no longer handed to the handler threads
+  for (const auto &connection : connections) {
+    reactor_->remove(connection.second->getDescriptor());
+  }
+#else
   running_ = false;
+#endif
   // await threads to shutdown.
   client_thread_pool_.shutdown();
   std::unique_ptr<io::Socket> socket_ptr;
@@ -239,10 +236,128 @@ void GetTCP::notifyStop() {
     socket_ring_buffer_.try_dequeue(socket_ptr);
   }
 }
+std::unique_ptr<io::Socket> GetTCP::createSocket(const std::string &endpoint) {
+  std::vector<std::string> hostAndPort = utils::StringUtils::split(endpoint, ":");
+  if (hostAndPort.size() != 2) {
+    logger_->log_error("Could not create socket for %s", endpoint);
+    return nullptr;
+  }
+  logger_->log_debug("Opening another socket to %s:%s is secure %d", hostAndPort.at(0), hostAndPort.at(1), (ssl_service_ != nullptr));
+  std::unique_ptr<io::Socket> socket =
+      ssl_service_ != nullptr ?
+          stream_factory_->createSecureSocket(hostAndPort.at(0), std::stoi(hostAndPort.at(1)), ssl_service_) : stream_factory_->createSocket(hostAndPort.at(0), std::stoi(hostAndPort.at(1)));
+  socket->setNonBlocking();
+  if (socket->initialize() == -1) {
+    logger_->log_error("Could not create socket during initialization for %s", endpoint);
+    return nullptr;
+  }
+  return socket;
+}
+
+void GetTCP::handleMessages(const std::string &source, std::vector<uint8_t> &buffer, int size_read) {
+  // determine cut location
+  int startLoc = 0, i = 0;
+  for (; i < size_read; i++) {
+    if (buffer.at(i) == endOfMessageByte && i > 0) {
+      if (i - startLoc > 0) {
+        handler_->handle(source, buffer.data() + startLoc, (i - startLoc), true);
+      }
+      startLoc = i;
+    }
+  }
+  if (startLoc > 0) {
+    logger_->log_trace("Starting at %i, ending at %i", startLoc, size_read);
+    if (size_read - startLoc > 0) {
+      handler_->handle(source, buffer.data() + startLoc, (size_read - startLoc), true);
+    }
+  } else {
+    logger_->log_trace("Handling at %i, ending at %i", startLoc, size_read);
+    if (size_read > 0) {
+      handler_->handle(source, buffer.data(), size_read, false);
+    }
+  }
+}
+
+#ifndef WIN32
+bool GetTCP::watch(const std::string &endpoint, const std::shared_ptr<io::Socket> &socket) {
+  return reactor_->add(socket->getDescriptor(), REACTOR_READABLE, [this, endpoint, socket](int fd, uint32_t events) {
+    // the connection is read on a handler thread, and watched again once it has been drained
+    reactor_->remove(fd);
+    std::function<int()> task = [this, endpoint, socket]() {
+      readConnection(endpoint, socket);
+      return 0;
+    };
+    utils::Worker<int> worker(task, "workers");
+    std::future<int> future;
+    client_thread_pool_.execute(std::move(worker), future);
+  });
+}
+
+void GetTCP::readConnection(const std::string &endpoint, const std::shared_ptr<io::Socket> &socket) {
+  std::vector<uint8_t> buffer;
+  read_buffers_.try_dequeue(buffer);
+  int size_read = 0;
+  // data that TLS has already decrypted is not reported by the reactor, so all of it is read
+  while (running_) {
+    size_read = socket->readData(buffer, receive_buffer_size_, false);
+    if (size_read <= 0) {
+      break;
+    }
+    try {
+      handleMessages(socket->getHostname(), buffer, size_read);
+    } catch (const std::exception &exception) {
+      // nothing else catches on the handler threads
+      logger_->log_error("Could not handle the messages from %s: %s", endpoint, exception.what());
+      size_read = -1;
+      break;
+    }
+  }
+  read_buffers_.enqueue(std::move(buffer));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto connection = connections_.find(endpoint);
+  // a stopping processor closes its connections itself
+  if (!running_ || connection == connections_.end() || connection->second != socket) {
+    return;
+  }
+  if (size_read == -2 && stay_connected_ && watch(endpoint, socket)) {
+    return;
+  }
+  logger_->log_info("Closing the connection to %s, which is opened again in %llu msec", endpoint, reconnect_interval_);
+  connections_.erase(connection);
+  reconnect_times_[endpoint] = getTimeMillis() + reconnect_interval_;
+  socket->closeStream();
+}
+#endif
+
 void GetTCP::onTrigger(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session) {
   // Perform directory list
   metrics_->iterations_++;
   std::lock_guard<std::mutex> lock(mutex_);
+#ifndef WIN32
+  uint64_t now = getTimeMillis();
+  for (auto &endpoint : endpoints) {
+    if (connections_.find(endpoint) != connections_.end()) {
+      logger_->log_debug("Connection still open for %s", endpoint);
+      continue;
+    }
+    auto reconnect_time = reconnect_times_.find(endpoint);
+    if (reconnect_time != reconnect_times_.end() && now < reconnect_time->second) {
+      continue;
+    }
+    logger_->log_info("creating endpoint for %s", endpoint);
+    std::shared_ptr<io::Socket> socket = createSocket(endpoint);
+    if (socket != nullptr) {
+      connections_[endpoint] = socket;
+      if (watch(endpoint, socket)) {
+        continue;
+      }
+      logger_->log_error("Could not watch the connection to %s", endpoint);
+      connections_.erase(endpoint);
+    }
+    reconnect_times_[endpoint] = now + reconnect_interval_;
+  }
+#else
   // check if the futures are valid. If they've terminated remove it from the map.
 
   for (auto &endpoint : endpoints) {
@@ -250,23 +365,12 @@ void GetTCP::onTrigger(const std::shared_ptr<core::ProcessContext> &context, con
     // does not exist
     if (endPointFuture == live_clients_.end()) {
       logger_->log_info("creating endpoint for %s", endpoint);
-      std::vector<std::string> hostAndPort = utils::StringUtils::split(endpoint, ":");
-      if (hostAndPort.size() == 2) {
-        logger_->log_debug("Opening another socket to %s:%s is secure %d", hostAndPort.at(0), hostAndPort.at(1), (ssl_service_ != nullptr));
-        std::unique_ptr<io::Socket> socket =
-            ssl_service_ != nullptr ?
-                stream_factory_->createSecureSocket(hostAndPort.at(0), std::stoi(hostAndPort.at(1)), ssl_service_) : stream_factory_->createSocket(hostAndPort.at(0), std::stoi(hostAndPort.at(1)));
-        socket->setNonBlocking();
-        if (socket->initialize() != -1) {
-          logger_->log_debug("Enqueueing socket into ring buffer %s:%s", hostAndPort.at(0), hostAndPort.at(1));
-          socket_ring_buffer_.enqueue(std::move(socket));
-        } else {
-          logger_->log_error("Could not create socket during initialization for %s", endpoint);
-          continue;
-        }
-      } else {
-        logger_->log_error("Could not create socket for %s", endpoint);
+      std::unique_ptr<io::Socket> socket = createSocket(endpoint);
+      if (socket == nullptr) {
+        continue;
       }
+      logger_->log_debug("Enqueueing socket into ring buffer %s", endpoint);
+      socket_ring_buffer_.enqueue(std::move(socket));
       std::future<int> *future = new std::future<int>();
       std::unique_ptr<utils::AfterExecute<int>> after_execute = std::unique_ptr<utils::AfterExecute<int>>(new SocketAfterExecute(running_, endpoint, &live_clients_, &mutex_));
       utils::Worker<int> functor(f_ex, "workers", std::move(after_execute));
@@ -288,6 +392,7 @@ void GetTCP::onTrigger(const std::shared_ptr<core::ProcessContext> &context, con
       }
     }
   }
+#endif
   logger_->log_debug("Updating endpoint");
   context->yield();
 }
@@ -19,6 +19,10 @@
  */
 #include "processors/ListenSyslog.h"
 #include <stdio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -88,164 +92,161 @@ void ListenSyslog::initialize() {
   setSupportedRelationships(relationships);
 }
 
-void ListenSyslog::startSocketThread() {
-  if (_thread != NULL)
+// size of the buffer messages are received into
+#define SYSLOG_READ_BUFFER_SIZE (2048)
+
+void ListenSyslog::startServerSocket() {
+  std::lock_guard<std::mutex> lock(socket_mutex_);
+  if (_serverSocket > 0)
     return;
 
-  logger_->log_trace("ListenSysLog Socket Thread Start");
-  _serverTheadRunning = true;
-  _thread = new std::thread(run, this);
-  _thread->detach();
+  uint16_t portno = _port;
+  struct sockaddr_in serv_addr;
+  int sockfd;
+  if (_protocol == "TCP")
+    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+  else
+    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sockfd < 0) {
+    logger_->log_error("ListenSysLog Server socket creation failed");
+    return;
+  }
+  bzero(reinterpret_cast<char *>(&serv_addr), sizeof(serv_addr));
+  serv_addr.sin_family = AF_INET;
+  serv_addr.sin_addr.s_addr = INADDR_ANY;
+  serv_addr.sin_port = htons(portno);
+  if (bind(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) {
+    logger_->log_error("ListenSysLog Server socket bind failed");
+    close(sockfd);
+    return;
+  }
+  if (_protocol == "TCP")
+    listen(sockfd, 5);
+  io::Reactor::setNonBlocking(sockfd);
+
+  reactor_ = io::Reactor::getReactor();
+  bool tcp = _protocol == "TCP";
+  if (!reactor_->add(sockfd, REACTOR_READABLE, [this, tcp](int fd, uint32_t events) {
+    if (tcp)
+      acceptClients(fd);
+    else
+      readDatagrams(fd);
+  })) {
+    logger_->log_error("ListenSysLog Server socket %d could not be registered", sockfd);
+    close(sockfd);
+    return;
+  }
+  _serverSocket = sockfd;
+  logger_->log_info("ListenSysLog Server socket %d bind OK to port %d", _serverSocket, portno);
 }
 
-void ListenSyslog::run(ListenSyslog *process) {
-  process->runThread();
+void ListenSyslog::stopServerSocket() {
+  int serverSocket;
+  std::map<int, std::string> clientSockets;
+  {
+    std::lock_guard<std::mutex> lock(socket_mutex_);
+    serverSocket = _serverSocket;
+    _serverSocket = 0;
+    clientSockets.swap(_clientSockets);
+  }
+  if (reactor_ == nullptr)
+    return;
+  // removing waits for the callbacks of the sockets to return
+  if (serverSocket > 0) {
+    reactor_->remove(serverSocket);
+    logger_->log_debug("ListenSysLog Server socket %d close", serverSocket);
+    close(serverSocket);
+  }
+  for (const auto &client : clientSockets) {
+    reactor_->remove(client.first);
+    close(client.first);
+  }
 }
 
-void ListenSyslog::runThread() {
-  while (_serverTheadRunning) {
-    if (_resetServerSocket) {
-      _resetServerSocket = false;
-      // need to reset the socket
-      std::vector<int>::iterator it;
-      for (it = _clientSockets.begin(); it != _clientSockets.end(); ++it) {
-        int clientSocket = *it;
-        close(clientSocket);
-      }
-      _clientSockets.clear();
-      if (_serverSocket > 0) {
-        close(_serverSocket);
-        _serverSocket = 0;
-      }
+void ListenSyslog::acceptClients(int fd) {
+  while (true) {
+    socklen_t clilen;
+    struct sockaddr_in cli_addr;
+    clilen = sizeof(cli_addr);
+    int newsockfd = accept(fd, reinterpret_cast<struct sockaddr *>(&cli_addr), &clilen);
+    if (newsockfd < 0)
+      return;
+    std::lock_guard<std::mutex> lock(socket_mutex_);
+    if (_clientSockets.size() >= (uint64_t) _maxConnections) {
+      close(newsockfd);
+      continue;
     }
+    io::Reactor::setNonBlocking(newsockfd);
+    _clientSockets[newsockfd] = "";
+    reactor_->add(newsockfd, REACTOR_READABLE, [this](int fd, uint32_t events) {
+      readClient(fd);
+    });
+    logger_->log_info("ListenSysLog new client socket %d connection", newsockfd);
+  }
+}
 
-    if (_serverSocket <= 0) {
-      uint16_t portno = _port;
-      struct sockaddr_in serv_addr;
-      int sockfd;
-      if (_protocol == "TCP")
-        sockfd = socket(AF_INET, SOCK_STREAM, 0);
-      else
-        sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-      if (sockfd < 0) {
-        logger_->log_error("ListenSysLog Server socket creation failed");
-        break;
-      }
-      bzero(reinterpret_cast<char *>(&serv_addr), sizeof(serv_addr));
-      serv_addr.sin_family = AF_INET;
-      serv_addr.sin_addr.s_addr = INADDR_ANY;
-      serv_addr.sin_port = htons(portno);
-      if (bind(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) {
-        logger_->log_error("ListenSysLog Server socket bind failed");
-        break;
-      }
-      if (_protocol == "TCP")
-        listen(sockfd, 5);
-      _serverSocket = sockfd;
-      logger_->log_info("ListenSysLog Server socket %d bind OK to port %d", _serverSocket, portno);
-    }
-    FD_ZERO(&_readfds);
-    FD_SET(_serverSocket, &_readfds);
-    _maxFds = _serverSocket;
-    std::vector<int>::iterator it;
-    for (it = _clientSockets.begin(); it != _clientSockets.end(); ++it) {
-      int clientSocket = *it;
-      if (clientSocket >= _maxFds)
-        _maxFds = clientSocket;
-      FD_SET(clientSocket, &_readfds);
-    }
-    fd_set fds;
-    struct timeval tv;
-    int retval;
-    fds = _readfds;
-    tv.tv_sec = 0;
-    // 100 msec
-    tv.tv_usec = 100000;
-    retval = select(_maxFds + 1, &fds, NULL, NULL, &tv);
-    if (retval < 0)
-      break;
-    if (retval == 0)
+void ListenSyslog::readClient(int fd) {
+  char buffer[SYSLOG_READ_BUFFER_SIZE];
+  while (true) {
+    int recvlen = recv(fd, buffer, sizeof(buffer), 0);
+    if (recvlen < 0 && errno == EINTR)
       continue;
-    if (FD_ISSET(_serverSocket, &fds)) {
-      // server socket, either we have UDP datagram or TCP connection request
-      if (_protocol == "TCP") {
-        socklen_t clilen;
-        struct sockaddr_in cli_addr;
-        clilen = sizeof(cli_addr);
-        int newsockfd = accept(_serverSocket, reinterpret_cast<struct sockaddr *>(&cli_addr), &clilen);
-        if (newsockfd > 0) {
-          if (_clientSockets.size() < (uint64_t) _maxConnections) {
-            _clientSockets.push_back(newsockfd);
-            logger_->log_info("ListenSysLog new client socket %d connection", newsockfd);
-            continue;
-          } else {
-            close(newsockfd);
-          }
-        }
-      } else {
-        socklen_t clilen;
-        struct sockaddr_in cli_addr;
-        clilen = sizeof(cli_addr);
-        int recvlen = recvfrom(_serverSocket, _buffer, sizeof(_buffer), 0, (struct sockaddr *) &cli_addr, &clilen);
-        if (recvlen > 0 && (uint64_t) (recvlen + getEventQueueByteSize()) <= _recvBufSize) {
-          uint8_t *payload = new uint8_t[recvlen];
-          memcpy(payload, _buffer, recvlen);
-          putEvent(payload, recvlen);
-        }
+    if (recvlen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+    if (recvlen <= 0) {
+      {
+        std::lock_guard<std::mutex> lock(socket_mutex_);
+        if (_clientSockets.erase(fd) == 0)
+          return;
       }
+      reactor_->remove(fd);
+      close(fd);
+      logger_->log_debug("ListenSysLog client socket %d close", fd);
+      return;
     }
-    it = _clientSockets.begin();
-    while (it != _clientSockets.end()) {
-      int clientSocket = *it;
-      if (FD_ISSET(clientSocket, &fds)) {
-        int recvlen = readline(clientSocket, _buffer, sizeof(_buffer));
-        if (recvlen <= 0) {
-          close(clientSocket);
-          logger_->log_debug("ListenSysLog client socket %d close", clientSocket);
-          it = _clientSockets.erase(it);
-        } else {
-          if ((uint64_t) (recvlen + getEventQueueByteSize()) <= _recvBufSize) {
-            uint8_t *payload = new uint8_t[recvlen];
-            memcpy(payload, _buffer, recvlen);
-            putEvent(payload, recvlen);
-          }
-          ++it;
+    std::vector<std::string> lines;
+    {
+      std::lock_guard<std::mutex> lock(socket_mutex_);
+      auto client = _clientSockets.find(fd);
+      if (client == _clientSockets.end())
+        return;
+      std::string &line = client->second;
+      for (int i = 0; i < recvlen; i++) {
+        line.push_back(buffer[i]);
+        // lines longer than the buffer are split, as before
+        if (buffer[i] == '\n' || line.size() >= SYSLOG_READ_BUFFER_SIZE) {
+          lines.push_back(std::move(line));
+          line.clear();
         }
       }
     }
+    for (const auto &line : lines) {
+      putMessage(line.data(), line.size());
+    }
   }
-  return;
 }
 
-int ListenSyslog::readline(int fd, char *bufptr, size_t len) {
-  char *bufx = bufptr;
-  static char *bp;
-  static int cnt = 0;
-  static char b[2048];
-  char c;
-
-  while (--len > 0) {
-    if (--cnt <= 0) {
-      cnt = recv(fd, b, sizeof(b), 0);
-      if (cnt < 0) {
-        if (errno == EINTR) {
-          len++; /* the while will decrement */
-          continue;
-        }
-        return -1;
-      }
-      if (cnt == 0)
-        return 0;
-      bp = b;
-    }
-    c = *bp++;
-    *bufptr++ = c;
-    if (c == '\n') {
-      *bufptr = '\n';
-      return bufptr - bufx + 1;
-    }
+void ListenSyslog::readDatagrams(int fd) {
+  char buffer[SYSLOG_READ_BUFFER_SIZE];
+  while (true) {
+    socklen_t clilen;
+    struct sockaddr_in cli_addr;
+    clilen = sizeof(cli_addr);
+    int recvlen = recvfrom(fd, buffer, sizeof(buffer), 0, (struct sockaddr *) &cli_addr, &clilen);
+    if (recvlen < 0 && errno == EINTR)
+      continue;
+    if (recvlen <= 0)
+      return;
+    putMessage(buffer, recvlen);
   }
-  return -1;
+}
+
+void ListenSyslog::putMessage(const char *message, size_t len) {
+  if ((uint64_t) (len + getEventQueueByteSize()) > _recvBufSize)
+    return;
+  uint8_t *payload = new uint8_t[len];
+  memcpy(payload, message, len);
+  putEvent(payload, len);
 }
 
 void ListenSyslog::onTrigger(core::ProcessContext *context, core::ProcessSession *session) {
@@ -282,9 +283,9 @@ void ListenSyslog::onTrigger(core::ProcessContext *context, core::ProcessSession
   }
 
   if (needResetServerSocket)
-    _resetServerSocket = true;
+    stopServerSocket();
 
-  startSocketThread();
+  startServerSocket();
 
   // read from the event queue
   if (isEventQueueEmpty()) {
@@ -17,9 +17,11 @@
  */
 
 #include "provenance/Provenance.h"
+#include "provenance/ProvenancePolicy.h"
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include "core/Repository.h"
 #include "io/DataStream.h"
@@ -87,6 +89,17 @@ bool ProvenanceEventRecord::DeSerialize(const std::shared_ptr<core::Serializable
 bool ProvenanceEventRecord::Serialize(const std::shared_ptr<core::SerializableComponent> &repo) {
   org::apache::nifi::minifi::io::DataStream outStream;
 
+  if (!Serialize(outStream)) {
+    return false;
+  }
+  // Persist to the DB
+  if (!repo->Serialize(uuidStr_, const_cast<uint8_t*>(outStream.getBuffer()), outStream.getSize())) {
+    logger_->log_error("NiFi Provenance Store event %s size %llu fail", uuidStr_, outStream.getSize());
+  }
+  return true;
+}
+
+bool ProvenanceEventRecord::Serialize(org::apache::nifi::minifi::io::DataStream &outStream) {
   int ret;
 
   ret = writeUTF(this->uuidStr_, &outStream);
@@ -217,10 +230,6 @@ bool ProvenanceEventRecord::Serialize(const std::shared_ptr<core::SerializableCo
       return false;
     }
   }
-  // Persist to the DB
-  if (!repo->Serialize(uuidStr_, const_cast<uint8_t*>(outStream.getBuffer()), outStream.getSize())) {
-    logger_->log_error("NiFi Provenance Store event %s size %llu fail", uuidStr_, outStream.getSize());
-  }
   return true;
 }
 
@@ -372,14 +381,53 @@ bool ProvenanceEventRecord::DeSerialize(const uint8_t *buffer, const size_t buff
   return true;
 }
 
+ProvenanceReporter::ProvenanceReporter(std::shared_ptr<core::Repository> repo, std::string componentId, std::string componentType)
+    : logger_(logging::LoggerFactory<ProvenanceReporter>::getLogger()) {
+  _componentId = componentId;
+  _componentType = componentType;
+  repo_ = repo;
+  if (nullptr != repo_) {
+    auto policy = repo_->getProvenancePolicy();
+    if (nullptr != policy) {
+      policy_ = policy->getComponentPolicy(componentId);
+    }
+  }
+}
+
+ProvenanceEventRecord *ProvenanceReporter::allocate(ProvenanceEventRecord::ProvenanceEventType eventType, std::shared_ptr<core::FlowFile> flow) {
+  if (nullptr != policy_ && !policy_->accept(eventType)) {
+    return nullptr;
+  }
+  ProvenanceEventRecord *event = new ProvenanceEventRecord(eventType, _componentId, _componentType);
+  event->fromFlowFile(flow);
+  return event;
+}
+
 void ProvenanceReporter::commit() {
+  if (nullptr != policy_) {
+    for (auto summary : policy_->takeSummaries(_componentId, _componentType)) {
+      add(summary);
+    }
+  }
+  if (_events.empty()) {
+    return;
+  }
+  if (repo_->isFull()) {
+    logger_->log_debug("Provenance Repository is full");
+    return;
+  }
+  // hand the session's events to the repository together, so that it may persist them in one write
+  std::vector<std::pair<std::string, std::unique_ptr<io::DataStream>>> serialized;
+  serialized.reserve(_events.size());
   for (auto event : _events) {
-    if (!repo_->isFull()) {
-      event->Serialize(repo_);
-    } else {
-      logger_->log_debug("Provenance Repository is full");
+    std::unique_ptr<io::DataStream> stream(new io::DataStream());
+    if (event->Serialize(*stream)) {
+      serialized.emplace_back(event->getEventId(), std::move(stream));
     }
   }
+  if (!repo_->MultiPut(serialized)) {
+    logger_->log_error("Could not store %llu provenance events", serialized.size());
+  }
 }
 
 void ProvenanceReporter::create(std::shared_ptr<core::FlowFile> flow, std::string detail) {
@@ -0,0 +1,207 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "provenance/ProvenancePolicy.h"
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "core/Property.h"
+#include "core/logging/LoggerConfiguration.h"
+#include "utils/StringUtils.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace provenance {
+
+std::shared_ptr<logging::Logger> ProvenancePolicy::logger_ = logging::LoggerFactory<ProvenancePolicy>::getLogger();
+
+namespace {
+
+uint64_t steadyMillis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::vector<std::string> splitList(const std::string &value) {
+  std::vector<std::string> items;
+  for (const auto &item : utils::StringUtils::split(value, ",")) {
+    std::string trimmed = utils::StringUtils::trim(item);
+    if (!trimmed.empty()) {
+      items.push_back(trimmed);
+    }
+  }
+  return items;
+}
+
+}  // namespace
+
+ComponentProvenancePolicy::ComponentProvenancePolicy(const std::bitset<PROVENANCE_EVENT_TYPES> &excluded_types, uint64_t sample_rate, uint64_t max_events_per_second,
+                                                     uint64_t summary_interval_ms)
+    : excluded_types_(excluded_types),
+      sample_rate_(std::max<uint64_t>(sample_rate, 1)),
+      max_events_per_second_(max_events_per_second),
+      summary_interval_ms_(summary_interval_ms),
+      window_start_ms_(0),
+      window_events_(0),
+      last_summary_ms_(steadyMillis()) {
+  for (int i = 0; i < PROVENANCE_EVENT_TYPES; i++) {
+    offered_[i] = 0;
+    dropped_[i] = 0;
+  }
+}
+
+bool ComponentProvenancePolicy::accept(ProvenanceEventRecord::ProvenanceEventType type) {
+  if (excluded_types_.test(type)) {
+    return false;
+  }
+  if (sample_rate_ == 1 && max_events_per_second_ == 0) {
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (offered_[type]++ % sample_rate_ != 0) {
+    dropped_[type]++;
+    return false;
+  }
+  if (max_events_per_second_ > 0) {
+    uint64_t now = steadyMillis();
+    if (now - window_start_ms_ >= 1000) {
+      window_start_ms_ = now;
+      window_events_ = 0;
+    }
+    if (window_events_ >= max_events_per_second_) {
+      dropped_[type]++;
+      return false;
+    }
+    window_events_++;
+  }
+  return true;
+}
+
+std::vector<ProvenanceEventRecord*> ComponentProvenancePolicy::takeSummaries(const std::string &componentId, const std::string &componentType) {
+  std::vector<ProvenanceEventRecord*> summaries;
+  if (summary_interval_ms_ == 0) {
+    return summaries;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t now = steadyMillis();
+  uint64_t elapsed = now - last_summary_ms_;
+  if (elapsed < summary_interval_ms_) {
+    return summaries;
+  }
+  last_summary_ms_ = now;
+  for (int i = 0; i < PROVENANCE_EVENT_TYPES; i++) {
+    if (dropped_[i] == 0) {
+      continue;
+    }
+    ProvenanceEventRecord *summary = new ProvenanceEventRecord(static_cast<ProvenanceEventRecord::ProvenanceEventType>(i), componentId, componentType);
+    summary->setDetails("Summary of " + std::to_string(dropped_[i]) + " " + ProvenanceEventRecord::ProvenanceEventTypeStr[i] + " events not recorded in the last "
+        + std::to_string(elapsed) + " ms");
+    summary->setEventDuration(elapsed);
+    summaries.push_back(summary);
+    dropped_[i] = 0;
+  }
+  return summaries;
+}
+
+ProvenancePolicy::ProvenancePolicy(const std::set<std::string> &excluded_components, const std::bitset<PROVENANCE_EVENT_TYPES> &excluded_types, uint64_t sample_rate,
+                                   uint64_t max_events_per_second, uint64_t summary_interval_ms)
+    : excluded_components_(excluded_components),
+      excluded_types_(excluded_types),
+      sample_rate_(sample_rate),
+      max_events_per_second_(max_events_per_second),
+      summary_interval_ms_(summary_interval_ms) {
+}
+
+std::shared_ptr<ProvenancePolicy> ProvenancePolicy::create(const std::shared_ptr<Configure> &configure) {
+  std::string value;
+  std::set<std::string> excluded_components;
+  if (configure->get(Configure::nifi_provenance_policy_excluded_components, value)) {
+    for (const auto &component : splitList(value)) {
+      excluded_components.insert(component);
+    }
+  }
+  std::bitset<PROVENANCE_EVENT_TYPES> excluded_types;
+  if (configure->get(Configure::nifi_provenance_policy_excluded_event_types, value)) {
+    for (const auto &name : splitList(value)) {
+      bool found = false;
+      for (int i = 0; i < PROVENANCE_EVENT_TYPES; i++) {
+        if (utils::StringUtils::equalsIgnoreCase(name, ProvenanceEventRecord::ProvenanceEventTypeStr[i])) {
+          excluded_types.set(i);
+          found = true;
+        }
+      }
+      if (!found) {
+        logger_->log_warn("Ignoring unknown provenance event type %s", name);
+      }
+    }
+  }
+  int64_t sample_rate = 1;
+  if (configure->get(Configure::nifi_provenance_policy_sample_rate, value)) {
+    if (!core::Property::StringToInt(value, sample_rate) || sample_rate < 1) {
+      logger_->log_warn("Invalid provenance sample rate %s, recording every event", value);
+      sample_rate = 1;
+    }
+  }
+  int64_t max_events_per_second = 0;
+  if (configure->get(Configure::nifi_provenance_policy_max_events_per_second, value)) {
+    if (!core::Property::StringToInt(value, max_events_per_second) || max_events_per_second < 0) {
+      logger_->log_warn("Invalid provenance rate limit %s, not limiting events", value);
+      max_events_per_second = 0;
+    }
+  }
+  int64_t summary_interval = 0;
+  if (configure->get(Configure::nifi_provenance_policy_summary_interval, value)) {
+    core::TimeUnit unit;
+    if (!core::Property::StringToTime(value, summary_interval, unit) || !core::Property::ConvertTimeUnitToMS(summary_interval, unit, summary_interval) || summary_interval < 0) {
+      logger_->log_warn("Invalid provenance summary interval %s, not summarizing dropped events", value);
+      summary_interval = 0;
+    }
+  }
+
+  if (excluded_components.empty() && excluded_types.none() && sample_rate == 1 && max_events_per_second == 0) {
+    return nullptr;
+  }
+  logger_->log_debug("Provenance policy excludes %llu components and %llu event types, samples 1 in %lld, limits to %lld events/s", static_cast<uint64_t>(excluded_components.size()),
+                     static_cast<uint64_t>(excluded_types.count()), sample_rate, max_events_per_second);
+  return std::make_shared<ProvenancePolicy>(excluded_components, excluded_types, sample_rate, max_events_per_second, summary_interval);
+}
+
+std::shared_ptr<ComponentProvenancePolicy> ProvenancePolicy::getComponentPolicy(const std::string &componentId) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = components_.find(componentId);
+  if (it != components_.end()) {
+    return it->second;
+  }
+  std::shared_ptr<ComponentProvenancePolicy> policy;
+  if (excluded_components_.find(componentId) != excluded_components_.end()) {
+    policy = std::make_shared<ComponentProvenancePolicy>(std::bitset<PROVENANCE_EVENT_TYPES>().set(), 1, 0, 0);
+  } else {
+    policy = std::make_shared<ComponentProvenancePolicy>(excluded_types_, sample_rate_, max_events_per_second_, summary_interval_ms_);
+  }
+  components_[componentId] = policy;
+  return policy;
+}
+
+} /* namespace provenance */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
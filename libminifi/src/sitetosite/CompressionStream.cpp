@@ -0,0 +1,174 @@
+/**
+ * @file CompressionStream.cpp
+ * CompressionOutputStream and CompressionInputStream class implementation
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sitetosite/CompressionStream.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace sitetosite {
+
+namespace {
+
+const uint8_t SYNC_BYTES[] = { 'S', 'Y', 'N', 'C' };
+
+// "SYNC" followed by the uncompressed and the compressed length
+const size_t CHUNK_HEADER_SIZE = sizeof(SYNC_BYTES) + 8;
+
+void writeInt(uint8_t *buf, uint32_t value) {
+  buf[0] = static_cast<uint8_t>(value >> 24);
+  buf[1] = static_cast<uint8_t>(value >> 16);
+  buf[2] = static_cast<uint8_t>(value >> 8);
+  buf[3] = static_cast<uint8_t>(value);
+}
+
+uint32_t readInt(const uint8_t *buf) {
+  return (static_cast<uint32_t>(buf[0]) << 24) | (static_cast<uint32_t>(buf[1]) << 16) | (static_cast<uint32_t>(buf[2]) << 8) | buf[3];
+}
+
+}  // namespace
+
+CompressionOutputStream::CompressionOutputStream(io::DataStream *stream)
+    : stream_(stream),
+      data_written_(false) {
+  buffer_.reserve(COMPRESSION_CHUNK_SIZE);
+}
+
+int CompressionOutputStream::write(const uint8_t *value, int len) {
+  int written = 0;
+  while (written < len) {
+    size_t count = std::min<size_t>(len - written, COMPRESSION_CHUNK_SIZE - buffer_.size());
+    buffer_.insert(buffer_.end(), value + written, value + written + count);
+    written += count;
+    if (buffer_.size() == COMPRESSION_CHUNK_SIZE && writeChunk() < 0) {
+      return -1;
+    }
+  }
+  return len;
+}
+
+int CompressionOutputStream::close() {
+  if (!buffer_.empty() && writeChunk() < 0) {
+    return -1;
+  }
+  uint8_t end = 0;
+  return stream_->writeData(&end, 1) == 1 ? 1 : -1;
+}
+
+int CompressionOutputStream::writeChunk() {
+  // a 1 between chunks tells the reader that more data follows
+  size_t offset = data_written_ ? 1 : 0;
+  uLongf compressed_size = compressBound(buffer_.size());
+  compressed_.resize(offset + CHUNK_HEADER_SIZE + compressed_size);
+  if (compress2(compressed_.data() + offset + CHUNK_HEADER_SIZE, &compressed_size, buffer_.data(), buffer_.size(), Z_BEST_SPEED) != Z_OK) {
+    return -1;
+  }
+  if (data_written_) {
+    compressed_[0] = 1;
+  }
+  memcpy(compressed_.data() + offset, SYNC_BYTES, sizeof(SYNC_BYTES));
+  writeInt(compressed_.data() + offset + sizeof(SYNC_BYTES), buffer_.size());
+  writeInt(compressed_.data() + offset + sizeof(SYNC_BYTES) + 4, compressed_size);
+
+  int size = offset + CHUNK_HEADER_SIZE + compressed_size;
+  if (stream_->writeData(compressed_.data(), size) != size) {
+    return -1;
+  }
+  data_written_ = true;
+  buffer_.clear();
+  return size;
+}
+
+CompressionInputStream::CompressionInputStream(io::DataStream *stream)
+    : stream_(stream),
+      index_(0),
+      all_data_read_(false) {
+}
+
+int CompressionInputStream::read(uint8_t *value, int len) {
+  int total = 0;
+  while (total < len) {
+    if (index_ == buffer_.size()) {
+      if (all_data_read_) {
+        break;
+      }
+      if (!readChunk()) {
+        return -1;
+      }
+      continue;
+    }
+    size_t count = std::min<size_t>(len - total, buffer_.size() - index_);
+    memcpy(value + total, buffer_.data() + index_, count);
+    index_ += count;
+    total += count;
+  }
+  return total;
+}
+
+bool CompressionInputStream::readChunk() {
+  uint8_t header[CHUNK_HEADER_SIZE];
+  if (!readFully(header, CHUNK_HEADER_SIZE) || memcmp(header, SYNC_BYTES, sizeof(SYNC_BYTES)) != 0) {
+    return false;
+  }
+  uint32_t size = readInt(header + sizeof(SYNC_BYTES));
+  uint32_t compressed_size = readInt(header + sizeof(SYNC_BYTES) + 4);
+  if (size > MAX_COMPRESSION_CHUNK_SIZE || compressed_size > compressBound(MAX_COMPRESSION_CHUNK_SIZE)) {
+    return false;
+  }
+  compressed_.resize(compressed_size);
+  if (!readFully(compressed_.data(), compressed_size)) {
+    return false;
+  }
+  buffer_.resize(size);
+  uLongf uncompressed_size = size;
+  if (uncompress(buffer_.data(), &uncompressed_size, compressed_.data(), compressed_size) != Z_OK || uncompressed_size != size) {
+    return false;
+  }
+  index_ = 0;
+
+  // the chunk is followed by 1 if more data is to come, or by 0 at the end of the packet
+  uint8_t more_data;
+  if (!readFully(&more_data, 1) || more_data > 1) {
+    return false;
+  }
+  all_data_read_ = more_data == 0;
+  return true;
+}
+
+bool CompressionInputStream::readFully(uint8_t *value, int len) {
+  int total = 0;
+  while (total < len) {
+    int ret = stream_->readData(value + total, len - total);
+    if (ret <= 0) {
+      return false;
+    }
+    total += ret;
+  }
+  return true;
+}
+
+} /* namespace sitetosite */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
@@ -51,21 +51,56 @@ bool SiteToSitePeer::Open() {
     }
   }
 
-  if (stream_->initialize() < 0)
+  if (getProtocolStream()->initialize() < 0)
     return false;
 
   uint16_t data_size = sizeof MAGIC_BYTES;
 
-  if (stream_->writeData(reinterpret_cast<uint8_t *>(const_cast<char*>(MAGIC_BYTES)), data_size) != data_size) {
+  if (getProtocolStream()->writeData(reinterpret_cast<uint8_t *>(const_cast<char*>(MAGIC_BYTES)), data_size) != data_size) {
     return false;
   }
 
   return true;
 }
 
+void SiteToSitePeer::startCompressedWrite() {
+  compression_output_ = std::unique_ptr<CompressionOutputStream>(new CompressionOutputStream(getProtocolStream()));
+}
+
+int SiteToSitePeer::finishCompressedWrite() {
+  if (compression_output_ == nullptr)
+    return -1;
+  int ret = compression_output_->close();
+  compression_output_ = nullptr;
+  return ret;
+}
+
+void SiteToSitePeer::startCompressedRead() {
+  compression_input_ = std::unique_ptr<CompressionInputStream>(new CompressionInputStream(getProtocolStream()));
+}
+
+void SiteToSitePeer::finishCompressedRead() {
+  compression_input_ = nullptr;
+}
+
+void SiteToSitePeer::setBufferedWrites(bool buffered) {
+  if (!buffered) {
+    flush();
+    buffered_stream_ = nullptr;
+  } else if (buffered_stream_ == nullptr && stream_ != nullptr) {
+    buffered_stream_ = std::unique_ptr<io::BufferedStream>(new io::BufferedStream(stream_.get()));
+  }
+}
+
+int SiteToSitePeer::flush() {
+  if (buffered_stream_ == nullptr)
+    return 0;
+  return buffered_stream_->flush();
+}
+
 void SiteToSitePeer::Close() {
   if (stream_ != nullptr)
-    stream_->closeStream();
+    getProtocolStream()->closeStream();
 }
 
 } /* namespace sitetosite */
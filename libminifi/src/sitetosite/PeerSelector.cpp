@@ -0,0 +1,106 @@
+/**
+ * @file PeerSelector.cpp
+ * PeerSelector class implementation
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sitetosite/PeerSelector.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include "utils/TimeUtil.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace sitetosite {
+
+namespace {
+
+std::string peerKey(const std::string &host, uint16_t port) {
+  return host + ":" + std::to_string(port);
+}
+
+}  // namespace
+
+PeerSelector::PeerSelector()
+    : index_(0),
+      random_(std::random_device()()) {
+}
+
+void PeerSelector::setPeers(const std::vector<PeerStatus> &peers, TransferDirection direction) {
+  uint64_t total_flow_files = 0;
+  for (const auto &peer : peers) {
+    total_flow_files += peer.getFlowFileCount();
+  }
+  size_t destinations = std::max<size_t>(PEER_SELECTOR_DESTINATIONS, peers.size());
+
+  std::vector<std::shared_ptr<Peer>> weighted;
+  for (const auto &peer : peers) {
+    double weight = 1.0 / peers.size();
+    if (total_flow_files > 0 && peers.size() > 1) {
+      double share = std::min(PEER_SELECTOR_MAX_SHARE, static_cast<double>(peer.getFlowFileCount()) / total_flow_files);
+      weight = direction == SEND ? 1 - share : share;
+    }
+    size_t entries = std::max<size_t>(1, static_cast<size_t>(destinations * weight));
+    for (size_t i = 0; i < entries; i++) {
+      weighted.push_back(peer.getPeer());
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::shuffle(weighted.begin(), weighted.end(), random_);
+  destinations_.swap(weighted);
+  index_ = 0;
+}
+
+std::shared_ptr<Peer> PeerSelector::getNextPeer() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t now = getTimeMillis();
+  for (size_t i = 0; i < destinations_.size(); i++) {
+    std::shared_ptr<Peer> peer = destinations_[index_];
+    index_ = (index_ + 1) % destinations_.size();
+    auto penalty = penalized_until_.find(peerKey(peer->getHost(), peer->getPort()));
+    if (penalty == penalized_until_.end()) {
+      return peer;
+    }
+    if (penalty->second <= now) {
+      penalized_until_.erase(penalty);
+      return peer;
+    }
+  }
+  return nullptr;
+}
+
+void PeerSelector::penalize(const std::string &host, uint16_t port, uint64_t penalization_ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  penalized_until_[peerKey(host, port)] = getTimeMillis() + penalization_ms;
+}
+
+size_t PeerSelector::getEntries(const std::string &host, uint16_t port) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::count_if(destinations_.begin(), destinations_.end(), [&](const std::shared_ptr<Peer> &peer) {
+    return peer->getHost() == host && peer->getPort() == port;
+  });
+}
+
+} /* namespace sitetosite */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
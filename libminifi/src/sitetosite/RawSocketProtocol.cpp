@@ -252,7 +252,7 @@ bool RawSiteToSiteClient::handShake() {
   }
 
   std::map<std::string, std::string> properties;
-  properties[HandShakePropertyStr[GZIP]] = "false";
+  properties[HandShakePropertyStr[GZIP]] = use_compression_ ? "true" : "false";
   properties[HandShakePropertyStr[PORT_IDENTIFIER]] = port_id_str_;
   properties[HandShakePropertyStr[REQUEST_EXPIRATION_MILLIS]] = std::to_string(_timeOut);
   if (_currentVersion >= 5) {
@@ -603,9 +603,26 @@ std::shared_ptr<Transaction> RawSiteToSiteClient::createTransaction(std::string
 
 bool RawSiteToSiteClient::transmitPayload(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, const std::string &payload,
                                           std::map<std::string, std::string> attributes) {
+  if (payload.length() <= 0)
+    return false;
+
+  bool produced = false;
+  return transmitPayloads(context, session, [&payload, &produced](std::string &next) {
+    if (produced) {
+      return false;
+    }
+    next = payload;
+    produced = true;
+    return true;
+  }, attributes);
+}
+
+bool RawSiteToSiteClient::transmitPayloads(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session,
+                                           const std::function<bool(std::string&)> &next, std::map<std::string, std::string> attributes) {
   std::shared_ptr<Transaction> transaction = NULL;
 
-  if (payload.length() <= 0)
+  std::string payload;
+  if (!next(payload) || payload.length() <= 0)
     return false;
 
   if (peer_state_ != READY) {
@@ -631,13 +648,15 @@ bool RawSiteToSiteClient::transmitPayload(const std::shared_ptr<core::ProcessCon
   }
 
   try {
-    DataPacket packet(getLogger(), transaction, attributes, payload);
+    do {
+      DataPacket packet(getLogger(), transaction, attributes, payload);
 
-    int16_t resp = send(transactionID, &packet, nullptr, session);
-    if (resp == -1) {
-      throw Exception(SITE2SITE_EXCEPTION, "Send Failed");
-    }
-    logging::LOG_INFO(logger_) << "Site2Site transaction " << transactionID << " sent bytes length" << payload.length();
+      int16_t resp = send(transactionID, &packet, nullptr, session);
+      if (resp == -1) {
+        throw Exception(SITE2SITE_EXCEPTION, "Send Failed");
+      }
+      logging::LOG_INFO(logger_) << "Site2Site transaction " << transactionID << " sent bytes length" << payload.length();
+    } while (next(payload) && payload.length() > 0);
 
     if (!confirm(transactionID)) {
       throw Exception(SITE2SITE_EXCEPTION, "Confirm Failed");
@@ -146,6 +146,14 @@ void SiteToSiteClient::tearDown() {
 }
 
 bool SiteToSiteClient::transferFlowFiles(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session) {
+  std::string transactionID;
+  if (!startTransferFlowFiles(context, session, transactionID)) {
+    return false;
+  }
+  return finishTransferFlowFiles(context, transactionID);
+}
+
+bool SiteToSiteClient::startTransferFlowFiles(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, std::string &transactionID) {
   std::shared_ptr<FlowFileRecord> flow = std::static_pointer_cast<FlowFileRecord>(session->get());
 
   std::shared_ptr<Transaction> transaction = NULL;
@@ -166,7 +174,6 @@ bool SiteToSiteClient::transferFlowFiles(const std::shared_ptr<core::ProcessCont
   }
 
   // Create the transaction
-  std::string transactionID;
   transaction = createTransaction(transactionID, SEND);
   if (transaction == NULL) {
     context->yield();
@@ -208,26 +215,51 @@ bool SiteToSiteClient::transferFlowFiles(const std::shared_ptr<core::ProcessCont
       }
     }  // while true
 
+    if (!finishSending(transactionID)) {
+      throw Exception(SITE2SITE_EXCEPTION, "Finish Failed for " + transactionID);
+    }
+  } catch (std::exception &exception) {
+    if (transaction)
+      deleteTransaction(transactionID);
+    context->yield();
+    tearDown();
+    logger_->log_debug("Caught Exception %s", exception.what());
+    throw;
+  } catch (...) {
+    if (transaction)
+      deleteTransaction(transactionID);
+    context->yield();
+    tearDown();
+    logger_->log_debug("Caught Exception during SiteToSiteClient::startTransferFlowFiles");
+    throw;
+  }
+
+  return true;
+}
+
+bool SiteToSiteClient::finishTransferFlowFiles(const std::shared_ptr<core::ProcessContext> &context, const std::string &transactionID) {
+  try {
     if (!confirm(transactionID)) {
       throw Exception(SITE2SITE_EXCEPTION, "Confirm Failed for " + transactionID);
     }
     if (!complete(transactionID)) {
       throw Exception(SITE2SITE_EXCEPTION, "Complete Failed for " + transactionID);
     }
-    logger_->log_debug("Site2Site transaction %s successfully send flow record %d, content bytes %llu", transactionID, transaction->total_transfers_, transaction->_bytes);
+    auto it = known_transactions_.find(transactionID);
+    if (it != known_transactions_.end()) {
+      logger_->log_debug("Site2Site transaction %s successfully send flow record %d, content bytes %llu", transactionID, it->second->total_transfers_, it->second->_bytes);
+    }
   } catch (std::exception &exception) {
-    if (transaction)
-      deleteTransaction(transactionID);
+    deleteTransaction(transactionID);
     context->yield();
     tearDown();
     logger_->log_debug("Caught Exception %s", exception.what());
     throw;
   } catch (...) {
-    if (transaction)
-      deleteTransaction(transactionID);
+    deleteTransaction(transactionID);
     context->yield();
     tearDown();
-    logger_->log_debug("Caught Exception during SiteToSiteClient::transferFlowFiles");
+    logger_->log_debug("Caught Exception during SiteToSiteClient::finishTransferFlowFiles");
     throw;
   }
 
@@ -236,6 +268,27 @@ bool SiteToSiteClient::transferFlowFiles(const std::shared_ptr<core::ProcessCont
   return true;
 }
 
+bool SiteToSiteClient::finishSending(std::string transactionID) {
+  auto it = this->known_transactions_.find(transactionID);
+
+  if (it == known_transactions_.end()) {
+    return false;
+  }
+  std::shared_ptr<Transaction> transaction = it->second;
+
+  if (transaction->getState() != DATA_EXCHANGED || transaction->getDirection() != SEND) {
+    return false;
+  }
+
+  logger_->log_debug("Site2Site Send FINISH TRANSACTION for transaction %s", transactionID);
+  // the peer may not be read again until the transaction is confirmed
+  if (writeResponse(transaction, FINISH_TRANSACTION, "FINISH_TRANSACTION") <= 0 || peer_->flush() < 0) {
+    return false;
+  }
+  transaction->_state = DATA_SENT;
+  return true;
+}
+
 bool SiteToSiteClient::confirm(std::string transactionID) {
   int ret;
   std::shared_ptr<Transaction> transaction = NULL;
@@ -261,7 +314,7 @@ bool SiteToSiteClient::confirm(std::string transactionID) {
     return true;
   }
 
-  if (transaction->getState() != DATA_EXCHANGED)
+  if (transaction->getState() != DATA_EXCHANGED && transaction->getState() != DATA_SENT)
     return false;
 
   if (transaction->getDirection() == RECEIVE) {
@@ -298,9 +351,7 @@ bool SiteToSiteClient::confirm(std::string transactionID) {
       return false;
     }
   } else {
-    logger_->log_debug("Site2Site Send FINISH TRANSACTION for transaction %s", transactionID);
-    ret = writeResponse(transaction, FINISH_TRANSACTION, "FINISH_TRANSACTION");
-    if (ret <= 0)
+    if (transaction->getState() == DATA_EXCHANGED && !finishSending(transactionID))
       return false;
     RespondCode code;
     std::string message;
@@ -411,7 +462,7 @@ bool SiteToSiteClient::complete(std::string transactionID) {
     } else {
       logger_->log_debug("Site2Site transaction %s send finished", transactionID);
       ret = this->writeResponse(transaction, TRANSACTION_FINISHED, "Finished");
-      if (ret <= 0) {
+      if (ret <= 0 || peer_->flush() < 0) {
         return false;
       } else {
         transaction->_state = TRANSACTION_COMPLETED;
@@ -479,6 +530,32 @@ int16_t SiteToSiteClient::send(std::string transactionID, DataPacket *packet, co
       return -1;
     }
   }
+  uint64_t len = 0;
+  if (use_compression_) {
+    peer_->startCompressedWrite();
+  }
+  int16_t status = writePacket(transaction, packet, flowFile, session, len);
+  if (use_compression_ && peer_->finishCompressedWrite() <= 0 && status == 0) {
+    status = -1;
+  }
+  if (status != 0) {
+    return status;
+  }
+
+  transaction->current_transfers_++;
+  transaction->total_transfers_++;
+  transaction->_state = DATA_EXCHANGED;
+  transaction->_bytes += len;
+
+  logging::LOG_INFO(logger_) << "Site to Site transaction " << transactionID << " sent flow " << transaction->total_transfers_
+                             << "flow records, with total size " << transaction->_bytes;
+
+  return 0;
+}
+
+int16_t SiteToSiteClient::writePacket(const std::shared_ptr<Transaction> &transaction, DataPacket *packet, const std::shared_ptr<FlowFileRecord> &flowFile,
+                                      const std::shared_ptr<core::ProcessSession> &session, uint64_t &len) {
+  int ret;
   // start to read the packet
   uint32_t numAttributes = packet->_attributes.size();
   ret = transaction->getStream().write(numAttributes);
@@ -497,10 +574,10 @@ int16_t SiteToSiteClient::send(std::string transactionID, DataPacket *packet, co
     if (ret <= 0) {
       return -1;
     }
-    logger_->log_debug("Site2Site transaction %s send attribute key %s value %s", transactionID, itAttribute->first, itAttribute->second);
+    logger_->log_debug("Site2Site transaction %s send attribute key %s value %s", transaction->getUUIDStr(), itAttribute->first, itAttribute->second);
   }
 
-  uint64_t len = 0;
+  len = 0;
   if (flowFile) {
     len = flowFile->getSize();
     ret = transaction->getStream().write(len);
@@ -538,14 +615,6 @@ int16_t SiteToSiteClient::send(std::string transactionID, DataPacket *packet, co
     packet->_size += len;
   }
 
-  transaction->current_transfers_++;
-  transaction->total_transfers_++;
-  transaction->_state = DATA_EXCHANGED;
-  transaction->_bytes += len;
-
-  logging::LOG_INFO(logger_) << "Site to Site transaction " << transactionID << " sent flow " << transaction->total_transfers_
-                             << "flow records, with total size " << transaction->_bytes;
-
   return 0;
 }
 
@@ -614,6 +683,9 @@ bool SiteToSiteClient::receive(std::string transactionID, DataPacket *packet, bo
     return true;
   }
 
+  if (use_compression_) {
+    peer_->startCompressedRead();
+  }
   // start to read the packet
   uint32_t numAttributes;
   ret = transaction->getStream().read(numAttributes);
@@ -696,6 +768,8 @@ bool SiteToSiteClient::receiveFlowFiles(const std::shared_ptr<core::ProcessConte
       std::string payload;
       DataPacket packet(getLogger(), transaction, empty, payload);
       bool eof = false;
+      // the packet is read by receive and by the write callback of its content
+      CompressedReadGuard compressed_read(peer_.get());
 
       if (!receive(transactionID, &packet, eof)) {
         throw Exception(SITE2SITE_EXCEPTION, "Receive Failed");
@@ -0,0 +1,710 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sitetosite/SiteToSiteServer.h"
+#ifndef WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include "core/Property.h"
+#include "io/CRCStream.h"
+#include "sitetosite/RawSocketProtocol.h"
+#include "sitetosite/SiteToSiteClient.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtil.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace sitetosite {
+
+namespace {
+
+const char *RESOURCE_NAME = "SocketFlowFileProtocol";
+const char *CODEC_NAME = "StandardFlowFileCodec";
+
+RespondCodeContext *getRespondCodeContext(RespondCode code) {
+  for (unsigned int i = 0; i < sizeof(SiteToSiteRequest::respondCodeContext) / sizeof(RespondCodeContext); i++) {
+    if (SiteToSiteRequest::respondCodeContext[i].code == code) {
+      return &SiteToSiteRequest::respondCodeContext[i];
+    }
+  }
+  return nullptr;
+}
+
+#ifndef WIN32
+/**
+ * Socket of an accepted connection. The server closes the descriptor once the reactor no
+ * longer watches it, so that it cannot be reused by another connection while still watched.
+ */
+class ConnectionSocket : public io::Socket {
+ public:
+  ConnectionSocket(int fd, const std::string &host, uint16_t port)
+      : io::Socket(nullptr, host, port) {
+    socket_file_descriptor_ = fd;
+  }
+
+  virtual ~ConnectionSocket() {
+    socket_file_descriptor_ = -1;
+  }
+
+  virtual int16_t initialize() {
+    return 0;
+  }
+
+  virtual void closeStream() {
+    socket_file_descriptor_ = -1;
+  }
+};
+#endif
+
+}  // namespace
+
+SiteToSiteServer::SiteToSiteServer(const std::string &host, uint16_t port, uint16_t threads)
+    : host_(host),
+      port_(port),
+      pool_(threads, false, nullptr, "Site2SiteServer"),
+      logger_(logging::LoggerFactory<SiteToSiteServer>::getLogger()) {
+}
+
+SiteToSiteServer::~SiteToSiteServer() {
+  stop();
+}
+
+std::shared_ptr<SiteToSiteServer> SiteToSiteServer::getServer(const std::shared_ptr<Configure> &configure) {
+  static std::mutex servers_mutex;
+  static std::map<uint16_t, std::weak_ptr<SiteToSiteServer>> servers;
+
+  std::string value;
+  int64_t port;
+  if (configure == nullptr || !configure->get(Configure::nifi_remote_input_socket_port, value) || !core::Property::StringToInt(value, port) || port < 0 || port > 65535) {
+    return nullptr;
+  }
+  std::string host;
+  if (!configure->get(Configure::nifi_remote_input_host, host) || host.empty()) {
+    host = io::Socket::getMyHostName();
+  }
+
+  std::lock_guard<std::mutex> lock(servers_mutex);
+  std::shared_ptr<SiteToSiteServer> server = servers[port].lock();
+  if (server == nullptr) {
+    server = std::make_shared<SiteToSiteServer>(host, port);
+    if (!server->start()) {
+      return nullptr;
+    }
+    servers[port] = server;
+  }
+  return server;
+}
+
+#ifdef WIN32
+bool SiteToSiteServer::start() {
+  logger_->log_error("The site to site server is not supported on this platform");
+  return false;
+}
+
+void SiteToSiteServer::stop() {
+}
+#else
+bool SiteToSiteServer::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (server_socket_ != nullptr) {
+    return true;
+  }
+  std::unique_ptr<io::ServerSocket> server_socket(new io::ServerSocket(nullptr, host_, port_, 16));
+  if (server_socket->initialize(false) < 0) {
+    logger_->log_error("Site2Site server could not listen on port %d", port_);
+    return false;
+  }
+  port_ = server_socket->getPort();
+  reactor_ = io::Reactor::getReactor();
+  pool_.start();
+  server_socket_ = std::move(server_socket);
+  server_socket_->registerConnectionCallback([] {return true;}, [this](int fd) {
+    addConnection(fd);
+  });
+  logger_->log_info("Site2Site server listening on port %d", port_);
+  return true;
+}
+
+void SiteToSiteServer::stop() {
+  std::unique_ptr<io::ServerSocket> server_socket;
+  std::map<int, std::shared_ptr<Connection>> connections;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    server_socket.swap(server_socket_);
+    connections.swap(connections_);
+  }
+  // connections accepted until the server socket is closed are closed by addConnection
+  server_socket = nullptr;
+  if (reactor_ == nullptr) {
+    return;
+  }
+  for (const auto &connection : connections) {
+    reactor_->remove(connection.first);
+    // requests waiting for data give up, so that the threads can be stopped
+    shutdown(connection.first, SHUT_RDWR);
+  }
+  pool_.shutdown();
+  for (auto &connection : connections) {
+    connection.second = nullptr;
+    close(connection.first);
+  }
+}
+
+void SiteToSiteServer::addConnection(int fd) {
+  // requests are read with blocking calls, which give up once the client is silent for too long
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags >= 0) {
+    fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+  }
+  struct timeval timeout;
+  timeout.tv_sec = SITE2SITE_SERVER_TIMEOUT_MS / 1000;
+  timeout.tv_usec = (SITE2SITE_SERVER_TIMEOUT_MS % 1000) * 1000;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  std::string host = "unknown";
+  uint16_t port = 0;
+  struct sockaddr_storage address;
+  socklen_t length = sizeof(address);
+  if (getpeername(fd, reinterpret_cast<struct sockaddr*>(&address), &length) == 0) {
+    char name[INET6_ADDRSTRLEN] = { 0 };
+    if (address.ss_family == AF_INET) {
+      auto ipv4 = reinterpret_cast<struct sockaddr_in*>(&address);
+      inet_ntop(AF_INET, &ipv4->sin_addr, name, sizeof(name));
+      port = ntohs(ipv4->sin_port);
+    } else if (address.ss_family == AF_INET6) {
+      auto ipv6 = reinterpret_cast<struct sockaddr_in6*>(&address);
+      inet_ntop(AF_INET6, &ipv6->sin6_addr, name, sizeof(name));
+      port = ntohs(ipv6->sin6_port);
+    }
+    host = name;
+  }
+
+  auto connection = std::make_shared<Connection>();
+  connection->fd = fd;
+  connection->peer = std::unique_ptr<SiteToSitePeer>(new SiteToSitePeer(std::unique_ptr<io::DataStream>(new ConnectionSocket(fd, host, port)), host, port, ""));
+  connection->peer->setBufferedWrites(true);
+  connection->state = IDLE;
+  connection->version = 0;
+  connection->use_compression = false;
+  connection->batch_count = 0;
+  connection->batch_size = 0;
+  connection->batch_duration = 0;
+  std::lock_guard<std::mutex> lock(mutex_);
+  // a stopping server no longer holds the connection
+  if (server_socket_ == nullptr) {
+    connection = nullptr;
+    close(fd);
+    return;
+  }
+  connections_[fd] = connection;
+  logger_->log_debug("Site2Site server accepted connection from %s:%d", host, port);
+  if (!watch(fd)) {
+    connections_.erase(fd);
+    connection = nullptr;
+    close(fd);
+  }
+}
+
+bool SiteToSiteServer::watch(int fd) {
+  return reactor_->add(fd, REACTOR_READABLE, [this](int fd, uint32_t events) {
+    // the request is served on a thread of the server, and the connection watched again afterwards
+    reactor_->remove(fd);
+    std::function<bool()> task = [this, fd]() {
+      dispatch(fd);
+      return true;
+    };
+    utils::Worker<bool> worker(task, "Site2SiteServer");
+    std::future<bool> future;
+    pool_.execute(std::move(worker), future);
+  });
+}
+
+void SiteToSiteServer::dispatch(int fd) {
+  std::shared_ptr<Connection> connection;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = connections_.find(fd);
+    if (it == connections_.end())
+      return;
+    connection = it->second;
+  }
+  if (serve(*connection)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // a stopping server closes the connections it took over itself
+    if (connections_.find(fd) == connections_.end() || watch(fd))
+      return;
+  }
+  connection = nullptr;
+  closeConnection(fd);
+}
+
+void SiteToSiteServer::closeConnection(int fd) {
+  reactor_->remove(fd);
+  std::shared_ptr<Connection> connection;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = connections_.find(fd);
+    if (it == connections_.end())
+      return;
+    connection = std::move(it->second);
+    connections_.erase(it);
+  }
+  logger_->log_debug("Site2Site server closing connection from %s", connection->peer->getHostName());
+  // the peer sends what it has buffered before the descriptor is closed
+  connection = nullptr;
+  close(fd);
+}
+#endif
+
+size_t SiteToSiteServer::getConnectionCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return connections_.size();
+}
+
+void SiteToSiteServer::registerPort(const std::string &id, const std::string &name, TransferDirection direction, const std::shared_ptr<core::ProcessSessionFactory> &session_factory) {
+  auto port = std::make_shared<Port>();
+  port->name = name;
+  port->direction = direction;
+  port->session_factory = session_factory;
+  std::lock_guard<std::mutex> lock(mutex_);
+  ports_[id] = port;
+  logger_->log_info("Site2Site server serving %s port %s (%s)", direction == SEND ? "input" : "output", name, id);
+}
+
+void SiteToSiteServer::unregisterPort(const std::string &id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ports_.erase(id);
+}
+
+std::shared_ptr<SiteToSiteServer::Port> SiteToSiteServer::getPort(const std::string &id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = ports_.find(id);
+  if (it == ports_.end())
+    return nullptr;
+  return it->second;
+}
+
+bool SiteToSiteServer::serve(Connection &connection) {
+  bool ret = false;
+  if (connection.state == IDLE) {
+    ret = establish(connection);
+  } else {
+    std::string request;
+    if (connection.peer->readUTF(request) <= 0) {
+      return false;
+    }
+    int type = MAX_REQUEST_TYPE;
+    for (int i = NEGOTIATE_FLOWFILE_CODEC; i < MAX_REQUEST_TYPE; i++) {
+      if (request == SiteToSiteRequest::RequestTypeStr[i]) {
+        type = i;
+        break;
+      }
+    }
+    switch (type) {
+      case NEGOTIATE_FLOWFILE_CODEC:
+        ret = negotiateCodec(connection);
+        break;
+      case REQUEST_PEER_LIST:
+        ret = sendPeerList(connection);
+        break;
+      case SEND_FLOWFILES:
+      case RECEIVE_FLOWFILES: {
+        // the client sends SEND_FLOWFILES to input ports and RECEIVE_FLOWFILES to output ports
+        TransferDirection direction = type == SEND_FLOWFILES ? SEND : RECEIVE;
+        std::shared_ptr<Port> port = getPort(connection.port_id);
+        if (connection.state != READY || port == nullptr || port->direction != direction) {
+          logger_->log_warn("Site2Site server cannot serve %s for port %s", request, connection.port_id);
+          return false;
+        }
+        ret = direction == SEND ? receiveFlowFiles(connection, port) : sendFlowFiles(connection, port);
+        break;
+      }
+      case SHUTDOWN:
+        logger_->log_debug("Site2Site server peer %s shut down", connection.peer->getHostName());
+        return false;
+      default:
+        logger_->log_warn("Site2Site server received unknown request %s", request);
+        return false;
+    }
+  }
+  // responses are sent before waiting for the next request
+  int flushed = connection.peer->flush();
+  return ret && flushed >= 0;
+}
+
+bool SiteToSiteServer::establish(Connection &connection) {
+  uint8_t magic[sizeof(MAGIC_BYTES)];
+  if (connection.peer->read(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, MAGIC_BYTES, sizeof(MAGIC_BYTES)) != 0) {
+    logger_->log_debug("Site2Site server connection from %s is not site to site", connection.peer->getHostName());
+    return false;
+  }
+
+  // the client offers lower versions until one is supported
+  while (true) {
+    std::string resource;
+    uint32_t version;
+    if (connection.peer->readUTF(resource) <= 0 || connection.peer->read(version) <= 0) {
+      return false;
+    }
+    if (resource != RESOURCE_NAME) {
+      logger_->log_warn("Site2Site server does not support resource %s", resource);
+      connection.peer->write(static_cast<uint8_t>(NEGOTIATED_ABORT));
+      return false;
+    }
+    if (version >= 1 && version <= SITE2SITE_SERVER_VERSION) {
+      connection.version = version;
+      if (connection.peer->write(static_cast<uint8_t>(RESOURCE_OK)) <= 0) {
+        return false;
+      }
+      break;
+    }
+    if (connection.peer->write(static_cast<uint8_t>(DIFFERENT_RESOURCE_VERSION)) <= 0 || connection.peer->write(static_cast<uint32_t>(SITE2SITE_SERVER_VERSION)) <= 0) {
+      return false;
+    }
+  }
+  connection.state = ESTABLISHED;
+  return handShake(connection);
+}
+
+bool SiteToSiteServer::handShake(Connection &connection) {
+  std::string comms_identifier;
+  if (connection.peer->readUTF(comms_identifier) <= 0) {
+    return false;
+  }
+  if (connection.version >= 3) {
+    std::string url;
+    if (connection.peer->readUTF(url) <= 0) {
+      return false;
+    }
+  }
+  uint32_t count;
+  if (connection.peer->read(count) <= 0 || count > MAX_NUM_ATTRIBUTES) {
+    return false;
+  }
+  std::map<std::string, std::string> properties;
+  for (uint32_t i = 0; i < count; i++) {
+    std::string key;
+    std::string value;
+    if (connection.peer->readUTF(key) <= 0 || connection.peer->readUTF(value) <= 0) {
+      return false;
+    }
+    logger_->log_debug("Site2Site server received handshake property %s %s", key, value);
+    properties[key] = value;
+  }
+
+  int64_t number;
+  for (const auto &property : properties) {
+    if (property.first == RawSiteToSiteClient::HandShakePropertyStr[GZIP]) {
+      utils::StringUtils::StringToBool(property.second, connection.use_compression);
+    } else if (property.first == RawSiteToSiteClient::HandShakePropertyStr[PORT_IDENTIFIER]) {
+      connection.port_id = property.second;
+    } else if (property.first == RawSiteToSiteClient::HandShakePropertyStr[BATCH_COUNT] && core::Property::StringToInt(property.second, number) && number > 0) {
+      connection.batch_count = number;
+    } else if (property.first == RawSiteToSiteClient::HandShakePropertyStr[BATCH_SIZE] && core::Property::StringToInt(property.second, number) && number > 0) {
+      connection.batch_size = number;
+    } else if (property.first == RawSiteToSiteClient::HandShakePropertyStr[BATCH_DURATION] && core::Property::StringToInt(property.second, number) && number > 0) {
+      connection.batch_duration = number;
+    }
+  }
+
+  // only peer lists may be requested without a port
+  if (!connection.port_id.empty() && getPort(connection.port_id) == nullptr) {
+    logger_->log_warn("Site2Site server has no port %s", connection.port_id);
+    writeResponse(connection, UNKNOWN_PORT, "");
+    return false;
+  }
+  if (writeResponse(connection, PROPERTIES_OK, "") <= 0) {
+    return false;
+  }
+  connection.state = HANDSHAKED;
+  logger_->log_debug("Site2Site server handshake with %s completed", connection.peer->getHostName());
+  return true;
+}
+
+bool SiteToSiteServer::negotiateCodec(Connection &connection) {
+  while (true) {
+    std::string codec;
+    uint32_t version;
+    if (connection.peer->readUTF(codec) <= 0 || connection.peer->read(version) <= 0) {
+      return false;
+    }
+    if (codec != CODEC_NAME) {
+      logger_->log_warn("Site2Site server does not support codec %s", codec);
+      connection.peer->write(static_cast<uint8_t>(NEGOTIATED_ABORT));
+      return false;
+    }
+    if (version == SITE2SITE_SERVER_CODEC_VERSION) {
+      connection.state = READY;
+      return connection.peer->write(static_cast<uint8_t>(RESOURCE_OK)) > 0;
+    }
+    if (connection.peer->write(static_cast<uint8_t>(DIFFERENT_RESOURCE_VERSION)) <= 0 || connection.peer->write(static_cast<uint32_t>(SITE2SITE_SERVER_CODEC_VERSION)) <= 0) {
+      return false;
+    }
+  }
+}
+
+bool SiteToSiteServer::sendPeerList(Connection &connection) {
+  // this agent is the only peer
+  return connection.peer->write(static_cast<uint32_t>(1)) > 0 && connection.peer->writeUTF(host_) > 0 && connection.peer->write(static_cast<uint32_t>(port_)) > 0
+      && connection.peer->write(static_cast<uint8_t>(0)) > 0 && connection.peer->write(static_cast<uint32_t>(0)) > 0;
+}
+
+bool SiteToSiteServer::receiveFlowFiles(Connection &connection, const std::shared_ptr<Port> &port) {
+  std::shared_ptr<core::ProcessSession> session = port->session_factory->createSession();
+  io::CRCStream<SiteToSitePeer> crc_stream(connection.peer.get());
+  auto transaction = std::make_shared<Transaction>(SEND, crc_stream);
+  core::Relationship relation;  // undefined relationship
+
+  try {
+    while (true) {
+      uint64_t start_time = getTimeMillis();
+      std::map<std::string, std::string> attributes;
+      std::string payload;
+      DataPacket packet(logger_, transaction, attributes, payload);
+
+      CompressedReadGuard compressed_read(connection.peer.get());
+      if (connection.use_compression) {
+        connection.peer->startCompressedRead();
+      }
+      uint32_t num_attributes;
+      if (transaction->getStream().read(num_attributes) <= 0 || num_attributes > MAX_NUM_ATTRIBUTES) {
+        throw Exception(SITE2SITE_EXCEPTION, "Could not read the attributes");
+      }
+      for (uint32_t i = 0; i < num_attributes; i++) {
+        std::string key;
+        std::string value;
+        if (transaction->getStream().readUTF(key, true) <= 0 || transaction->getStream().readUTF(value, true) <= 0) {
+          throw Exception(SITE2SITE_EXCEPTION, "Could not read the attributes");
+        }
+        packet._attributes[key] = value;
+      }
+      uint64_t len;
+      if (transaction->getStream().read(len) <= 0) {
+        throw Exception(SITE2SITE_EXCEPTION, "Could not read the content length");
+      }
+      packet._size = len;
+
+      std::shared_ptr<FlowFileRecord> flow_file = std::static_pointer_cast<FlowFileRecord>(session->create());
+      std::string source_identifier;
+      for (const auto &attribute : packet._attributes) {
+        if (attribute.first == FlowAttributeKey(UUID))
+          source_identifier = attribute.second;
+        flow_file->addAttribute(attribute.first, attribute.second);
+      }
+      if (len > 0) {
+        // the content is written to the content repository as it is read from the socket
+        WriteCallback callback(&packet);
+        session->write(flow_file, &callback);
+        if (flow_file->getSize() != len) {
+          throw Exception(SITE2SITE_EXCEPTION, "Received less content than announced");
+        }
+      }
+      transaction->current_transfers_++;
+      transaction->total_transfers_++;
+      transaction->_bytes += len;
+
+      std::string transit_uri = connection.peer->getURL() + "/" + source_identifier;
+      std::string details = "urn:nifi:" + source_identifier + "Remote Host=" + connection.peer->getHostName();
+      session->getProvenanceReporter()->receive(flow_file, transit_uri, source_identifier, details, getTimeMillis() - start_time);
+      session->transfer(flow_file, relation);
+
+      RespondCode code;
+      std::string message;
+      if (readResponse(connection, code, message) <= 0) {
+        throw Exception(SITE2SITE_EXCEPTION, "Could not read the transaction indicator");
+      }
+      if (code == FINISH_TRANSACTION) {
+        break;
+      } else if (code != CONTINUE_TRANSACTION) {
+        throw Exception(SITE2SITE_EXCEPTION, "Unexpected transaction indicator " + std::to_string(code));
+      }
+    }
+
+    // the client confirms the checksum before the flow files are committed
+    int64_t crc_value = transaction->getCRC();
+    if (writeResponse(connection, CONFIRM_TRANSACTION, std::to_string(crc_value)) <= 0) {
+      throw Exception(SITE2SITE_EXCEPTION, "Could not confirm the transaction");
+    }
+    RespondCode code;
+    std::string message;
+    if (readResponse(connection, code, message) <= 0 || code != CONFIRM_TRANSACTION) {
+      throw Exception(SITE2SITE_EXCEPTION, "Client did not confirm the transaction");
+    }
+    session->commit();
+    if (writeResponse(connection, TRANSACTION_FINISHED, "") <= 0) {
+      return false;
+    }
+    logging::LOG_INFO(logger_) << "Site2Site server received " << transaction->total_transfers_ << " flow files, with content size " << transaction->_bytes << " bytes, from "
+                               << connection.peer->getHostName() << " into port " << port->name;
+    return true;
+  } catch (std::exception &exception) {
+    logger_->log_warn("Site2Site server could not receive flow files from %s: %s", connection.peer->getHostName(), exception.what());
+    session->rollback();
+    return false;
+  }
+}
+
+bool SiteToSiteServer::sendFlowFiles(Connection &connection, const std::shared_ptr<Port> &port) {
+  std::shared_ptr<core::ProcessSession> session = port->session_factory->createSession();
+
+  try {
+    std::shared_ptr<FlowFileRecord> flow_file = std::static_pointer_cast<FlowFileRecord>(session->get());
+    if (!flow_file) {
+      return writeResponse(connection, NO_MORE_DATA, "") > 0;
+    }
+    if (writeResponse(connection, MORE_DATA, "") <= 0) {
+      throw Exception(SITE2SITE_EXCEPTION, "Could not start the transaction");
+    }
+
+    io::CRCStream<SiteToSitePeer> crc_stream(connection.peer.get());
+    auto transaction = std::make_shared<Transaction>(RECEIVE, crc_stream);
+    uint64_t batch_duration = connection.batch_duration > 0 ? connection.batch_duration : SITE2SITE_SERVER_BATCH_DURATION_MS;
+    uint64_t batch_start = getTimeMillis();
+
+    while (flow_file) {
+      uint64_t start_time = getTimeMillis();
+      if (transaction->current_transfers_ > 0 && writeResponse(connection, CONTINUE_TRANSACTION, "") <= 0) {
+        throw Exception(SITE2SITE_EXCEPTION, "Could not continue the transaction");
+      }
+      if (connection.use_compression) {
+        connection.peer->startCompressedWrite();
+      }
+      std::map<std::string, std::string> attributes = flow_file->getAttributes();
+      std::string payload;
+      DataPacket packet(logger_, transaction, attributes, payload);
+      if (transaction->getStream().write(static_cast<uint32_t>(attributes.size())) != 4) {
+        throw Exception(SITE2SITE_EXCEPTION, "Could not send the attributes");
+      }
+      for (const auto &attribute : attributes) {
+        if (transaction->getStream().writeUTF(attribute.first, true) <= 0 || transaction->getStream().writeUTF(attribute.second, true) <= 0) {
+          throw Exception(SITE2SITE_EXCEPTION, "Could not send the attributes");
+        }
+      }
+      uint64_t len = flow_file->getSize();
+      if (transaction->getStream().write(len) != 8) {
+        throw Exception(SITE2SITE_EXCEPTION, "Could not send the content length");
+      }
+      if (len > 0) {
+        ReadCallback callback(&packet);
+        session->read(flow_file, &callback);
+        if (packet._size != len) {
+          throw Exception(SITE2SITE_EXCEPTION, "Could not send the content");
+        }
+      }
+      if (connection.use_compression && connection.peer->finishCompressedWrite() <= 0) {
+        throw Exception(SITE2SITE_EXCEPTION, "Could not send the content");
+      }
+      transaction->current_transfers_++;
+      transaction->total_transfers_++;
+      transaction->_bytes += len;
+
+      std::string transit_uri = connection.peer->getURL() + "/" + flow_file->getUUIDStr();
+      std::string details = "urn:nifi:" + flow_file->getUUIDStr() + "Remote Host=" + connection.peer->getHostName();
+      session->getProvenanceReporter()->send(flow_file, transit_uri, details, getTimeMillis() - start_time, false);
+      session->remove(flow_file);
+
+      if ((connection.batch_count > 0 && transaction->total_transfers_ >= connection.batch_count) || (connection.batch_size > 0 && transaction->_bytes >= connection.batch_size)
+          || getTimeMillis() - batch_start >= batch_duration) {
+        break;
+      }
+      flow_file = std::static_pointer_cast<FlowFileRecord>(session->get());
+    }
+
+    if (writeResponse(connection, FINISH_TRANSACTION, "") <= 0) {
+      throw Exception(SITE2SITE_EXCEPTION, "Could not finish the transaction");
+    }
+    RespondCode code;
+    std::string message;
+    if (readResponse(connection, code, message) <= 0 || code != CONFIRM_TRANSACTION) {
+      throw Exception(SITE2SITE_EXCEPTION, "Client did not confirm the transaction");
+    }
+    int64_t crc_value = transaction->getCRC();
+    if (message != std::to_string(crc_value)) {
+      writeResponse(connection, BAD_CHECKSUM, "");
+      throw Exception(SITE2SITE_EXCEPTION, "Client computed the checksum " + message + ", expected " + std::to_string(crc_value));
+    }
+    if (writeResponse(connection, CONFIRM_TRANSACTION, "CONFIRM_TRANSACTION") <= 0) {
+      throw Exception(SITE2SITE_EXCEPTION, "Could not confirm the transaction");
+    }
+    // the flow files are removed once the client has them
+    if (readResponse(connection, code, message) <= 0 || code != TRANSACTION_FINISHED) {
+      throw Exception(SITE2SITE_EXCEPTION, "Client did not finish the transaction");
+    }
+    session->commit();
+    logging::LOG_INFO(logger_) << "Site2Site server sent " << transaction->total_transfers_ << " flow files, with content size " << transaction->_bytes << " bytes, from port "
+                               << port->name << " to " << connection.peer->getHostName();
+    return true;
+  } catch (std::exception &exception) {
+    logger_->log_warn("Site2Site server could not send flow files to %s: %s", connection.peer->getHostName(), exception.what());
+    session->rollback();
+    return false;
+  }
+}
+
+int SiteToSiteServer::readResponse(Connection &connection, RespondCode &code, std::string &message) {
+  uint8_t first_byte;
+  uint8_t second_byte;
+  uint8_t third_byte;
+  if (connection.peer->read(first_byte) <= 0 || first_byte != CODE_SEQUENCE_VALUE_1 || connection.peer->read(second_byte) <= 0 || second_byte != CODE_SEQUENCE_VALUE_2
+      || connection.peer->read(third_byte) <= 0) {
+    return -1;
+  }
+  code = static_cast<RespondCode>(third_byte);
+  RespondCodeContext *context = getRespondCodeContext(code);
+  if (context == nullptr) {
+    return -1;
+  }
+  if (context->hasDescription && connection.peer->readUTF(message) <= 0) {
+    return -1;
+  }
+  return 3 + message.size();
+}
+
+int SiteToSiteServer::writeResponse(Connection &connection, RespondCode code, const std::string &message) {
+  RespondCodeContext *context = getRespondCodeContext(code);
+  if (context == nullptr) {
+    return -1;
+  }
+  uint8_t code_sequence[3] = { CODE_SEQUENCE_VALUE_1, CODE_SEQUENCE_VALUE_2, static_cast<uint8_t>(code) };
+  if (connection.peer->write(code_sequence, 3) != 3) {
+    return -1;
+  }
+  if (context->hasDescription) {
+    int ret = connection.peer->writeUTF(message);
+    return ret > 0 ? 3 + ret : ret;
+  }
+  return 3;
+}
+
+} /* namespace sitetosite */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
@@ -16,6 +16,8 @@
  * limitations under the License.
  */
 #include "utils/ByteArrayCallback.h"
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <utility>
 #include <string>
@@ -165,6 +167,43 @@ bool ByteOutputCallback::preload_next_str() {
   size_ -= current_str.size();
   return true;
 }
+void HandoffOutputCallback::write(char *data, size_t size) {
+  std::unique_lock<std::recursive_mutex> lock(vector_lock_);
+  if (!is_alive_ || size == 0)
+    return;
+  pending_ = data;
+  size_ = size;
+  total_written_ += size;
+  spinner_.notify_all();
+  spinner_.wait(lock, [&] {
+    return size_ == 0 || !is_alive_;});
+  // the data left once the callback has been closed is dropped
+  pending_ = nullptr;
+  size_ = 0;
+}
+
+size_t HandoffOutputCallback::readFully(char *buffer, size_t size) {
+  std::unique_lock<std::recursive_mutex> lock(vector_lock_);
+  size_t read = 0;
+  while (read < size) {
+    spinner_.wait(lock, [&] {
+      return size_ > 0 || !is_alive_;});
+    if (size_ == 0) {
+      break;
+    }
+    size_t amount = std::min<size_t>(size_, size - read);
+    memcpy(buffer + read, pending_, amount);
+    pending_ += amount;
+    size_ -= amount;
+    total_read_ += amount;
+    read += amount;
+    if (size_ == 0) {
+      spinner_.notify_all();
+    }
+  }
+  return read;
+}
+
 } /* namespace utils */
 } /* namespace minifi */
 } /* namespace nifi */
@@ -0,0 +1,245 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utils/CRC32.h"
+#include <zlib.h>
+#include <climits>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32_PCLMUL
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__AARCH64EL__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32_ARMV8
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace utils {
+
+namespace {
+
+typedef uint32_t (*CRCFunction)(uint32_t crc, const uint8_t *data, size_t length);
+
+uint32_t zlibCRC(uint32_t crc, const uint8_t *data, size_t length) {
+  // zlib takes the length as an unsigned int
+  while (length > 0) {
+    uInt chunk = length > UINT_MAX ? UINT_MAX : static_cast<uInt>(length);
+    crc = static_cast<uint32_t>(crc32(crc, data, chunk));
+    data += chunk;
+    length -= chunk;
+  }
+  return crc;
+}
+
+#ifdef CRC32_PCLMUL
+bool supportsPCLMUL() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return (ecx & bit_PCLMUL) && (ecx & bit_SSE4_1);
+}
+
+/**
+ * Folds a buffer of at least 64 bytes, whose length is a multiple of 16, into the inverted checksum
+ * crc, as described in "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+ * (Gopal et al., Intel, 2009). The constants are those of the bit-reflected CRC-32 polynomial.
+ */
+__attribute__((target("pclmul,sse4.1")))
+uint32_t foldPCLMUL(const uint8_t *data, size_t length, uint32_t crc) {
+  alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+  alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+  alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+  alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+  x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+  x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+  x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+  x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+  data += 64;
+  length -= 64;
+
+  // fold four blocks of 16 bytes at a time
+  while (length >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+    y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+    y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+    y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+    data += 64;
+    length -= 64;
+  }
+
+  // fold the four blocks into one
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  // fold the remaining blocks of 16 bytes
+  while (length >= 16) {
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    data += 16;
+    length -= 16;
+  }
+
+  // fold 128 bits into 64
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+  x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett reduction to 32 bits
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+uint32_t pclmulCRC(uint32_t crc, const uint8_t *data, size_t length) {
+  if (length >= 64) {
+    const size_t folded = length & ~static_cast<size_t>(15);
+    crc = ~foldPCLMUL(data, folded, ~crc);
+    data += folded;
+    length -= folded;
+  }
+  return length > 0 ? zlibCRC(crc, data, length) : crc;
+}
+#endif
+
+#ifdef CRC32_ARMV8
+#if defined(__clang__)
+#define CRC32_ARMV8_TARGET __attribute__((target("crc")))
+#define CRC32_ARMV8_BYTE __builtin_arm_crc32b
+#define CRC32_ARMV8_WORD __builtin_arm_crc32d
+#else
+#define CRC32_ARMV8_TARGET __attribute__((target("+crc")))
+#define CRC32_ARMV8_BYTE __builtin_aarch64_crc32b
+#define CRC32_ARMV8_WORD __builtin_aarch64_crc32x
+#endif
+
+bool supportsARMv8CRC() {
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+CRC32_ARMV8_TARGET
+uint32_t armv8CRC(uint32_t crc, const uint8_t *data, size_t length) {
+  uint32_t value = ~crc;
+  while (length > 0 && (reinterpret_cast<uintptr_t>(data) & 7) != 0) {
+    value = CRC32_ARMV8_BYTE(value, *data++);
+    length--;
+  }
+  while (length >= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    value = CRC32_ARMV8_WORD(value, word);
+    data += 8;
+    length -= 8;
+  }
+  while (length > 0) {
+    value = CRC32_ARMV8_BYTE(value, *data++);
+    length--;
+  }
+  return ~value;
+}
+#endif
+
+struct Implementation {
+  const char *name;
+  CRCFunction function;
+};
+
+Implementation selectImplementation() {
+#ifdef CRC32_PCLMUL
+  if (supportsPCLMUL()) {
+    return {"PCLMULQDQ", pclmulCRC};
+  }
+#endif
+#ifdef CRC32_ARMV8
+  if (supportsARMv8CRC()) {
+    return {"ARMv8 CRC32", armv8CRC};
+  }
+#endif
+  return {"zlib", zlibCRC};
+}
+
+const Implementation &getSelectedImplementation() {
+  static const Implementation implementation = selectImplementation();
+  return implementation;
+}
+
+}  // namespace
+
+uint32_t CRC32::update(uint32_t crc, const uint8_t *data, size_t length) {
+  if (length == 0) {
+    return crc;
+  }
+  return getSelectedImplementation().function(crc, data, length);
+}
+
+const char *CRC32::getImplementation() {
+  return getSelectedImplementation().name;
+}
+
+} /* namespace utils */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
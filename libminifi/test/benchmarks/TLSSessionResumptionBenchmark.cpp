@@ -0,0 +1,143 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <openssl/ssl.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "../TestBase.h"
+#include "controllers/SSLContextService.h"
+#include "io/tls/TLSSocket.h"
+#include "properties/Configure.h"
+
+#define BENCHMARK_CONNECTIONS 200
+
+/**
+ * Local TLS server which answers every connection with the byte it receives.
+ */
+class EchoServer {
+ public:
+  EchoServer()
+      : running_(true),
+        port_(0) {
+    ctx_ = SSL_CTX_new(SSLv23_server_method());
+    SSL_CTX_use_certificate_file(ctx_, "resources/nifi-cert.pem", SSL_FILETYPE_PEM);
+    SSL_CTX_use_PrivateKey_file(ctx_, "resources/nifi-key.pem", SSL_FILETYPE_PEM);
+    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    socklen_t length = sizeof(addr);
+    getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), &length);
+    port_ = ntohs(addr.sin_port);
+    listen(listen_fd_, 16);
+    thread_ = std::thread(&EchoServer::run, this);
+  }
+
+  ~EchoServer() {
+    running_ = false;
+    shutdown(listen_fd_, SHUT_RDWR);
+    thread_.join();
+    close(listen_fd_);
+    SSL_CTX_free(ctx_);
+  }
+
+  uint16_t getPort() const {
+    return port_;
+  }
+
+ private:
+  void run() {
+    while (running_) {
+      int fd = accept(listen_fd_, nullptr, nullptr);
+      if (fd < 0) {
+        break;
+      }
+      SSL *ssl = SSL_new(ctx_);
+      SSL_set_fd(ssl, fd);
+      uint8_t value;
+      if (SSL_accept(ssl) == 1 && SSL_read(ssl, &value, 1) == 1) {
+        SSL_write(ssl, &value, 1);
+        SSL_shutdown(ssl);
+      }
+      SSL_free(ssl);
+      close(fd);
+    }
+  }
+
+  std::atomic<bool> running_;
+  int listen_fd_;
+  uint16_t port_;
+  SSL_CTX *ctx_;
+  std::thread thread_;
+};
+
+/**
+ * Connects, exchanges a byte and disconnects, returning the mean time of a connection in microseconds.
+ */
+double runConnections(const std::shared_ptr<minifi::io::TLSContext> &context, uint16_t port, bool resume) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCHMARK_CONNECTIONS; i++) {
+    if (!resume) {
+      context->removeSession("localhost", port);
+    }
+    minifi::io::TLSSocket socket(context, "localhost", port);
+    REQUIRE(0 == socket.initialize());
+    uint8_t value = 'a';
+    REQUIRE(1 == socket.writeData(&value, 1));
+    value = 0;
+    REQUIRE(1 == socket.readData(&value, 1));
+    REQUIRE('a' == value);
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / BENCHMARK_CONNECTIONS;
+}
+
+TEST_CASE("TLS connections with and without session resumption", "[benchmark]") {
+  TestController testController;
+  signal(SIGPIPE, SIG_IGN);
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_security_client_certificate, "resources/cn.crt.pem");
+  configuration->set(minifi::Configure::nifi_security_client_private_key, "resources/cn.ckey.pem");
+  configuration->set(minifi::Configure::nifi_security_client_ca_certificate, "resources/nifi-cert.pem");
+  auto ssl_service = std::make_shared<minifi::controllers::SSLContextService>("SSLContextService", configuration);
+  ssl_service->onEnable();
+
+  EchoServer server;
+  auto context = std::make_shared<minifi::io::TLSContext>(configuration, ssl_service);
+  REQUIRE(0 == context->initialize());
+
+  double full = runConnections(context, server.getPort(), false);
+  double resumed = runConnections(context, server.getPort(), true);
+  REQUIRE(1 == ssl_service->getSessionCache()->size());
+
+  std::cout << "full handshake (us/connection)\tresumed session (us/connection)" << std::endl;
+  std::cout << static_cast<uint64_t>(full) << "\t" << static_cast<uint64_t>(resumed) << std::endl;
+}
@@ -0,0 +1,178 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../TestBase.h"
+#include "ResourceClaim.h"
+#include "io/AtomicEntryStream.h"
+#include "core/repository/AtomicRepoEntries.h"
+#include "core/repository/VolatileContentRepository.h"
+#include "properties/Configure.h"
+
+#define BENCHMARK_ENTRIES 10000
+#define BENCHMARK_ITERATIONS 20000
+
+typedef core::repository::AtomicEntry<std::shared_ptr<minifi::ResourceClaim>> ClaimEntry;
+typedef minifi::io::AtomicEntryStream<std::shared_ptr<minifi::ResourceClaim>> ClaimStream;
+
+/**
+ * The master list as it was before striping: a single mutex around a std::map, and a linear scan
+ * over every entry to find a free one. Kept here so that the benchmark can be compared against it.
+ */
+class SingleLockMasterList {
+ public:
+  SingleLockMasterList()
+      : current_size_(0),
+        max_size_(1024 * 1024 * 1024) {
+    comparator_ = [](std::shared_ptr<minifi::ResourceClaim> lhs, std::shared_ptr<minifi::ResourceClaim> rhs) {
+      return lhs->getContentFullPath() == rhs->getContentFullPath();
+    };
+    for (int i = 0; i < BENCHMARK_ENTRIES; i++) {
+      entries_.push_back(new ClaimEntry(&current_size_, &max_size_));
+    }
+  }
+
+  ~SingleLockMasterList() {
+    for (auto entry : entries_) {
+      delete entry;
+    }
+  }
+
+  std::shared_ptr<minifi::io::BaseStream> write(const std::shared_ptr<minifi::ResourceClaim> &claim) {
+    for (auto entry : entries_) {
+      if (entry->testAndSetKey(claim, nullptr, nullptr, comparator_)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        master_list_[claim->getContentFullPath()] = entry;
+        return std::make_shared<ClaimStream>(claim, entry);
+      }
+    }
+    return nullptr;
+  }
+
+  std::shared_ptr<minifi::io::BaseStream> read(const std::shared_ptr<minifi::ResourceClaim> &claim) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto entry = master_list_.find(claim->getContentFullPath());
+    if (entry == master_list_.end() || entry->second->takeOwnership() == nullptr) {
+      return nullptr;
+    }
+    return std::make_shared<ClaimStream>(claim, entry->second);
+  }
+
+  bool remove(const std::shared_ptr<minifi::ResourceClaim> &claim) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto entry = master_list_.find(claim->getContentFullPath());
+    if (entry == master_list_.end()) {
+      return false;
+    }
+    auto ptr = entry->second;
+    master_list_.erase(entry);
+    ptr->decrementOwnership();
+    return ptr->freeValue(claim);
+  }
+
+ private:
+  std::atomic<size_t> current_size_;
+  size_t max_size_;
+  std::function<bool(std::shared_ptr<minifi::ResourceClaim>, std::shared_ptr<minifi::ResourceClaim>)> comparator_;
+  std::vector<ClaimEntry*> entries_;
+  std::mutex mutex_;
+  std::map<std::string, ClaimEntry*> master_list_;
+};
+
+/**
+ * Runs write, read and remove cycles on threads, each keeping a backlog of live claims
+ * so that the entry list is partially occupied, and returns the cycles per second.
+ */
+template<typename Repo>
+double runCycles(const std::shared_ptr<Repo> &repo, const std::shared_ptr<core::StreamManager<minifi::ResourceClaim>> &manager, int threads) {
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&repo, &manager, t, threads]() {
+      uint8_t payload[64] = { 0 };
+      uint8_t read_buffer[64];
+      const int backlog = BENCHMARK_ENTRIES / (2 * threads);
+      std::deque<std::shared_ptr<minifi::ResourceClaim>> live;
+      for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        auto claim = std::make_shared<minifi::ResourceClaim>("benchmark/" + std::to_string(t) + "/" + std::to_string(i), manager);
+        auto stream = repo->write(claim);
+        if (stream != nullptr) {
+          stream->writeData(payload, sizeof(payload));
+        }
+        stream = repo->read(claim);
+        if (stream != nullptr) {
+          stream->readData(read_buffer, sizeof(read_buffer));
+        }
+        stream = nullptr;
+        live.push_back(claim);
+        if (live.size() > static_cast<size_t>(backlog)) {
+          repo->remove(live.front());
+          live.pop_front();
+        }
+      }
+      for (const auto &claim : live) {
+        repo->remove(claim);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return (threads * BENCHMARK_ITERATIONS) / elapsed.count();
+}
+
+std::shared_ptr<core::repository::VolatileContentRepository> createRepository(bool minimal_locking) {
+  auto configuration = std::make_shared<minifi::Configure>();
+  std::string options = std::string(minifi::Configure::nifi_volatile_repository_options) + "content.";
+  configuration->set(options + "max.count", std::to_string(BENCHMARK_ENTRIES));
+  configuration->set(options + "max.bytes", std::to_string(1024 * 1024 * 1024));
+  configuration->set(options + core::repository::VolatileContentRepository::minimal_locking, minimal_locking ? "true" : "false");
+  auto repo = std::make_shared<core::repository::VolatileContentRepository>("content");
+  repo->initialize(configuration);
+  return repo;
+}
+
+TEST_CASE("VolatileContentRepository concurrent write/read/remove", "[benchmark]") {
+  TestController testController;
+  std::cout << "threads\tsingle lock (cycles/s)\tstriped (cycles/s)\tstriped, minimal.locking=false (cycles/s)" << std::endl;
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    auto baseline = std::make_shared<SingleLockMasterList>();
+    double single_lock = runCycles(baseline, nullptr, threads);
+
+    auto repo = createRepository(true);
+    double striped = runCycles(repo, repo, threads);
+    repo->stop();
+
+    auto locking_repo = createRepository(false);
+    double striped_locking = runCycles(locking_repo, locking_repo, threads);
+    locking_repo->stop();
+
+    std::cout << threads << "\t" << static_cast<uint64_t>(single_lock) << "\t" << static_cast<uint64_t>(striped) << "\t" << static_cast<uint64_t>(striped_locking) << std::endl;
+    REQUIRE(striped > 0);
+  }
+}
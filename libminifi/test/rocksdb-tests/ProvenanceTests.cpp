@@ -17,16 +17,22 @@
  */
 
 #include "../TestBase.h"
+#include <chrono>
+#include <thread>
 #include <utility>
 #include <memory>
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
+#include <atomic>
 #include "../unit/ProvenanceTestHelper.h"
 #include "provenance/Provenance.h"
 #include "FlowFileRecord.h"
 #include "core/Core.h"
 #include "core/repository/AtomicRepoEntries.h"
 #include "FlowFileRepository.h"
+#include "ProvenanceRepository.h"
 #include "core/repository/VolatileProvenanceRepository.h"
 
 TEST_CASE("Test Provenance record create", "[Testprovenance::ProvenanceEventRecord]") {
@@ -162,3 +168,410 @@ TEST_CASE("Test Provenance record serialization NoOp", "[Testprovenance::Provena
   record2.setEventId(eventId);
   REQUIRE(record2.DeSerialize(testRepository) == false);
 }
+
+std::shared_ptr<provenance::ProvenanceRepository> openProvenanceRepository(const std::string &dir) {
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_provenance_repository_directory_default, dir);
+  auto repository = std::make_shared<provenance::ProvenanceRepository>("prov", dir, 0, 0, 0);
+  REQUIRE(true == repository->initialize(configuration));
+  return repository;
+}
+
+TEST_CASE("Test Provenance queries by flow file, component and type", "[TestProvenanceIndex1]") {
+  TestController testController;
+  char format[] = "/tmp/testProvenance.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  std::shared_ptr<core::Repository> flow_repo = std::make_shared<TestRepository>();
+  std::map<std::string, std::string> attributes;
+  std::shared_ptr<core::FlowFile> first = std::make_shared<minifi::FlowFileRecord>(flow_repo, content_repo, attributes);
+  std::shared_ptr<core::FlowFile> second = std::make_shared<minifi::FlowFileRecord>(flow_repo, content_repo, attributes);
+
+  std::vector<std::string> first_event_ids;
+  {
+    auto repository = openProvenanceRepository(dir);
+    for (int i = 0; i < 10; i++) {
+      provenance::ProvenanceEventRecord event(i % 2 == 0 ? provenance::ProvenanceEventRecord::SEND : provenance::ProvenanceEventRecord::ROUTE, "component" + std::to_string(i % 3), "type");
+      event.fromFlowFile(i < 5 ? first : second);
+      REQUIRE(event.Serialize(repository));
+      if (i < 5) {
+        first_event_ids.push_back(event.getEventId());
+      }
+    }
+  }
+
+  // the sequence continues where it left off after reopening, keeping events in storage order
+  auto repository = openProvenanceRepository(dir);
+  provenance::ProvenanceEventRecord later(provenance::ProvenanceEventRecord::DROP, "component0", "type");
+  later.fromFlowFile(first);
+  REQUIRE(later.Serialize(repository));
+  first_event_ids.push_back(later.getEventId());
+
+  std::vector<std::shared_ptr<provenance::ProvenanceEventRecord>> records;
+  std::string cursor;
+  REQUIRE(repository->getEventsForFlowFile(first->getUUIDStr(), records, 4, cursor));
+  REQUIRE(4 == records.size());
+  REQUIRE(false == cursor.empty());
+  REQUIRE(repository->getEventsForFlowFile(first->getUUIDStr(), records, 4, cursor));
+  REQUIRE(6 == records.size());
+  REQUIRE(cursor.empty());
+  for (size_t i = 0; i < records.size(); i++) {
+    REQUIRE(first_event_ids[i] == records[i]->getEventId());
+  }
+
+  records.clear();
+  REQUIRE(repository->getEventsForComponent("component0", records, 100, cursor));
+  // events 0, 3, 6, 9 and the later one
+  REQUIRE(5 == records.size());
+  REQUIRE(cursor.empty());
+
+  records.clear();
+  REQUIRE(repository->getEventsOfType(provenance::ProvenanceEventRecord::SEND, records, 100, cursor));
+  REQUIRE(5 == records.size());
+  for (const auto &record : records) {
+    REQUIRE(provenance::ProvenanceEventRecord::SEND == record->getEventType());
+  }
+
+  records.clear();
+  REQUIRE(repository->getEventsForComponent("component", records, 100, cursor));
+  REQUIRE(records.empty());
+
+  // deleted events disappear from every index
+  repository->Delete(first_event_ids[0]);
+  repository->flush();
+  records.clear();
+  REQUIRE(repository->getEventsForFlowFile(first->getUUIDStr(), records, 100, cursor));
+  REQUIRE(5 == records.size());
+  records.clear();
+  REQUIRE(repository->getEventsOfType(provenance::ProvenanceEventRecord::SEND, records, 100, cursor));
+  REQUIRE(4 == records.size());
+  std::string value;
+  REQUIRE(false == repository->Get(first_event_ids[0], value));
+  REQUIRE(repository->Get(first_event_ids[1], value));
+}
+
+TEST_CASE("Test Provenance queries by time range", "[TestProvenanceIndex2]") {
+  TestController testController;
+  char format[] = "/tmp/testProvenance.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  auto repository = openProvenanceRepository(dir);
+
+  uint64_t begin = getTimeMillis();
+  for (int i = 0; i < 3; i++) {
+    provenance::ProvenanceEventRecord event(provenance::ProvenanceEventRecord::CREATE, "component", "type");
+    REQUIRE(event.Serialize(repository));
+  }
+  uint64_t end = getTimeMillis() + 1;
+
+  std::vector<std::shared_ptr<provenance::ProvenanceEventRecord>> records;
+  std::string cursor;
+  REQUIRE(repository->getEventsInTimeRange(begin, end, records, 2, cursor));
+  REQUIRE(2 == records.size());
+  REQUIRE(repository->getEventsInTimeRange(begin, end, records, 2, cursor));
+  REQUIRE(3 == records.size());
+  REQUIRE(cursor.empty());
+
+  records.clear();
+  REQUIRE(repository->getEventsInTimeRange(end, end + 60000, records, 10, cursor));
+  REQUIRE(records.empty());
+  REQUIRE(repository->getEventsInTimeRange(0, begin, records, 10, cursor));
+  REQUIRE(records.empty());
+}
+
+TEST_CASE("Test Provenance reporter commits a session's events in one write", "[TestProvenanceCommit]") {
+  TestController testController;
+  char format[] = "/tmp/testProvenance.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  std::shared_ptr<core::Repository> flow_repo = std::make_shared<TestRepository>();
+  std::map<std::string, std::string> attributes;
+  std::shared_ptr<core::FlowFile> flow = std::make_shared<minifi::FlowFileRecord>(flow_repo, content_repo, attributes);
+
+  auto repository = openProvenanceRepository(dir);
+  std::vector<std::string> event_ids;
+  {
+    provenance::ProvenanceReporter reporter(repository, "component", "type");
+    for (int i = 0; i < 20; i++) {
+      reporter.modifyAttributes(flow, "detail" + std::to_string(i));
+    }
+    for (auto event : reporter.getEvents()) {
+      event_ids.push_back(event->getEventId());
+    }
+    reporter.commit();
+  }
+
+  REQUIRE(20 == event_ids.size());
+  std::string value;
+  for (const auto &event_id : event_ids) {
+    REQUIRE(repository->Get(event_id, value));
+  }
+  std::vector<std::shared_ptr<provenance::ProvenanceEventRecord>> records;
+  std::string cursor;
+  REQUIRE(repository->getEventsForFlowFile(flow->getUUIDStr(), records, 100, cursor));
+  REQUIRE(20 == records.size());
+  records.clear();
+  REQUIRE(repository->getEventsOfType(provenance::ProvenanceEventRecord::ATTRIBUTES_MODIFIED, records, 100, cursor));
+  REQUIRE(20 == records.size());
+}
+
+TEST_CASE("Test Provenance repository drops expired events", "[TestProvenanceRetention1]") {
+  TestController testController;
+  char format[] = "/tmp/testProvenance.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  std::shared_ptr<core::Repository> flow_repo = std::make_shared<TestRepository>();
+  std::map<std::string, std::string> attributes;
+  std::shared_ptr<core::FlowFile> flow = std::make_shared<minifi::FlowFileRecord>(flow_repo, content_repo, attributes);
+
+  std::vector<std::string> expired_ids;
+  {
+    auto configuration = std::make_shared<minifi::Configure>();
+    configuration->set(minifi::Configure::nifi_provenance_repository_directory_default, dir);
+    auto repository = std::make_shared<provenance::ProvenanceRepository>("prov", dir, 100, 10 * 1024 * 1024, 10);
+    REQUIRE(true == repository->initialize(configuration));
+    for (int i = 0; i < 10; i++) {
+      provenance::ProvenanceEventRecord event(provenance::ProvenanceEventRecord::SEND, "component", "type");
+      event.fromFlowFile(flow);
+      REQUIRE(event.Serialize(repository));
+      expired_ids.push_back(event.getEventId());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    repository->start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    repository->stop();
+
+    std::string value;
+    for (const auto &event_id : expired_ids) {
+      REQUIRE(false == repository->Get(event_id, value));
+    }
+    std::vector<std::shared_ptr<provenance::ProvenanceEventRecord>> records;
+    std::string cursor;
+    REQUIRE(repository->getEventsInTimeRange(0, getTimeMillis(), records, 100, cursor));
+    REQUIRE(records.empty());
+  }
+
+  // sequence numbers are not reused after every event was dropped, so stale index entries
+  // left for compaction never refer to new events
+  auto repository = openProvenanceRepository(dir);
+  provenance::ProvenanceEventRecord event(provenance::ProvenanceEventRecord::RECEIVE, "component", "type");
+  event.fromFlowFile(flow);
+  REQUIRE(event.Serialize(repository));
+  std::vector<std::shared_ptr<provenance::ProvenanceEventRecord>> records;
+  std::string cursor;
+  REQUIRE(repository->getEventsForFlowFile(flow->getUUIDStr(), records, 100, cursor));
+  REQUIRE(1 == records.size());
+  REQUIRE(event.getEventId() == records[0]->getEventId());
+}
+
+// an event whose time is set, as if it had been reported late
+class TimedProvenanceEventRecord : public provenance::ProvenanceEventRecord {
+ public:
+  explicit TimedProvenanceEventRecord(uint64_t event_time)
+      : provenance::ProvenanceEventRecord(provenance::ProvenanceEventRecord::SEND, "component", "type") {
+    _eventTime = event_time;
+  }
+};
+
+TEST_CASE("Test Provenance repository expires events stored out of time order", "[TestProvenanceRetention3]") {
+  TestController testController;
+  char format[] = "/tmp/testProvenance.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_provenance_repository_directory_default, dir);
+  auto repository = std::make_shared<provenance::ProvenanceRepository>("prov", dir, 60000, 10 * 1024 * 1024, 10);
+  REQUIRE(true == repository->initialize(configuration));
+
+  // an unexpired event is stored between two expired ones
+  const uint64_t now = getTimeMillis();
+  TimedProvenanceEventRecord first(now - 120000);
+  TimedProvenanceEventRecord current(now);
+  TimedProvenanceEventRecord last(now - 120000);
+  REQUIRE(first.Serialize(repository));
+  REQUIRE(current.Serialize(repository));
+  REQUIRE(last.Serialize(repository));
+  const uint64_t stored_size = repository->getRepoSize();
+  repository->start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  repository->stop();
+
+  // the events dropped by compaction no longer count towards the size of the repository
+  REQUIRE(repository->getRepoSize() < stored_size);
+  std::string value;
+  REQUIRE(false == repository->Get(first.getEventId(), value));
+  REQUIRE(false == repository->Get(last.getEventId(), value));
+  REQUIRE(repository->Get(current.getEventId(), value));
+  std::vector<std::shared_ptr<provenance::ProvenanceEventRecord>> records;
+  std::string cursor;
+  REQUIRE(repository->getEventsOfType(provenance::ProvenanceEventRecord::SEND, records, 100, cursor));
+  REQUIRE(1 == records.size());
+  REQUIRE(current.getEventId() == records[0]->getEventId());
+}
+
+TEST_CASE("Test Provenance repository drops the oldest events when full", "[TestProvenanceRetention2]") {
+  TestController testController;
+  char format[] = "/tmp/testProvenance.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  std::shared_ptr<core::Repository> flow_repo = std::make_shared<TestRepository>();
+  std::map<std::string, std::string> attributes;
+  std::shared_ptr<core::FlowFile> flow = std::make_shared<minifi::FlowFileRecord>(flow_repo, content_repo, attributes);
+
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_provenance_repository_directory_default, dir);
+  auto repository = std::make_shared<provenance::ProvenanceRepository>("prov", dir, MAX_PROVENANCE_ENTRY_LIFE_TIME, 10 * 1024, 10);
+  REQUIRE(true == repository->initialize(configuration));
+  std::vector<std::string> event_ids;
+  while (repository->getRepoSize() <= 10 * 1024) {
+    provenance::ProvenanceEventRecord event(provenance::ProvenanceEventRecord::SEND, "component", "type");
+    event.fromFlowFile(flow);
+    REQUIRE(event.Serialize(repository));
+    event_ids.push_back(event.getEventId());
+  }
+  repository->start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  repository->stop();
+
+  REQUIRE(repository->getRepoSize() <= 10 * 1024 * 3 / 4);
+  REQUIRE(false == repository->isFull());
+  std::string value;
+  REQUIRE(false == repository->Get(event_ids.front(), value));
+  REQUIRE(repository->Get(event_ids.back(), value));
+}
+
+TEST_CASE("Test Provenance repository reads resume from a cursor", "[TestProvenanceCursor]") {
+  TestController testController;
+  char format[] = "/tmp/testProvenance.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  auto repository = openProvenanceRepository(dir);
+  std::vector<std::string> event_ids;
+  for (int i = 0; i < 5; i++) {
+    provenance::ProvenanceEventRecord event(provenance::ProvenanceEventRecord::SEND, "component", "type");
+    REQUIRE(event.Serialize(repository));
+    event_ids.push_back(event.getEventId());
+  }
+
+  std::function<std::shared_ptr<core::SerializableComponent>()> constructor = []() {return std::make_shared<provenance::ProvenanceEventRecord>();};
+  std::shared_ptr<core::Repository> repo = repository;
+  std::vector<std::shared_ptr<core::SerializableComponent>> records;
+  std::string cursor;
+  size_t max_size = 3;
+  REQUIRE(repo->DeSerialize(records, max_size, constructor, cursor));
+  REQUIRE(3 == max_size);
+
+  // events stored after the first read are picked up by the next one
+  provenance::ProvenanceEventRecord later(provenance::ProvenanceEventRecord::SEND, "component", "type");
+  REQUIRE(later.Serialize(repository));
+  event_ids.push_back(later.getEventId());
+  max_size = 10;
+  REQUIRE(repo->DeSerialize(records, max_size, constructor, cursor));
+  REQUIRE(3 == max_size);
+  REQUIRE(6 == records.size());
+  for (size_t i = 0; i < records.size(); i++) {
+    REQUIRE(event_ids[i] == std::static_pointer_cast<provenance::ProvenanceEventRecord>(records[i])->getEventId());
+  }
+
+  max_size = 10;
+  REQUIRE(false == repo->DeSerialize(records, max_size, constructor, cursor));
+  REQUIRE(0 == max_size);
+
+  // reported events are deleted by their ids
+  repo->Delete(records);
+  repository->flush();
+  std::string value;
+  REQUIRE(false == repository->Get(event_ids[0], value));
+}
+
+TEST_CASE("Test Provenance repository migrates events keyed by their id", "[TestProvenanceMigration]") {
+  TestController testController;
+  char format[] = "/tmp/testProvenance.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  std::shared_ptr<core::Repository> flow_repo = std::make_shared<TestRepository>();
+  std::map<std::string, std::string> attributes;
+  std::shared_ptr<core::FlowFile> flow = std::make_shared<minifi::FlowFileRecord>(flow_repo, content_repo, attributes);
+
+  // earlier versions stored each event under its id in the default column family
+  std::shared_ptr<TestRepository> serialized = std::make_shared<TestRepository>();
+  for (int i = 0; i < 3; i++) {
+    provenance::ProvenanceEventRecord event(provenance::ProvenanceEventRecord::SEND, "component", "type");
+    event.fromFlowFile(flow);
+    REQUIRE(event.Serialize(serialized));
+  }
+  {
+    rocksdb::Options options;
+    options.create_if_missing = true;
+    rocksdb::DB *db = nullptr;
+    REQUIRE(rocksdb::DB::Open(options, dir, &db).ok());
+    for (const auto &entry : serialized->getRepoMap()) {
+      REQUIRE(db->Put(rocksdb::WriteOptions(), entry.first, entry.second).ok());
+    }
+    REQUIRE(db->Put(rocksdb::WriteOptions(), "unreadable", "event").ok());
+    delete db;
+  }
+
+  auto repository = openProvenanceRepository(dir);
+  std::string value;
+  for (const auto &entry : serialized->getRepoMap()) {
+    REQUIRE(repository->Get(entry.first, value));
+    REQUIRE(entry.second == value);
+  }
+  std::vector<std::shared_ptr<provenance::ProvenanceEventRecord>> records;
+  std::string cursor;
+  REQUIRE(repository->getEventsForFlowFile(flow->getUUIDStr(), records, 100, cursor));
+  REQUIRE(3 == records.size());
+
+  // only sequence keys remain, and new events follow the migrated ones
+  provenance::ProvenanceEventRecord later(provenance::ProvenanceEventRecord::DROP, "component", "type");
+  later.fromFlowFile(flow);
+  REQUIRE(later.Serialize(repository));
+  std::function<std::shared_ptr<core::SerializableComponent>()> constructor = []() {return std::make_shared<provenance::ProvenanceEventRecord>();};
+  std::vector<std::shared_ptr<core::SerializableComponent>> stored;
+  size_t max_size = 10;
+  REQUIRE(repository->DeSerialize(stored, max_size, constructor, cursor));
+  REQUIRE(4 == max_size);
+  REQUIRE(later.getEventId() == std::static_pointer_cast<provenance::ProvenanceEventRecord>(stored.back())->getEventId());
+}
+
+TEST_CASE("Test Provenance cursor reads miss no event stored concurrently", "[TestProvenanceCursor2]") {
+  TestController testController;
+  char format[] = "/tmp/testProvenance.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  auto repository = openProvenanceRepository(dir);
+
+  std::atomic<int> running_writers(4);
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 4; i++) {
+    writers.push_back(std::thread([&repository, &running_writers]() {
+      for (int j = 0; j < 200; j++) {
+        provenance::ProvenanceEventRecord event(provenance::ProvenanceEventRecord::SEND, "component", "type");
+        event.Serialize(repository);
+      }
+      running_writers--;
+    }));
+  }
+
+  std::function<std::shared_ptr<core::SerializableComponent>()> constructor = []() {return std::make_shared<provenance::ProvenanceEventRecord>();};
+  std::shared_ptr<core::Repository> repo = repository;
+  std::vector<std::shared_ptr<core::SerializableComponent>> records;
+  std::string cursor;
+  bool done = false;
+  while (!done) {
+    // one more read once every writer finished picks up the remaining events
+    done = running_writers == 0;
+    size_t max_size;
+    do {
+      max_size = 50;
+      repo->DeSerialize(records, max_size, constructor, cursor);
+    } while (max_size == 50);
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  std::set<std::string> event_ids;
+  for (const auto &record : records) {
+    event_ids.insert(std::static_pointer_cast<provenance::ProvenanceEventRecord>(record)->getEventId());
+  }
+  REQUIRE(800 == records.size());
+  REQUIRE(800 == event_ids.size());
+}
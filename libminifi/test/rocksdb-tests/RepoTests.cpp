@@ -21,6 +21,7 @@
 #include <chrono>
 #include <thread>
 #include <map>
+#include <sys/stat.h>
 #include "../unit/ProvenanceTestHelper.h"
 #include "provenance/Provenance.h"
 #include "FlowFileRecord.h"
@@ -179,6 +180,64 @@ TEST_CASE("Test Delete Content ", "[TestFFR4]") {
   LogTestController::getInstance().reset();
 }
 
+TEST_CASE("Test Delete Content With Claim ", "[TestFFR6]") {
+  TestController testController;
+  char format[] = "/tmp/testRepo.XXXXXX";
+  LogTestController::getInstance().setDebug<core::ContentRepository>();
+  LogTestController::getInstance().setDebug<core::repository::FileSystemRepository>();
+  LogTestController::getInstance().setDebug<core::repository::FlowFileRepository>();
+
+  char *dir = testController.createTempDirectory(format);
+
+  std::shared_ptr<core::repository::FlowFileRepository> repository = std::make_shared<core::repository::FlowFileRepository>("ff", dir, 0, 0, 1);
+
+  std::map<std::string, std::string> attributes;
+
+  std::fstream file;
+  std::stringstream ss;
+  ss << dir << "/" << "tstFile.ext";
+  file.open(ss.str(), std::ios::out);
+  file << "tempFile";
+  file.close();
+
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::FileSystemRepository>();
+
+  repository->initialize(std::make_shared<minifi::Configure>());
+
+  repository->loadComponent(content_repo);
+
+  std::shared_ptr<minifi::ResourceClaim> claim = std::make_shared<minifi::ResourceClaim>(ss.str(), content_repo);
+
+  minifi::FlowFileRecord record(repository, content_repo, attributes, claim);
+
+  record.addAttribute("keyA", "hasdgasdgjsdgasgdsgsadaskgasd");
+
+  REQUIRE(true == record.Serialize());
+  REQUIRE(record.getStoredSize() > 0);
+  REQUIRE(record.getStoredSize() == repository->getRepoSize());
+
+  claim->decreaseFlowFileRecordOwnedCount();
+
+  claim->decreaseFlowFileRecordOwnedCount();
+
+  repository->Delete(record.getUUIDStr(), claim, record.getStoredSize());
+
+  repository->flush();
+
+  std::string value;
+  REQUIRE(false == repository->Get(record.getUUIDStr(), value));
+  REQUIRE(0 == repository->getRepoSize());
+
+  repository->stop();
+
+  std::ifstream fileopen(ss.str());
+  REQUIRE(false == fileopen.good());
+
+  utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY, true);
+
+  LogTestController::getInstance().reset();
+}
+
 TEST_CASE("Test Validate Checkpoint ", "[TestFFR5]") {
   TestController testController;
   utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY, true);
@@ -242,3 +301,100 @@ TEST_CASE("Test Validate Checkpoint ", "[TestFFR5]") {
   LogTestController::getInstance().reset();
 }
 
+
+TEST_CASE("Test Recovery Into Connections ", "[TestFFR7]") {
+  TestController testController;
+  utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY, true);
+  char format[] = "/tmp/testRepo.XXXXXX";
+  LogTestController::getInstance().setDebug<core::repository::FlowFileRepository>();
+
+  char *dir = testController.createTempDirectory(format);
+
+  std::shared_ptr<core::repository::FlowFileRepository> repository = std::make_shared<core::repository::FlowFileRepository>("ff", dir, 0, 0, 1);
+
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_flowfile_repository_recovery_threads, "4");
+  repository->initialize(configuration);
+
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+
+  std::shared_ptr<minifi::Connection> connection = std::make_shared<minifi::Connection>(repository, content_repo, "recovered");
+  std::map<std::string, std::string> attributes;
+  for (int i = 0; i < 100; i++) {
+    minifi::FlowFileRecord record(repository, content_repo, attributes);
+    record.setUuidConnection(connection->getUUIDStr());
+    REQUIRE(true == record.Serialize());
+  }
+  // records for connections that no longer exist are dropped
+  minifi::FlowFileRecord orphan(repository, content_repo, attributes);
+  orphan.setUuidConnection("6f2f2c3c-5a1e-11e8-9c2d-fa7ae01bbebc");
+  REQUIRE(true == orphan.Serialize());
+
+  std::map<std::string, std::shared_ptr<core::Connectable>> connectionMap;
+  connectionMap[connection->getUUIDStr()] = connection;
+  repository->setConnectionMap(connectionMap);
+  repository->loadComponent(content_repo);
+  repository->start();
+
+  for (int i = 0; i < 100 && connection->getQueueSize() < 100; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  repository->stop();
+
+  REQUIRE(100 == connection->getQueueSize());
+  std::string value;
+  REQUIRE(false == repository->Get(orphan.getUUIDStr(), value));
+
+  utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY, true);
+
+  LogTestController::getInstance().reset();
+}
+
+TEST_CASE("Test Recovery From Startup Snapshot", "[TestFFR8]") {
+  TestController testController;
+  utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY, true);
+  char format[] = "/tmp/testRepo.XXXXXX";
+  LogTestController::getInstance().setDebug<core::repository::FlowFileRepository>();
+
+  char *dir = testController.createTempDirectory(format);
+
+  std::shared_ptr<core::repository::FlowFileRepository> repository = std::make_shared<core::repository::FlowFileRepository>("ff", dir, 0, 0, 1);
+
+  repository->initialize(std::make_shared<minifi::Configure>());
+
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+
+  std::shared_ptr<minifi::Connection> connection = std::make_shared<minifi::Connection>(repository, content_repo, "recovered");
+  std::map<std::string, std::string> attributes;
+  for (int i = 0; i < 10; i++) {
+    minifi::FlowFileRecord record(repository, content_repo, attributes);
+    record.setUuidConnection(connection->getUUIDStr());
+    REQUIRE(true == record.Serialize());
+  }
+
+  std::map<std::string, std::shared_ptr<core::Connectable>> connectionMap;
+  connectionMap[connection->getUUIDStr()] = connection;
+  repository->setConnectionMap(connectionMap);
+  // a checkpoint left behind by an earlier version is removed when loading
+  utils::file::FileUtils::create_dir(FLOWFILE_CHECKPOINT_DIRECTORY);
+  repository->loadComponent(content_repo);
+
+  // flow files stored after the repository is loaded are not recovered
+  minifi::FlowFileRecord late(repository, content_repo, attributes);
+  late.setUuidConnection(connection->getUUIDStr());
+  REQUIRE(true == late.Serialize());
+
+  repository->start();
+  for (int i = 0; i < 100 && connection->getQueueSize() < 10; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  repository->stop();
+
+  REQUIRE(10 == connection->getQueueSize());
+  std::string value;
+  REQUIRE(true == repository->Get(late.getUUIDStr(), value));
+  struct stat checkpoint_stat;
+  REQUIRE(0 != stat(FLOWFILE_CHECKPOINT_DIRECTORY, &checkpoint_stat));
+
+  LogTestController::getInstance().reset();
+}
@@ -0,0 +1,100 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../TestBase.h"
+#include <memory>
+#include <string>
+#include "DatabaseContentRepository.h"
+#include "FlowFileRepository.h"
+#include "ProvenanceRepository.h"
+#include "RocksDbResources.h"
+#include "properties/Configure.h"
+
+std::shared_ptr<minifi::Configure> createConfiguration(TestController &testController) {
+  char format[] = "/tmp/testRocksDb.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_flowfile_repository_directory_default, dir + "/flowfile");
+  configuration->set(minifi::Configure::nifi_provenance_repository_directory_default, dir + "/provenance");
+  configuration->set(minifi::Configure::nifi_dbcontent_repository_directory_default, dir + "/content");
+  return configuration;
+}
+
+TEST_CASE("Repositories share one block cache and write buffer budget", "[TestRocksDbResources1]") {
+  TestController testController;
+  auto configuration = createConfiguration(testController);
+  configuration->set(minifi::Configure::nifi_rocksdb_block_cache_size, "4 MB");
+  configuration->set(minifi::Configure::nifi_rocksdb_write_buffer_limit, "2 MB");
+
+  auto flowfile_repo = std::make_shared<core::repository::FlowFileRepository>("ff");
+  REQUIRE(true == flowfile_repo->initialize(configuration));
+  auto provenance_repo = std::make_shared<minifi::provenance::ProvenanceRepository>("prov");
+  REQUIRE(true == provenance_repo->initialize(configuration));
+  auto content_repo = std::make_shared<core::repository::DatabaseContentRepository>();
+  REQUIRE(true == content_repo->initialize(configuration));
+
+  // repositories opened later share what the first one created, whatever their configuration
+  auto resources = core::repository::RocksDbResources::getInstance(nullptr);
+  REQUIRE(4 * 1024 * 1024 == resources->getBlockCacheSize());
+  REQUIRE(4 * 1024 * 1024 == resources->getBlockCache()->GetCapacity());
+  REQUIRE(2 * 1024 * 1024 == resources->getWriteBufferLimit());
+  REQUIRE(2 * 1024 * 1024 == resources->getWriteBufferManager()->buffer_size());
+
+  std::string value(1024, 'x');
+  REQUIRE(true == flowfile_repo->Put("key", reinterpret_cast<const uint8_t*>(value.data()), value.size()));
+  provenance::ProvenanceEventRecord event(provenance::ProvenanceEventRecord::CREATE, "component", "type");
+  event.setDetails(value);
+  REQUIRE(true == event.Serialize(provenance_repo));
+  // memtables of both databases are charged to the shared manager
+  REQUIRE(resources->getWriteBufferManager()->memory_usage() >= 2 * value.size());
+
+  content_repo->stop();
+}
+
+TEST_CASE("Resources are recreated once every repository releases them", "[TestRocksDbResources2]") {
+  TestController testController;
+  auto configuration = createConfiguration(testController);
+  configuration->set(minifi::Configure::nifi_rocksdb_block_cache_size, "1 MB");
+  {
+    auto flowfile_repo = std::make_shared<core::repository::FlowFileRepository>("ff");
+    REQUIRE(true == flowfile_repo->initialize(configuration));
+    REQUIRE(1024 * 1024 == core::repository::RocksDbResources::getInstance(nullptr)->getBlockCacheSize());
+  }
+
+  configuration->set(minifi::Configure::nifi_rocksdb_block_cache_size, "2 MB");
+  auto flowfile_repo = std::make_shared<core::repository::FlowFileRepository>("ff");
+  REQUIRE(true == flowfile_repo->initialize(configuration));
+  auto resources = core::repository::RocksDbResources::getInstance(nullptr);
+  REQUIRE(2 * 1024 * 1024 == resources->getBlockCacheSize());
+  REQUIRE(ROCKSDB_DEFAULT_WRITE_BUFFER_LIMIT == resources->getWriteBufferLimit());
+}
+
+TEST_CASE("Invalid block cache sizes fall back to the default", "[TestRocksDbResources3]") {
+  TestController testController;
+  auto configuration = createConfiguration(testController);
+  configuration->set(minifi::Configure::nifi_rocksdb_block_cache_size, "-1");
+  {
+    auto flowfile_repo = std::make_shared<core::repository::FlowFileRepository>("ff");
+    REQUIRE(true == flowfile_repo->initialize(configuration));
+    REQUIRE(ROCKSDB_DEFAULT_BLOCK_CACHE_SIZE == core::repository::RocksDbResources::getInstance(nullptr)->getBlockCacheSize());
+  }
+
+  configuration->set(minifi::Configure::nifi_rocksdb_block_cache_size, "0");
+  auto flowfile_repo = std::make_shared<core::repository::FlowFileRepository>("ff");
+  REQUIRE(true == flowfile_repo->initialize(configuration));
+  REQUIRE(ROCKSDB_DEFAULT_BLOCK_CACHE_SIZE == core::repository::RocksDbResources::getInstance(nullptr)->getBlockCacheSize());
+}
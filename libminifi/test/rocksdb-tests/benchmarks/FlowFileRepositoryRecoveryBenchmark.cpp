@@ -0,0 +1,103 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include "../../TestBase.h"
+#include "Connection.h"
+#include "FlowFileRecord.h"
+#include "FlowFileRepository.h"
+#include "core/repository/VolatileContentRepository.h"
+#include "properties/Configure.h"
+
+#define BENCHMARK_RECORDS 50000
+#define BENCHMARK_CONNECTIONS 4
+
+std::shared_ptr<core::repository::FlowFileRepository> openRepository(const std::string &dir, const std::string &threads) {
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_flowfile_repository_recovery_threads, threads);
+  auto repository = std::make_shared<core::repository::FlowFileRepository>("ff", dir, 0, 0, 1);
+  REQUIRE(repository->initialize(configuration));
+  return repository;
+}
+
+TEST_CASE("FlowFileRepository recovery rate", "[benchmark]") {
+  TestController testController;
+  utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY, true);
+  char format[] = "/tmp/benchmarkRecovery.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+
+  std::vector<std::string> connection_uuids;
+  {
+    auto repository = openRepository(dir, "1");
+    std::map<std::string, std::string> attributes;
+    attributes["custom.key"] = "custom value";
+    for (int i = 0; i < BENCHMARK_CONNECTIONS; i++) {
+      auto connection = std::make_shared<minifi::Connection>(repository, content_repo, "connection" + std::to_string(i));
+      connection_uuids.push_back(connection->getUUIDStr());
+    }
+    for (int i = 0; i < BENCHMARK_RECORDS; i++) {
+      minifi::FlowFileRecord record(repository, content_repo, attributes);
+      record.setUuidConnection(connection_uuids[i % BENCHMARK_CONNECTIONS]);
+      REQUIRE(record.Serialize());
+    }
+  }
+
+  std::cout << "threads\trecords\tmillis\trecords/s" << std::endl;
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    auto repository = openRepository(dir, std::to_string(threads));
+    std::map<std::string, std::shared_ptr<core::Connectable>> connectionMap;
+    std::vector<std::shared_ptr<minifi::Connection>> connections;
+    for (const auto &uuid_str : connection_uuids) {
+      utils::Identifier uuid;
+      uuid = uuid_str;
+      auto connection = std::make_shared<minifi::Connection>(repository, content_repo, uuid_str, uuid);
+      connections.push_back(connection);
+      connectionMap[uuid_str] = connection;
+    }
+    repository->setConnectionMap(connectionMap);
+    repository->loadComponent(content_repo);
+
+    auto start = std::chrono::steady_clock::now();
+    repository->start();
+    uint64_t recovered = 0;
+    while (recovered < BENCHMARK_RECORDS) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      recovered = 0;
+      for (const auto &connection : connections) {
+        recovered += connection->getQueueSize();
+      }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    repository->stop();
+
+    std::cout << threads << "\t" << recovered << "\t" << elapsed << "\t" << (recovered * 1000 / std::max<int64_t>(elapsed, 1)) << std::endl;
+    REQUIRE(BENCHMARK_RECORDS == recovered);
+    // break the cycle between the repository and the connections so that the database is closed
+    connectionMap.clear();
+    repository->setConnectionMap(connectionMap);
+    connections.clear();
+  }
+
+  utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY, true);
+}
@@ -0,0 +1,121 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../TestBase.h"
+#include "Connection.h"
+#include "FlowFileRecord.h"
+#include "FlowFileRepository.h"
+#include "core/repository/VolatileContentRepository.h"
+#include "core/repository/WriteAheadLogFlowFileRepository.h"
+#include "properties/Configure.h"
+
+#define BENCHMARK_RECORDS 20000
+#define BENCHMARK_THREADS 4
+
+typedef std::function<std::shared_ptr<core::Repository>(const std::string &dir)> RepositoryOpener;
+
+std::shared_ptr<core::Repository> openRocksDb(const std::string &dir) {
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_flowfile_repository_directory_default, dir);
+  auto repository = std::make_shared<core::repository::FlowFileRepository>("ff", dir, 0, 0, 1);
+  REQUIRE(repository->initialize(configuration));
+  return repository;
+}
+
+RepositoryOpener openWriteAheadLog(const std::string &sync) {
+  return [sync](const std::string &dir) {
+    auto configuration = std::make_shared<minifi::Configure>();
+    configuration->set(minifi::Configure::nifi_flowfile_repository_directory_default, dir);
+    configuration->set(minifi::Configure::nifi_flowfile_repository_wal_sync, sync);
+    auto repository = std::make_shared<core::repository::WriteAheadLogFlowFileRepository>("wal", dir, 0, 0, 1);
+    REQUIRE(repository->initialize(configuration));
+    return std::static_pointer_cast<core::Repository>(repository);
+  };
+}
+
+/**
+ * Stores BENCHMARK_RECORDS flow files from BENCHMARK_THREADS threads, then reopens the repository
+ * and recovers them into their connection, printing the rate of each.
+ */
+void benchmark(const std::string &name, const RepositoryOpener &open) {
+  TestController testController;
+  utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY, true);
+  char format[] = "/tmp/benchmarkWAL.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  std::string connection_uuid;
+
+  int64_t commit_millis = 0;
+  {
+    auto repository = open(dir);
+    connection_uuid = std::make_shared<minifi::Connection>(repository, content_repo, "connection")->getUUIDStr();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> writers;
+    for (int t = 0; t < BENCHMARK_THREADS; t++) {
+      writers.emplace_back([repository, content_repo, connection_uuid]() {
+        std::map<std::string, std::string> attributes;
+        attributes["custom.key"] = "custom value";
+        for (int i = 0; i < BENCHMARK_RECORDS / BENCHMARK_THREADS; i++) {
+          minifi::FlowFileRecord record(repository, content_repo, attributes);
+          record.setUuidConnection(connection_uuid);
+          record.Serialize();
+        }
+      });
+    }
+    for (auto &writer : writers) {
+      writer.join();
+    }
+    commit_millis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  auto repository = open(dir);
+  utils::Identifier uuid;
+  uuid = connection_uuid;
+  auto connection = std::make_shared<minifi::Connection>(repository, content_repo, "connection", uuid);
+  std::map<std::string, std::shared_ptr<core::Connectable>> connectionMap;
+  connectionMap[connection_uuid] = connection;
+  repository->setConnectionMap(connectionMap);
+  auto start = std::chrono::steady_clock::now();
+  repository->loadComponent(content_repo);
+  repository->start();
+  while (connection->getQueueSize() < BENCHMARK_RECORDS) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  int64_t recovery_millis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  repository->stop();
+  connectionMap.clear();
+  repository->setConnectionMap(connectionMap);
+
+  std::cout << name << "\t" << (BENCHMARK_RECORDS * 1000 / std::max<int64_t>(commit_millis, 1)) << "\t" << (BENCHMARK_RECORDS * 1000 / std::max<int64_t>(recovery_millis, 1)) << std::endl;
+  utils::file::FileUtils::delete_dir(FLOWFILE_CHECKPOINT_DIRECTORY, true);
+}
+
+TEST_CASE("FlowFile repository commit and recovery rates", "[benchmark]") {
+  std::cout << "repository\tcommits/s\trecovered/s" << std::endl;
+  benchmark("rocksdb", openRocksDb);
+  benchmark("wal", openWriteAheadLog("true"));
+  benchmark("wal-nosync", openWriteAheadLog("false"));
+}
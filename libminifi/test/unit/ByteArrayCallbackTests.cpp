@@ -0,0 +1,69 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils/ByteArrayCallback.h"
+#include "../TestBase.h"
+
+TEST_CASE("HandoffOutputCallbackPassesData", "[handoff]") {
+  std::string data;
+  for (int i = 0; i < 10000; i++) {
+    data += std::to_string(i);
+  }
+
+  minifi::utils::HandoffOutputCallback callback;
+  // the writer hands over chunks that the reads do not line up with
+  std::thread writer([&callback, &data]() {
+    std::vector<char> chunk;
+    for (size_t position = 0; position < data.size(); position += 1000) {
+      chunk.assign(data.begin() + position, data.begin() + std::min(position + 1000, data.size()));
+      callback.write(chunk.data(), chunk.size());
+    }
+    callback.close();
+  });
+
+  std::string received;
+  std::vector<char> buffer(777);
+  size_t read;
+  while ((read = callback.readFully(buffer.data(), buffer.size())) > 0) {
+    received.append(buffer.data(), read);
+  }
+  writer.join();
+
+  REQUIRE(data == received);
+  REQUIRE(0 == callback.getSize());
+}
+
+TEST_CASE("HandoffOutputCallbackCloseReleasesWriter", "[handoff]") {
+  minifi::utils::HandoffOutputCallback callback;
+  std::string data = "never read";
+  std::thread writer([&callback, &data]() {
+    callback.write(&data[0], data.size());
+  });
+
+  // the write blocks until the data is read or the callback is closed
+  std::vector<char> buffer(5);
+  REQUIRE(5 == callback.readFully(buffer.data(), buffer.size()));
+  REQUIRE("never" == std::string(buffer.data(), buffer.size()));
+  callback.close();
+  writer.join();
+
+  REQUIRE(0 == callback.readFully(buffer.data(), buffer.size()));
+}
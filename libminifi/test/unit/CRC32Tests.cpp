@@ -0,0 +1,63 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zlib.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "utils/CRC32.h"
+#include "io/BaseStream.h"
+#include "io/CRCStream.h"
+#include "../TestBase.h"
+
+TEST_CASE("CRC32MatchesZlib", "[CRC32]") {
+  std::mt19937 generator(42);
+  std::vector<uint8_t> data(4096 + 16);
+  for (auto &byte : data) {
+    byte = static_cast<uint8_t>(generator());
+  }
+
+  // every length around the block sizes of the implementations, at unaligned offsets
+  for (size_t offset = 0; offset < 16; offset += 3) {
+    for (size_t length = 0; length <= 4096; length += (length < 300 ? 1 : 61)) {
+      const uint8_t *buffer = data.data() + offset;
+      uint32_t expected = crc32(0L, buffer, length);
+      REQUIRE(expected == minifi::utils::CRC32::update(0, buffer, length));
+
+      // updating in parts gives the same checksum
+      size_t split = length / 3;
+      uint32_t crc = minifi::utils::CRC32::update(0, buffer, split);
+      REQUIRE(expected == minifi::utils::CRC32::update(crc, buffer + split, length - split));
+    }
+  }
+
+  std::string check = "123456789";
+  REQUIRE(0xCBF43926 == minifi::utils::CRC32::update(0, reinterpret_cast<const uint8_t*>(check.data()), check.size()));
+  REQUIRE(std::string(minifi::utils::CRC32::getImplementation()).length() > 0);
+}
+
+TEST_CASE("CRCStreamMatchesZlib", "[CRC32]") {
+  std::vector<uint8_t> data(1000, 'a');
+  minifi::io::BaseStream base;
+  minifi::io::CRCStream<minifi::io::BaseStream> stream(&base);
+  stream.writeData(data.data(), data.size());
+  REQUIRE(crc32(0L, data.data(), data.size()) == stream.getCRC());
+
+  stream.reset();
+  REQUIRE(0 == stream.getCRC());
+}
@@ -0,0 +1,125 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+#include "../TestBase.h"
+#include "FlowFileRecord.h"
+#include "ResourceClaim.h"
+#include "core/repository/FileSystemRepository.h"
+#include "io/DataStream.h"
+#include "properties/Configure.h"
+
+std::shared_ptr<core::ContentRepository> createContentRepository(TestController &testController) {
+  char format[] = "/tmp/testRecord.XXXXXX";
+  char *dir = testController.createTempDirectory(format);
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_dbcontent_repository_directory_default, dir);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::FileSystemRepository>();
+  REQUIRE(true == content_repo->initialize(configuration));
+  return content_repo;
+}
+
+TEST_CASE("Compact records round trip", "[TestFlowFileRecord1]") {
+  TestController testController;
+  auto content_repo = createContentRepository(testController);
+
+  auto claim = std::make_shared<minifi::ResourceClaim>(content_repo);
+  std::map<std::string, std::string> attributes;
+  attributes["custom.key"] = "custom value";
+  attributes["mime.type"] = "text/plain";
+  attributes["empty"] = "";
+  minifi::FlowFileRecord record(nullptr, content_repo, attributes, claim);
+  record.setUuidConnection("6f2f2c3c-5a1e-11e8-9c2d-fa7ae01bbebc");
+  record.setSize(1024);
+  record.setOffset(12);
+
+  minifi::io::DataStream stream;
+  REQUIRE(record.Serialize(stream));
+  REQUIRE(FLOWFILE_RECORD_COMPACT_MARKER == stream.getBuffer()[0]);
+  // both uuids are binary and the content path is reduced to the claim id
+  REQUIRE(std::string::npos == std::string(reinterpret_cast<const char*>(stream.getBuffer()), stream.getSize()).find(content_repo->getStoragePath()));
+
+  minifi::FlowFileRecord copy(nullptr, content_repo);
+  REQUIRE(copy.DeSerialize(stream));
+  REQUIRE(record.getUUIDStr() == copy.getUUIDStr());
+  REQUIRE("6f2f2c3c-5a1e-11e8-9c2d-fa7ae01bbebc" == copy.getConnectionUuid());
+  REQUIRE(record.getEventTime() == copy.getEventTime());
+  REQUIRE(record.getEntryDate() == copy.getEntryDate());
+  REQUIRE(record.getlineageStartDate() == copy.getlineageStartDate());
+  REQUIRE(record.getAttributes() == copy.getAttributes());
+  REQUIRE(claim->getContentFullPath() == copy.getContentFullPath());
+  REQUIRE(claim->getContentFullPath() == copy.getResourceClaim()->getContentFullPath());
+  REQUIRE(1024 == copy.getSize());
+  REQUIRE(12 == copy.getOffset());
+}
+
+TEST_CASE("Compact records keep values that are not uuids", "[TestFlowFileRecord2]") {
+  TestController testController;
+  auto content_repo = createContentRepository(testController);
+
+  std::map<std::string, std::string> attributes;
+  minifi::FlowFileRecord record(nullptr, content_repo, attributes);
+  record.setUuidConnection("not a uuid");
+
+  minifi::io::DataStream stream;
+  REQUIRE(record.Serialize(stream));
+
+  minifi::FlowFileRecord copy(nullptr, content_repo);
+  REQUIRE(copy.DeSerialize(stream));
+  REQUIRE(record.getUUIDStr() == copy.getUUIDStr());
+  REQUIRE("not a uuid" == copy.getConnectionUuid());
+  REQUIRE(copy.getContentFullPath().empty());
+}
+
+TEST_CASE("Records in the original format are still read", "[TestFlowFileRecord3]") {
+  TestController testController;
+  auto content_repo = createContentRepository(testController);
+
+  minifi::io::DataStream stream;
+  minifi::io::Serializable ser;
+  ser.write(static_cast<uint64_t>(1526054400123), &stream);
+  ser.write(static_cast<uint64_t>(1526054400100), &stream);
+  ser.write(static_cast<uint64_t>(1526054400000), &stream);
+  ser.writeUTF("9a4c4a8e-5a1e-11e8-9c2d-fa7ae01bbebc", &stream);
+  ser.writeUTF("6f2f2c3c-5a1e-11e8-9c2d-fa7ae01bbebc", &stream);
+  ser.write(static_cast<uint32_t>(2), &stream);
+  ser.writeUTF("filename", &stream, true);
+  ser.writeUTF("file.txt", &stream, true);
+  ser.writeUTF("custom.key", &stream, true);
+  ser.writeUTF("", &stream, true);
+  ser.writeUTF("/var/content/1526054400000-1", &stream);
+  ser.write(static_cast<uint64_t>(512), &stream);
+  ser.write(static_cast<uint64_t>(0), &stream);
+
+  minifi::FlowFileRecord record(nullptr, content_repo);
+  REQUIRE(record.DeSerialize(stream));
+  REQUIRE("9a4c4a8e-5a1e-11e8-9c2d-fa7ae01bbebc" == record.getUUIDStr());
+  REQUIRE("6f2f2c3c-5a1e-11e8-9c2d-fa7ae01bbebc" == record.getConnectionUuid());
+  REQUIRE(1526054400123 == record.getEventTime());
+  REQUIRE(1526054400100 == record.getEntryDate());
+  REQUIRE(1526054400000 == record.getlineageStartDate());
+  std::string value;
+  REQUIRE(record.getAttribute("filename", value));
+  REQUIRE("file.txt" == value);
+  REQUIRE(record.getAttribute("custom.key", value));
+  REQUIRE("" == value);
+  REQUIRE("/var/content/1526054400000-1" == record.getContentFullPath());
+  REQUIRE(512 == record.getSize());
+}
@@ -46,10 +46,12 @@ const char* TEST_FILE = "test_file.txt";
 const char* MD5_ATTR = "MD5Attr";
 const char* SHA1_ATTR = "SHA1Attr";
 const char* SHA256_ATTR = "SHA256Attr";
+const char* CRC32_ATTR = "CRC32Attr";
 
 const char* MD5_CHECKSUM = "4FE8A693C64F93F65C5FAF42DC49AB23";
 const char* SHA1_CHECKSUM = "03840DEB949D6CF0C0A624FA7EBA87FBDBCB7783";
 const char* SHA256_CHECKSUM = "66D5B2CC06203137F8A0E9714638DC1085C57A3F1FA26C8823AE5CF89AB26488";
+const char* CRC32_CHECKSUM = "891BC0E8";
 
 
 TEST_CASE("Test Creation of HashContent", "[HashContentCreate]") {
@@ -90,6 +92,11 @@ TEST_CASE("Test usage of ExtractText", "[extracttextTest]") {
   plan->setProperty(sha2processor, org::apache::nifi::minifi::processors::HashContent::HashAttribute.getName(), SHA256_ATTR);
   plan->setProperty(sha2processor, org::apache::nifi::minifi::processors::HashContent::HashAlgorithm.getName(), "sha-256");
 
+  std::shared_ptr<core::Processor> crcprocessor = plan->addProcessor("HashContent", "HashContentCRC32",
+                                                                    core::Relationship("success", "description"), true);
+  plan->setProperty(crcprocessor, org::apache::nifi::minifi::processors::HashContent::HashAttribute.getName(), CRC32_ATTR);
+  plan->setProperty(crcprocessor, org::apache::nifi::minifi::processors::HashContent::HashAlgorithm.getName(), "crc32");
+
   std::shared_ptr<core::Processor> laprocessor = plan->addProcessor("LogAttribute", "outputLogAttribute",
                                                                     core::Relationship("success", "description"), true);
 
@@ -103,7 +110,7 @@ TEST_CASE("Test usage of ExtractText", "[extracttextTest]") {
     test_file.close();
   }
 
-  for (int i = 0; i < 5; ++i) {
+  for (int i = 0; i < 6; ++i) {
     plan->runNextProcessor();
   }
 
@@ -124,6 +131,12 @@ TEST_CASE("Test usage of ExtractText", "[extracttextTest]") {
   log_check = ss2.str();
 
   REQUIRE(LogTestController::getInstance().contains(log_check));
+
+  ss2.str("");
+  ss2 << "key:" << CRC32_ATTR << " value:" << CRC32_CHECKSUM;
+  log_check = ss2.str();
+
+  REQUIRE(LogTestController::getInstance().contains(log_check));
 }
 
 #endif  // OPENSSL_SUPPORT
@@ -0,0 +1,78 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "sitetosite/Peer.h"
+#include "sitetosite/PeerSelector.h"
+#include "../TestBase.h"
+
+namespace {
+
+std::vector<minifi::sitetosite::PeerStatus> createPeers(uint32_t first_count, uint32_t second_count) {
+  std::vector<minifi::sitetosite::PeerStatus> peers;
+  peers.emplace_back(std::make_shared<minifi::sitetosite::Peer>("host1", 8081), first_count, false);
+  peers.emplace_back(std::make_shared<minifi::sitetosite::Peer>("host2", 8081), second_count, false);
+  return peers;
+}
+
+}  // namespace
+
+TEST_CASE("PeerSelectorWeightsByFlowFiles", "[PeerSelector1]") {
+  minifi::sitetosite::PeerSelector selector;
+
+  selector.setPeers(createPeers(100, 900), minifi::sitetosite::SEND);
+  REQUIRE(selector.getEntries("host1", 8081) > selector.getEntries("host2", 8081));
+
+  selector.setPeers(createPeers(100, 900), minifi::sitetosite::RECEIVE);
+  REQUIRE(selector.getEntries("host1", 8081) < selector.getEntries("host2", 8081));
+
+  // without any queued flow files the peers are weighted equally
+  selector.setPeers(createPeers(0, 0), minifi::sitetosite::SEND);
+  REQUIRE(selector.getEntries("host1", 8081) == selector.getEntries("host2", 8081));
+
+  // even a peer holding all of the flow files keeps an entry
+  selector.setPeers(createPeers(0, 1000), minifi::sitetosite::SEND);
+  REQUIRE(selector.getEntries("host2", 8081) > 0);
+}
+
+TEST_CASE("PeerSelectorSkipsPenalizedPeers", "[PeerSelector2]") {
+  minifi::sitetosite::PeerSelector selector;
+  REQUIRE(nullptr == selector.getNextPeer());
+
+  selector.setPeers(createPeers(500, 500), minifi::sitetosite::SEND);
+  std::set<std::string> hosts;
+  for (int i = 0; i < PEER_SELECTOR_DESTINATIONS; i++) {
+    hosts.insert(selector.getNextPeer()->getHost());
+  }
+  REQUIRE(2 == hosts.size());
+
+  selector.penalize("host1", 8081, 60000);
+  for (int i = 0; i < PEER_SELECTOR_DESTINATIONS; i++) {
+    REQUIRE("host2" == selector.getNextPeer()->getHost());
+  }
+
+  selector.penalize("host2", 8081, 60000);
+  REQUIRE(nullptr == selector.getNextPeer());
+
+  // an expired penalty no longer applies
+  selector.penalize("host1", 8081, 0);
+  REQUIRE("host1" == selector.getNextPeer()->getHost());
+}
@@ -22,6 +22,8 @@
 #include <vector>
 #include <set>
 #include <fstream>
+#include <map>
+#include <algorithm>
 
 #include "../TestBase.h"
 #include "processors/LogAttribute.h"
@@ -34,6 +36,9 @@
 #include "core/ProcessSession.h"
 #include "core/ProcessorNode.h"
 #include "core/reporting/SiteToSiteProvenanceReportingTask.h"
+#include "RemoteProcessorGroupPort.h"
+#include "sitetosite/SiteToSiteClient.h"
+#include "sitetosite/SiteToSiteFactory.h"
 
 TEST_CASE("Test Creation of GetFile", "[getfileCreate]") {
   TestController testController;
@@ -324,12 +329,48 @@ TEST_CASE("Test Find file", "[getfileCreate3]") {
         taskReport->getJsonReport(context, session, recordsReport, jsonStr);
         REQUIRE(recordsReport.size() == 1);
         REQUIRE(taskReport->getName() == std::string(org::apache::nifi::minifi::core::reporting::SiteToSiteProvenanceReportingTask::ReportTaskName));
-        REQUIRE(jsonStr.find("\"componentType\": \"getfileCreate2\"") != std::string::npos);
+        REQUIRE(jsonStr.find("\"componentType\":\"getfileCreate2\"") != std::string::npos);
       };
 
   testController.runSession(plan, false, verifyReporter);
 }
 
+TEST_CASE("Test provenance reports are split by size", "[provenanceReportSplit]") {
+  TestController testController;
+  auto taskReport = std::make_shared<org::apache::nifi::minifi::core::reporting::SiteToSiteProvenanceReportingTask>(
+      minifi::io::StreamFactory::getInstance(std::make_shared<org::apache::nifi::minifi::Configure>()), std::make_shared<org::apache::nifi::minifi::Configure>());
+  std::vector<std::shared_ptr<core::SerializableComponent>> records;
+  for (int i = 0; i < 10; i++) {
+    auto record = std::make_shared<provenance::ProvenanceEventRecord>(provenance::ProvenanceEventRecord::SEND, "component", "type");
+    record->setDetails("details " + std::to_string(i));
+    records.push_back(record);
+  }
+
+  std::string report;
+  REQUIRE(10 == taskReport->writeJsonReport(records, 0, report));
+  size_t record_size = report.size() / 10;
+
+  // each report holds as many records as fit, and at least one
+  taskReport->setMaxReportSize(record_size * 3);
+  size_t next = 0;
+  int reports = 0;
+  while (next < records.size()) {
+    size_t begin = next;
+    next = taskReport->writeJsonReport(records, begin, report);
+    REQUIRE(next > begin);
+    REQUIRE(report.front() == '[');
+    REQUIRE(report.back() == ']');
+    REQUIRE(report.find("\"details\":\"details " + std::to_string(begin) + "\"") != std::string::npos);
+    REQUIRE(report.find('\n') == std::string::npos);
+    reports++;
+  }
+  REQUIRE(reports > 1);
+  REQUIRE(reports < 10);
+
+  taskReport->setMaxReportSize(1);
+  REQUIRE(5 == taskReport->writeJsonReport(records, 4, report));
+}
+
 class TestProcessorNoContent : public minifi::core::Processor {
  public:
   explicit TestProcessorNoContent(std::string name, utils::Identifier uuid = NULL)
@@ -449,6 +490,167 @@ TEST_CASE("TestRPGValid", "[TestRPG6]") {
   testRPGBypass("", "8080", "8080", false);
 }
 
+/**
+ * Sends one flow file per transaction, and fails the confirmation of one transaction.
+ */
+class ConfirmFailingSiteToSiteClient : public minifi::sitetosite::SiteToSiteClient {
+ public:
+  struct Transfers {
+    int started = 0;
+    int finished = 0;
+    int in_flight = 0;
+    int max_in_flight = 0;
+    int failing_confirm = 0;
+    std::string failed_flow_file;
+    std::map<std::string, std::string> flow_files;
+  };
+
+  explicit ConfirmFailingSiteToSiteClient(const std::shared_ptr<Transfers> &transfers)
+      : transfers_(transfers) {
+  }
+
+  virtual bool startTransferFlowFiles(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, std::string &transactionID) {
+    std::shared_ptr<core::FlowFile> flow = session->get();
+    if (flow == nullptr) {
+      return false;
+    }
+    session->remove(flow);
+    transactionID = std::to_string(++transfers_->started);
+    transfers_->flow_files[transactionID] = flow->getUUIDStr();
+    transfers_->max_in_flight = std::max(transfers_->max_in_flight, ++transfers_->in_flight);
+    return true;
+  }
+
+  virtual bool finishTransferFlowFiles(const std::shared_ptr<core::ProcessContext> &context, const std::string &transactionID) {
+    transfers_->in_flight--;
+    if (++transfers_->finished == transfers_->failing_confirm) {
+      transfers_->failed_flow_file = transfers_->flow_files[transactionID];
+      throw minifi::Exception(minifi::SITE2SITE_EXCEPTION, "Confirm Failed for " + transactionID);
+    }
+    return true;
+  }
+
+  virtual bool transmitPayload(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, const std::string &payload,
+                               std::map<std::string, std::string> attributes) {
+    return false;
+  }
+
+  virtual std::shared_ptr<minifi::sitetosite::Transaction> createTransaction(std::string &transactionID, minifi::sitetosite::TransferDirection direction) {
+    return nullptr;
+  }
+
+  virtual bool getPeerList(std::vector<minifi::sitetosite::PeerStatus> &peers) {
+    return false;
+  }
+
+  virtual bool establish() {
+    return true;
+  }
+
+ private:
+  std::shared_ptr<Transfers> transfers_;
+};
+
+class PipelinedRemoteProcessorGroupPort : public minifi::RemoteProcessorGroupPort {
+ public:
+  PipelinedRemoteProcessorGroupPort(const std::shared_ptr<minifi::io::StreamFactory> &stream_factory, const std::shared_ptr<minifi::Configure> &configure)
+      : minifi::RemoteProcessorGroupPort(stream_factory, "rpg", "http://localhost:8989/nifi", configure) {
+  }
+
+  void addProtocol(std::unique_ptr<minifi::sitetosite::SiteToSiteClient> protocol) {
+    available_protocols_.enqueue(std::move(protocol));
+  }
+
+  void transfer(const std::shared_ptr<core::ProcessContext> &context, uint32_t max_in_flight_transactions) {
+    max_in_flight_transactions_ = max_in_flight_transactions;
+    transferPipelined(context);
+  }
+
+  // replaces the peers as a successful refresh does
+  void refreshPeers(std::vector<minifi::sitetosite::PeerStatus> &peers) {
+    std::lock_guard<std::mutex> lock(peer_mutex_);
+    peers_.swap(peers);
+    retainListedProtocols();
+  }
+
+  std::unique_ptr<minifi::sitetosite::SiteToSiteClient> takeProtocol() {
+    return getNextProtocol(false);
+  }
+};
+
+TEST_CASE("TestRPGPipelinedConfirmFailure", "[TestRPG7]") {
+  TestController testController;
+  auto configuration = std::make_shared<org::apache::nifi::minifi::Configure>();
+  auto factory = minifi::io::StreamFactory::getInstance(configuration);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  std::shared_ptr<core::Repository> test_repo = std::make_shared<TestRepository>();
+  std::shared_ptr<TestRepository> repo = std::static_pointer_cast<TestRepository>(test_repo);
+
+  auto rpg = std::make_shared<PipelinedRemoteProcessorGroupPort>(factory, configuration);
+  utils::Identifier rpg_uuid;
+  rpg->getUUID(rpg_uuid);
+  std::shared_ptr<minifi::Connection> connection = std::make_shared<minifi::Connection>(test_repo, content_repo, "rpgConnection");
+  connection->setDestination(rpg);
+  connection->setDestinationUUID(rpg_uuid);
+  rpg->addConnection(connection);
+  std::map<std::string, std::string> attributes;
+  for (int i = 0; i < 6; i++) {
+    std::shared_ptr<core::FlowFile> flow = std::make_shared<minifi::FlowFileRecord>(test_repo, content_repo, attributes);
+    connection->put(flow);
+  }
+
+  // more connections are available than transactions may be in flight
+  auto transfers = std::make_shared<ConfirmFailingSiteToSiteClient::Transfers>();
+  transfers->failing_confirm = 2;
+  for (int i = 0; i < 4; i++) {
+    rpg->addProtocol(std::unique_ptr<minifi::sitetosite::SiteToSiteClient>(new ConfirmFailingSiteToSiteClient(transfers)));
+  }
+  std::shared_ptr<core::ProcessorNode> node = std::make_shared<core::ProcessorNode>(rpg);
+  std::shared_ptr<core::controller::ControllerServiceProvider> controller_services_provider = nullptr;
+  auto context = std::make_shared<core::ProcessContext>(node, controller_services_provider, repo, repo, content_repo);
+  rpg->transfer(context, 3);
+
+  // no transaction starts after the failure, and those already in flight complete
+  REQUIRE(3 == transfers->max_in_flight);
+  REQUIRE(4 == transfers->started);
+  REQUIRE(4 == transfers->finished);
+  REQUIRE(0 == transfers->in_flight);
+
+  // only the flow file of the failed transaction is queued again, next to the unsent ones
+  REQUIRE(3 == connection->getQueueSize());
+  std::set<std::string> queued;
+  std::set<std::shared_ptr<core::FlowFile>> expired;
+  for (std::shared_ptr<core::FlowFile> flow = connection->poll(expired); flow != nullptr; flow = connection->poll(expired)) {
+    queued.insert(flow->getUUIDStr());
+  }
+  REQUIRE(1 == queued.count(transfers->failed_flow_file));
+  REQUIRE(0 == queued.count(transfers->flow_files["1"]));
+  REQUIRE(0 == queued.count(transfers->flow_files["3"]));
+  REQUIRE(0 == queued.count(transfers->flow_files["4"]));
+}
+
+TEST_CASE("TestRPGRefreshKeepsProtocolsToListedPeers", "[TestRPG8]") {
+  auto configuration = std::make_shared<org::apache::nifi::minifi::Configure>();
+  auto factory = minifi::io::StreamFactory::getInstance(configuration);
+  auto rpg = std::make_shared<PipelinedRemoteProcessorGroupPort>(factory, configuration);
+  utils::Identifier port_id;
+  for (uint16_t port = 8001; port <= 8002; port++) {
+    minifi::sitetosite::SiteToSiteClientConfiguration config(factory, std::make_shared<minifi::sitetosite::Peer>(port_id, "localhost", port), "");
+    rpg->addProtocol(minifi::sitetosite::createClient(config));
+  }
+
+  std::vector<minifi::sitetosite::PeerStatus> peers;
+  peers.emplace_back(std::make_shared<minifi::sitetosite::Peer>(port_id, "localhost", 8002), 0, false);
+  peers.emplace_back(std::make_shared<minifi::sitetosite::Peer>(port_id, "localhost", 8003), 0, false);
+  rpg->refreshPeers(peers);
+
+  // the protocol to the removed peer is closed, while the one to the remaining peer is reused
+  auto protocol = rpg->takeProtocol();
+  REQUIRE(nullptr != protocol);
+  REQUIRE(8002 == protocol->getPeer()->getPort());
+  REQUIRE(nullptr == rpg->takeProtocol());
+}
+
 int fileSize(const char *add) {
   std::ifstream mySource;
   mySource.open(add, std::ios_base::binary);
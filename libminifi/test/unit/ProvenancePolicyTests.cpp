@@ -0,0 +1,116 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include "../TestBase.h"
+#include "ProvenanceTestHelper.h"
+#include "FlowFileRecord.h"
+#include "provenance/Provenance.h"
+#include "provenance/ProvenancePolicy.h"
+#include "properties/Configure.h"
+
+std::shared_ptr<provenance::ProvenancePolicy> createPolicy(const std::map<std::string, std::string> &properties) {
+  auto configuration = std::make_shared<minifi::Configure>();
+  for (const auto &property : properties) {
+    configuration->set(property.first, property.second);
+  }
+  return provenance::ProvenancePolicy::create(configuration);
+}
+
+TEST_CASE("Provenance policy records every event by default", "[ProvenancePolicy]") {
+  REQUIRE(nullptr == createPolicy({}));
+  REQUIRE(nullptr == createPolicy({{minifi::Configure::nifi_provenance_policy_sample_rate, "1"}}));
+}
+
+TEST_CASE("Provenance policy excludes event types and components", "[ProvenancePolicy]") {
+  auto policy = createPolicy({{minifi::Configure::nifi_provenance_policy_excluded_event_types, "attributes_modified, ROUTE"},
+                              {minifi::Configure::nifi_provenance_policy_excluded_components, "quiet"}});
+  REQUIRE(nullptr != policy);
+
+  auto component = policy->getComponentPolicy("loud");
+  REQUIRE(component == policy->getComponentPolicy("loud"));
+  REQUIRE(component->accept(provenance::ProvenanceEventRecord::SEND));
+  REQUIRE(component->accept(provenance::ProvenanceEventRecord::RECEIVE));
+  REQUIRE(false == component->accept(provenance::ProvenanceEventRecord::ATTRIBUTES_MODIFIED));
+  REQUIRE(false == component->accept(provenance::ProvenanceEventRecord::ROUTE));
+
+  auto quiet = policy->getComponentPolicy("quiet");
+  REQUIRE(false == quiet->accept(provenance::ProvenanceEventRecord::SEND));
+  REQUIRE(false == quiet->accept(provenance::ProvenanceEventRecord::RECEIVE));
+}
+
+TEST_CASE("Provenance policy samples and rate limits events", "[ProvenancePolicy]") {
+  SECTION("sampling") {
+    auto component = createPolicy({{minifi::Configure::nifi_provenance_policy_sample_rate, "4"}})->getComponentPolicy("component");
+    int accepted = 0;
+    for (int i = 0; i < 100; i++) {
+      accepted += component->accept(provenance::ProvenanceEventRecord::SEND) ? 1 : 0;
+    }
+    REQUIRE(25 == accepted);
+    // each type is sampled on its own
+    REQUIRE(component->accept(provenance::ProvenanceEventRecord::RECEIVE));
+  }
+  SECTION("rate limit") {
+    auto policy = createPolicy({{minifi::Configure::nifi_provenance_policy_max_events_per_second, "10"}});
+    auto component = policy->getComponentPolicy("component");
+    int accepted = 0;
+    for (int i = 0; i < 100; i++) {
+      accepted += component->accept(provenance::ProvenanceEventRecord::SEND) ? 1 : 0;
+    }
+    REQUIRE(10 == accepted);
+    // the limit applies to each component on its own
+    REQUIRE(policy->getComponentPolicy("other")->accept(provenance::ProvenanceEventRecord::SEND));
+  }
+}
+
+TEST_CASE("Provenance reporter creates no dropped events and summarizes them", "[ProvenancePolicy]") {
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  std::shared_ptr<core::Repository> repo = std::make_shared<TestRepository>();
+  repo->setProvenancePolicy(createPolicy({{minifi::Configure::nifi_provenance_policy_excluded_event_types, "ROUTE"},
+                                          {minifi::Configure::nifi_provenance_policy_sample_rate, "10"},
+                                          {minifi::Configure::nifi_provenance_policy_summary_interval, "1 ms"}}));
+  std::map<std::string, std::string> attributes;
+  std::shared_ptr<core::FlowFile> flow = std::make_shared<minifi::FlowFileRecord>(repo, content_repo, attributes);
+
+  provenance::ProvenanceReporter reporter(repo, "component", "type");
+  for (int i = 0; i < 20; i++) {
+    reporter.modifyAttributes(flow, "detail");
+    reporter.route(flow, core::Relationship("success", ""), "detail", 0);
+  }
+  REQUIRE(2 == reporter.getEvents().size());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  reporter.commit();
+  // the summary of the sampled events is committed with them, excluded types are not summarized
+  auto events = reporter.getEvents();
+  REQUIRE(3 == events.size());
+  int summaries = 0;
+  std::string value;
+  for (auto event : events) {
+    REQUIRE(provenance::ProvenanceEventRecord::ATTRIBUTES_MODIFIED == event->getEventType());
+    REQUIRE(repo->Get(event->getEventId(), value));
+    if (event->getDetails().find("Summary of 18 ATTRIBUTES_MODIFIED events") == 0) {
+      summaries++;
+    }
+  }
+  REQUIRE(1 == summaries);
+}
@@ -0,0 +1,95 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "io/Reactor.h"
+#include "../TestBase.h"
+
+namespace {
+
+bool waitFor(const std::function<bool()> &condition) {
+  for (int i = 0; i < 500 && !condition(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return condition();
+}
+
+}  // namespace
+
+TEST_CASE("ReactorDispatchesReadyDescriptors", "[Reactor1]") {
+  minifi::io::Reactor reactor(2);
+  REQUIRE(reactor.start());
+
+  const int connections = 200;
+  std::vector<int> fds;
+  std::atomic<int> received(0);
+  auto callback = [&received](int fd, uint32_t events) {
+    char buffer[16];
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+      received++;
+    }
+  };
+  auto received_all = [&received] {return received == connections;};
+  auto received_one_more = [&received] {return received == connections + 1;};
+  for (int i = 0; i < connections; i++) {
+    int pair[2];
+    REQUIRE(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, pair));
+    minifi::io::Reactor::setNonBlocking(pair[0]);
+    REQUIRE(reactor.add(pair[0], REACTOR_READABLE, callback));
+    fds.push_back(pair[0]);
+    fds.push_back(pair[1]);
+  }
+  REQUIRE(connections == reactor.size());
+
+  for (int i = 1; i < connections * 2; i += 2) {
+    REQUIRE(1 == write(fds[i], "a", 1));
+  }
+  REQUIRE(waitFor(received_all));
+
+  // removed descriptors are not dispatched
+  reactor.remove(fds[0]);
+  REQUIRE(1 == write(fds[1], "a", 1));
+  REQUIRE(1 == write(fds[3], "a", 1));
+  REQUIRE(waitFor(received_one_more));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  REQUIRE(connections + 1 == received);
+
+  reactor.stop();
+  for (int fd : fds) {
+    close(fd);
+  }
+}
+
+TEST_CASE("ReactorRunsTimers", "[Reactor2]") {
+  minifi::io::Reactor reactor;
+  REQUIRE(reactor.start());
+
+  std::atomic<int> runs(0);
+  reactor.schedule(10, [&runs] {runs++;});
+  uint64_t cancelled = reactor.schedule(50, [&runs] {runs += 10;});
+  reactor.cancel(cancelled);
+  auto ran_once = [&runs] {return runs == 1;};
+  REQUIRE(waitFor(ran_once));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  REQUIRE(1 == runs);
+}
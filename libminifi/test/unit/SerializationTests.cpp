@@ -19,8 +19,10 @@
 #include <uuid/uuid.h>
 #include "SiteToSiteHelper.h"
 #include <algorithm>
+#include <limits>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "../TestBase.h"
 #include "../unit/SiteToSiteHelper.h"
@@ -70,3 +72,52 @@ TEST_CASE("TestWriteUTF3", "[MINIFI193]") {
   REQUIRE(verifyString == stringOne);
 }
 
+
+TEST_CASE("TestWriteVarInt", "[VarInt]") {
+  org::apache::nifi::minifi::io::DataStream baseStream;
+
+  org::apache::nifi::minifi::io::Serializable ser;
+
+  std::vector<uint64_t> values = { 0, 1, 127, 128, 16383, 16384, 1526054400000, std::numeric_limits<uint64_t>::max() };
+  REQUIRE(1 == ser.writeVarInt(127, &baseStream));
+  REQUIRE(2 == ser.writeVarInt(128, &baseStream));
+  REQUIRE(10 == ser.writeVarInt(std::numeric_limits<uint64_t>::max(), &baseStream));
+  for (auto value : values) {
+    REQUIRE(ser.writeVarInt(value, &baseStream) > 0);
+  }
+
+  uint64_t verifyValue = 0;
+  REQUIRE(1 == ser.readVarInt(verifyValue, &baseStream));
+  REQUIRE(127 == verifyValue);
+  REQUIRE(2 == ser.readVarInt(verifyValue, &baseStream));
+  REQUIRE(128 == verifyValue);
+  REQUIRE(10 == ser.readVarInt(verifyValue, &baseStream));
+  REQUIRE(std::numeric_limits<uint64_t>::max() == verifyValue);
+  for (auto value : values) {
+    REQUIRE(ser.readVarInt(verifyValue, &baseStream) > 0);
+    REQUIRE(value == verifyValue);
+  }
+  // the stream is exhausted
+  REQUIRE(-1 == ser.readVarInt(verifyValue, &baseStream));
+}
+
+TEST_CASE("TestWriteVarString", "[VarInt]") {
+  org::apache::nifi::minifi::io::DataStream baseStream;
+
+  org::apache::nifi::minifi::io::Serializable ser;
+
+  std::string stringOne = "hel\xa1o world";
+  std::string stringTwo(300, 'a');
+  REQUIRE(1 == ser.writeVarString("", &baseStream));
+  REQUIRE(12 == ser.writeVarString(stringOne, &baseStream));
+  REQUIRE(302 == ser.writeVarString(stringTwo, &baseStream));
+
+  std::string verifyString = "not empty";
+  REQUIRE(1 == ser.readVarString(verifyString, &baseStream));
+  REQUIRE(verifyString.empty());
+  REQUIRE(12 == ser.readVarString(verifyString, &baseStream));
+  REQUIRE(verifyString == stringOne);
+  REQUIRE(302 == ser.readVarString(verifyString, &baseStream));
+  REQUIRE(verifyString == stringTwo);
+  REQUIRE(-1 == ser.readVarString(verifyString, &baseStream));
+}
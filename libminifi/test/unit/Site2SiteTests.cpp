@@ -22,6 +22,8 @@
 #include <utility>
 #include <map>
 #include "io/BaseStream.h"
+#include "io/CRCStream.h"
+#include "sitetosite/CompressionStream.h"
 #include "sitetosite/Peer.h"
 #include "sitetosite/RawSocketProtocol.h"
 #include <algorithm>
@@ -177,3 +179,220 @@ TEST_CASE("TestSiteToSiteVerifyNegotiationFail", "[S2S4]") {
 
   REQUIRE(false == protocol.bootstrap());
 }
+
+TEST_CASE("TestSiteToSiteCompressionStream", "[S2S5]") {
+  std::string data;
+  for (int i = 0; data.size() < 3 * COMPRESSION_CHUNK_SIZE; i++) {
+    data += "line " + std::to_string(i) + " of a compressible payload\n";
+  }
+
+  minifi::io::DataStream stream;
+  minifi::sitetosite::CompressionOutputStream output(&stream);
+  const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data.c_str());
+  REQUIRE(1000 == output.write(bytes, 1000));
+  REQUIRE(static_cast<int>(data.size() - 1000) == output.write(bytes + 1000, data.size() - 1000));
+  REQUIRE(1 == output.close());
+  uint8_t marker = 0x14;
+  stream.writeData(&marker, 1);
+
+  // NiFi framing: SYNC, big endian uncompressed and compressed lengths, 1 between chunks, 0 at the end
+  const uint8_t *framed = stream.getBuffer();
+  REQUIRE(std::string("SYNC") == std::string(reinterpret_cast<const char*>(framed), 4));
+  REQUIRE(0x00010000 == ((framed[4] << 24) | (framed[5] << 16) | (framed[6] << 8) | framed[7]));
+  uint32_t compressed_size = (framed[8] << 24) | (framed[9] << 16) | (framed[10] << 8) | framed[11];
+  REQUIRE(1 == framed[12 + compressed_size]);
+  REQUIRE(std::string("SYNC") == std::string(reinterpret_cast<const char*>(framed) + 13 + compressed_size, 4));
+  REQUIRE(stream.getSize() < data.size() / 5);
+  REQUIRE(0 == framed[stream.getSize() - 2]);
+
+  minifi::sitetosite::CompressionInputStream input(&stream);
+  std::string read;
+  std::vector<uint8_t> buffer(7777);
+  while (!input.finished()) {
+    int ret = input.read(buffer.data(), buffer.size());
+    REQUIRE(ret > 0);
+    read.append(reinterpret_cast<char*>(buffer.data()), ret);
+  }
+  REQUIRE(data == read);
+  // the end of the packet is consumed, but nothing after it
+  uint8_t next;
+  REQUIRE(1 == stream.readData(&next, 1));
+  REQUIRE(marker == next);
+}
+
+TEST_CASE("TestSiteToSiteVerifySendCompressed", "[S2S6]") {
+  SiteToSiteResponder *collector = new SiteToSiteResponder();
+
+  sunny_path_bootstrap(collector);
+
+  std::unique_ptr<minifi::sitetosite::SiteToSitePeer> peer = std::unique_ptr<minifi::sitetosite::SiteToSitePeer>(
+      new minifi::sitetosite::SiteToSitePeer(std::unique_ptr<minifi::io::DataStream>(new org::apache::nifi::minifi::io::BaseStream(collector)), "fake_host", 65433, ""));
+
+  minifi::sitetosite::RawSiteToSiteClient protocol(std::move(peer));
+  protocol.setUseCompression(true);
+
+  utils::Identifier fakeUUID;
+  fakeUUID = "C56A4180-65AA-42EC-A945-5FD21DEC0538";
+  protocol.setPortId(fakeUUID);
+
+  REQUIRE(true == protocol.bootstrap());
+
+  while (collector->get_next_client_response() != "GZIP") {
+  }
+  collector->get_next_client_response();
+  REQUIRE(collector->get_next_client_response() == "true");
+  while (collector->get_next_client_response() != "StandardFlowFileCodec") {
+  }
+  collector->get_next_client_response();  // codec version
+
+  std::string transactionID;
+  std::string payload = "Test MiNiFi payload";
+  std::shared_ptr<minifi::sitetosite::Transaction> transaction;
+  transaction = protocol.createTransaction(transactionID, minifi::sitetosite::SEND);
+  collector->get_next_client_response();
+  REQUIRE(collector->get_next_client_response() == "SEND_FLOWFILES");
+  std::map<std::string, std::string> attributes;
+  attributes["filename"] = "payload.txt";
+  std::shared_ptr<logging::Logger> logger = nullptr;
+  minifi::sitetosite::DataPacket packet(logger, transaction, attributes, payload);
+  REQUIRE(protocol.send(transactionID, &packet, nullptr, nullptr) == 0);
+
+  // the data packet arrives as a single compressed chunk followed by the end of the packet
+  minifi::io::DataStream stream;
+  while (collector->has_next_client_response()) {
+    std::string response = collector->get_next_client_response();
+    stream.writeData(reinterpret_cast<uint8_t*>(const_cast<char*>(response.data())), response.size());
+  }
+  minifi::sitetosite::CompressionInputStream input(&stream);
+  minifi::io::BaseStream decompressed;
+  uint8_t buffer[1024];
+  int ret = input.read(buffer, sizeof(buffer));
+  REQUIRE(input.finished());
+  decompressed.writeData(buffer, ret);
+
+  // read the packet as the receiving side of a transaction does
+  minifi::io::CRCStream<minifi::io::BaseStream> packetStream(&decompressed);
+  uint32_t numAttributes;
+  packetStream.read(numAttributes);
+  REQUIRE(1 == numAttributes);
+  std::string key, value;
+  packetStream.readUTF(key, true);
+  packetStream.readUTF(value, true);
+  REQUIRE("filename" == key);
+  REQUIRE("payload.txt" == value);
+  uint64_t len;
+  packetStream.read(len);
+  REQUIRE(payload.size() == len);
+  uint8_t content[sizeof(buffer)];
+  REQUIRE(static_cast<int>(len) == packetStream.readData(content, len));
+  REQUIRE(payload == std::string(reinterpret_cast<char*>(content), len));
+  REQUIRE(static_cast<uint64_t>(4 + 4 + 8 + 4 + 11 + 8 + payload.size()) == decompressed.getSize());
+}
+
+/**
+ * Exposes the steps of a send transaction.
+ */
+class PipelinedSiteToSiteClient : public minifi::sitetosite::RawSiteToSiteClient {
+ public:
+  explicit PipelinedSiteToSiteClient(std::unique_ptr<minifi::sitetosite::SiteToSitePeer> peer)
+      : minifi::sitetosite::RawSiteToSiteClient(std::move(peer)) {
+  }
+  using minifi::sitetosite::RawSiteToSiteClient::finishSending;
+  using minifi::sitetosite::RawSiteToSiteClient::confirm;
+  using minifi::sitetosite::RawSiteToSiteClient::complete;
+};
+
+TEST_CASE("TestSiteToSiteFinishSendingBeforeConfirm", "[S2S7]") {
+  SiteToSiteResponder *collector = new SiteToSiteResponder();
+
+  sunny_path_bootstrap(collector);
+
+  std::unique_ptr<minifi::sitetosite::SiteToSitePeer> peer = std::unique_ptr<minifi::sitetosite::SiteToSitePeer>(
+      new minifi::sitetosite::SiteToSitePeer(std::unique_ptr<minifi::io::DataStream>(new org::apache::nifi::minifi::io::BaseStream(collector)), "fake_host", 65433, ""));
+
+  PipelinedSiteToSiteClient protocol(std::move(peer));
+
+  utils::Identifier fakeUUID;
+  fakeUUID = "C56A4180-65AA-42EC-A945-5FD21DEC0538";
+  protocol.setPortId(fakeUUID);
+
+  REQUIRE(true == protocol.bootstrap());
+
+  std::string transactionID;
+  std::string payload = "Test MiNiFi payload";
+  std::shared_ptr<minifi::sitetosite::Transaction> transaction;
+  transaction = protocol.createTransaction(transactionID, minifi::sitetosite::SEND);
+  std::map<std::string, std::string> attributes;
+  std::shared_ptr<logging::Logger> logger = nullptr;
+  minifi::sitetosite::DataPacket packet(logger, transaction, attributes, payload);
+  REQUIRE(protocol.send(transactionID, &packet, nullptr, nullptr) == 0);
+
+  // the end of the transaction is sent without waiting for the peer
+  REQUIRE(protocol.finishSending(transactionID));
+  REQUIRE(minifi::sitetosite::DATA_SENT == transaction->getState());
+  std::string last;
+  while (collector->has_next_client_response()) {
+    last = collector->get_next_client_response();
+  }
+  REQUIRE(std::string("RC\x0b") == last);
+  REQUIRE(false == protocol.finishSending(transactionID));
+
+  // confirmation does not send it again
+  collector->push_response("R");
+  collector->push_response("C");
+  collector->push_response(std::string(1, static_cast<char>(minifi::sitetosite::CONFIRM_TRANSACTION)));
+  std::string crc = std::to_string(transaction->getCRC());
+  collector->push_response(std::to_string(crc.size()));
+  collector->push_response(crc);
+  collector->push_response("R");
+  collector->push_response("C");
+  collector->push_response(std::string(1, static_cast<char>(minifi::sitetosite::TRANSACTION_FINISHED)));
+  REQUIRE(protocol.confirm(transactionID));
+  REQUIRE(std::string("RC\x0c") == collector->get_next_client_response());
+  REQUIRE(protocol.complete(transactionID));
+  REQUIRE(minifi::sitetosite::TRANSACTION_COMPLETED == transaction->getState());
+}
+
+TEST_CASE("TestBufferedPeerWrites", "[S2S8]") {
+  SiteToSiteResponder *collector = new SiteToSiteResponder();
+  minifi::sitetosite::SiteToSitePeer peer(std::unique_ptr<minifi::io::DataStream>(new org::apache::nifi::minifi::io::BaseStream(collector)), "fake_host", 65433, "");
+  peer.setBufferedWrites(true);
+
+  // the length fields and strings of a packet header go out in one write
+  REQUIRE(4 == peer.write(static_cast<uint32_t>(1)));
+  peer.writeUTF("key", true);
+  peer.writeUTF("value", true);
+  REQUIRE(false == collector->has_next_client_response());
+
+  // reading a response sends the buffered data first
+  collector->push_response("R");
+  uint8_t value = 0;
+  REQUIRE(1 == peer.read(value));
+  REQUIRE('R' == value);
+  REQUIRE(4 + 4 + 3 + 4 + 5 == collector->get_next_client_response().size());
+  REQUIRE(false == collector->has_next_client_response());
+
+  peer.write(static_cast<uint32_t>(2));
+  REQUIRE(4 == peer.flush());
+  REQUIRE(4 == collector->get_next_client_response().size());
+  REQUIRE(0 == peer.flush());
+}
+
+TEST_CASE("TestCompressedReadEndsOnError", "[S2S9]") {
+  SiteToSiteResponder *collector = new SiteToSiteResponder();
+  minifi::sitetosite::SiteToSitePeer peer(std::unique_ptr<minifi::io::DataStream>(new org::apache::nifi::minifi::io::BaseStream(collector)), "fake_host", 65433, "");
+
+  // a chunk header without the sync bytes aborts the packet
+  collector->push_response("NOSYNC000000");
+  collector->push_response("R");
+  uint8_t buffer[4];
+  {
+    minifi::sitetosite::CompressedReadGuard compressed_read(&peer);
+    peer.startCompressedRead();
+    REQUIRE(-1 == peer.read(buffer, 4));
+  }
+
+  // what follows the aborted packet is read as it is
+  REQUIRE(1 == peer.read(buffer, 1));
+  REQUIRE('R' == buffer[0]);
+}
@@ -0,0 +1,273 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../TestBase.h"
+#include "RemoteProcessorGroupPort.h"
+#include "RootGroupPort.h"
+#include "io/ClientSocket.h"
+#include "io/Reactor.h"
+#include "io/StreamFactory.h"
+#include "processors/GenerateFlowFile.h"
+#include "processors/LogAttribute.h"
+#include "sitetosite/SiteToSiteServer.h"
+
+namespace {
+
+// the gateway listens on a port chosen by the system, so that the tests do not collide with other listeners
+std::shared_ptr<minifi::Configure> createGatewayConfiguration() {
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_remote_input_host, "localhost");
+  configuration->set(minifi::Configure::nifi_remote_input_socket_port, "0");
+  return configuration;
+}
+
+// returns the port of the server held by the scheduled gateway port
+std::string getServerPort() {
+  return std::to_string(minifi::sitetosite::SiteToSiteServer::getServer(createGatewayConfiguration())->getPort());
+}
+
+std::shared_ptr<minifi::RemoteProcessorGroupPort> createRemotePort(const std::string &port_id) {
+  auto configuration = std::make_shared<minifi::Configure>();
+  utils::Identifier uuid;
+  uuid = port_id;
+  auto rpg = std::make_shared<minifi::RemoteProcessorGroupPort>(minifi::io::StreamFactory::getInstance(configuration), "rpg", "http://localhost:" + getServerPort(), configuration, uuid);
+  rpg->setTransmitting(true);
+  return rpg;
+}
+
+// the port connects to the gateway directly, as there is no REST API to ask for the peers
+void connectRemotePort(const std::shared_ptr<TestPlan> &plan, const std::shared_ptr<core::Processor> &rpg, bool use_compression) {
+  plan->setProperty(rpg, minifi::RemoteProcessorGroupPort::hostName.getName(), "localhost");
+  plan->setProperty(rpg, minifi::RemoteProcessorGroupPort::port.getName(), getServerPort());
+  plan->setProperty(rpg, minifi::RemoteProcessorGroupPort::useCompression.getName(), use_compression ? "true" : "false");
+}
+
+}  // namespace
+
+TEST_CASE("SiteToSiteServerNeedsPort", "[S2SServer]") {
+  auto configuration = std::make_shared<minifi::Configure>();
+  REQUIRE(nullptr == minifi::sitetosite::SiteToSiteServer::getServer(configuration));
+
+  configuration->set(minifi::Configure::nifi_remote_input_socket_port, "not a port");
+  REQUIRE(nullptr == minifi::sitetosite::SiteToSiteServer::getServer(configuration));
+
+  // ports share the server of the agent
+  auto server = minifi::sitetosite::SiteToSiteServer::getServer(createGatewayConfiguration());
+  REQUIRE(nullptr != server);
+  REQUIRE(server == minifi::sitetosite::SiteToSiteServer::getServer(createGatewayConfiguration()));
+  REQUIRE(0 != server->getPort());
+}
+
+TEST_CASE("SiteToSiteServerInputPort", "[S2SServer]") {
+  TestController testController;
+  LogTestController::getInstance().setDebug<minifi::sitetosite::SiteToSiteServer>();
+  LogTestController::getInstance().setDebug<minifi::RemoteProcessorGroupPort>();
+
+  // the gateway receives the flow files of the leaf on its input port
+  auto gateway_port = std::make_shared<minifi::RootGroupPort>("input", createGatewayConfiguration());
+  gateway_port->setDirection(minifi::sitetosite::SEND);
+  std::shared_ptr<TestPlan> gateway = testController.createPlan();
+  gateway->addProcessor(gateway_port, "input", core::Relationship());
+  gateway->addProcessor("LogAttribute", "log", core::Relationship(), true);
+  gateway->runNextProcessor();
+
+  std::shared_ptr<TestPlan> leaf = testController.createPlan();
+  auto generate = leaf->addProcessor("GenerateFlowFile", "generate");
+  leaf->setProperty(generate, minifi::processors::GenerateFlowFile::BatchSize.getName(), "5");
+  auto rpg = createRemotePort(gateway_port->getUUIDStr());
+  rpg->setDirection(minifi::sitetosite::SEND);
+  leaf->addProcessor(rpg, "rpg", core::Relationship("success", "description"), true);
+  connectRemotePort(leaf, rpg, false);
+  leaf->runNextProcessor();
+  leaf->runNextProcessor();
+
+  int received = 0;
+  auto count = [&received](const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session) {
+    std::shared_ptr<core::FlowFile> flow_file;
+    while ((flow_file = session->get()) != nullptr) {
+      REQUIRE(1024 == flow_file->getSize());
+      session->remove(flow_file);
+      received++;
+    }
+  };
+  gateway->runNextProcessor(count);
+  REQUIRE(5 == received);
+
+  gateway_port->setScheduledState(core::STOPPED);
+  LogTestController::getInstance().reset();
+}
+
+TEST_CASE("SiteToSiteServerStalledClients", "[S2SServer]") {
+  TestController testController;
+
+  auto gateway_port = std::make_shared<minifi::RootGroupPort>("input", createGatewayConfiguration());
+  gateway_port->setDirection(minifi::sitetosite::SEND);
+  std::shared_ptr<TestPlan> gateway = testController.createPlan();
+  gateway->addProcessor(gateway_port, "input", core::Relationship());
+  gateway->addProcessor("LogAttribute", "log", core::Relationship(), true);
+  gateway->runNextProcessor();
+
+  // instances that stop sending midway hold a thread of the server, but not the shared reactor
+  auto socket_context = std::make_shared<minifi::io::SocketContext>(std::make_shared<minifi::Configure>());
+  std::vector<std::unique_ptr<minifi::io::Socket>> stalled;
+  std::vector<uint8_t> magic = { 'N', 'i' };
+  for (int i = 0; i < REACTOR_THREADS; i++) {
+    stalled.push_back(std::unique_ptr<minifi::io::Socket>(new minifi::io::Socket(socket_context, "localhost", std::stoi(getServerPort()))));
+    REQUIRE(-1 != stalled.back()->initialize());
+    REQUIRE(2 == stalled.back()->writeData(magic, 2));
+  }
+
+  std::shared_ptr<TestPlan> leaf = testController.createPlan();
+  auto generate = leaf->addProcessor("GenerateFlowFile", "generate");
+  leaf->setProperty(generate, minifi::processors::GenerateFlowFile::BatchSize.getName(), "5");
+  auto rpg = createRemotePort(gateway_port->getUUIDStr());
+  rpg->setDirection(minifi::sitetosite::SEND);
+  leaf->addProcessor(rpg, "rpg", core::Relationship("success", "description"), true);
+  connectRemotePort(leaf, rpg, false);
+  leaf->runNextProcessor();
+  leaf->runNextProcessor();
+
+  int received = 0;
+  auto count = [&received](const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session) {
+    std::shared_ptr<core::FlowFile> flow_file;
+    while ((flow_file = session->get()) != nullptr) {
+      session->remove(flow_file);
+      received++;
+    }
+  };
+  gateway->runNextProcessor(count);
+  REQUIRE(5 == received);
+
+  gateway_port->setScheduledState(core::STOPPED);
+  for (auto &client : stalled) {
+    client->closeStream();
+  }
+}
+
+TEST_CASE("SiteToSiteServerStopClosesConnections", "[S2SServer]") {
+  minifi::sitetosite::SiteToSiteServer server("localhost", 0);
+  REQUIRE(server.start());
+  REQUIRE(0 != server.getPort());
+
+  auto socket_context = std::make_shared<minifi::io::SocketContext>(std::make_shared<minifi::Configure>());
+  minifi::io::Socket client(socket_context, "localhost", server.getPort());
+  REQUIRE(-1 != client.initialize());
+  std::vector<uint8_t> magic = { 'N', 'i' };
+  REQUIRE(2 == client.writeData(magic, 2));
+  for (int i = 0; i < 500 && server.getConnectionCount() == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  REQUIRE(1 == server.getConnectionCount());
+
+  // the request waiting for the rest of the magic bytes gives up, and the connection is closed
+  server.stop();
+  REQUIRE(0 == server.getConnectionCount());
+  std::vector<uint8_t> buffer(1);
+  REQUIRE(0 > client.readData(buffer, 1));
+}
+
+TEST_CASE("SiteToSiteServerLargeFlowFiles", "[S2SServer]") {
+  TestController testController;
+
+  // the content spans several reads of the receive buffer
+  auto gateway_port = std::make_shared<minifi::RootGroupPort>("input", createGatewayConfiguration());
+  gateway_port->setDirection(minifi::sitetosite::SEND);
+  std::shared_ptr<TestPlan> gateway = testController.createPlan();
+  gateway->addProcessor(gateway_port, "input", core::Relationship());
+  gateway->addProcessor("LogAttribute", "log", core::Relationship(), true);
+  gateway->runNextProcessor();
+
+  std::shared_ptr<TestPlan> leaf = testController.createPlan();
+  auto generate = leaf->addProcessor("GenerateFlowFile", "generate");
+  leaf->setProperty(generate, minifi::processors::GenerateFlowFile::BatchSize.getName(), "2");
+  leaf->setProperty(generate, minifi::processors::GenerateFlowFile::FileSize.getName(), "600000");
+  auto rpg = createRemotePort(gateway_port->getUUIDStr());
+  rpg->setDirection(minifi::sitetosite::SEND);
+  leaf->addProcessor(rpg, "rpg", core::Relationship("success", "description"), true);
+  connectRemotePort(leaf, rpg, false);
+  leaf->runNextProcessor();
+  leaf->runNextProcessor();
+
+  int received = 0;
+  auto count = [&received](const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session) {
+    std::shared_ptr<core::FlowFile> flow_file;
+    while ((flow_file = session->get()) != nullptr) {
+      REQUIRE(600000 == flow_file->getSize());
+      session->remove(flow_file);
+      received++;
+    }
+  };
+  gateway->runNextProcessor(count);
+  REQUIRE(2 == received);
+
+  gateway_port->setScheduledState(core::STOPPED);
+}
+
+TEST_CASE("SiteToSiteServerOutputPort", "[S2SServer]") {
+  TestController testController;
+  LogTestController::getInstance().setDebug<minifi::sitetosite::SiteToSiteServer>();
+  LogTestController::getInstance().setDebug<minifi::RemoteProcessorGroupPort>();
+
+  // the leaf pulls the flow files queued at the output port of the gateway, compressed
+  auto gateway_port = std::make_shared<minifi::RootGroupPort>("output", createGatewayConfiguration());
+  gateway_port->setDirection(minifi::sitetosite::RECEIVE);
+  std::shared_ptr<TestPlan> gateway = testController.createPlan();
+  auto generate = gateway->addProcessor("GenerateFlowFile", "generate");
+  gateway->setProperty(generate, minifi::processors::GenerateFlowFile::BatchSize.getName(), "5");
+  gateway->addProcessor(gateway_port, "output", core::Relationship("success", "description"), true);
+  // the port is scheduled before the flow files are generated, as the plan takes a flow file from its queue
+  auto nothing = [](const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session) {
+  };
+  gateway->runNextProcessor(nothing);
+  gateway->runNextProcessor();
+  gateway->reset();
+  gateway->runNextProcessor();
+
+  std::shared_ptr<TestPlan> leaf = testController.createPlan();
+  auto rpg = createRemotePort(gateway_port->getUUIDStr());
+  rpg->setDirection(minifi::sitetosite::RECEIVE);
+  leaf->addProcessor(rpg, "rpg", core::Relationship());
+  connectRemotePort(leaf, rpg, true);
+  leaf->addProcessor("LogAttribute", "log", core::Relationship(), true);
+  leaf->runNextProcessor();
+
+  int received = 0;
+  auto count = [&received](const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session) {
+    std::shared_ptr<core::FlowFile> flow_file;
+    while ((flow_file = session->get()) != nullptr) {
+      REQUIRE(1024 == flow_file->getSize());
+      session->remove(flow_file);
+      received++;
+    }
+  };
+  leaf->runNextProcessor(count);
+  REQUIRE(5 == received);
+
+  // the flow files were removed from the gateway once the leaf had them
+  leaf->reset();
+  leaf->runNextProcessor();
+  leaf->runNextProcessor(count);
+  REQUIRE(5 == received);
+
+  gateway_port->setScheduledState(core::STOPPED);
+  LogTestController::getInstance().reset();
+}
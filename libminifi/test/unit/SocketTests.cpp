@@ -16,6 +16,11 @@
  * limitations under the License.
  */
 
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <random>
 #include <chrono>
@@ -28,6 +33,7 @@
 #include "io/ClientSocket.h"
 #include "io/ServerSocket.h"
 #include "io/tls/TLSSocket.h"
+#include "controllers/SSLContextService.h"
 #include "utils/ThreadPool.h"
 
 TEST_CASE("TestSocket", "[TestSocket1]") {
@@ -78,6 +84,123 @@ TEST_CASE("TestSocketWriteTest2", "[TestSocket3]") {
   client.closeStream();
 }
 
+TEST_CASE("TestSocketWriteV", "[TestSocket11]") {
+  std::shared_ptr<org::apache::nifi::minifi::io::SocketContext> socket_context = std::make_shared<org::apache::nifi::minifi::io::SocketContext>(std::make_shared<minifi::Configure>());
+
+  org::apache::nifi::minifi::io::ServerSocket server(socket_context, "localhost", 9183, 1);
+
+  REQUIRE(-1 != server.initialize());
+
+  org::apache::nifi::minifi::io::Socket client(socket_context, "localhost", 9183);
+
+  REQUIRE(-1 != client.initialize());
+
+  std::string header = "header";
+  std::string body = "body";
+  struct iovec iov[2];
+  iov[0].iov_base = const_cast<char*>(header.data());
+  iov[0].iov_len = header.size();
+  iov[1].iov_base = const_cast<char*>(body.data());
+  iov[1].iov_len = body.size();
+  REQUIRE(10 == client.writeV(iov, 2));
+
+  std::vector<uint8_t> first(6);
+  std::vector<uint8_t> second(4);
+  struct iovec read_iov[2];
+  read_iov[0].iov_base = first.data();
+  read_iov[0].iov_len = first.size();
+  read_iov[1].iov_base = second.data();
+  read_iov[1].iov_len = second.size();
+  REQUIRE(10 == server.readV(read_iov, 2));
+
+  REQUIRE(header == std::string(first.begin(), first.end()));
+  REQUIRE(body == std::string(second.begin(), second.end()));
+
+  server.closeStream();
+
+  client.closeStream();
+}
+
+TEST_CASE("TestServerSocketHandlersDoNotStallTheReactor", "[TestSocket12]") {
+  std::shared_ptr<org::apache::nifi::minifi::io::SocketContext> socket_context = std::make_shared<org::apache::nifi::minifi::io::SocketContext>(std::make_shared<minifi::Configure>());
+  std::atomic<bool> released(false);
+  std::atomic<int> handled(0);
+  std::vector<std::unique_ptr<org::apache::nifi::minifi::io::Socket>> clients;
+  {
+    org::apache::nifi::minifi::io::ServerSocket server(socket_context, "localhost", 9184, 1);
+    REQUIRE(-1 != server.initialize());
+    // the first handlers block until released, as they would on a slow client
+    server.registerCallback([]() {return true;}, [&released, &handled](org::apache::nifi::minifi::io::BaseStream *stream) {
+      std::vector<uint8_t> request(1);
+      if (stream->readData(request, 1) == 1 && request[0] == 'b') {
+        while (!released) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+      }
+      handled++;
+    });
+
+    std::vector<uint8_t> block(1, 'b');
+    std::vector<uint8_t> pass(1, 'p');
+    for (int i = 0; i < REACTOR_THREADS + 1; i++) {
+      clients.push_back(std::unique_ptr<org::apache::nifi::minifi::io::Socket>(new org::apache::nifi::minifi::io::Socket(socket_context, "localhost", 9184)));
+      REQUIRE(-1 != clients.back()->initialize());
+      REQUIRE(1 == clients.back()->writeData(i < REACTOR_THREADS ? block : pass, 1));
+    }
+    for (int i = 0; i < 500 && handled == 0; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // released before checking, so that a failure does not leave the handlers blocked
+    const bool handled_while_blocked = handled == 1;
+    released = true;
+    REQUIRE(handled_while_blocked);
+  }
+  // the server socket waits for its running handlers
+  REQUIRE(REACTOR_THREADS + 1 == handled);
+  for (auto &client : clients) {
+    client->closeStream();
+  }
+}
+
+TEST_CASE("TestServerSocketDescriptorsAboveFDSetSize", "[TestSocket14]") {
+  struct rlimit limit;
+  REQUIRE(0 == getrlimit(RLIMIT_NOFILE, &limit));
+  if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < FD_SETSIZE + 16) {
+    return;
+  }
+  struct rlimit raised = limit;
+  raised.rlim_cur = std::max<rlim_t>(limit.rlim_cur, FD_SETSIZE + 16);
+  REQUIRE(0 == setrlimit(RLIMIT_NOFILE, &raised));
+  // the descriptors below FD_SETSIZE are taken, so that the sockets are given larger ones
+  std::vector<int> taken;
+  taken.push_back(open("/dev/null", O_RDONLY));
+  REQUIRE(taken.back() >= 0);
+  while (taken.back() >= 0 && taken.back() < FD_SETSIZE) {
+    taken.push_back(dup(taken.front()));
+  }
+
+  std::vector<uint8_t> buffer;
+  buffer.push_back('a');
+  std::shared_ptr<org::apache::nifi::minifi::io::SocketContext> socket_context = std::make_shared<org::apache::nifi::minifi::io::SocketContext>(std::make_shared<minifi::Configure>());
+  org::apache::nifi::minifi::io::ServerSocket server(socket_context, "localhost", 9185, 1);
+  REQUIRE(-1 != server.initialize());
+  org::apache::nifi::minifi::io::Socket client(socket_context, "localhost", 9185);
+  REQUIRE(-1 != client.initialize());
+  REQUIRE(1 == client.writeData(buffer, 1));
+
+  std::vector<uint8_t> readBuffer;
+  readBuffer.resize(1);
+  REQUIRE(1 == server.readData(readBuffer, 1));
+  REQUIRE(readBuffer == buffer);
+
+  client.closeStream();
+  server.closeStream();
+  for (int fd : taken) {
+    close(fd);
+  }
+  setrlimit(RLIMIT_NOFILE, &limit);
+}
+
 TEST_CASE("TestGetHostName", "[TestSocket4]") {
   REQUIRE(org::apache::nifi::minifi::io::Socket::getMyHostName().length() > 0);
 }
@@ -241,3 +364,26 @@ TEST_CASE("TestTLSContextCreationNullptr", "[TestSocket10]") {
   REQUIRE(tls == nullptr);
 }
 
+
+TEST_CASE("TestTLSContextSharedThroughService", "[TestSocket13]") {
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_security_client_certificate, "resources/cn.crt.pem");
+  configuration->set(minifi::Configure::nifi_security_client_private_key, "resources/cn.ckey.pem");
+  configuration->set(minifi::Configure::nifi_security_client_ca_certificate, "resources/missing-cert.pem");
+  auto ssl_service = std::make_shared<minifi::controllers::SSLContextService>("SSLContextService", configuration);
+  ssl_service->onEnable();
+
+  // a CA certificate that cannot be loaded fails the context, and none is shared
+  auto context = std::make_shared<minifi::io::TLSContext>(configuration, ssl_service);
+  REQUIRE(TLS_ERROR_CERT_ERROR == context->initialize());
+  auto other = std::make_shared<minifi::io::TLSContext>(configuration, ssl_service);
+  REQUIRE(TLS_ERROR_CERT_ERROR == other->initialize());
+
+  // no certificate is loaded when clients need not authenticate
+  configuration->set(minifi::Configure::nifi_security_need_ClientAuth, "false");
+  auto anonymous = std::make_shared<minifi::io::TLSContext>(configuration, ssl_service);
+  REQUIRE(0 == anonymous->initialize());
+  auto shared = std::make_shared<minifi::io::TLSContext>(configuration, ssl_service);
+  REQUIRE(0 == shared->initialize());
+  REQUIRE(anonymous->getContext() == shared->getContext());
+}
@@ -25,6 +25,7 @@
 #include <utility>
 #include "../TestBase.h"
 #include "io/BaseStream.h"
+#include "io/BufferedStream.h"
 
 TEST_CASE("TestReadData", "[testread]") {
   auto base = std::make_shared<minifi::io::BaseStream>();
@@ -73,3 +74,74 @@ TEST_CASE("TestRead4", "[testread]") {
   base->read(c);
   REQUIRE(c == 8);
 }
+
+TEST_CASE("TestBufferedWrites", "[testbuffered]") {
+  minifi::io::BaseStream base;
+  minifi::io::BufferedStream buffered(&base, 16);
+  minifi::io::BaseStream writer(&buffered);
+
+  uint32_t b = 8;
+  REQUIRE(4 == writer.write(b));
+  writer.writeUTF("abc");
+  REQUIRE(0 == base.getSize());
+  REQUIRE(9 == buffered.getBufferedSize());
+
+  // a write that would overflow the buffer sends the buffered data first
+  std::vector<uint8_t> data(10, 'x');
+  REQUIRE(10 == buffered.writeData(data.data(), data.size()));
+  REQUIRE(9 == base.getSize());
+  REQUIRE(10 == buffered.flush());
+  REQUIRE(19 == base.getSize());
+  REQUIRE(0 == buffered.flush());
+
+  // writes as large as the buffer are not buffered
+  std::vector<uint8_t> large(32, 'y');
+  REQUIRE(32 == buffered.writeData(large.data(), large.size()));
+  REQUIRE(51 == base.getSize());
+  REQUIRE(0 == buffered.getBufferedSize());
+}
+
+TEST_CASE("TestBufferedReadFlushes", "[testbuffered]") {
+  minifi::io::BaseStream base;
+  minifi::io::BufferedStream buffered(&base);
+  minifi::io::BaseStream stream(&buffered);
+
+  uint32_t b = 8;
+  stream.write(b);
+  REQUIRE(0 == base.getSize());
+  uint32_t c = 0;
+  REQUIRE(4 == stream.read(c));
+  REQUIRE(c == 8);
+}
+
+TEST_CASE("TestWriteV", "[testwritev]") {
+  minifi::io::BaseStream base;
+  std::string header = "header";
+  std::string body = "body";
+  struct iovec iov[2];
+  iov[0].iov_base = const_cast<char*>(header.data());
+  iov[0].iov_len = header.size();
+  iov[1].iov_base = const_cast<char*>(body.data());
+  iov[1].iov_len = body.size();
+  REQUIRE(10 == base.writeV(iov, 2));
+  REQUIRE(10 == base.getSize());
+
+  std::vector<uint8_t> first(6);
+  std::vector<uint8_t> second(4);
+  struct iovec read_iov[2];
+  read_iov[0].iov_base = first.data();
+  read_iov[0].iov_len = first.size();
+  read_iov[1].iov_base = second.data();
+  read_iov[1].iov_len = second.size();
+  REQUIRE(10 == base.readV(read_iov, 2));
+  REQUIRE(header == std::string(first.begin(), first.end()));
+  REQUIRE(body == std::string(second.begin(), second.end()));
+
+  // buffered writes that do not fit go out along with the buffered data
+  minifi::io::BaseStream sink;
+  minifi::io::BufferedStream buffered(&sink, 8);
+  REQUIRE(4 == buffered.writeData(reinterpret_cast<uint8_t*>(const_cast<char*>(body.data())), body.size()));
+  REQUIRE(10 == buffered.writeV(iov, 2));
+  REQUIRE(14 == sink.getSize());
+  REQUIRE(0 == buffered.getBufferedSize());
+}
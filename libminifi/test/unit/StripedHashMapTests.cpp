@@ -0,0 +1,112 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils/StripedHashMap.h"
+#include "../TestBase.h"
+
+TEST_CASE("StripedHashMapPutAndFind", "[stripedmap]") {
+  minifi::utils::StripedHashMap<std::string, int> map(4);
+  for (int i = 0; i < 100; i++) {
+    map.put(std::to_string(i), i);
+  }
+  REQUIRE(100 == map.size());
+
+  int value = -1;
+  for (int i = 0; i < 100; i++) {
+    REQUIRE(map.find(std::to_string(i), value));
+    REQUIRE(i == value);
+  }
+  REQUIRE(false == map.find("100", value));
+
+  // put replaces, putIfAbsent does not
+  map.put("1", 10);
+  REQUIRE(false == map.putIfAbsent("1", 11));
+  REQUIRE(map.find("1", value));
+  REQUIRE(10 == value);
+  REQUIRE(map.putIfAbsent("100", 100));
+  int previous = -1;
+  REQUIRE(map.exchange("100", 1000, previous));
+  REQUIRE(100 == previous);
+  REQUIRE(false == map.exchange("101", 101, previous));
+  REQUIRE(map.erase("101"));
+  REQUIRE(101 == map.size());
+
+  auto increment = [](int &entry) {entry++;};
+  REQUIRE(map.applyIfPresent("2", increment));
+  REQUIRE(map.find("2", value));
+  REQUIRE(3 == value);
+  REQUIRE(false == map.applyIfPresent("missing", increment));
+}
+
+TEST_CASE("StripedHashMapErase", "[stripedmap]") {
+  minifi::utils::StripedHashMap<std::string, int> map(4);
+  map.put("a", 1);
+  map.put("b", 2);
+  map.put("c", 3);
+
+  int value = 0;
+  REQUIRE(map.erase("a", value));
+  REQUIRE(1 == value);
+  REQUIRE(false == map.erase("a", value));
+  REQUIRE(false == map.contains("a"));
+
+  // only removed while it holds the expected value
+  REQUIRE(false == map.eraseIfEqual("b", 3));
+  REQUIRE(map.contains("b"));
+  REQUIRE(map.eraseIfEqual("b", 2));
+  REQUIRE(false == map.contains("b"));
+
+  REQUIRE(map.erase("c"));
+  REQUIRE(0 == map.size());
+
+  map.put("d", 4);
+  map.clear();
+  REQUIRE(0 == map.size());
+}
+
+TEST_CASE("StripedHashMapConcurrentPutOfSameKey", "[stripedmap]") {
+  minifi::utils::StripedHashMap<std::string, int> map;
+  std::atomic<int> inserted(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&map, &inserted, t]() {
+      for (int i = 0; i < 1000; i++) {
+        if (map.putIfAbsent(std::to_string(i), t)) {
+          inserted++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // exactly one thread wins each key
+  REQUIRE(1000 == inserted);
+  REQUIRE(1000 == map.size());
+  int entries = 0;
+  map.forEach([&entries](const std::string &key, int &value) {
+    REQUIRE(value >= 0);
+    REQUIRE(value < 8);
+    entries++;
+  });
+  REQUIRE(1000 == entries);
+}
@@ -0,0 +1,165 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../TestBase.h"
+#include "ResourceClaim.h"
+#include "core/repository/TieredContentRepository.h"
+#include "properties/Configure.h"
+
+std::shared_ptr<core::repository::TieredContentRepository> createTieredRepository(TestController &testController, const std::string &spill_age, const std::string &max_bytes) {
+  char format[] = "/tmp/testTiered.XXXXXX";
+  char *dir = testController.createTempDirectory(format);
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_dbcontent_repository_directory_default, dir);
+  configuration->set(minifi::Configure::nifi_tiered_content_repository_spill_age, spill_age);
+  configuration->set(std::string(minifi::Configure::nifi_volatile_repository_options) + "content.max.bytes", max_bytes);
+  auto content_repo = std::make_shared<core::repository::TieredContentRepository>("content");
+  REQUIRE(true == content_repo->initialize(configuration));
+  return content_repo;
+}
+
+void writeClaim(const std::shared_ptr<minifi::io::BaseStream> &stream, std::string content) {
+  REQUIRE(nullptr != stream);
+  REQUIRE(static_cast<int>(content.size()) == stream->writeData(reinterpret_cast<uint8_t*>(&content[0]), content.size()));
+}
+
+std::string readClaim(const std::shared_ptr<core::repository::TieredContentRepository> &content_repo, const std::shared_ptr<minifi::ResourceClaim> &claim) {
+  auto stream = content_repo->read(claim);
+  REQUIRE(nullptr != stream);
+  std::vector<uint8_t> buffer;
+  buffer.resize(stream->getSize());
+  REQUIRE(static_cast<int>(buffer.size()) == stream->readData(buffer, buffer.size()));
+  return std::string(buffer.begin(), buffer.end());
+}
+
+TEST_CASE("Young claims stay in memory", "[TestTiered1]") {
+  TestController testController;
+  auto content_repo = createTieredRepository(testController, "1 hour", "1048576");
+
+  auto claim = std::make_shared<minifi::ResourceClaim>(content_repo);
+  writeClaim(content_repo->write(claim), "well hello there");
+
+  REQUIRE(content_repo->isInMemory(claim));
+  REQUIRE(content_repo->exists(claim));
+  REQUIRE("well hello there" == readClaim(content_repo, claim));
+
+  // nothing should have touched the disk tier
+  std::ifstream file(claim->getContentFullPath());
+  REQUIRE(false == file.good());
+
+  REQUIRE(content_repo->remove(claim));
+  REQUIRE(false == content_repo->exists(claim));
+  content_repo->stop();
+}
+
+TEST_CASE("Aged claims migrate to disk", "[TestTiered2]") {
+  TestController testController;
+  auto content_repo = createTieredRepository(testController, "10 ms", "1048576");
+
+  auto claim = std::make_shared<minifi::ResourceClaim>(content_repo);
+  writeClaim(content_repo->write(claim), "well hello there");
+
+  for (int i = 0; i < 100 && content_repo->isInMemory(claim); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  REQUIRE(false == content_repo->isInMemory(claim));
+  std::ifstream file(claim->getContentFullPath());
+  REQUIRE(file.good());
+  REQUIRE("well hello there" == readClaim(content_repo, claim));
+
+  REQUIRE(content_repo->remove(claim));
+  REQUIRE(false == content_repo->exists(claim));
+  content_repo->stop();
+}
+
+TEST_CASE("Writes exceeding the memory tier spill to disk", "[TestTiered3]") {
+  TestController testController;
+  auto content_repo = createTieredRepository(testController, "1 hour", "64");
+
+  auto claim = std::make_shared<minifi::ResourceClaim>(content_repo);
+  std::string content(1024, 'a');
+  {
+    auto stream = content_repo->write(claim);
+    writeClaim(stream, "small");
+    REQUIRE(content_repo->isInMemory(claim));
+    // exceeds the memory tier, so the claim continues on disk
+    writeClaim(stream, content);
+    REQUIRE(false == content_repo->isInMemory(claim));
+  }
+
+  REQUIRE("small" + content == readClaim(content_repo, claim));
+  content_repo->stop();
+}
+
+TEST_CASE("Claims above the spill threshold migrate to disk", "[TestTiered4]") {
+  TestController testController;
+  // the memory tier spills its oldest claims once it holds more than 75 percent of its 1000 bytes
+  auto content_repo = createTieredRepository(testController, "1 hour", "1000");
+
+  std::vector<std::shared_ptr<minifi::ResourceClaim>> claims;
+  for (int i = 0; i < 3; i++) {
+    auto claim = std::make_shared<minifi::ResourceClaim>(content_repo);
+    writeClaim(content_repo->write(claim), std::string(300, 'a' + i));
+    claims.push_back(claim);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  for (int i = 0; i < 100 && content_repo->isInMemory(claims[0]); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  // moving the oldest claim brings the memory tier below the threshold
+  REQUIRE(false == content_repo->isInMemory(claims[0]));
+  REQUIRE(content_repo->isInMemory(claims[1]));
+  REQUIRE(content_repo->isInMemory(claims[2]));
+  std::ifstream file(claims[0]->getContentFullPath());
+  REQUIRE(file.good());
+  for (int i = 0; i < 3; i++) {
+    REQUIRE(content_repo->exists(claims[i]));
+    REQUIRE(std::string(300, 'a' + i) == readClaim(content_repo, claims[i]));
+  }
+
+  // removed from the memory tier
+  REQUIRE(content_repo->remove(claims[1]));
+  REQUIRE(false == content_repo->exists(claims[1]));
+  content_repo->stop();
+}
+
+TEST_CASE("Checking a memory claim does not keep it alive", "[TestTiered5]") {
+  TestController testController;
+  auto content_repo = createTieredRepository(testController, "1 hour", "1048576");
+
+  auto claim = std::make_shared<minifi::ResourceClaim>(content_repo);
+  writeClaim(content_repo->write(claim), "well hello there");
+  REQUIRE(content_repo->isInMemory(claim));
+  REQUIRE(16 == content_repo->getMemoryTierSize());
+
+  REQUIRE(content_repo->exists(claim));
+  REQUIRE(content_repo->exists(claim));
+
+  // the bytes go back to the memory tier once the claim is removed
+  REQUIRE(content_repo->remove(claim));
+  REQUIRE(0 == content_repo->getMemoryTierSize());
+  content_repo->stop();
+}
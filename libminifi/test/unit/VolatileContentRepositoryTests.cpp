@@ -0,0 +1,58 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../TestBase.h"
+#include "ResourceClaim.h"
+#include "core/repository/VolatileContentRepository.h"
+#include "properties/Configure.h"
+
+TEST_CASE("ConcurrentWritesOfAClaimShareAnEntry", "[volatilecontent]") {
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(std::string(minifi::Configure::nifi_volatile_repository_options) + "content.max.count", "2");
+  auto content_repo = std::make_shared<core::repository::VolatileContentRepository>("content");
+  REQUIRE(content_repo->initialize(configuration));
+
+  for (int round = 0; round < 1000; round++) {
+    auto claim = std::make_shared<minifi::ResourceClaim>("claim", content_repo);
+    std::atomic<bool> start(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; t++) {
+      threads.emplace_back([&content_repo, &claim, &start]() {
+        while (!start) {
+        }
+        auto stream = content_repo->write(claim);
+      });
+    }
+    start = true;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    content_repo->remove(claim);
+  }
+
+  // the entries of the writers that lost a race were returned, so both are free
+  auto first = std::make_shared<minifi::ResourceClaim>("first", content_repo);
+  auto second = std::make_shared<minifi::ResourceClaim>("second", content_repo);
+  REQUIRE(nullptr != content_repo->write(first));
+  REQUIRE(nullptr != content_repo->write(second));
+  content_repo->stop();
+}
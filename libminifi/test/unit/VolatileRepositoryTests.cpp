@@ -0,0 +1,94 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include "../TestBase.h"
+#include "core/repository/VolatileProvenanceRepository.h"
+#include "properties/Configure.h"
+
+std::shared_ptr<core::repository::VolatileProvenanceRepository> createVolatileRepository(const std::string &max_count) {
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(std::string(minifi::Configure::nifi_volatile_repository_options) + "provenance.max.count", max_count);
+  auto repo = std::make_shared<core::repository::VolatileProvenanceRepository>("provenance");
+  REQUIRE(true == repo->initialize(configuration));
+  return repo;
+}
+
+bool putValue(const std::shared_ptr<core::repository::VolatileProvenanceRepository> &repo, const std::string &key, std::string value) {
+  return repo->Put(key, reinterpret_cast<const uint8_t*>(value.data()), value.size());
+}
+
+TEST_CASE("Get and Delete find keys past 65535 entries", "[TestVolatile1]") {
+  TestController testController;
+  auto repo = createVolatileRepository("70000");
+
+  for (int i = 0; i < 70000; i++) {
+    REQUIRE(putValue(repo, "key" + std::to_string(i), "value" + std::to_string(i)));
+  }
+
+  std::string value;
+  REQUIRE(repo->Get("key69999", value));
+  REQUIRE("value69999" == value);
+  // values may only be retrieved once
+  REQUIRE(false == repo->Get("key69999", value));
+
+  REQUIRE(repo->Delete("key100"));
+  REQUIRE(false == repo->Delete("key100"));
+  REQUIRE(false == repo->Get("key100", value));
+
+  value.clear();
+  REQUIRE(repo->Get("key0", value));
+  REQUIRE("value0" == value);
+  REQUIRE(false == repo->Delete("missing"));
+}
+
+TEST_CASE("Keys overwritten by the ring are no longer found", "[TestVolatile2]") {
+  TestController testController;
+  auto repo = createVolatileRepository("4");
+
+  for (int i = 0; i < 6; i++) {
+    REQUIRE(putValue(repo, "key" + std::to_string(i), "value" + std::to_string(i)));
+  }
+
+  std::string value;
+  REQUIRE(false == repo->Get("key0", value));
+  REQUIRE(false == repo->Delete("key1"));
+  REQUIRE(repo->Get("key4", value));
+  REQUIRE("value4" == value);
+  REQUIRE(repo->Delete("key5"));
+  value.clear();
+  REQUIRE(repo->Get("key2", value));
+  REQUIRE("value2" == value);
+}
+
+TEST_CASE("Putting a key again frees its previous slot", "[TestVolatile3]") {
+  TestController testController;
+  auto repo = createVolatileRepository("4");
+
+  REQUIRE(putValue(repo, "key", "value"));
+  const uint64_t size = repo->getRepoSize();
+  REQUIRE(putValue(repo, "key", "value"));
+  REQUIRE(size == repo->getRepoSize());
+
+  std::string value;
+  REQUIRE(repo->Get("key", value));
+  REQUIRE("value" == value);
+  REQUIRE(0 == repo->getRepoSize());
+  REQUIRE(false == repo->Get("key", value));
+}
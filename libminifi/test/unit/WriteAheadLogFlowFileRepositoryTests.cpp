@@ -0,0 +1,234 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/stat.h>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../TestBase.h"
+#include "Connection.h"
+#include "FlowFileRecord.h"
+#include "core/repository/VolatileContentRepository.h"
+#include "core/repository/WriteAheadLogFlowFileRepository.h"
+#include "properties/Configure.h"
+
+std::shared_ptr<core::repository::WriteAheadLogFlowFileRepository> openRepository(const std::string &dir) {
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_flowfile_repository_directory_default, dir);
+  auto repository = std::make_shared<core::repository::WriteAheadLogFlowFileRepository>("wal");
+  REQUIRE(true == repository->initialize(configuration));
+  return repository;
+}
+
+bool putValue(const std::shared_ptr<core::repository::WriteAheadLogFlowFileRepository> &repository, const std::string &key, const std::string &value) {
+  return repository->Put(key, reinterpret_cast<const uint8_t*>(value.data()), value.size());
+}
+
+bool fileExists(const std::string &path) {
+  struct stat file_stat;
+  return stat(path.c_str(), &file_stat) == 0;
+}
+
+TEST_CASE("Records survive reopening the log", "[TestWAL1]") {
+  TestController testController;
+  char format[] = "/tmp/testWAL.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  {
+    auto repository = openRepository(dir);
+    REQUIRE(putValue(repository, "a", "first"));
+    REQUIRE(putValue(repository, "b", "second"));
+    REQUIRE(putValue(repository, "a", "updated"));
+    REQUIRE(repository->Delete("b"));
+  }
+  auto repository = openRepository(dir);
+  std::string value;
+  REQUIRE(repository->Get("a", value));
+  REQUIRE("updated" == value);
+  REQUIRE(false == repository->Get("b", value));
+  REQUIRE(7 == repository->getRepoSize());
+}
+
+TEST_CASE("Snapshots truncate the log", "[TestWAL2]") {
+  TestController testController;
+  char format[] = "/tmp/testWAL.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::string first_segment;
+  {
+    auto repository = openRepository(dir);
+    for (int i = 0; i < 100; i++) {
+      REQUIRE(putValue(repository, "key" + std::to_string(i), "value" + std::to_string(i)));
+    }
+    first_segment = repository->getSegmentPath(1);
+    REQUIRE(fileExists(first_segment));
+    REQUIRE(repository->snapshot());
+    REQUIRE(false == fileExists(first_segment));
+    REQUIRE(fileExists(repository->getSnapshotPath()));
+    // records after the snapshot go to the next segment
+    REQUIRE(repository->Delete("key0"));
+    REQUIRE(putValue(repository, "key100", "value100"));
+  }
+  auto repository = openRepository(dir);
+  std::string value;
+  REQUIRE(false == repository->Get("key0", value));
+  REQUIRE(repository->Get("key99", value));
+  REQUIRE("value99" == value);
+  value.clear();
+  REQUIRE(repository->Get("key100", value));
+  REQUIRE("value100" == value);
+}
+
+TEST_CASE("A torn record at the end of a segment is discarded", "[TestWAL3]") {
+  TestController testController;
+  char format[] = "/tmp/testWAL.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::string segment;
+  {
+    auto repository = openRepository(dir);
+    REQUIRE(putValue(repository, "a", "first"));
+    segment = repository->getSegmentPath(1);
+  }
+  {
+    // a partial header followed by a record whose checksum does not match
+    std::ofstream file(segment, std::ios::out | std::ios::binary | std::ios::app);
+    file.write("\x00\x00\x00\x10\xde\xad\xbe\xef\x01\x00", 10);
+  }
+  {
+    auto repository = openRepository(dir);
+    std::string value;
+    REQUIRE(repository->Get("a", value));
+    REQUIRE("first" == value);
+    REQUIRE(putValue(repository, "b", "second"));
+  }
+  // appends after the torn record went to a new segment and are still found
+  auto repository = openRepository(dir);
+  std::string value;
+  REQUIRE(repository->Get("b", value));
+  REQUIRE("second" == value);
+}
+
+TEST_CASE("Group commit from concurrent writers", "[TestWAL4]") {
+  TestController testController;
+  char format[] = "/tmp/testWAL.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  {
+    auto repository = openRepository(dir);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+      writers.emplace_back([repository, t]() {
+        for (int i = 0; i < 250; i++) {
+          putValue(repository, std::to_string(t) + "-" + std::to_string(i), "value");
+        }
+      });
+    }
+    for (auto &writer : writers) {
+      writer.join();
+    }
+  }
+  auto repository = openRepository(dir);
+  std::string value;
+  for (int t = 0; t < 4; t++) {
+    for (int i = 0; i < 250; i++) {
+      REQUIRE(repository->Get(std::to_string(t) + "-" + std::to_string(i), value));
+    }
+  }
+}
+
+TEST_CASE("Stored flow files are recovered into their connections", "[TestWAL5]") {
+  TestController testController;
+  char format[] = "/tmp/testWAL.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  std::map<std::string, std::string> attributes;
+  std::string connection_uuid;
+  std::string orphan_uuid;
+  {
+    auto repository = openRepository(dir);
+    auto connection = std::make_shared<minifi::Connection>(repository, content_repo, "recovered");
+    connection_uuid = connection->getUUIDStr();
+    for (int i = 0; i < 10; i++) {
+      minifi::FlowFileRecord record(repository, content_repo, attributes);
+      record.setUuidConnection(connection_uuid);
+      REQUIRE(true == record.Serialize());
+    }
+    minifi::FlowFileRecord orphan(repository, content_repo, attributes);
+    orphan.setUuidConnection("6f2f2c3c-5a1e-11e8-9c2d-fa7ae01bbebc");
+    REQUIRE(true == orphan.Serialize());
+    orphan_uuid = orphan.getUUIDStr();
+  }
+
+  auto repository = openRepository(dir);
+  utils::Identifier uuid;
+  uuid = connection_uuid;
+  auto connection = std::make_shared<minifi::Connection>(repository, content_repo, "recovered", uuid);
+  std::map<std::string, std::shared_ptr<core::Connectable>> connectionMap;
+  connectionMap[connection_uuid] = connection;
+  repository->setConnectionMap(connectionMap);
+  repository->loadComponent(content_repo);
+  repository->start();
+  for (int i = 0; i < 100 && connection->getQueueSize() < 10; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  repository->stop();
+
+  REQUIRE(10 == connection->getQueueSize());
+  std::string value;
+  REQUIRE(false == repository->Get(orphan_uuid, value));
+  connectionMap.clear();
+  repository->setConnectionMap(connectionMap);
+}
+
+TEST_CASE("Deletes are written by flush", "[TestWAL6]") {
+  TestController testController;
+  char format[] = "/tmp/testWAL.XXXXXX";
+  std::string dir = testController.createTempDirectory(format);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  REQUIRE(content_repo->initialize(std::make_shared<minifi::Configure>()));
+  auto claim = std::make_shared<minifi::ResourceClaim>(content_repo);
+  std::string content = "content";
+  REQUIRE(static_cast<int>(content.size()) == content_repo->write(claim)->writeData(reinterpret_cast<uint8_t*>(&content[0]), content.size()));
+  {
+    auto repository = openRepository(dir);
+    repository->loadComponent(content_repo);
+    REQUIRE(putValue(repository, "a", "first"));
+    REQUIRE(putValue(repository, "b", "second"));
+    REQUIRE(repository->Delete("a", claim, 5));
+    REQUIRE(repository->Delete("missing"));
+
+    // the delete is queued rather than written by the caller
+    std::string value;
+    REQUIRE(repository->Get("a", value));
+    REQUIRE(content_repo->exists(claim));
+
+    repository->flush();
+    REQUIRE(false == repository->Get("a", value));
+    REQUIRE(false == content_repo->exists(claim));
+    REQUIRE(6 == repository->getRepoSize());
+
+    // deletes still queued when the repository goes away are written by its destructor
+    REQUIRE(repository->Delete("b"));
+  }
+  auto repository = openRepository(dir);
+  std::string value;
+  REQUIRE(false == repository->Get("a", value));
+  REQUIRE(false == repository->Get("b", value));
+  REQUIRE(0 == repository->getRepoSize());
+}
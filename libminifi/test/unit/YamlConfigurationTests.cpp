@@ -21,6 +21,7 @@
 #include "core/repository/VolatileContentRepository.h"
 #include <core/RepositoryFactory.h>
 #include "core/yaml/YamlConfiguration.h"
+#include "RootGroupPort.h"
 #include "../TestBase.h"
 
 TEST_CASE("Test YAML Config Processing", "[YamlConfiguration]") {
@@ -747,3 +748,47 @@ TEST_CASE("Test Regex Property 2", "[YamlConfigurationRegexProperty2]") {
 }
 
 #endif  // YAML_CONFIGURATION_USE_REGEX
+
+TEST_CASE("Test Root Group Ports", "[YamlConfigurationRootGroupPorts]") {
+  TestController test_controller;
+
+  std::shared_ptr<core::Repository> testProvRepo = core::createRepository("provenancerepository", true);
+  std::shared_ptr<core::Repository> testFlowFileRepo = core::createRepository("flowfilerepository", true);
+  std::shared_ptr<minifi::Configure> configuration = std::make_shared<minifi::Configure>();
+  std::shared_ptr<minifi::io::StreamFactory> streamFactory = minifi::io::StreamFactory::getInstance(configuration);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  core::YamlConfiguration yamlConfig(testProvRepo, testFlowFileRepo, content_repo, streamFactory, configuration);
+
+  static const std::string TEST_CONFIG_YAML = R"(
+Flow Controller:
+  name: Gateway
+Processors:
+- name: LogAttribute
+  class: LogAttribute
+  auto-terminated relationships list: [success]
+Input Ports:
+- id: 471deef6-2a6e-4a7d-912a-81cc17e3a204
+  name: fromedge
+Output Ports:
+- id: 8644cbcc-a45c-40e0-964d-5e536e2ada61
+  name: toedge
+Connections:
+- name: FromEdge
+  source name: fromedge
+  destination name: LogAttribute
+      )";
+  std::istringstream configYamlStream(TEST_CONFIG_YAML);
+  std::unique_ptr<core::ProcessGroup> rootFlowConfig = yamlConfig.getYamlRoot(configYamlStream);
+
+  REQUIRE(rootFlowConfig);
+  auto input = std::dynamic_pointer_cast<minifi::RootGroupPort>(rootFlowConfig->findProcessor("fromedge"));
+  REQUIRE(input);
+  REQUIRE("471deef6-2a6e-4a7d-912a-81cc17e3a204" == input->getUUIDStr());
+  REQUIRE(minifi::sitetosite::SEND == input->getDirection());
+  auto connections = std::static_pointer_cast<core::Connectable>(input)->getOutGoingConnections(core::Relationship().getName());
+  REQUIRE(1 == connections.size());
+
+  auto output = std::dynamic_pointer_cast<minifi::RootGroupPort>(rootFlowConfig->findProcessor("toedge"));
+  REQUIRE(output);
+  REQUIRE(minifi::sitetosite::RECEIVE == output->getDirection());
+}